@@ -152,6 +152,7 @@
 
 #include "SimTKcommon/internal/MatrixHelper.h"
 #include "SimTKcommon/internal/MatrixCharacteristics.h"
+#include "SimTKcommon/internal/VectorKernels.h"
 
 #include <iostream>
 #include <cassert>
@@ -187,6 +187,14 @@ public:
             return typename CNT<ScalarNormSq>::TSqrt(0);
         }
 
+        // Use the vectorized kernel if the data is all in one piece.
+        if (Base::hasContiguousData()) {
+            ScalarNormSq sumsq;
+            if (VectorKernels::trySumSquares
+                   (Base::getContiguousScalarData(), n, sumsq, worstOne))
+                return CNT<ScalarNormSq>::sqrt(sumsq/n);
+        }
+
         ScalarNormSq sumsq = 0;
         if (worstOne) {
             *worstOne = 0;
@@ -225,6 +233,14 @@ public:
             return typename CNT<ScalarNormSq>::TSqrt(0);
         }
 
+        if (Base::hasContiguousData() && w.hasContiguousData()) {
+            ScalarNormSq sumsq;
+            if (VectorKernels::tryWeightedSumSquares
+                   (w.getContiguousScalarData(), Base::getContiguousScalarData(),
+                    n, sumsq, worstOne))
+                return CNT<ScalarNormSq>::sqrt(sumsq/n);
+        }
+
         ScalarNormSq sumsq = 0;
         if (worstOne) {
             *worstOne = 0;
@@ -258,6 +274,13 @@ public:
             return EAbs(0);
         }
 
+        if (Base::hasContiguousData()) {
+            EAbs maxabs;
+            if (VectorKernels::tryMaxAbs
+                   (Base::getContiguousScalarData(), n, maxabs, worstOne))
+                return maxabs;
+        }
+
         EAbs maxabs = 0;
         if (worstOne) {
             *worstOne = 0;
@@ -293,6 +316,14 @@ public:
             return EAbs(0);
         }
 
+        if (Base::hasContiguousData() && w.hasContiguousData()) {
+            EAbs maxabs;
+            if (VectorKernels::tryWeightedMaxAbs
+                   (w.getContiguousScalarData(), Base::getContiguousScalarData(),
+                    n, maxabs, worstOne))
+                return maxabs;
+        }
+
         EAbs maxabs = 0;
         if (worstOne) {
             *worstOne = 0;
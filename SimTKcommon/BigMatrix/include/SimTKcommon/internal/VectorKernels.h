@@ -0,0 +1,136 @@
+#ifndef SimTK_SIMMATRIX_VECTOR_KERNELS_H_
+#define SimTK_SIMMATRIX_VECTOR_KERNELS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKcommon                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+/** @file
+Declares low-level kernels that operate on contiguous arrays of scalars. These
+are used internally by VectorBase norms and by the integrators for
+weighted error norms and Runge-Kutta stage combinations, whenever the
+operands are known to have contiguous storage. They are vectorized with SIMD
+instructions where the platform supports it; otherwise they are unrolled
+scalar loops with independent accumulators.
+
+These are intended for internal use and for performance-critical code that
+is already working with raw contiguous data; ordinary users should use the
+Vector methods instead. **/
+
+#include "SimTKcommon/internal/common.h"
+
+namespace SimTK {
+namespace VectorKernels {
+
+/** Return sum(v_i^2), i=0..n-1. If \a worstOne is non-null, return there
+the index of the element of largest absolute value (the first one if there
+are ties; 0 if all are zero). **/
+SimTK_SimTKCOMMON_EXPORT double
+calcSumSquares(const double* v, int n, int* worstOne);
+SimTK_SimTKCOMMON_EXPORT float
+calcSumSquares(const float* v, int n, int* worstOne);
+
+/** Return sum((w_i*v_i)^2), i=0..n-1. If \a worstOne is non-null, return
+there the index of the largest weighted element. **/
+SimTK_SimTKCOMMON_EXPORT double
+calcWeightedSumSquares(const double* w, const double* v, int n,
+                       int* worstOne);
+SimTK_SimTKCOMMON_EXPORT float
+calcWeightedSumSquares(const float* w, const float* v, int n,
+                       int* worstOne);
+
+/** Return max_i |v_i|, with optional return of the index of the first element
+of that magnitude. NaN elements are ignored. **/
+SimTK_SimTKCOMMON_EXPORT double
+calcMaxAbs(const double* v, int n, int* worstOne);
+SimTK_SimTKCOMMON_EXPORT float
+calcMaxAbs(const float* v, int n, int* worstOne);
+
+/** Return max_i |w_i*v_i|, with optional return of the index of the first
+element of that magnitude. NaN elements are ignored. **/
+SimTK_SimTKCOMMON_EXPORT double
+calcWeightedMaxAbs(const double* w, const double* v, int n, int* worstOne);
+SimTK_SimTKCOMMON_EXPORT float
+calcWeightedMaxAbs(const float* w, const float* v, int n, int* worstOne);
+
+/** Fused scale-and-accumulate: y_i += a*x_i, i=0..n-1. **/
+SimTK_SimTKCOMMON_EXPORT void
+scaleAndAccumulate(double a, const double* x, int n, double* y);
+SimTK_SimTKCOMMON_EXPORT void
+scaleAndAccumulate(float a, const float* x, int n, float* y);
+
+/** Linear combination as used in Runge-Kutta stages:
+    out_i = y0_i + h * sum_k c_k*f_k_i,   k=0..nTerms-1, i=0..n-1.
+Terms with c_k==0 are skipped. \a out may be the same as \a y0 but must not
+overlap any of the \a f arrays. **/
+SimTK_SimTKCOMMON_EXPORT void
+calcLinearCombination(const double* y0, double h, int nTerms,
+                      const double* c, const double* const* f,
+                      int n, double* out);
+SimTK_SimTKCOMMON_EXPORT void
+calcLinearCombination(const float* y0, float h, int nTerms,
+                      const float* c, const float* const* f,
+                      int n, float* out);
+
+
+// These overloads are used by the VectorBase templates to pick up a kernel
+// when one is available for the element type. The generic versions return
+// false, meaning the caller must use its own element-by-element loop.
+
+/** @cond **/ // don't show in Doxygen
+template <class S, class R> inline bool
+trySumSquares(const S*, int, R&, int*) {return false;}
+inline bool trySumSquares(const double* v, int n, double& r, int* worst)
+{   r = calcSumSquares(v, n, worst); return true; }
+inline bool trySumSquares(const float* v, int n, float& r, int* worst)
+{   r = calcSumSquares(v, n, worst); return true; }
+
+template <class SW, class S, class R> inline bool
+tryWeightedSumSquares(const SW*, const S*, int, R&, int*) {return false;}
+inline bool tryWeightedSumSquares(const double* w, const double* v, int n,
+                                  double& r, int* worst)
+{   r = calcWeightedSumSquares(w, v, n, worst); return true; }
+inline bool tryWeightedSumSquares(const float* w, const float* v, int n,
+                                  float& r, int* worst)
+{   r = calcWeightedSumSquares(w, v, n, worst); return true; }
+
+template <class S, class R> inline bool
+tryMaxAbs(const S*, int, R&, int*) {return false;}
+inline bool tryMaxAbs(const double* v, int n, double& r, int* worst)
+{   r = calcMaxAbs(v, n, worst); return true; }
+inline bool tryMaxAbs(const float* v, int n, float& r, int* worst)
+{   r = calcMaxAbs(v, n, worst); return true; }
+
+template <class SW, class S, class R> inline bool
+tryWeightedMaxAbs(const SW*, const S*, int, R&, int*) {return false;}
+inline bool tryWeightedMaxAbs(const double* w, const double* v, int n,
+                              double& r, int* worst)
+{   r = calcWeightedMaxAbs(w, v, n, worst); return true; }
+inline bool tryWeightedMaxAbs(const float* w, const float* v, int n,
+                              float& r, int* worst)
+{   r = calcWeightedMaxAbs(w, v, n, worst); return true; }
+/** @endcond **/
+
+} // namespace VectorKernels
+} // namespace SimTK
+
+#endif // SimTK_SIMMATRIX_VECTOR_KERNELS_H_
@@ -0,0 +1,363 @@
+/* -------------------------------------------------------------------------- *
+ *                       Simbody(tm): SimTKcommon                             *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon/internal/common.h"
+#include "SimTKcommon/internal/VectorKernels.h"
+
+#include <cmath>
+
+// SSE2 is always available on x86-64; on 32 bit x86 it depends on the
+// instruction set chosen at build time (see BUILD_INST_SET in CMake).
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SimTK_VECTOR_KERNELS_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+using namespace SimTK;
+
+namespace {
+
+//==============================================================================
+//                          PORTABLE IMPLEMENTATIONS
+//==============================================================================
+// These are written with four independent accumulators so that the compiler
+// can keep several operations in flight (and vectorize if it wants to). They
+// handle float everywhere, and double on platforms without SSE2.
+
+// After finding the largest squared (or absolute) value, find the first
+// element that produced it. This is a second pass but only over the data
+// that is already in cache, and it keeps the main loop branch free.
+template <class T, class F>
+int findFirst(int n, T target, F valueOf) {
+    for (int i=0; i < n; ++i)
+        if (valueOf(i) == target) return i;
+    return 0; // can only happen if everything was NaN
+}
+
+template <class T>
+T sumSquaresPortable(const T* v, int n, T& maxsq) {
+    T s0=0, s1=0, s2=0, s3=0, m0=0, m1=0;
+    int i=0;
+    for (; i+4 <= n; i += 4) {
+        const T a=v[i]*v[i], b=v[i+1]*v[i+1], c=v[i+2]*v[i+2], d=v[i+3]*v[i+3];
+        s0 += a; s1 += b; s2 += c; s3 += d;
+        if (a > m0) m0=a; if (b > m1) m1=b; if (c > m0) m0=c; if (d > m1) m1=d;
+    }
+    for (; i < n; ++i) {
+        const T a=v[i]*v[i]; s0 += a; if (a > m0) m0=a;
+    }
+    maxsq = m0 > m1 ? m0 : m1;
+    return (s0+s1)+(s2+s3);
+}
+
+template <class T>
+T weightedSumSquaresPortable(const T* w, const T* v, int n, T& maxsq) {
+    T s0=0, s1=0, s2=0, s3=0, m0=0, m1=0;
+    int i=0;
+    for (; i+4 <= n; i += 4) {
+        const T wa=w[i]*v[i], wb=w[i+1]*v[i+1],
+                wc=w[i+2]*v[i+2], wd=w[i+3]*v[i+3];
+        const T a=wa*wa, b=wb*wb, c=wc*wc, d=wd*wd;
+        s0 += a; s1 += b; s2 += c; s3 += d;
+        if (a > m0) m0=a; if (b > m1) m1=b; if (c > m0) m0=c; if (d > m1) m1=d;
+    }
+    for (; i < n; ++i) {
+        const T wa=w[i]*v[i], a=wa*wa; s0 += a; if (a > m0) m0=a;
+    }
+    maxsq = m0 > m1 ? m0 : m1;
+    return (s0+s1)+(s2+s3);
+}
+
+template <class T>
+T maxAbsPortable(const T* v, int n) {
+    T m0=0, m1=0;
+    int i=0;
+    for (; i+2 <= n; i += 2) {
+        const T a=std::abs(v[i]), b=std::abs(v[i+1]);
+        if (a > m0) m0=a; if (b > m1) m1=b;
+    }
+    if (i < n) {const T a=std::abs(v[i]); if (a > m0) m0=a;}
+    return m0 > m1 ? m0 : m1;
+}
+
+template <class T>
+T weightedMaxAbsPortable(const T* w, const T* v, int n) {
+    T m0=0, m1=0;
+    int i=0;
+    for (; i+2 <= n; i += 2) {
+        const T a=std::abs(w[i]*v[i]), b=std::abs(w[i+1]*v[i+1]);
+        if (a > m0) m0=a; if (b > m1) m1=b;
+    }
+    if (i < n) {const T a=std::abs(w[i]*v[i]); if (a > m0) m0=a;}
+    return m0 > m1 ? m0 : m1;
+}
+
+template <class T>
+void scaleAndAccumulatePortable(T a, const T* x, int n, T* y) {
+    int i=0;
+    for (; i+4 <= n; i += 4) {
+        y[i]   += a*x[i];   y[i+1] += a*x[i+1];
+        y[i+2] += a*x[i+2]; y[i+3] += a*x[i+3];
+    }
+    for (; i < n; ++i) y[i] += a*x[i];
+}
+
+#ifdef SimTK_VECTOR_KERNELS_USE_SSE2
+//==============================================================================
+//                           SSE2 IMPLEMENTATIONS
+//==============================================================================
+// Two doubles per register, two registers per iteration so we have four
+// independent partial sums. Unaligned loads are used since Vector data
+// is only guaranteed to have malloc alignment and views may start anywhere.
+// Note that _mm_max_pd(a,b) returns b if either is NaN, so putting the new
+// value first makes the running max ignore NaNs, matching the scalar code.
+
+inline double hsum(__m128d a) {
+    return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+}
+inline double hmax(__m128d a) {
+    return _mm_cvtsd_f64(_mm_max_sd(_mm_unpackhi_pd(a, a), a));
+}
+inline __m128d absPd(__m128d a) {
+    const __m128d signMask = _mm_set1_pd(-0.);
+    return _mm_andnot_pd(signMask, a);
+}
+
+double sumSquaresSSE2(const double* v, int n, double& maxsq) {
+    __m128d s0=_mm_setzero_pd(), s1=_mm_setzero_pd(),
+            m0=_mm_setzero_pd(), m1=_mm_setzero_pd();
+    int i=0;
+    for (; i+4 <= n; i += 4) {
+        const __m128d a=_mm_loadu_pd(v+i), b=_mm_loadu_pd(v+i+2);
+        const __m128d a2=_mm_mul_pd(a,a), b2=_mm_mul_pd(b,b);
+        s0=_mm_add_pd(s0,a2); s1=_mm_add_pd(s1,b2);
+        m0=_mm_max_pd(a2,m0); m1=_mm_max_pd(b2,m1);
+    }
+    double sum = hsum(_mm_add_pd(s0,s1));
+    maxsq = hmax(_mm_max_pd(m0,m1));
+    for (; i < n; ++i) {
+        const double a2=v[i]*v[i]; sum += a2; if (a2 > maxsq) maxsq=a2;
+    }
+    return sum;
+}
+
+double weightedSumSquaresSSE2(const double* w, const double* v, int n,
+                              double& maxsq) {
+    __m128d s0=_mm_setzero_pd(), s1=_mm_setzero_pd(),
+            m0=_mm_setzero_pd(), m1=_mm_setzero_pd();
+    int i=0;
+    for (; i+4 <= n; i += 4) {
+        const __m128d a=_mm_mul_pd(_mm_loadu_pd(w+i),   _mm_loadu_pd(v+i));
+        const __m128d b=_mm_mul_pd(_mm_loadu_pd(w+i+2), _mm_loadu_pd(v+i+2));
+        const __m128d a2=_mm_mul_pd(a,a), b2=_mm_mul_pd(b,b);
+        s0=_mm_add_pd(s0,a2); s1=_mm_add_pd(s1,b2);
+        m0=_mm_max_pd(a2,m0); m1=_mm_max_pd(b2,m1);
+    }
+    double sum = hsum(_mm_add_pd(s0,s1));
+    maxsq = hmax(_mm_max_pd(m0,m1));
+    for (; i < n; ++i) {
+        const double wv=w[i]*v[i], a2=wv*wv;
+        sum += a2; if (a2 > maxsq) maxsq=a2;
+    }
+    return sum;
+}
+
+double maxAbsSSE2(const double* v, int n) {
+    __m128d m0=_mm_setzero_pd(), m1=_mm_setzero_pd();
+    int i=0;
+    for (; i+4 <= n; i += 4) {
+        m0=_mm_max_pd(absPd(_mm_loadu_pd(v+i)),   m0);
+        m1=_mm_max_pd(absPd(_mm_loadu_pd(v+i+2)), m1);
+    }
+    double maxabs = hmax(_mm_max_pd(m0,m1));
+    for (; i < n; ++i) {
+        const double a=std::abs(v[i]); if (a > maxabs) maxabs=a;
+    }
+    return maxabs;
+}
+
+double weightedMaxAbsSSE2(const double* w, const double* v, int n) {
+    __m128d m0=_mm_setzero_pd(), m1=_mm_setzero_pd();
+    int i=0;
+    for (; i+4 <= n; i += 4) {
+        m0=_mm_max_pd(absPd(_mm_mul_pd(_mm_loadu_pd(w+i),
+                                       _mm_loadu_pd(v+i))),   m0);
+        m1=_mm_max_pd(absPd(_mm_mul_pd(_mm_loadu_pd(w+i+2),
+                                       _mm_loadu_pd(v+i+2))), m1);
+    }
+    double maxabs = hmax(_mm_max_pd(m0,m1));
+    for (; i < n; ++i) {
+        const double a=std::abs(w[i]*v[i]); if (a > maxabs) maxabs=a;
+    }
+    return maxabs;
+}
+
+void scaleAndAccumulateSSE2(double a, const double* x, int n, double* y) {
+    const __m128d av = _mm_set1_pd(a);
+    int i=0;
+    for (; i+4 <= n; i += 4) {
+        const __m128d y0=_mm_loadu_pd(y+i), y1=_mm_loadu_pd(y+i+2);
+        _mm_storeu_pd(y+i,   _mm_add_pd(y0, _mm_mul_pd(av,_mm_loadu_pd(x+i))));
+        _mm_storeu_pd(y+i+2, _mm_add_pd(y1, _mm_mul_pd(av,_mm_loadu_pd(x+i+2))));
+    }
+    for (; i < n; ++i) y[i] += a*x[i];
+}
+#endif // SimTK_VECTOR_KERNELS_USE_SSE2
+
+}
+
+
+
+//==============================================================================
+//                            EXPORTED KERNELS
+//==============================================================================
+namespace SimTK {
+namespace VectorKernels {
+
+double calcSumSquares(const double* v, int n, int* worstOne) {
+    double maxsq;
+    #ifdef SimTK_VECTOR_KERNELS_USE_SSE2
+    const double sum = sumSquaresSSE2(v, n, maxsq);
+    #else
+    const double sum = sumSquaresPortable(v, n, maxsq);
+    #endif
+    if (worstOne)
+        *worstOne = findFirst(n, maxsq, [v](int i) {return v[i]*v[i];});
+    return sum;
+}
+
+float calcSumSquares(const float* v, int n, int* worstOne) {
+    float maxsq;
+    const float sum = sumSquaresPortable(v, n, maxsq);
+    if (worstOne)
+        *worstOne = findFirst(n, maxsq, [v](int i) {return v[i]*v[i];});
+    return sum;
+}
+
+double calcWeightedSumSquares(const double* w, const double* v, int n,
+                              int* worstOne) {
+    double maxsq;
+    #ifdef SimTK_VECTOR_KERNELS_USE_SSE2
+    const double sum = weightedSumSquaresSSE2(w, v, n, maxsq);
+    #else
+    const double sum = weightedSumSquaresPortable(w, v, n, maxsq);
+    #endif
+    if (worstOne)
+        *worstOne = findFirst(n, maxsq,
+            [w,v](int i) {const double wv=w[i]*v[i]; return wv*wv;});
+    return sum;
+}
+
+float calcWeightedSumSquares(const float* w, const float* v, int n,
+                             int* worstOne) {
+    float maxsq;
+    const float sum = weightedSumSquaresPortable(w, v, n, maxsq);
+    if (worstOne)
+        *worstOne = findFirst(n, maxsq,
+            [w,v](int i) {const float wv=w[i]*v[i]; return wv*wv;});
+    return sum;
+}
+
+double calcMaxAbs(const double* v, int n, int* worstOne) {
+    #ifdef SimTK_VECTOR_KERNELS_USE_SSE2
+    const double maxabs = maxAbsSSE2(v, n);
+    #else
+    const double maxabs = maxAbsPortable(v, n);
+    #endif
+    if (worstOne)
+        *worstOne = findFirst(n, maxabs, [v](int i) {return std::abs(v[i]);});
+    return maxabs;
+}
+
+float calcMaxAbs(const float* v, int n, int* worstOne) {
+    const float maxabs = maxAbsPortable(v, n);
+    if (worstOne)
+        *worstOne = findFirst(n, maxabs, [v](int i) {return std::abs(v[i]);});
+    return maxabs;
+}
+
+double calcWeightedMaxAbs(const double* w, const double* v, int n,
+                          int* worstOne) {
+    #ifdef SimTK_VECTOR_KERNELS_USE_SSE2
+    const double maxabs = weightedMaxAbsSSE2(w, v, n);
+    #else
+    const double maxabs = weightedMaxAbsPortable(w, v, n);
+    #endif
+    if (worstOne)
+        *worstOne = findFirst(n, maxabs,
+                              [w,v](int i) {return std::abs(w[i]*v[i]);});
+    return maxabs;
+}
+
+float calcWeightedMaxAbs(const float* w, const float* v, int n,
+                         int* worstOne) {
+    const float maxabs = weightedMaxAbsPortable(w, v, n);
+    if (worstOne)
+        *worstOne = findFirst(n, maxabs,
+                              [w,v](int i) {return std::abs(w[i]*v[i]);});
+    return maxabs;
+}
+
+void scaleAndAccumulate(double a, const double* x, int n, double* y) {
+    #ifdef SimTK_VECTOR_KERNELS_USE_SSE2
+    scaleAndAccumulateSSE2(a, x, n, y);
+    #else
+    scaleAndAccumulatePortable(a, x, n, y);
+    #endif
+}
+
+void scaleAndAccumulate(float a, const float* x, int n, float* y) {
+    scaleAndAccumulatePortable(a, x, n, y);
+}
+
+// We make one pass to initialize out=y0 (if necessary), then accumulate
+// one term at a time. Each pass is a streaming fused multiply-add which
+// is about as fast as it gets for the short lists of terms used by
+// Runge-Kutta methods, and avoids the temporaries that would be created by
+// writing this as a Vector expression.
+template <class T>
+static void calcLinearCombinationImpl(const T* y0, T h, int nTerms,
+                                      const T* c, const T* const* f,
+                                      int n, T* out) {
+    if (out != y0)
+        for (int i=0; i < n; ++i) out[i] = y0[i];
+    for (int k=0; k < nTerms; ++k)
+        if (c[k] != 0)
+            scaleAndAccumulate(h*c[k], f[k], n, out);
+}
+
+void calcLinearCombination(const double* y0, double h, int nTerms,
+                           const double* c, const double* const* f,
+                           int n, double* out) {
+    calcLinearCombinationImpl(y0, h, nTerms, c, f, n, out);
+}
+
+void calcLinearCombination(const float* y0, float h, int nTerms,
+                           const float* c, const float* const* f,
+                           int n, float* out) {
+    calcLinearCombinationImpl(y0, h, nTerms, c, f, n, out);
+}
+
+} // namespace VectorKernels
+} // namespace SimTK
@@ -127,6 +127,47 @@ template class Vector_<negator<double> >;
 template class RowVector_<negator<double> >;
 }
 
+// The Vector norms use vectorized kernels when the data is contiguous and
+// an element-by-element loop otherwise. Compare the two by computing the same
+// norms on a strided view of the same data (a Matrix row), for lengths that
+// exercise the kernels' unrolled loops and remainders.
+template <class E>
+void testVectorNorms() {
+    const E tol = 10*NTraits<E>::getEps();
+    Random::Uniform rand(-10, 10); rand.setSeed(42);
+    for (int n=0; n < 14; ++n) {
+        Matrix_<E> m(2, n); // row 0 is data, row 1 is weights
+        for (int j=0; j < n; ++j)
+            m(0,j) = E(rand.getValue()), m(1,j) = std::abs(E(rand.getValue()));
+        if (n > 5) m(0,5) = E(50); // a known worst element
+        const Vector_<E> v = ~m[0], w = ~m[1];  // contiguous copies
+        const VectorView_<E> vs = ~m[0], ws = ~m[1]; // strided views
+        ASSERT(v.hasContiguousData() && !(n > 1 && vs.hasContiguousData()));
+
+        int iv, is;
+        ASSERT(std::abs(v.normRMS(&iv) - vs.normRMS(&is)) <= tol*50);
+        ASSERT(iv == is); if (n > 5) ASSERT(iv == 5);
+        ASSERT(std::abs(v.weightedNormRMS(w,&iv) - vs.weightedNormRMS(ws,&is))
+               <= tol*500);
+        ASSERT(iv == is);
+        ASSERT(v.normInf(&iv) == vs.normInf(&is)); ASSERT(iv == is);
+        ASSERT(v.weightedNormInf(w,&iv) == vs.weightedNormInf(ws,&is));
+        ASSERT(iv == is);
+    }
+
+    // Stage combinations used by the Runge-Kutta integrators.
+    const int n = 11;
+    Vector_<E> y0(n), f0(n), f1(n), out(n);
+    for (int i=0; i < n; ++i)
+        y0[i]=E(rand.getValue()), f0[i]=E(rand.getValue()),
+        f1[i]=E(rand.getValue());
+    const E c[] = {E(.25), E(-1.5)};
+    const E* f[] = {&f0[0], &f1[0]};
+    VectorKernels::calcLinearCombination(&y0[0], E(.1), 2, c, f, n, &out[0]);
+    const Vector_<E> expected = y0 + E(.1)*(E(.25)*f0 - E(1.5)*f1);
+    ASSERT((out - expected).normInf() <= tol*10);
+}
+
 int main() {
     try {
         // Currently, this only tests a small number of operations that were recently added.
@@ -145,6 +186,8 @@ int main() {
 
         testMatDivision();
         testTransform();
+        testVectorNorms<double>();
+        testVectorNorms<float>();
         
         Matrix m(Mat22(1, 2, 3, 4));
         testMatrix<Matrix,2,2>(m, Mat22(1, 2, 3, 4));
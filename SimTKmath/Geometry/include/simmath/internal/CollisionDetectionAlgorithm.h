@@ -171,9 +171,9 @@ private:
     void processBox(const ContactGeometry::TriangleMesh& mesh, 
                     const ContactGeometry::TriangleMesh::OBBTreeNode& node,
                     const Transform& transform, const Vec3& axisDir, 
-                    Real xoffset, std::set<int>& insideFaces) const;
+                    Real xoffset, MeshFaceSet& insideFaces) const;
     void addAllTriangles(const ContactGeometry::TriangleMesh::OBBTreeNode& node,
-                         std::set<int>& insideFaces) const;
+                         MeshFaceSet& insideFaces) const;
 };
 
 /**
@@ -194,7 +194,7 @@ private:
     void processBox(const Vec3& center, Real radius2, 
                     const ContactGeometry::TriangleMesh& mesh, 
                     const ContactGeometry::TriangleMesh::OBBTreeNode& node,
-                    std::set<int>& insideFaces) const;
+                    MeshFaceSet& insideFaces) const;
 };
 
 /**
@@ -217,14 +217,14 @@ private:
                       const ContactGeometry::TriangleMesh::OBBTreeNode& node1, 
                       const ContactGeometry::TriangleMesh::OBBTreeNode& node2,
                       const OrientedBoundingBox& node2Bounds, 
-                      const Transform& transform, std::set<int>& triangles1, 
-                      std::set<int>& triangles2) const;
+                      const Transform& transform, MeshFaceSet& triangles1, 
+                      MeshFaceSet& triangles2) const;
     void findInsideTriangles(const ContactGeometry::TriangleMesh& mesh, 
                              const ContactGeometry::TriangleMesh& otherMesh,
                              const Transform& transform, 
-                             std::set<int>& triangles) const;
+                             MeshFaceSet& triangles) const;
     void tagFaces(const ContactGeometry::TriangleMesh& mesh, 
-                  Array_<int>& faceType, std::set<int>& triangles, 
+                  Array_<int>& faceType, MeshFaceSet& triangles, 
                   int index, int depth) const;
     static const int OUTSIDE = -1;
     static const int UNKNOWN = 0;
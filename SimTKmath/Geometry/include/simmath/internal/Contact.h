@@ -26,6 +26,7 @@
 
 #include "SimTKcommon.h"
 #include "simmath/internal/common.h"
+#include "simmath/internal/MeshFaceSet.h"
 
 namespace SimTK {
 
@@ -475,6 +476,33 @@ objects is a TriangleMesh. It stores a list of every face on each object
 that is partly or completely inside the other one. **/
 class SimTK_SIMMATH_EXPORT TriangleMeshContact : public Contact {
 public:
+    /** Create a TriangleMeshContact object from the sets of faces found by
+    a contact tracker. The faces are copied and stored in ascending order.
+    @param surf1    the index of the first surface involved in the contact, 
+                    specified by its index within its contact set
+    @param surf2    the index of the second surface involved in the contact, 
+                    specified by its index within its contact set
+    @param X_S1S2   the transform giving surf2's frame measured and expressed
+                    in surf1's frame
+    @param faces1   the faces of the first surface which are inside the 
+                    second one
+    @param faces2   the faces of the second surface which are inside the 
+                    first one **/
+    TriangleMeshContact(ContactSurfaceIndex     surf1, 
+                        ContactSurfaceIndex     surf2,
+                        const Transform&        X_S1S2,
+                        const MeshFaceSet&      faces1, 
+                        const MeshFaceSet&      faces2);
+
+    /** Create a TriangleMeshContact object from lists of faces, which must
+    be in ascending order, such as those of another TriangleMeshContact. The
+    parameters are as for the constructor above. **/
+    TriangleMeshContact(ContactSurfaceIndex     surf1, 
+                        ContactSurfaceIndex     surf2,
+                        const Transform&        X_S1S2,
+                        const Array_<int>&      faceList1, 
+                        const Array_<int>&      faceList2);
+
     /** Create a TriangleMeshContact object.
     @param surf1    the index of the first surface involved in the contact, 
                     specified by its index within its contact set
@@ -492,13 +520,24 @@ public:
                         const std::set<int>&    faces1, 
                         const std::set<int>&    faces2);
 
+    /** Get the indices of all faces of surface1 that are partly or completely 
+    inside surface2, in ascending order. If surface1 is not a TriangleMesh, 
+    this will return an empty list. **/
+    const Array_<int>& getSurface1FaceList() const;
+    /** Get the indices of all faces of surface2 that are partly or completely
+    inside surface1, in ascending order. If surface2 is not a TriangleMesh, 
+    this will return an empty list. **/
+    const Array_<int>& getSurface2FaceList() const;
+
     /** Get the indices of all faces of surface1 that are partly or completely 
     inside surface2. If surface1 is not a TriangleMesh, this will return an 
-    empty set. **/
+    empty set. The set is built from getSurface1FaceList() the first time it
+    is asked for; use that instead in new code. **/
     const std::set<int>& getSurface1Faces() const;
     /** Get the indices of all faces of surface2 that are partly or completely
     inside surface1. If surface2 is not a TriangleMesh, this will return an 
-    empty set. **/
+    empty set. The set is built from getSurface2FaceList() the first time it
+    is asked for; use that instead in new code. **/
     const std::set<int>& getSurface2Faces() const;
 
     /** Determine whether a Contact object is a TriangleMeshContact. **/
@@ -44,7 +44,7 @@ contact geometry for fast lookup purposes. **/
 SimTK_DEFINE_UNIQUE_INDEX_TYPE(ContactGeometryTypeId);
 
 class ContactGeometryImpl;
-class OBBTreeNodeImpl;
+class OBBTreeImpl;
 class OBBTree;
 class Plane;
 
@@ -1076,9 +1076,25 @@ SmoothHeightMap. **/
 const BicubicSurface& getBicubicSurface() const;
 
 /** (Advanced) Return a reference to the oriented bounding box tree for this
-surface. **/
+surface. The tree holds a Bezier patch in every node, so it is large for a
+big surface; it is not built until the first time it is requested. **/
 const OBBTree& getOBBTree() const;
 
+/** Find bounds on the height z of the surface over the part of an 
+axis-aligned rectangle in the x-y plane that lies within the surface's 
+boundary. This uses a min/max pyramid over the patches built with the
+surface, so its cost does not depend on the size of the rectangle or the
+number of patches; use it to reject a contact cheaply, or to find where to
+look more closely.
+@param[in]  low     The low corner (x,y) of the rectangle.
+@param[in]  high    The high corner (x,y) of the rectangle.
+@param[out] minZ    No point of the surface over the rectangle is below this.
+@param[out] maxZ    No point of the surface over the rectangle is above this.
+@return \c false if the rectangle doesn't overlap the surface at all, in 
+which case \a minZ and \a maxZ are not set. **/
+bool findHeightBounds(const Vec2& low, const Vec2& high, 
+                      Real& minZ, Real& maxZ) const;
+
 /** Return true if the supplied ContactGeometry object is a SmoothHeightMap. **/
 static bool isInstance(const ContactGeometry& geo)
 {   return geo.getTypeId()==classTypeId(); }
@@ -1164,6 +1180,7 @@ class SimTK_SIMMATH_EXPORT ContactGeometry::TriangleMesh
 :   public ContactGeometry {
 public:
 class OBBTreeNode;
+class OBBTreeOptions;
 /** Create a TriangleMesh.
 @param vertices     The positions of all vertices in the mesh.
 @param faceIndices  The indices of the vertices that make up each face. The 
@@ -1184,6 +1201,15 @@ triangulated.
                  If false, it will be treated as a faceted mesh with a constant
                  normal vector over each face. **/
 explicit TriangleMesh(const PolygonalMesh& mesh, bool smooth=false);
+/** Create a TriangleMesh as above, but with control over how its Oriented 
+Bounding Box Tree is built; see OBBTreeOptions. **/
+TriangleMesh(const ArrayViewConst_<Vec3>& vertices, 
+             const ArrayViewConst_<int>& faceIndices, bool smooth,
+             const OBBTreeOptions& options);
+/** Create a TriangleMesh from a PolygonalMesh as above, but with control over
+how its Oriented Bounding Box Tree is built; see OBBTreeOptions. **/
+TriangleMesh(const PolygonalMesh& mesh, bool smooth, 
+             const OBBTreeOptions& options);
 /** Get the number of edges in the mesh. **/
 int getNumEdges() const;
 /** Get the number of faces in the mesh. **/
@@ -1309,6 +1335,29 @@ bool intersectsRay(const Vec3& origin, const UnitVec3& direction, Real& distance
 Box Tree. **/
 OBBTreeNode getOBBTreeNode() const;
 
+/** Precompute a sparse signed distance field for this mesh, replacing any
+that was created earlier. The field is sampled on a uniform grid with the 
+given cell size, covering the mesh with a margin. Near the surface it keeps
+the exact distance at every grid vertex; elsewhere it keeps one value per
+block of 8x8x8 cells. The mesh must be closed, as contact meshes must be.
+
+Once it exists, estimateSignedDistance() answers in constant time, and 
+findNearestPoint() and the sphere-mesh contact tracker use the field to 
+skip most of the OBB tree search. Their results are unchanged. Smaller 
+cells give tighter estimates but take longer to build and more memory.
+@param cellSize     The grid spacing; must be positive. **/
+void createDistanceField(Real cellSize);
+/** Return true if createDistanceField() has been called for this mesh. **/
+bool hasDistanceField() const;
+/** Estimate the signed distance of a point from the surface of this mesh, 
+negative inside, using the distance field. The true signed distance is
+within \a maxError of \a distance. Near the surface \a maxError is about a 
+cell diagonal; far from it, it is about the diagonal of a block.
+@return \c false, leaving \a distance and \a maxError unchanged, if there
+        is no distance field or the point is outside of it. **/
+bool estimateSignedDistance(const Vec3& position, Real& distance, 
+                            Real& maxError) const;
+
 /** Generate a PolygonalMesh from this TriangleMesh; useful mostly for debugging
 because you can create a DecorativeMesh from this and then look at it. **/
 PolygonalMesh createPolygonalMesh() const;
@@ -1339,13 +1388,16 @@ Impl& updImpl(); /**< Internal use only. **/
 /** This class represents a node in the Oriented Bounding Box Tree for a 
 TriangleMesh. Each node has an OrientedBoundingBox that fully encloses all 
 triangles contained within it or its  children. This is a binary tree: each 
-non-leaf node has two children. Triangles are stored only in the leaf nodes. **/
+non-leaf node has two children. Triangles are stored only in the leaf nodes. 
+An %OBBTreeNode is a lightweight handle referring to a node of the tree 
+owned by the TriangleMesh; it is valid only as long as that mesh is. **/
 class SimTK_SIMMATH_EXPORT ContactGeometry::TriangleMesh::OBBTreeNode {
 public:
-OBBTreeNode(const OBBTreeNodeImpl& impl);
+OBBTreeNode(const OBBTreeImpl& tree, int index);
 /** Get the OrientedBoundingBox which encloses all triangles in this node or 
-its children. **/
-const OrientedBoundingBox& getBounds() const;
+its children. The tree stores its boxes in a compact form, so this is 
+unpacked on each call; hold onto the result rather than asking repeatedly. **/
+OrientedBoundingBox getBounds() const;
 /** Get whether this is a leaf node. **/
 bool isLeafNode() const;
 /** Get the first child node. Calling this on a leaf node will produce an 
@@ -1355,15 +1407,76 @@ const OBBTreeNode getFirstChildNode() const;
 exception. **/
 const OBBTreeNode getSecondChildNode() const;
 /** Get the indices of all triangles contained in this node. Calling this on a
-non-leaf node will produce an exception. **/
-const Array_<int>& getTriangles() const;
+non-leaf node will produce an exception. The returned view refers to storage
+inside the TriangleMesh. **/
+ArrayViewConst_<int> getTriangles() const;
 /** Get the number of triangles inside this node. If this is not a leaf node,
 this is the total number of triangles contained by all children of this
 node. **/
 int getNumTriangles() const;
 
 private:
-const OBBTreeNodeImpl* impl;
+const OBBTreeImpl*  tree;
+int                 index;
+};
+
+
+
+//==============================================================================
+//                     TRIANGLE MESH :: OBB TREE OPTIONS
+//==============================================================================
+/** Options controlling how a TriangleMesh builds its Oriented Bounding Box 
+Tree. The defaults reproduce the tree that a TriangleMesh has always had, 
+built on as many threads as there are processors. The tree that results does
+not depend on the number of threads used to build it.
+
+For very large meshes (millions of triangles) building the tree can take
+several seconds. If you give a cache file, the built tree is saved there and 
+later constructions of the same mesh with the same split method load it 
+rather than building it again. A good place for it is next to the file the 
+mesh came from, say "femur.obj.obbtree". The cache records the mesh it was 
+built for, and is silently ignored and rewritten if it doesn't match, so a 
+stale or damaged file just costs a rebuild. **/
+class ContactGeometry::TriangleMesh::OBBTreeOptions {
+public:
+/** How each node's triangles are divided between its two children. **/
+enum SplitMethod {
+    /** Split across the middle of the triangles' extents along one of the
+    coordinate axes. This is fast and is the default. **/
+    MedianSplit         = 0,
+    /** Choose the split along each of the node's box axes that minimizes the
+    surface area heuristic, that is, the sum over both children of the box 
+    surface area times the number of triangles. This takes longer to build
+    but usually gives tighter boxes and faster queries. **/
+    SurfaceAreaSplit    = 1
+};
+
+/** Default options: median split, all processors, no cache file. **/
+OBBTreeOptions() : splitMethod(MedianSplit), numThreads(0) {}
+
+/** Set how nodes are split. **/
+OBBTreeOptions& setSplitMethod(SplitMethod method) 
+{   splitMethod = method; return *this; }
+/** Set the maximum number of threads to use for building the tree. Zero,
+the default, means use all the processors; 1 builds it serially. Small meshes
+are always built serially. **/
+OBBTreeOptions& setNumThreads(int nThreads) 
+{   SimTK_APIARGCHECK1_ALWAYS(nThreads >= 0, "TriangleMesh::OBBTreeOptions",
+        "setNumThreads", "Illegal number of threads %d.", nThreads);
+    numThreads = nThreads; return *this; }
+/** Set the name of a file in which to cache the built tree. An empty name,
+the default, means don't cache it. **/
+OBBTreeOptions& setCacheFile(const std::string& pathname) 
+{   cacheFile = pathname; return *this; }
+
+SplitMethod getSplitMethod() const {return splitMethod;}
+int getNumThreads() const {return numThreads;}
+const std::string& getCacheFile() const {return cacheFile;}
+
+private:
+SplitMethod     splitMethod;
+int             numThreads;
+std::string     cacheFile;
 };
 
 //==============================================================================
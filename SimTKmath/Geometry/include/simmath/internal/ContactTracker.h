@@ -121,8 +121,9 @@ opposite normals because the perpendicularity conditions can't distinguish n
 from -n. We are depending on having an initial guess that is good enough so
 that we find the correct solution by going downhill from there. Don't try to
 use this if you don't have a reasonably good guess already. For \e convex 
-implicit surfaces you can use estimateConvexImplicitPairContactUsingMPR() to 
-get a good start if the surfaces are in contact.
+implicit surfaces you can use estimateConvexImplicitPairContactUsingGJK() or
+estimateConvexImplicitPairContactUsingMPR() to get a good start if the 
+surfaces are in contact.
 
 @returns \c true if the requested accuracy is achieved but returns its best
 attempt at the refined points regardless. **/
@@ -163,6 +164,58 @@ static bool estimateConvexImplicitPairContactUsingMPR
     Vec3& pointP_A, Vec3& pointQ_B, UnitVec3& dirInA,
     int& numIterations);
 
+/** Use GJK (Gilbert, Johnson & Keerthi) on the support functions of two 
+\e convex shapes to generate a reasonably good starting estimate of their
+contact points, switching to the Expanding Polytope Algorithm (EPA) if they
+overlap. Unlike MPR, this also finds the nearest points if the surfaces are
+separated but close. Returns \c false if the two shapes are definitely \e not
+in contact (a separating plane was found); in that case the returned direction
+is the separating plane normal and the points are the support points that
+prove separation. Otherwise there \e might be contact and the points are 
+estimates that you still have to refine. On entry \a simplex holds up to four 
+support directions (in A) to start from, typically those returned by the 
+previous call for the same pair, and \a simplexSize says how many; pass zero
+to start from scratch. On return they hold the directions to start from next
+time. **/
+static bool estimateConvexImplicitPairContactUsingGJK
+   (const ContactGeometry& shapeA, const ContactGeometry& shapeB, 
+    const Transform& X_AB, UnitVec3 simplex[4], int& simplexSize,
+    Vec3& pointP_A, Vec3& pointQ_B, UnitVec3& dirInA,
+    int& numIterations);
+
+/** Return a lower bound on the distance separating two surfaces of any
+types, which is exact or nearly so for the common cases: half spaces against
+meshes and finite convex shapes, spheres against spheres and meshes, and 
+pairs of finite convex shapes (using GJK, to within \a accuracy). Other pairs
+fall back on one surface's bounding sphere, which may underestimate the 
+separation badly but never overestimates it. A result of zero or less means 
+the surfaces may be touching; it says nothing about how deeply. **/
+static Real calcSeparationLowerBound
+   (const Transform& X_GS1, const ContactGeometry& surface1,
+    const Transform& X_GS2, const ContactGeometry& surface2,
+    Real accuracy);
+
+/** Use conservative advancement to find the earliest time at which two 
+moving surfaces could come within \a tolerance of one another, for use in 
+preventing fast surfaces from passing through thin ones during a single time
+step. Each surface S is assumed to move with constant spatial velocity V_GS, 
+that is, its origin moves at constant velocity while the surface spins about 
+it at constant angular velocity. The separation lower bound from 
+calcSeparationLowerBound() divided by a bound on the speed of approach of any
+two surface points is a time during which the surfaces can't touch, so we
+advance by that repeatedly. 
+
+@returns \c true if the surfaces may come within \a tolerance of each other 
+no later than \a maxTime, with \a timeOfImpact set to a time that is no 
+later than that happens. Returns \c false if they can't, or if a spinning
+unbounded surface (a half space, say) makes their approach unbounded. **/
+static bool calcTimeOfImpact
+   (const Transform& X_GS1, const SpatialVec& V_GS1, 
+    const ContactGeometry& surface1,
+    const Transform& X_GS2, const SpatialVec& V_GS2, 
+    const ContactGeometry& surface2,
+    Real maxTime, Real tolerance, Real& timeOfImpact, int& numIterations);
+
 
 //--------------------------------------------------------------------------
                                 private:
@@ -294,9 +347,9 @@ private:
 void processBox(const ContactGeometry::TriangleMesh&              mesh, 
                 const ContactGeometry::TriangleMesh::OBBTreeNode& node, 
                 const Transform& X_HM, const UnitVec3& hsNormal_M, 
-                Real hsFaceHeight_M, std::set<int>& insideFaces) const;
+                Real hsFaceHeight_M, MeshFaceSet& insideFaces) const;
 void addAllTriangles(const ContactGeometry::TriangleMesh::OBBTreeNode& node, 
-                     std::set<int>& insideFaces) const; 
+                     MeshFaceSet& insideFaces) const; 
 };
 
 
@@ -327,7 +380,7 @@ void processBox
    (const ContactGeometry::TriangleMesh&              mesh, 
     const ContactGeometry::TriangleMesh::OBBTreeNode& node, 
     const Vec3& center_M, Real radius2,   
-    std::set<int>& insideFaces) const ;
+    MeshFaceSet& insideFaces) const ;
 };
 
 
@@ -357,22 +410,19 @@ private:
 void findIntersectingFaces
    (const ContactGeometry::TriangleMesh&                mesh1, 
     const ContactGeometry::TriangleMesh&                mesh2,
-    const ContactGeometry::TriangleMesh::OBBTreeNode&   node1, 
-    const ContactGeometry::TriangleMesh::OBBTreeNode&   node2, 
-    const OrientedBoundingBox&                          node2Bounds_M1,
     const Transform&                                    X_M1M2, 
-    std::set<int>&                                      insideFaces1, 
-    std::set<int>&                                      insideFaces2) const; 
+    MeshFaceSet&                                        insideFaces1, 
+    MeshFaceSet&                                        insideFaces2) const; 
 
 void findBuriedFaces
    (const ContactGeometry::TriangleMesh&    mesh,
     const ContactGeometry::TriangleMesh&    otherMesh,
     const Transform&                        X_OM, 
-    std::set<int>&                          insideFaces) const;
+    MeshFaceSet&                            insideFaces) const;
 
 void tagFaces(const ContactGeometry::TriangleMesh&   mesh, 
               Array_<int>&                           faceType,
-              std::set<int>&                         triangles, 
+              MeshFaceSet&                           triangles, 
               int                                    index,
               int                                    depth) const;
 };
@@ -0,0 +1,117 @@
+#ifndef SimTK_SIMMATH_MESH_FACE_SET_H_
+#define SimTK_SIMMATH_MESH_FACE_SET_H_
+
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/internal/common.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace SimTK {
+
+/** A set of face indices of a triangle mesh, kept as a bit mask with one bit
+per face of the mesh along with a list of the faces in the set. Membership 
+tests and insertions are constant time, and iterating over the set is a 
+linear scan of the list. Unlike std::set<int> nothing is allocated as faces 
+are added once the set has been sized for its mesh, and reset() for a mesh 
+no larger than any seen before also reuses the existing memory, so a set 
+that is kept around as workspace stops allocating after its first use.
+
+Faces are listed in the order they were inserted; call sortFaces() to put 
+them in ascending order. **/
+class MeshFaceSet {
+public:
+    typedef Array_<int>::const_iterator const_iterator;
+
+    /** Create an empty set that has no room for any faces; call reset() to
+    size it for a mesh. **/
+    MeshFaceSet() : m_numMeshFaces(0) {}
+    /** Create an empty set for a mesh with the given number of faces. **/
+    explicit MeshFaceSet(int numMeshFaces) : m_numMeshFaces(0) 
+    {   reset(numMeshFaces); }
+
+    /** Empty the set and size it for a mesh with the given number of faces.
+    The cost is proportional to the number of faces that were in the set, 
+    not the number in the mesh, unless the mask has to grow. **/
+    void reset(int numMeshFaces) {
+        assert(numMeshFaces >= 0);
+        clear();
+        const unsigned numWords = (unsigned)(numMeshFaces+31)/32;
+        if (numWords > m_mask.size())
+            m_mask.resize(numWords, 0u);
+        m_numMeshFaces = numMeshFaces;
+    }
+
+    /** Remove all the faces, keeping the mesh size. **/
+    void clear() {
+        for (unsigned i=0; i < m_faces.size(); ++i)
+            m_mask[m_faces[i] >> 5] = 0u;
+        m_faces.clear();
+    }
+
+    /** The number of faces in the mesh this set was sized for. **/
+    int getNumMeshFaces() const {return m_numMeshFaces;}
+
+    /** Add a face to the set if it isn't already there. Returns true if the
+    face was added. **/
+    bool insert(int face) {
+        assert(0 <= face && face < m_numMeshFaces);
+        unsigned& word = m_mask[face >> 5];
+        const unsigned bit = 1u << (face & 31);
+        if (word & bit)
+            return false;
+        word |= bit;
+        m_faces.push_back(face);
+        return true;
+    }
+
+    /** Return true if the given face is in the set. **/
+    bool contains(int face) const {
+        assert(0 <= face && face < m_numMeshFaces);
+        return (m_mask[face >> 5] & (1u << (face & 31))) != 0;
+    }
+
+    /** Put the list of faces in ascending order. **/
+    void sortFaces() {std::sort(m_faces.begin(), m_faces.end());}
+
+    bool empty() const {return m_faces.empty();}
+    int size() const {return (int)m_faces.size();}
+    /** Get the i'th face in the list, 0 <= i < size(). **/
+    int operator[](int i) const {return m_faces[i];}
+    /** Get the list of faces in the set. **/
+    const Array_<int>& getFaces() const {return m_faces;}
+    const_iterator begin() const {return m_faces.begin();}
+    const_iterator end() const {return m_faces.end();}
+
+private:
+    Array_<unsigned>    m_mask;     // one bit per face, 32 per word
+    Array_<int>         m_faces;    // the faces whose bits are set
+    int                 m_numMeshFaces;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMMATH_MESH_FACE_SET_H_
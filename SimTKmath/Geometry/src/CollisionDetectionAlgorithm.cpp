@@ -31,6 +31,13 @@ using std::set;
 
 namespace SimTK {
 
+// Per-thread workspace for the sets of inside faces, as in ContactTracker.
+static MeshFaceSet& updFaceWorkspace(int which, int numMeshFaces) {
+    static thread_local MeshFaceSet workspace[2];
+    workspace[which].reset(numMeshFaces);
+    return workspace[which];
+}
+
 //==============================================================================
 //                        COLLISION DETECTION ALGORITHM
 //==============================================================================
@@ -224,20 +231,20 @@ void CollisionDetectionAlgorithm::HalfSpaceTriangleMesh::processObjects
         ContactGeometry::TriangleMesh::getAs(object2);
     // Transform giving mesh (S2) frame in the halfspace (S1) frame.
     const Transform X_HM = (~X_GH)*X_GM; 
-    set<int> insideFaces;
+    MeshFaceSet& insideFaces = updFaceWorkspace(0, mesh.getNumFaces());
     Vec3 axisDir = ~X_HM.R()*Vec3(-1, 0, 0);
     Real xoffset = ~axisDir*(~X_HM*Vec3(0));
     processBox(mesh, mesh.getOBBTreeNode(), X_HM, axisDir, xoffset, insideFaces);
     if (insideFaces.size() > 0)
         contacts.push_back(TriangleMeshContact(index1, index2, X_HM, 
-                                               set<int>(), insideFaces));
+                                               MeshFaceSet(), insideFaces));
 }
 
 void CollisionDetectionAlgorithm::HalfSpaceTriangleMesh::processBox
    (const ContactGeometry::TriangleMesh&              mesh, 
     const ContactGeometry::TriangleMesh::OBBTreeNode& node, 
     const Transform& X_HM, const Vec3& axisDir, Real xoffset, 
-    set<int>& insideFaces) const 
+    MeshFaceSet& insideFaces) const 
 {   // First check against the node's bounding box.
     
     OrientedBoundingBox bounds = node.getBounds();
@@ -262,7 +269,7 @@ void CollisionDetectionAlgorithm::HalfSpaceTriangleMesh::processBox
     
     // Check the triangles.
     
-    const Array_<int>& triangles = node.getTriangles();
+    const ArrayViewConst_<int> triangles = node.getTriangles();
     const Row3 xdir = X_HM.R().row(0);
     const Real tx = X_HM.p()[0];
     for (int i = 0; i < (int) triangles.size(); i++) {
@@ -277,10 +284,10 @@ void CollisionDetectionAlgorithm::HalfSpaceTriangleMesh::processBox
 
 void CollisionDetectionAlgorithm::HalfSpaceTriangleMesh::addAllTriangles
    (const ContactGeometry::TriangleMesh::OBBTreeNode& node, 
-    std::set<int>& insideFaces) const 
+    MeshFaceSet& insideFaces) const 
 {
     if (node.isLeafNode()) {
-        const Array_<int>& triangles = node.getTriangles();
+        const ArrayViewConst_<int> triangles = node.getTriangles();
         for (int i = 0; i < (int) triangles.size(); i++)
             insideFaces.insert(triangles[i]);
     }
@@ -310,19 +317,19 @@ void CollisionDetectionAlgorithm::SphereTriangleMesh::processObjects
     const Transform X_SM = ~X_GS*X_GM;
     // Want the sphere center measured and expressed in the mesh frame.
     const Vec3 p_MC = (~X_SM).p();
-    set<int> insideFaces;
+    MeshFaceSet& insideFaces = updFaceWorkspace(0, mesh.getNumFaces());
     processBox(p_MC, sphere.getRadius()*sphere.getRadius(), 
                mesh, mesh.getOBBTreeNode(), insideFaces);
     if (insideFaces.size() > 0)
         contacts.push_back(TriangleMeshContact(index1, index2, X_SM,
-                                               set<int>(), insideFaces));
+                                               MeshFaceSet(), insideFaces));
 }
 
 void CollisionDetectionAlgorithm::SphereTriangleMesh::processBox
    (const Vec3& center, Real radius2, 
     const ContactGeometry::TriangleMesh& mesh, 
     const ContactGeometry::TriangleMesh::OBBTreeNode& node, 
-    set<int>& insideFaces) const 
+    MeshFaceSet& insideFaces) const 
 {   // First check against the node's bounding box.
 
     Vec3 nearestPoint = node.getBounds().findNearestPoint(center);
@@ -339,7 +346,7 @@ void CollisionDetectionAlgorithm::SphereTriangleMesh::processBox
     
     // Check the triangles.
     
-    const Array_<int>& triangles = node.getTriangles();
+    const ArrayViewConst_<int> triangles = node.getTriangles();
     for (int i = 0; i < (int) triangles.size(); i++) {
         Vec2 uv;
         Vec3 nearestPoint = mesh.findNearestPointToFace
@@ -369,8 +376,8 @@ processObjects
 
     // Get mesh2's frame measured and expressed in mesh1's frame.
     const Transform X_M1M2 = (~X_GM1)*X_GM2; 
-    set<int> triangles1;
-    set<int> triangles2;
+    MeshFaceSet& triangles1 = updFaceWorkspace(0, mesh1.getNumFaces());
+    MeshFaceSet& triangles2 = updFaceWorkspace(1, mesh2.getNumFaces());
     OrientedBoundingBox mesh2Bounds = X_M1M2*mesh2.getOBBTreeNode().getBounds();
     processNodes(mesh1, mesh2, mesh1.getOBBTreeNode(), mesh2.getOBBTreeNode(), 
                  mesh2Bounds, X_M1M2, triangles1, triangles2);
@@ -393,8 +400,8 @@ processNodes
     const ContactGeometry::TriangleMesh::OBBTreeNode&   node2, 
     const OrientedBoundingBox&                          node2Bounds,
     const Transform&                                    X_M1M2, 
-    set<int>&                                           triangles1, 
-    set<int>&                                           triangles2) const 
+    MeshFaceSet&                                        triangles1, 
+    MeshFaceSet&                                        triangles2) const 
 {   // See if the bounding boxes intersect.
     
     if (!node1.getBounds().intersectsBox(node2Bounds))
@@ -427,8 +434,8 @@ processNodes
     
     // These are both leaf nodes, so check triangles for intersections.
     
-    const Array_<int>& node1triangles = node1.getTriangles();
-    const Array_<int>& node2triangles = node2.getTriangles();
+    const ArrayViewConst_<int> node1triangles = node1.getTriangles();
+    const ArrayViewConst_<int> node2triangles = node2.getTriangles();
     for (int i = 0; i < (int) node2triangles.size(); i++) {
         Vec3 a1 = X_M1M2*mesh2.getVertexPosition(mesh2.getFaceVertex(node2triangles[i], 0));
         Vec3 a2 = X_M1M2*mesh2.getVertexPosition(mesh2.getFaceVertex(node2triangles[i], 1));
@@ -452,13 +459,14 @@ void CollisionDetectionAlgorithm::TriangleMeshTriangleMesh::
 findInsideTriangles(const ContactGeometry::TriangleMesh&    mesh,       // M 
                     const ContactGeometry::TriangleMesh&    otherMesh,  // O
                     const Transform&                        X_OM, 
-                    set<int>&                               triangles) const 
+                    MeshFaceSet&                            triangles) const 
 {   // Find which triangles are inside.
     const int Unknown = UNKNOWN; // work around gcc bug
-    Array_<int> faceType(mesh.getNumFaces(), Unknown);
-    for (set<int>::iterator iter = triangles.begin(); 
-                            iter != triangles.end(); ++iter)
-        faceType[*iter] = BOUNDARY;
+    static thread_local Array_<int> faceType; // reused like the face sets
+    faceType.clear();
+    faceType.resize(mesh.getNumFaces(), Unknown);
+    for (int i = 0; i < triangles.size(); i++)
+        faceType[triangles[i]] = BOUNDARY;
 
     for (int i = 0; i < (int) faceType.size(); i++) {
         if (faceType[i] == UNKNOWN) {
@@ -493,7 +501,7 @@ static const int MaxRecursionDepth = 500;
 void CollisionDetectionAlgorithm::TriangleMeshTriangleMesh::
 tagFaces(const ContactGeometry::TriangleMesh&   mesh, 
          Array_<int>&                           faceType,
-         set<int>&                              triangles, 
+         MeshFaceSet&                           triangles, 
          int                                    index,
          int                                    depth) const 
 {
@@ -27,6 +27,7 @@
 
 #include "ContactImpl.h"
 
+#include <algorithm>
 #include <set>
 
 using namespace SimTK;
@@ -226,6 +227,20 @@ bool BrickHalfSpaceContact::isInstance(const Contact& contact) {
 //==============================================================================
 //                      TRIANGLE MESH CONTACT & IMPL
 //==============================================================================
+TriangleMeshContact::TriangleMeshContact
+   (ContactSurfaceIndex surf1, ContactSurfaceIndex surf2,
+    const Transform& X_S1S2,
+    const MeshFaceSet& faces1, const MeshFaceSet& faces2) 
+:   Contact(new TriangleMeshContactImpl(surf1, surf2, X_S1S2, 
+                                        faces1, faces2)) {}
+
+TriangleMeshContact::TriangleMeshContact
+   (ContactSurfaceIndex surf1, ContactSurfaceIndex surf2,
+    const Transform& X_S1S2,
+    const Array_<int>& faceList1, const Array_<int>& faceList2) 
+:   Contact(new TriangleMeshContactImpl(surf1, surf2, X_S1S2, 
+                                        faceList1, faceList2)) {}
+
 TriangleMeshContact::TriangleMeshContact
    (ContactSurfaceIndex surf1, ContactSurfaceIndex surf2,
     const Transform& X_S1S2,
@@ -233,10 +248,15 @@ TriangleMeshContact::TriangleMeshContact
 :   Contact(new TriangleMeshContactImpl(surf1, surf2, X_S1S2, 
                                         faces1, faces2)) {}
 
+const Array_<int>& TriangleMeshContact::getSurface1FaceList() const 
+{   return getImpl().faceList1; }
+const Array_<int>& TriangleMeshContact::getSurface2FaceList() const 
+{   return getImpl().faceList2; }
+
 const set<int>& TriangleMeshContact::getSurface1Faces() const 
-{   return getImpl().faces1; }
+{   return getImpl().getFaceSet1(); }
 const set<int>& TriangleMeshContact::getSurface2Faces() const 
-{   return getImpl().faces2; }
+{   return getImpl().getFaceSet2(); }
 
 /*static*/ bool TriangleMeshContact::isInstance(const Contact& contact) 
 {   return (dynamic_cast<const TriangleMeshContactImpl*>(&contact.getImpl())
@@ -245,11 +265,48 @@ const set<int>& TriangleMeshContact::getSurface2Faces() const
 /*static*/ ContactTypeId TriangleMeshContact::classTypeId() 
 {   return TriangleMeshContactImpl::classTypeId(); }
 
+TriangleMeshContactImpl::TriangleMeshContactImpl
+   (ContactSurfaceIndex surf1, ContactSurfaceIndex surf2,
+    const Transform& X_S1S2,
+    const MeshFaceSet& faces1, const MeshFaceSet& faces2) 
+:   ContactImpl(surf1, surf2, X_S1S2), 
+    faceList1(faces1.begin(), faces1.end()), 
+    faceList2(faces2.begin(), faces2.end()) {
+    std::sort(faceList1.begin(), faceList1.end());
+    std::sort(faceList2.begin(), faceList2.end());
+}
+
+TriangleMeshContactImpl::TriangleMeshContactImpl
+   (ContactSurfaceIndex surf1, ContactSurfaceIndex surf2,
+    const Transform& X_S1S2,
+    const Array_<int>& faceList1, const Array_<int>& faceList2) 
+:   ContactImpl(surf1, surf2, X_S1S2), 
+    faceList1(faceList1), faceList2(faceList2) {}
+
+// A std::set is already in ascending order.
 TriangleMeshContactImpl::TriangleMeshContactImpl
    (ContactSurfaceIndex surf1, ContactSurfaceIndex surf2,
     const Transform& X_S1S2,
     const set<int>& faces1, const set<int>& faces2) 
-:   ContactImpl(surf1, surf2, X_S1S2), faces1(faces1), faces2(faces2) {}
+:   ContactImpl(surf1, surf2, X_S1S2), 
+    faceList1(faces1.begin(), faces1.end()), 
+    faceList2(faces2.begin(), faces2.end()) {}
+
+void TriangleMeshContactImpl::buildFaceSets() const {
+    faces1.insert(faceList1.begin(), faceList1.end());
+    faces2.insert(faceList2.begin(), faceList2.end());
+}
+
+// Contacts may be shared between threads, so make sure only one builds the
+// sets.
+const set<int>& TriangleMeshContactImpl::getFaceSet1() const {
+    std::call_once(facesBuilt, &TriangleMeshContactImpl::buildFaceSets, this);
+    return faces1;
+}
+const set<int>& TriangleMeshContactImpl::getFaceSet2() const {
+    std::call_once(facesBuilt, &TriangleMeshContactImpl::buildFaceSets, this);
+    return faces2;
+}
 
 
 
@@ -33,6 +33,8 @@
 #include "simmath/internal/ContactGeometry.h"
 
 #include <limits>
+#include <mutex>
+#include <utility>
 
 namespace SimTK {
 
@@ -846,6 +848,51 @@ private:
 
 
 
+//==============================================================================
+//                           HEIGHT MAP PYRAMID
+//==============================================================================
+// A min/max mip-map over the patches of a BicubicSurface. Level 0 has one cell
+// per patch, holding bounds on the height of that patch taken from its Bezier
+// control points; the patch lies within their convex hull. Each cell of level
+// k+1 bounds the 2x2 block of level k cells beneath it, so the top level is a 
+// single cell bounding the whole surface. Bounds are kept in single precision,
+// rounded outward. See ContactGeometry_SmoothHeightMap.cpp.
+class HeightMapPyramid {
+public:
+    HeightMapPyramid() {}
+
+    void build(const BicubicSurface& surface);
+
+    int getNumLevels() const {return (int)levelStart.size();}
+    const Vec2& getLow()  const {return low;}
+    const Vec2& getHigh() const {return high;}
+
+    // Bounds on the height of the whole surface.
+    Real getMinHeight() const {return minHeight.back();}
+    Real getMaxHeight() const {return maxHeight.back();}
+
+    // Find bounds on the height of the surface over the part of the given
+    // rectangle that is within the surface's boundary. Returns false if the
+    // rectangle misses the surface altogether. This picks the level at which 
+    // the rectangle spans no more than two cells each way, so it reads at
+    // most four cells however large the rectangle is.
+    bool findHeightBounds(const Vec2& lowXY, const Vec2& highXY,
+                          Real& minZ, Real& maxZ) const;
+
+private:
+    // Which patch along one axis contains the given coordinate, which must
+    // be within [edges.front(), edges.back()].
+    static int findPatch(const Array_<Real>& edges, Real x);
+
+    Vec2            low, high;      // the surface's xy boundary
+    Array_<Real>    xEdges, yEdges; // patch boundaries, nx+1 and ny+1
+    Array_<int>     nx, ny;         // cells in each level
+    Array_<int>     levelStart;     // first cell of each level
+    Array_<float>   minHeight, maxHeight; // all levels, row by row
+};
+
+
+
 class ContactGeometry::SmoothHeightMap::Impl : public ContactGeometryImpl {
 public:
     explicit Impl(const BicubicSurface& surface);
@@ -857,6 +904,11 @@ public:
     const BicubicSurface& getBicubicSurface() const {return surface;}
     BicubicSurface::PatchHint& updHint() const {return hint;}
 
+    // The OBB tree is big and slow to build for a large surface, so it
+    // isn't built until someone asks for it.
+    const OBBTree& getOBBTree() const;
+    const HeightMapPyramid& getPyramid() const {return pyramid;}
+
     ContactGeometryTypeId getTypeId() const override {return classTypeId();}
 
     DecorativeGeometry createDecorativeGeometry() const override;
@@ -899,6 +951,7 @@ public:
     }
 private:
     void createBoundingVolumes();
+    void createOBBTree();
     // The given OBBNode is assigned this range of patches. If there is
     // more than one patch in the range, it will dole those out to its
     // children recursively until the leaves each have responsibility for
@@ -919,6 +972,9 @@ private:
     mutable BicubicSurface::PatchHint   hint;
     Geo::Sphere                         boundingSphere;
     SmoothHeightMapImplicitFunction     implicitFunction;
+    HeightMapPyramid                    pyramid;
+    mutable std::mutex                  obbTreeLock;
+    mutable bool                        hasOBBTree;
 };
 
 
@@ -977,25 +1033,113 @@ private:
 
 
 //==============================================================================
-//                            OBB TREE NODE IMPL
+//                               OBB TREE IMPL
 //==============================================================================
-class OBBTreeNodeImpl {
+// The OBB tree of a TriangleMesh, kept in a single array of nodes in depth
+// first order so that a traversal walks through memory rather than chasing
+// pointers around the heap. A node's first child immediately follows it, so 
+// only the index of the second child is stored; that is zero for a leaf since
+// the root can't be anyone's child. The mesh faces are reordered so that the 
+// faces under any node are contiguous in faceOrder; a node just records its
+// range.
+//
+// To keep the nodes small the box orientation is stored as a float 
+// quaternion, and the box extents as floats measured along the axes of that
+// rounded orientation. The extents are rounded outward so the box we 
+// reconstruct from a node still encloses all of its faces.
+class OBBTreeImpl {
 public:
-    OBBTreeNodeImpl() : child1(NULL), child2(NULL), numTriangles(0) {
-    }
-    OBBTreeNodeImpl(const OBBTreeNodeImpl& copy);
-    ~OBBTreeNodeImpl();
-    OrientedBoundingBox bounds;
-    OBBTreeNodeImpl* child1;
-    OBBTreeNodeImpl* child2;
-    Array_<int> triangles;
-    int numTriangles;
+    struct Node {
+        float   q[4];           // box orientation in the mesh frame
+        float   lo[3], hi[3];   // box extent along each of the box axes
+        int     secondChild;    // 0 for a leaf node
+        int     firstFace;      // this node's range of faceOrder
+        int     numFaces;
+    };
+
+    int getNumNodes() const {return (int)nodes.size();}
+    bool isLeaf(int n) const {return nodes[n].secondChild == 0;}
+    int getFirstChild(int n) const {return n+1;}
+    int getSecondChild(int n) const {return nodes[n].secondChild;}
+    int getNumFaces(int n) const {return nodes[n].numFaces;}
+    const int* getFaces(int n) const 
+    {   return faceOrder.cbegin() + nodes[n].firstFace; }
+
+    // Unpack the box for node n, expressed in the mesh frame.
+    OrientedBoundingBox getBounds(int n) const;
+
+    // Cheaper versions of the OrientedBoundingBox queries that work directly
+    // on the packed box: the squared distance from a point to the box (zero
+    // if inside), and the distance along a ray to where it enters the box.
+    Real findDistance2(int n, const Vec3& position) const;
+    bool intersectsRay(int n, const Vec3& origin, const UnitVec3& direction,
+                       Real& distance) const;
+
+    // Re-express a mesh frame vector along the axes of node n's box.
+    static Vec3 toBoxFrame(const Node& node, const Vec3& v);
+
+    // Append a new node enclosing the given points, which must be all the
+    // vertices of its faces, and return the box that was actually stored.
+    // The caller must fill in the face range and children.
+    OrientedBoundingBox addNode(const Vector_<Vec3>& points);
+
     Vec3 findNearestPoint(const ContactGeometry::TriangleMesh::Impl& mesh, 
-                          const Vec3& position, Real cutoff2, Real& distance2, 
-                          int& face, Vec2& uv) const;
+                          int n, const Vec3& position, Real cutoff2, 
+                          Real& distance2, int& face, Vec2& uv) const;
     bool intersectsRay(const ContactGeometry::TriangleMesh::Impl& mesh, 
-                       const Vec3& origin, const UnitVec3& direction, 
+                       int n, const Vec3& origin, const UnitVec3& direction, 
                        Real& distance, int& face, Vec2& uv) const;
+
+    // Append to leafPairs every pair (leaf of this tree, leaf of other) whose
+    // boxes overlap, given X_MO locating the other tree's mesh frame in this
+    // one's. The boxes are compared with the separating axis test, several
+    // pairs at a time where SIMD is available. See OBBTreeOverlap.cpp.
+    void findOverlappingLeaves(const OBBTreeImpl& other, const Transform& X_MO,
+                               Array_< std::pair<int,int> >& leafPairs) const;
+
+    Array_<Node>    nodes;
+    Array_<int>     faceOrder;
+};
+
+
+
+//==============================================================================
+//                            DISTANCE FIELD IMPL
+//==============================================================================
+// An optional sparse signed distance field for a TriangleMesh, sampled at the
+// vertices of a uniform grid of cubical cells that covers the mesh with a
+// margin. The grid is divided into blocks of BlockSize^3 cells. Blocks near
+// the surface store the exact signed distance at each of their vertices, in
+// single precision; every other block lies entirely on one side of the
+// surface and stores only the signed distance of its center. See
+// TriangleMeshDistanceField.cpp.
+class DistanceFieldImpl {
+public:
+    static const int BlockSize = 8;
+
+    DistanceFieldImpl() : cellSize(0), farError(0) 
+    {   numBlocks[0] = numBlocks[1] = numBlocks[2] = 0; }
+
+    bool isEmpty() const {return blocks.empty();}
+    Real getCellSize() const {return cellSize;}
+    void clear();
+
+    // Sample the signed distance of the given mesh, which must already have
+    // its OBB tree.
+    void build(const ContactGeometry::TriangleMesh::Impl& mesh, Real cellSize);
+
+    // Return false if there is no field or the position is outside it.
+    // Otherwise the true signed distance is within maxError of distance.
+    bool estimateSignedDistance(const Vec3& position, Real& distance, 
+                                Real& maxError) const;
+
+    Vec3            origin;         // grid corner, in the mesh frame
+    Real            cellSize;
+    Real            farError;       // error bound for a far block
+    int             numBlocks[3];
+    Array_<int>     blocks;         // first sample, or -1 for a far block
+    Array_<float>   farDistance;    // signed distance of each block's center
+    Array_<float>   samples;        // (BlockSize+1)^3 for each near block
 };
 
 
@@ -1010,8 +1154,10 @@ public:
     class Vertex;
 
     Impl(const ArrayViewConst_<Vec3>& vertexPositions, 
-         const ArrayViewConst_<int>& faceIndices, bool smooth);
-    Impl(const PolygonalMesh& mesh, bool smooth);
+         const ArrayViewConst_<int>& faceIndices, bool smooth,
+         const OBBTreeOptions& options);
+    Impl(const PolygonalMesh& mesh, bool smooth, 
+         const OBBTreeOptions& options);
     ContactGeometryImpl* clone() const override {
         return new Impl(*this);
     }
@@ -1039,6 +1185,10 @@ public:
     bool isConvex() const override {return false;}
     bool isFinite() const override {return true;}
 
+    const OBBTreeImpl& getOBBTree() const {return obb;}
+
+    void createDistanceField(Real cellSize) {field.build(*this, cellSize);}
+    const DistanceFieldImpl& getDistanceField() const {return field;}
 
     static ContactGeometryTypeId classTypeId() {
         static const ContactGeometryTypeId id = 
@@ -1046,22 +1196,48 @@ public:
         return id;
     }
 private:
-    void init(const Array_<Vec3>& vertexPositions, const Array_<int>& faceIndices);
-    void createObbTree(OBBTreeNodeImpl& node, const Array_<int>& faceIndices);
+    class ObbSubtreeTask;
+
+    void init(const Array_<Vec3>& vertexPositions, const Array_<int>& faceIndices,
+              const OBBTreeOptions& options);
+    void buildObbTree(const OBBTreeOptions& options);
+    void createObbTree(OBBTreeImpl& tree, const Array_<int>& faceIndices,
+                       OBBTreeOptions::SplitMethod method) const;
+    void createObbTreeInParallel(const Array_<int>& faceIndices,
+                                 OBBTreeOptions::SplitMethod method,
+                                 int numThreads);
+    OrientedBoundingBox addObbNode(OBBTreeImpl& tree, 
+                                   const Array_<int>& faceIndices) const;
+    bool splitObbNode(const Array_<int>& faceIndices, 
+                      const OrientedBoundingBox& bounds,
+                      OBBTreeOptions::SplitMethod method,
+                      Array_<int>& child1Indices, 
+                      Array_<int>& child2Indices) const;
     void splitObbAxis(const Array_<int>& parentIndices, 
                       Array_<int>& child1Indices, 
-                      Array_<int>& child2Indices, int axis);
+                      Array_<int>& child2Indices, int axis) const;
+    bool splitObbSurfaceArea(const Array_<int>& parentIndices, 
+                             const OrientedBoundingBox& bounds,
+                             Array_<int>& child1Indices, 
+                             Array_<int>& child2Indices) const;
+    unsigned long long calcObbTreeKey(OBBTreeOptions::SplitMethod method) const;
+    bool loadObbTree(const std::string& pathname, 
+                     unsigned long long key);
+    void saveObbTree(const std::string& pathname, 
+                     unsigned long long key) const;
     void findBoundingSphere(Vec3* point[], int p, int b, 
                             Vec3& center, Real& radius);
     friend class ContactGeometry::TriangleMesh;
-    friend class OBBTreeNodeImpl;
+    friend class OBBTreeImpl;
+    friend class DistanceFieldImpl;
 
     Array_<Edge>    edges;
     Array_<Face>    faces;
     Array_<Vertex>  vertices;
     Vec3            boundingSphereCenter;
     Real            boundingSphereRadius;
-    OBBTreeNodeImpl obb;
+    OBBTreeImpl     obb;
+    DistanceFieldImpl field;
     bool            smooth;
 };
 
@@ -32,8 +32,10 @@
 
 #include "ContactGeometryImpl.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <limits>
 #include <map>
 #include <set>
 
@@ -45,6 +47,117 @@ using std::string;
 using std::cout; using std::endl;
 
 
+//==============================================================================
+//                           HEIGHT MAP PYRAMID
+//==============================================================================
+// Round a bound to single precision without letting it move inward.
+static float roundDown(Real x) {
+    float f = (float) x;
+    return f > x ? std::nextafter(f, -std::numeric_limits<float>::infinity())
+                 : f;
+}
+static float roundUp(Real x) {
+    float f = (float) x;
+    return f < x ? std::nextafter(f, std::numeric_limits<float>::infinity())
+                 : f;
+}
+
+void HeightMapPyramid::build(const BicubicSurface& surface) {
+    int nx0, ny0; surface.getNumPatches(nx0, ny0);
+    xEdges.resize(nx0+1); yEdges.resize(ny0+1);
+    nx.clear(); ny.clear(); levelStart.clear();
+    nx.push_back(nx0); ny.push_back(ny0); levelStart.push_back(0);
+
+    // Level 0 comes straight from the patches. Each patch's coefficients are
+    // calculated as it is visited and then discarded, so this never holds
+    // more than one patch at a time.
+    minHeight.resize(nx0*ny0); maxHeight.resize(nx0*ny0);
+    for (int i=0; i < nx0; ++i)
+        for (int j=0; j < ny0; ++j) {
+            const Geo::BicubicBezierPatch patch = surface.calcBezierPatch(i,j);
+            const Mat<4,4,Vec3>& B = patch.getControlPoints();
+            if (j==0) xEdges[i] = B(0,0)[0];
+            if (i==0) yEdges[j] = B(0,0)[1];
+            if (i==nx0-1 && j==ny0-1) 
+            {   xEdges[nx0] = B(3,3)[0]; yEdges[ny0] = B(3,3)[1]; }
+            Real lo = B(0,0)[2], hi = lo;
+            for (int m=0; m < 4; ++m)
+                for (int n=0; n < 4; ++n) {
+                    lo = std::min(lo, B(m,n)[2]);
+                    hi = std::max(hi, B(m,n)[2]);
+                }
+            minHeight[i*ny0+j] = roundDown(lo);
+            maxHeight[i*ny0+j] = roundUp(hi);
+        }
+    low  = Vec2(xEdges.front(), yEdges.front());
+    high = Vec2(xEdges.back(),  yEdges.back());
+
+    // Each higher level halves the cells each way, rounding up, until there
+    // is just one cell.
+    while (nx.back() > 1 || ny.back() > 1) {
+        const int k = (int)nx.size()-1;
+        const int cnx = nx[k], cny = ny[k], cstart = levelStart[k];
+        const int pnx = (cnx+1)/2, pny = (cny+1)/2;
+        const int pstart = (int)minHeight.size();
+        nx.push_back(pnx); ny.push_back(pny); levelStart.push_back(pstart);
+        minHeight.resize(pstart + pnx*pny); maxHeight.resize(pstart + pnx*pny);
+        for (int i=0; i < pnx; ++i)
+            for (int j=0; j < pny; ++j) {
+                float lo = std::numeric_limits<float>::infinity(), hi = -lo;
+                for (int ci=2*i; ci < std::min(2*i+2, cnx); ++ci)
+                    for (int cj=2*j; cj < std::min(2*j+2, cny); ++cj) {
+                        const int c = cstart + ci*cny + cj;
+                        lo = std::min(lo, minHeight[c]);
+                        hi = std::max(hi, maxHeight[c]);
+                    }
+                minHeight[pstart + i*pny + j] = lo;
+                maxHeight[pstart + i*pny + j] = hi;
+            }
+    }
+}
+
+// On a regular grid the first guess is always right; otherwise fall back to
+// a binary search of the interior edges.
+int HeightMapPyramid::findPatch(const Array_<Real>& edges, Real x) {
+    const int n = (int)edges.size()-1;
+    const int guess = std::max(0, std::min(n-1, 
+        (int)((x-edges[0])/(edges[n]-edges[0])*n)));
+    if (edges[guess] <= x && x <= edges[guess+1])
+        return guess;
+    return (int)(std::upper_bound(edges.begin()+1, edges.end()-1, x) 
+                 - edges.begin()) - 1;
+}
+
+bool HeightMapPyramid::findHeightBounds(const Vec2& lowXY, const Vec2& highXY,
+                                        Real& minZ, Real& maxZ) const {
+    if (levelStart.empty())
+        return false;
+    const Vec2 lo(std::max(lowXY[0], low[0]),   std::max(lowXY[1], low[1]));
+    const Vec2 hi(std::min(highXY[0], high[0]), std::min(highXY[1], high[1]));
+    if (!(lo[0] <= hi[0] && lo[1] <= hi[1])) // also catches NaN
+        return false;
+
+    int i0 = findPatch(xEdges, lo[0]), i1 = findPatch(xEdges, hi[0]);
+    int j0 = findPatch(yEdges, lo[1]), j1 = findPatch(yEdges, hi[1]);
+    int k = 0;
+    while (i1-i0 > 1 || j1-j0 > 1) {
+        i0 /= 2; i1 /= 2; j0 /= 2; j1 /= 2;
+        ++k;
+    }
+
+    float zlo = std::numeric_limits<float>::infinity(), zhi = -zlo;
+    for (int i=i0; i <= i1; ++i)
+        for (int j=j0; j <= j1; ++j) {
+            const int c = levelStart[k] + i*ny[k] + j;
+            zlo = std::min(zlo, minHeight[c]);
+            zhi = std::max(zhi, maxHeight[c]);
+        }
+    minZ = zlo; maxZ = zhi;
+    return true;
+}
+
+
+
 //==============================================================================
 //               CONTACT GEOMETRY :: SMOOTH HEIGHT MAP & IMPL
 //==============================================================================
@@ -63,6 +176,11 @@ getBicubicSurface() const {return getImpl().getBicubicSurface();}
 const OBBTree& ContactGeometry::SmoothHeightMap::
 getOBBTree() const {return getImpl().getOBBTree();}
 
+bool ContactGeometry::SmoothHeightMap::
+findHeightBounds(const Vec2& low, const Vec2& high, 
+                 Real& minZ, Real& maxZ) const 
+{   return getImpl().getPyramid().findHeightBounds(low, high, minZ, maxZ); }
+
 const ContactGeometry::SmoothHeightMap::Impl& ContactGeometry::SmoothHeightMap::
 getImpl() const {
     assert(impl);
@@ -78,13 +196,23 @@ updImpl() {
 // This is the main constructor.
 ContactGeometry::SmoothHeightMap::Impl::
 Impl(const BicubicSurface& surface) 
-:   surface(surface) { 
+:   surface(surface), hasOBBTree(false) { 
     implicitFunction.setOwner(*this); 
 
     createBoundingVolumes();
 
 }
 
+const OBBTree& ContactGeometry::SmoothHeightMap::Impl::
+getOBBTree() const {
+    std::lock_guard<std::mutex> lock(obbTreeLock);
+    if (!hasOBBTree) {
+        const_cast<Impl*>(this)->createOBBTree();
+        hasOBBTree = true;
+    }
+    return obbTree;
+}
+
 void ContactGeometry::SmoothHeightMap::Impl::
 assignPatch(const Geo::BicubicBezierPatch& patch, 
             OBBNode& node, int depth,
@@ -172,28 +300,27 @@ splitPatches(int x0,int y0, int nx, int ny,
 }
 
 void ContactGeometry::SmoothHeightMap::Impl::
-createBoundingVolumes() {
+createOBBTree() {
     // Temporarily convert the surface into a set of Bezier patches (using
     // a lot more memory than the original).
 
     int nx,ny; surface.getNumPatches(nx,ny);
     OBBNode& root = obbTree.updRoot();
     splitPatches(0,0,nx,ny,root,0);
+}
 
-
-    // Create bounding sphere.
-    // TODO: fake this using mesh; this needs to be done correctly instead
-    // by the BicubicSurface itself. Using 5 subdivisions per patch.
-    PolygonalMesh mesh = surface.createPolygonalMesh(5);
-
-    // Collect all the vertices.
-    const int n = mesh.getNumVertices();
-    Array_<const Vec3*> points(n);
-    for (int i=0; i<n; ++i)
-        points[i] = &mesh.getVertexPosition(i);
-    boundingSphere = Geo::Point::calcBoundingSphereIndirect(points);
-    // Add 10% as a hack to make it less likely we'll miss part of the surface.
-    boundingSphere.updRadius() *= Real(1.1);
+void ContactGeometry::SmoothHeightMap::Impl::
+createBoundingVolumes() {
+    pyramid.build(surface);
+
+    // The box over the surface's boundary that is bounded in z by the top of
+    // the pyramid contains the whole surface, so its circumscribed sphere 
+    // does too.
+    const Vec3 low (pyramid.getLow()[0],  pyramid.getLow()[1],  
+                    pyramid.getMinHeight());
+    const Vec3 high(pyramid.getHigh()[0], pyramid.getHigh()[1], 
+                    pyramid.getMaxHeight());
+    boundingSphere = Geo::Sphere((low+high)/2, (high-low).norm()/2);
 }
 
 DecorativeGeometry ContactGeometry::SmoothHeightMap::Impl::createDecorativeGeometry() const {
@@ -30,8 +30,12 @@
 
 #include "ContactGeometryImpl.h"
 
-#include <iostream>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
 #include <map>
 #include <set>
 
@@ -49,11 +53,23 @@ using std::cout; using std::endl;
 ContactGeometry::TriangleMesh::TriangleMesh
    (const ArrayViewConst_<Vec3>& vertices, 
     const ArrayViewConst_<int>& faceIndices, bool smooth) 
-:   ContactGeometry(new TriangleMesh::Impl(vertices, faceIndices, smooth)) {}
+:   ContactGeometry(new TriangleMesh::Impl(vertices, faceIndices, smooth,
+                                           OBBTreeOptions())) {}
 
 ContactGeometry::TriangleMesh::TriangleMesh
    (const PolygonalMesh& mesh, bool smooth) 
-:   ContactGeometry(new TriangleMesh::Impl(mesh, smooth)) {}
+:   ContactGeometry(new TriangleMesh::Impl(mesh, smooth, OBBTreeOptions())) {}
+
+ContactGeometry::TriangleMesh::TriangleMesh
+   (const ArrayViewConst_<Vec3>& vertices, 
+    const ArrayViewConst_<int>& faceIndices, bool smooth,
+    const OBBTreeOptions& options) 
+:   ContactGeometry(new TriangleMesh::Impl(vertices, faceIndices, smooth,
+                                           options)) {}
+
+ContactGeometry::TriangleMesh::TriangleMesh
+   (const PolygonalMesh& mesh, bool smooth, const OBBTreeOptions& options) 
+:   ContactGeometry(new TriangleMesh::Impl(mesh, smooth, options)) {}
 
 /*static*/ ContactGeometryTypeId ContactGeometry::TriangleMesh::classTypeId() 
 {   return ContactGeometry::TriangleMesh::Impl::classTypeId(); }
@@ -185,7 +201,24 @@ bool ContactGeometry::TriangleMesh::intersectsRay
 
 ContactGeometry::TriangleMesh::OBBTreeNode 
 ContactGeometry::TriangleMesh::getOBBTreeNode() const {
-    return OBBTreeNode(getImpl().obb);
+    return OBBTreeNode(getImpl().obb, 0);
+}
+
+void ContactGeometry::TriangleMesh::createDistanceField(Real cellSize) {
+    SimTK_APIARGCHECK1_ALWAYS(cellSize > 0, "ContactGeometry::TriangleMesh",
+        "createDistanceField", "The cell size must be positive but was %g.",
+        cellSize);
+    updImpl().createDistanceField(cellSize);
+}
+
+bool ContactGeometry::TriangleMesh::hasDistanceField() const {
+    return !getImpl().getDistanceField().isEmpty();
+}
+
+bool ContactGeometry::TriangleMesh::estimateSignedDistance
+   (const Vec3& position, Real& distance, Real& maxError) const {
+    return getImpl().getDistanceField()
+                    .estimateSignedDistance(position, distance, maxError);
 }
 
 PolygonalMesh ContactGeometry::TriangleMesh::createPolygonalMesh() const {
@@ -256,8 +289,16 @@ findNearestPoint(const Vec3& position, bool& inside, UnitVec3& normal) const {
 Vec3 ContactGeometry::TriangleMesh::Impl::
 findNearestPoint(const Vec3& position, bool& inside, int& face, Vec2& uv) const 
 {
+    // With a distance field we know how far away the nearest point can be,
+    // which lets the search skip every node that is farther away than that.
+    // The slop keeps a node at exactly that distance from being skipped.
+    Real cutoff2 = MostPositiveReal, estimate, maxError;
+    if (field.estimateSignedDistance(position, estimate, maxError))
+        cutoff2 = square((std::abs(estimate)+maxError)*(1+SqrtEps)) + TinyReal;
     Real distance2;
-    Vec3 nearestPoint = obb.findNearestPoint(*this, position, MostPositiveReal, distance2, face, uv);
+    Vec3 nearestPoint = obb.findNearestPoint(*this, 0, position, cutoff2, distance2, face, uv);
+    if (distance2 == MostPositiveReal) // shouldn't happen, but just in case
+        nearestPoint = obb.findNearestPoint(*this, 0, position, MostPositiveReal, distance2, face, uv);
     Vec3 delta = position-nearestPoint;
     inside = (~delta*faces[face].normal < 0);
     return nearestPoint;
@@ -278,9 +319,9 @@ bool ContactGeometry::TriangleMesh::Impl::
 intersectsRay(const Vec3& origin, const UnitVec3& direction, Real& distance, 
               int& face, Vec2& uv) const {
     Real boundsDistance;
-    if (!obb.bounds.intersectsRay(origin, direction, boundsDistance))
+    if (!obb.intersectsRay(0, origin, direction, boundsDistance))
         return false;
-    return obb.intersectsRay(*this, origin, direction, distance, face, uv);
+    return obb.intersectsRay(*this, 0, origin, direction, distance, face, uv);
 }
 
 void ContactGeometry::TriangleMesh::Impl::
@@ -302,13 +343,14 @@ createPolygonalMesh(PolygonalMesh& mesh) const {
 
 ContactGeometry::TriangleMesh::Impl::Impl
    (const ArrayViewConst_<Vec3>& vertexPositions, 
-    const ArrayViewConst_<int>& faceIndices, bool smooth) 
+    const ArrayViewConst_<int>& faceIndices, bool smooth,
+    const OBBTreeOptions& options) 
 :   ContactGeometryImpl(), smooth(smooth) {
-    init(vertexPositions, faceIndices);
+    init(vertexPositions, faceIndices, options);
 }
 
 ContactGeometry::TriangleMesh::Impl::Impl
-   (const PolygonalMesh& mesh, bool smooth) 
+   (const PolygonalMesh& mesh, bool smooth, const OBBTreeOptions& options) 
 :   ContactGeometryImpl(), smooth(smooth) 
 {   // Create the mesh, triangulating faces as necessary.
     Array_<Vec3>    vertexPositions;
@@ -354,7 +396,7 @@ ContactGeometry::TriangleMesh::Impl::Impl
             faceIndices.push_back(newIndex);
         }
     }
-    init(vertexPositions, faceIndices);
+    init(vertexPositions, faceIndices, options);
     
     // Make sure the mesh normals are oriented correctly.
     
@@ -373,7 +415,7 @@ ContactGeometry::TriangleMesh::Impl::Impl
     // face's normal will be pointing back at us. If it is wrong, the face 
     // normal will also be pointing inwards, in roughly the same direction as 
     // the ray.
-    origin -= max(obb.bounds.getSize())*direction;
+    origin -= max(obb.getBounds(0).getSize())*direction;
     Real distance;
     int face;
     Vec2 uv;
@@ -400,7 +442,8 @@ ContactGeometry::TriangleMesh::Impl::Impl
 }
 
 void ContactGeometry::TriangleMesh::Impl::init
-   (const Array_<Vec3>& vertexPositions, const Array_<int>& faceIndices) 
+   (const Array_<Vec3>& vertexPositions, const Array_<int>& faceIndices,
+    const OBBTreeOptions& options) 
 {   SimTK_APIARGCHECK_ALWAYS(faceIndices.size()%3 == 0, 
         "ContactGeometry::TriangleMesh::Impl", "TriangleMesh::Impl", 
         "The number of indices must be a multiple of 3.");
@@ -531,10 +574,7 @@ void ContactGeometry::TriangleMesh::Impl::init
     
     // Create the OBBTree.
     
-    Array_<int> allFaces(faces.size());
-    for (int i = 0; i < (int) allFaces.size(); i++)
-        allFaces[i] = i;
-    createObbTree(obb, allFaces);
+    buildObbTree(options);
     
     // Find the bounding sphere.
     Array_<const Vec3*> points(vertices.size());
@@ -545,26 +585,103 @@ void ContactGeometry::TriangleMesh::Impl::init
     boundingSphereRadius = bnd.getRadius();
 }
 
+// Below this many faces it isn't worth starting threads to build the tree.
+static const int MinFacesForThreads = 20000;
+
+void ContactGeometry::TriangleMesh::Impl::buildObbTree
+   (const OBBTreeOptions& options) 
+{
+    obb.nodes.clear();
+    obb.faceOrder.clear();
+    const std::string& cacheFile = options.getCacheFile();
+    const unsigned long long key = calcObbTreeKey(options.getSplitMethod());
+    if (!cacheFile.empty() && loadObbTree(cacheFile, key))
+        return;
+
+    Array_<int> allFaces(faces.size());
+    for (int i = 0; i < (int) allFaces.size(); i++)
+        allFaces[i] = i;
+    const int numThreads = options.getNumThreads() > 0 
+        ? options.getNumThreads() : ParallelExecutor::getNumProcessors();
+    if (   numThreads < 2 || (int) faces.size() < MinFacesForThreads
+        || ParallelExecutor::isWorkerThread())
+        createObbTree(obb, allFaces, options.getSplitMethod());
+    else
+        createObbTreeInParallel(allFaces, options.getSplitMethod(), 
+                                numThreads);
+
+    if (!cacheFile.empty())
+        saveObbTree(cacheFile, key);
+}
+
+// Nodes are appended to the tree in depth first order, and a leaf's faces 
+// are appended to faceOrder as the leaf is created, so every subtree ends up
+// owning a contiguous range of faceOrder that starts where it did when the 
+// subtree's root was added.
 void ContactGeometry::TriangleMesh::Impl::createObbTree
-   (OBBTreeNodeImpl& node, const Array_<int>& faceIndices) 
+   (OBBTreeImpl& tree, const Array_<int>& faceIndices, 
+    OBBTreeOptions::SplitMethod method) const
+{
+    const int node = tree.getNumNodes();
+    const OrientedBoundingBox bounds = addObbNode(tree, faceIndices);
+    tree.nodes[node].firstFace = (int)tree.faceOrder.size();
+    Array_<int> child1Indices, child2Indices;
+    if (splitObbNode(faceIndices, bounds, method, 
+                     child1Indices, child2Indices)) {
+        createObbTree(tree, child1Indices, method);
+        tree.nodes[node].secondChild = tree.getNumNodes();
+        createObbTree(tree, child2Indices, method);
+        return;
+    }
+
+    // This is a leaf node.
+    
+    tree.faceOrder.insert(tree.faceOrder.end(), faceIndices.begin(), 
+                          faceIndices.end());
+}
+
+// Append a node for the given faces to the tree, with no children and its
+// face range not yet filled in, and return its box.
+OrientedBoundingBox ContactGeometry::TriangleMesh::Impl::addObbNode
+   (OBBTreeImpl& tree, const Array_<int>& faceIndices) const
 {   // Find all vertices in the node and build the OrientedBoundingBox.
-    node.numTriangles = faceIndices.size();
-    set<int> vertexIndices;
+    Array_<int> vertexIndices;
+    vertexIndices.reserve(3*faceIndices.size());
     for (int i = 0; i < (int) faceIndices.size(); i++) 
         for (int j = 0; j < 3; j++)
-            vertexIndices.insert(faces[faceIndices[i]].vertices[j]);
+            vertexIndices.push_back(faces[faceIndices[i]].vertices[j]);
+    std::sort(vertexIndices.begin(), vertexIndices.end());
+    vertexIndices.erase(std::unique(vertexIndices.begin(), 
+                                    vertexIndices.end()),
+                        vertexIndices.end());
     Vector_<Vec3> points((int)vertexIndices.size());
-    int index = 0;
-    for (set<int>::iterator iter = vertexIndices.begin(); 
-                            iter != vertexIndices.end(); ++iter)
-        points[index++] = vertices[*iter].pos;
-    node.bounds = OrientedBoundingBox(points);
+    for (int i = 0; i < (int) vertexIndices.size(); i++)
+        points[i] = vertices[vertexIndices[i]].pos;
+    const OrientedBoundingBox bounds = tree.addNode(points);
+    OBBTreeImpl::Node& node = tree.nodes.back();
+    node.firstFace = 0;
+    node.numFaces = (int)faceIndices.size();
+    node.secondChild = 0;
+    return bounds;
+}
+
+// Divide a node's faces between two children. Returns false if the node 
+// should be a leaf.
+bool ContactGeometry::TriangleMesh::Impl::splitObbNode
+   (const Array_<int>& faceIndices, const OrientedBoundingBox& bounds,
+    OBBTreeOptions::SplitMethod method, 
+    Array_<int>& child1Indices, Array_<int>& child2Indices) const
+{
     if (faceIndices.size() > 3) {
+        if (   method == OBBTreeOptions::SurfaceAreaSplit
+            && splitObbSurfaceArea(faceIndices, bounds, 
+                                   child1Indices, child2Indices))
+            return true;
 
         // Order the axes by size.
 
         int axisOrder[3];
-        const Vec3& size = node.bounds.getSize();
+        const Vec3& size = bounds.getSize();
         if (size[0] > size[1]) {
             if (size[0] > size[2]) {
                 axisOrder[0] = 0;
@@ -603,35 +720,25 @@ void ContactGeometry::TriangleMesh::Impl::createObbTree
         // Try splitting along each axis.
 
         for (int i = 0; i < 3; i++) {
-            Array_<int> child1Indices, child2Indices;
+            child1Indices.clear();
+            child2Indices.clear();
             splitObbAxis(faceIndices, child1Indices, child2Indices, 
                          axisOrder[i]);
-            if (child1Indices.size() > 0 && child2Indices.size() > 0) {
-                // It was successfully split, so create the child nodes.
-
-                node.child1 = new OBBTreeNodeImpl();
-                node.child2 = new OBBTreeNodeImpl();
-                createObbTree(*node.child1, child1Indices);
-                createObbTree(*node.child2, child2Indices);
-                return;
-            }
+            if (child1Indices.size() > 0 && child2Indices.size() > 0)
+                return true;
         }
     }
-    
-    // This is a leaf node.
-    
-    node.triangles.insert(node.triangles.begin(), faceIndices.begin(), 
-                          faceIndices.end());
+    return false;
 }
 
 void ContactGeometry::TriangleMesh::Impl::splitObbAxis
    (const Array_<int>& parentIndices, Array_<int>& child1Indices, 
-    Array_<int>& child2Indices, int axis) 
+    Array_<int>& child2Indices, int axis) const
 {   // For each face, find its minimum and maximum extent along the axis.
     Vector minExtent(parentIndices.size());
     Vector maxExtent(parentIndices.size());
     for (int i = 0; i < (int) parentIndices.size(); i++) {
-        int* vertexIndices = faces[parentIndices[i]].vertices;
+        const int* vertexIndices = faces[parentIndices[i]].vertices;
         Real minVal = vertices[vertexIndices[0]].pos[axis];
         Real maxVal = vertices[vertexIndices[0]].pos[axis];
         minVal = std::min(minVal, vertices[vertexIndices[1]].pos[axis]);
@@ -659,6 +766,352 @@ void ContactGeometry::TriangleMesh::Impl::splitObbAxis
     }
 }
 
+// Binned surface area heuristic. Each face is represented by the center of
+// its bounding box, measured along the axes of the parent's box. Along each
+// of those axes we drop the faces into bins, then consider splitting between
+// every pair of adjacent bins, estimating the cost of the split as the sum 
+// over the two children of the surface area of the box around their faces
+// (aligned with the parent's box) times the number of faces. Returns false if
+// all the faces are in the same place, so there is nothing to choose.
+bool ContactGeometry::TriangleMesh::Impl::splitObbSurfaceArea
+   (const Array_<int>& parentIndices, const OrientedBoundingBox& bounds,
+    Array_<int>& child1Indices, Array_<int>& child2Indices) const
+{
+    static const int NumBins = 16;
+    const Rotation& R = bounds.getTransform().R();
+    const int n = (int) parentIndices.size();
+    Array_<Vec3> faceLo(n), faceHi(n);
+    Vec3 centerLo(MostPositiveReal), centerHi(MostNegativeReal);
+    for (int i = 0; i < n; i++) {
+        const int* vertexIndices = faces[parentIndices[i]].vertices;
+        faceLo[i] = faceHi[i] = ~R*vertices[vertexIndices[0]].pos;
+        for (int j = 1; j < 3; j++) {
+            const Vec3 p = ~R*vertices[vertexIndices[j]].pos;
+            for (int k = 0; k < 3; k++) {
+                faceLo[i][k] = std::min(faceLo[i][k], p[k]);
+                faceHi[i][k] = std::max(faceHi[i][k], p[k]);
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            const Real center = (faceLo[i][k]+faceHi[i][k])/2;
+            centerLo[k] = std::min(centerLo[k], center);
+            centerHi[k] = std::max(centerHi[k], center);
+        }
+    }
+
+    Real bestCost = Infinity;
+    int bestAxis = -1, bestBin = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        const Real width = centerHi[axis]-centerLo[axis];
+        if (!(width > 0))
+            continue;
+        Vec3 binLo[NumBins], binHi[NumBins];
+        int binCount[NumBins];
+        for (int b = 0; b < NumBins; b++) {
+            binLo[b] = Vec3(MostPositiveReal);
+            binHi[b] = Vec3(MostNegativeReal);
+            binCount[b] = 0;
+        }
+        for (int i = 0; i < n; i++) {
+            const Real center = (faceLo[i][axis]+faceHi[i][axis])/2;
+            const int b = std::min(NumBins-1, 
+                (int)(NumBins*(center-centerLo[axis])/width));
+            binCount[b]++;
+            for (int k = 0; k < 3; k++) {
+                binLo[b][k] = std::min(binLo[b][k], faceLo[i][k]);
+                binHi[b][k] = std::max(binHi[b][k], faceHi[i][k]);
+            }
+        }
+
+        // rightCost[b] is the cost of a child holding bins b and up.
+        Real rightCost[NumBins];
+        Vec3 lo(MostPositiveReal), hi(MostNegativeReal);
+        int count = 0;
+        for (int b = NumBins-1; b > 0; b--) {
+            count += binCount[b];
+            for (int k = 0; k < 3; k++) {
+                lo[k] = std::min(lo[k], binLo[b][k]);
+                hi[k] = std::max(hi[k], binHi[b][k]);
+            }
+            const Vec3 d = hi-lo;
+            rightCost[b] = count == 0 ? Real(0)
+                : 2*(d[0]*d[1]+d[1]*d[2]+d[2]*d[0])*count;
+        }
+        lo = Vec3(MostPositiveReal); hi = Vec3(MostNegativeReal);
+        count = 0;
+        for (int b = 1; b < NumBins; b++) {
+            count += binCount[b-1];
+            for (int k = 0; k < 3; k++) {
+                lo[k] = std::min(lo[k], binLo[b-1][k]);
+                hi[k] = std::max(hi[k], binHi[b-1][k]);
+            }
+            if (count == 0 || count == n)
+                continue;
+            const Vec3 d = hi-lo;
+            const Real cost = 2*(d[0]*d[1]+d[1]*d[2]+d[2]*d[0])*count
+                              + rightCost[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+    if (bestAxis < 0)
+        return false;
+
+    const Real width = centerHi[bestAxis]-centerLo[bestAxis];
+    for (int i = 0; i < n; i++) {
+        const Real center = (faceLo[i][bestAxis]+faceHi[i][bestAxis])/2;
+        const int b = std::min(NumBins-1, 
+            (int)(NumBins*(center-centerLo[bestAxis])/width));
+        if (b < bestBin)
+            child1Indices.push_back(parentIndices[i]);
+        else
+            child2Indices.push_back(parentIndices[i]);
+    }
+    return true;
+}
+
+// One piece of the top of the tree when it is built in parallel. It is either
+// the root of a subtree built by one of the tasks, a leaf, or an internal node
+// whose children are other pieces.
+namespace {
+struct ObbTopPiece {
+    ObbTopPiece() : node(-1), child1(-1), child2(-1), task(-1) {}
+    int         node;           // this piece's node in the top tree
+    int         child1, child2; // other pieces, if this is an internal node
+    int         task;           // which subtree task, if any
+    Array_<int> faces;          // if this is a leaf
+};
+}
+
+class ContactGeometry::TriangleMesh::Impl::ObbSubtreeTask 
+:   public ParallelExecutor::Task {
+public:
+    ObbSubtreeTask(const Impl& mesh, const Array_< Array_<int> >& faces,
+                   OBBTreeOptions::SplitMethod method, 
+                   Array_<OBBTreeImpl>& subtrees)
+    :   mesh(mesh), faces(faces), method(method), subtrees(subtrees) {}
+    void execute(int index) override {
+        mesh.createObbTree(subtrees[index], faces[index], method);
+    }
+private:
+    const Impl&                     mesh;
+    const Array_< Array_<int> >&    faces;
+    OBBTreeOptions::SplitMethod     method;
+    Array_<OBBTreeImpl>&            subtrees;
+};
+
+// Split the top few levels of the tree serially until there are a few 
+// subtrees for each thread, build those subtrees concurrently, then copy them
+// into place. Each subtree is built exactly as it would be in a serial build
+// and the pieces are put together in depth first order, so the result is the
+// same as the serial build no matter how many threads are used.
+
+void ContactGeometry::TriangleMesh::Impl::createObbTreeInParallel
+   (const Array_<int>& faceIndices, OBBTreeOptions::SplitMethod method,
+    int numThreads) 
+{
+    // Expand top nodes until there are about four subtrees per thread.
+    int depth = 0;
+    while ((1 << depth) < 4*numThreads)
+        depth++;
+
+    OBBTreeImpl top;
+    Array_<ObbTopPiece> pieces;
+    Array_< Array_<int> > taskFaces;
+    Array_<int> stack; // pieces still to expand, along with their depth
+    Array_< Array_<int> > stackFaces;
+    pieces.push_back(ObbTopPiece());
+    stack.push_back(0); stack.push_back(0);
+    stackFaces.push_back(faceIndices);
+    while (!stack.empty()) {
+        const int level = stack.back(); stack.pop_back();
+        const int piece = stack.back(); stack.pop_back();
+        Array_<int> pieceFaces;
+        pieceFaces.swap(stackFaces.back());
+        stackFaces.pop_back();
+
+        if (level == depth || (int) pieceFaces.size() < MinFacesForThreads/8) {
+            pieces[piece].task = (int) taskFaces.size();
+            taskFaces.push_back(Array_<int>());
+            taskFaces.back().swap(pieceFaces);
+            continue;
+        }
+        pieces[piece].node = top.getNumNodes();
+        const OrientedBoundingBox bounds = addObbNode(top, pieceFaces);
+        Array_<int> child1Indices, child2Indices;
+        if (!splitObbNode(pieceFaces, bounds, method, 
+                          child1Indices, child2Indices)) {
+            pieces[piece].faces.swap(pieceFaces);
+            continue;
+        }
+        pieces[piece].child1 = (int) pieces.size();
+        pieces[piece].child2 = (int) pieces.size()+1;
+        pieces.push_back(ObbTopPiece());
+        pieces.push_back(ObbTopPiece());
+        stack.push_back(pieces[piece].child1); stack.push_back(level+1);
+        stackFaces.push_back(Array_<int>());
+        stackFaces.back().swap(child1Indices);
+        stack.push_back(pieces[piece].child2); stack.push_back(level+1);
+        stackFaces.push_back(Array_<int>());
+        stackFaces.back().swap(child2Indices);
+    }
+
+    Array_<OBBTreeImpl> subtrees(taskFaces.size());
+    ParallelExecutor executor(numThreads);
+    ObbSubtreeTask task(*this, taskFaces, method, subtrees);
+    executor.execute(task, (int) taskFaces.size());
+
+    // Now lay the pieces out in depth first order. Walking the pieces with an
+    // explicit stack, a negative entry -(n+1) means that node n's second child
+    // is about to be laid out.
+    stack.clear();
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const int entry = stack.back(); stack.pop_back();
+        if (entry < 0) {
+            obb.nodes[-entry-1].secondChild = obb.getNumNodes();
+            continue;
+        }
+        const ObbTopPiece& piece = pieces[entry];
+        const int nodeOffset = obb.getNumNodes();
+        const int faceOffset = (int) obb.faceOrder.size();
+        if (piece.task >= 0) {
+            const OBBTreeImpl& subtree = subtrees[piece.task];
+            for (int i = 0; i < subtree.getNumNodes(); i++) {
+                OBBTreeImpl::Node node = subtree.nodes[i];
+                if (node.secondChild != 0)
+                    node.secondChild += nodeOffset;
+                node.firstFace += faceOffset;
+                obb.nodes.push_back(node);
+            }
+            obb.faceOrder.insert(obb.faceOrder.end(), 
+                                 subtree.faceOrder.begin(), 
+                                 subtree.faceOrder.end());
+            continue;
+        }
+        obb.nodes.push_back(top.nodes[piece.node]);
+        obb.nodes.back().firstFace = faceOffset;
+        if (piece.child1 < 0) {
+            obb.faceOrder.insert(obb.faceOrder.end(), 
+                                 piece.faces.begin(), piece.faces.end());
+            continue;
+        }
+        stack.push_back(piece.child2);
+        stack.push_back(-nodeOffset-1);
+        stack.push_back(piece.child1);
+    }
+}
+
+// The cache file is a small header followed by the raw node and face arrays.
+// The key identifies the mesh geometry, the split method, and the node 
+// layout; anything that doesn't match is rebuilt.
+static const char ObbCacheMagic[8] = {'S','i','m','T','K','O','B','B'};
+static const int  ObbCacheVersion = 1;
+
+// 64 bit FNV-1a hash.
+static void hashBytes(unsigned long long& hash, const void* data, size_t n) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+unsigned long long ContactGeometry::TriangleMesh::Impl::calcObbTreeKey
+   (OBBTreeOptions::SplitMethod method) const 
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    const int header[4] = {ObbCacheVersion, (int) sizeof(OBBTreeImpl::Node),
+                           (int) sizeof(Real), (int) method};
+    hashBytes(hash, header, sizeof(header));
+    for (int i = 0; i < (int) vertices.size(); i++)
+        hashBytes(hash, &vertices[i].pos, sizeof(Vec3));
+    for (int i = 0; i < (int) faces.size(); i++)
+        hashBytes(hash, faces[i].vertices, 3*sizeof(int));
+    return hash;
+}
+
+// Read the tree from a cache file, checking everything that could otherwise
+// cause trouble later. On any failure the tree is left empty.
+bool ContactGeometry::TriangleMesh::Impl::loadObbTree
+   (const std::string& pathname, unsigned long long key) 
+{
+    std::ifstream in(pathname.c_str(), std::ios::in | std::ios::binary);
+    if (!in)
+        return false;
+    char magic[8];
+    unsigned long long fileKey;
+    int numFaces, numNodes;
+    in.read(magic, sizeof(magic));
+    in.read((char*)&fileKey, sizeof(fileKey));
+    in.read((char*)&numFaces, sizeof(numFaces));
+    in.read((char*)&numNodes, sizeof(numNodes));
+    if (   !in || std::memcmp(magic, ObbCacheMagic, sizeof(magic)) != 0
+        || fileKey != key || numFaces != (int) faces.size() 
+        || numNodes < 1 || numNodes >= 2*numFaces+1)
+        return false;
+
+    obb.nodes.resize(numNodes);
+    obb.faceOrder.resize(numFaces);
+    in.read((char*)obb.nodes.begin(), numNodes*sizeof(OBBTreeImpl::Node));
+    in.read((char*)obb.faceOrder.begin(), numFaces*sizeof(int));
+    bool valid = (bool) in;
+
+    // Every face must appear exactly once, and each node's range must be 
+    // divided exactly between its children.
+    Array_<char> seen(valid ? numFaces : 0, 0);
+    for (int i = 0; valid && i < numFaces; i++) {
+        const int face = obb.faceOrder[i];
+        valid = face >= 0 && face < numFaces && !seen[face];
+        if (valid) seen[face] = 1;
+    }
+    for (int i = 0; valid && i < numNodes; i++) {
+        const OBBTreeImpl::Node& node = obb.nodes[i];
+        valid = node.numFaces > 0 && node.firstFace >= 0
+                && node.firstFace <= numFaces - node.numFaces;
+        if (!valid || node.secondChild == 0)
+            continue;
+        valid = node.secondChild > i+1 && node.secondChild < numNodes;
+        if (!valid)
+            continue;
+        const OBBTreeImpl::Node& child1 = obb.nodes[i+1];
+        const OBBTreeImpl::Node& child2 = obb.nodes[node.secondChild];
+        valid =    child1.firstFace == node.firstFace
+                && child2.firstFace == node.firstFace + child1.numFaces
+                && child1.numFaces + child2.numFaces == node.numFaces;
+    }
+    valid = valid && obb.nodes[0].firstFace == 0 
+                  && obb.nodes[0].numFaces == numFaces;
+    if (!valid) {
+        obb.nodes.clear();
+        obb.faceOrder.clear();
+    }
+    return valid;
+}
+
+// Failing to write the cache isn't an error; we'll just build the tree again
+// next time.
+void ContactGeometry::TriangleMesh::Impl::saveObbTree
+   (const std::string& pathname, unsigned long long key) const 
+{
+    std::ofstream out(pathname.c_str(), 
+                      std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out)
+        return;
+    const int numFaces = (int) obb.faceOrder.size();
+    const int numNodes = obb.getNumNodes();
+    out.write(ObbCacheMagic, sizeof(ObbCacheMagic));
+    out.write((const char*)&key, sizeof(key));
+    out.write((const char*)&numFaces, sizeof(numFaces));
+    out.write((const char*)&numNodes, sizeof(numNodes));
+    out.write((const char*)obb.nodes.cbegin(), 
+              numNodes*sizeof(OBBTreeImpl::Node));
+    out.write((const char*)obb.faceOrder.cbegin(), numFaces*sizeof(int));
+}
+
 Vec3 ContactGeometry::TriangleMesh::Impl::findNearestPointToFace
    (const Vec3& position, int face, Vec2& uv) const {
     // Calculate the distance between a point in space and a face of the mesh.
@@ -768,36 +1221,125 @@ Vec3 ContactGeometry::TriangleMesh::Impl::findNearestPointToFace
 
 
 //==============================================================================
-//                            OBB TREE NODE IMPL
+//                               OBB TREE IMPL
 //==============================================================================
 
-OBBTreeNodeImpl::OBBTreeNodeImpl(const OBBTreeNodeImpl& copy) 
-:   bounds(copy.bounds), triangles(copy.triangles), 
-    numTriangles(copy.numTriangles) {
-    if (copy.child1 == NULL) {
-        child1 = NULL;
-        child2 = NULL;
+// The stored float quaternion is not quite of unit length; it always gets 
+// normalized in double precision before use, so the extents measured along
+// its axes when the node is built are along the same axes used in queries.
+static Rotation unpackRotation(const OBBTreeImpl::Node& node) {
+    return Rotation(Quaternion(Vec4(node.q[0], node.q[1], 
+                                    node.q[2], node.q[3])));
+}
+
+// Rotate by the conjugate of the normalized quaternion, that is, calculate
+// ~R*v without forming R.
+Vec3 OBBTreeImpl::toBoxFrame(const Node& node, const Vec3& v) {
+    Vec4 q(node.q[0], node.q[1], node.q[2], node.q[3]);
+    q /= q.norm();
+    const Vec3 u(-q[1], -q[2], -q[3]);
+    const Vec3 t = 2*(u % v);
+    return v + q[0]*t + u % t;
+}
+
+// Round to the nearest float that is no greater (roundDown) or no less than x.
+static float roundDown(Real x) {
+    float f = (float)x;
+    return f > x ? std::nextafter(f, -std::numeric_limits<float>::infinity())
+                 : f;
+}
+static float roundUp(Real x) {
+    float f = (float)x;
+    return f < x ? std::nextafter(f,  std::numeric_limits<float>::infinity())
+                 : f;
+}
+
+OrientedBoundingBox OBBTreeImpl::getBounds(int n) const {
+    const Node& node = nodes[n];
+    const Rotation R = unpackRotation(node);
+    const Vec3 lo(node.lo[0], node.lo[1], node.lo[2]);
+    const Vec3 hi(node.hi[0], node.hi[1], node.hi[2]);
+    return OrientedBoundingBox(Transform(R, R*lo), hi-lo);
+}
+
+Real OBBTreeImpl::findDistance2(int n, const Vec3& position) const {
+    const Node& node = nodes[n];
+    const Vec3 p = toBoxFrame(node, position);
+    Real d2 = 0;
+    for (int i = 0; i < 3; i++) {
+        if (p[i] < node.lo[i])
+            d2 += square(node.lo[i]-p[i]);
+        else if (p[i] > node.hi[i])
+            d2 += square(p[i]-node.hi[i]);
     }
-    else {
-        child1 = new OBBTreeNodeImpl(*copy.child1);
-        child2 = new OBBTreeNodeImpl(*copy.child2);
+    return d2;
+}
+
+// This is the slab test from OrientedBoundingBox::intersectsRay().
+bool OBBTreeImpl::intersectsRay(int n, const Vec3& origin, 
+                                const UnitVec3& direction, 
+                                Real& distance) const {
+    const Node& node = nodes[n];
+    const Vec3 orig = toBoxFrame(node, origin);
+    const Vec3 dir  = toBoxFrame(node, Vec3(direction));
+    Real minDist = MostNegativeReal;
+    Real maxDist = MostPositiveReal;
+    for (int i = 0; i < 3; i++) {
+        if (dir[i] == 0.0) {
+            if (orig[i] < node.lo[i] || orig[i] > node.hi[i])
+                return false;
+            continue;
+        }
+        Real dist1 = (node.lo[i]-orig[i])/dir[i];
+        Real dist2 = (node.hi[i]-orig[i])/dir[i];
+        if (dist1 > dist2)
+            std::swap(dist1, dist2);
+        minDist = std::max(minDist, dist1);
+        maxDist = std::min(maxDist, dist2);
+        if (minDist > maxDist || maxDist < 0.0)
+            return false;
     }
+    distance = std::max(minDist, Real(0));
+    return true;
 }
 
-OBBTreeNodeImpl::~OBBTreeNodeImpl() {
-    if (child1 != NULL)
-        delete child1;
-    if (child2 != NULL)
-        delete child2;
+// Fit the box in full precision, then round its orientation and measure the
+// points along the rounded axes. We pad the extents the same way the 
+// OrientedBoundingBox constructor does before rounding them outward.
+OrientedBoundingBox OBBTreeImpl::addNode(const Vector_<Vec3>& points) {
+    const OrientedBoundingBox fit(points);
+    const Vec4 q = Quaternion(fit.getTransform().R()).asVec4();
+    nodes.push_back(Node());
+    Node& node = nodes.back();
+    for (int i = 0; i < 4; i++)
+        node.q[i] = (float)q[i];
+
+    Vec3 minExtent = Vec3(MostPositiveReal);
+    Vec3 maxExtent = Vec3(MostNegativeReal);
+    for (int i = 0; i < points.size(); i++) {
+        const Vec3 p = toBoxFrame(node, points[i]);
+        for (int j = 0; j < 3; j++) {
+            minExtent[j] = std::min(minExtent[j], p[j]);
+            maxExtent[j] = std::max(maxExtent[j], p[j]);
+        }
+    }
+    for (int j = 0; j < 3; j++) {
+        const Real tol = std::max(Real(1e-5)*(maxExtent[j]-minExtent[j]), 
+                                  Real(1e-10));
+        node.lo[j] = roundDown(minExtent[j]-tol);
+        node.hi[j] = roundUp(maxExtent[j]+tol);
+    }
+    return getBounds(getNumNodes()-1);
 }
 
-Vec3 OBBTreeNodeImpl::findNearestPoint
-   (const ContactGeometry::TriangleMesh::Impl& mesh, 
+Vec3 OBBTreeImpl::findNearestPoint
+   (const ContactGeometry::TriangleMesh::Impl& mesh, int n,
     const Vec3& position, Real cutoff2, 
     Real& distance2, int& face, Vec2& uv) const 
 {
     Real tol = 100*Eps;
-    if (child1 != NULL) {
+    if (!isLeaf(n)) {
+        const int child1 = getFirstChild(n), child2 = getSecondChild(n);
         // Recursively check the child nodes.
         
         Real child1distance2 = MostPositiveReal, 
@@ -805,25 +1347,25 @@ Vec3 OBBTreeNodeImpl::findNearestPoint
         int child1face, child2face;
         Vec2 child1uv, child2uv;
         Vec3 child1point, child2point;
-        Real child1BoundsDist2 = 
-            (child1->bounds.findNearestPoint(position)-position).normSqr();
-        Real child2BoundsDist2 = 
-            (child2->bounds.findNearestPoint(position)-position).normSqr();
+        Real child1BoundsDist2 = findDistance2(child1, position);
+        Real child2BoundsDist2 = findDistance2(child2, position);
         if (child1BoundsDist2 < child2BoundsDist2) {
             if (child1BoundsDist2 < cutoff2) {
-                child1point = child1->findNearestPoint(mesh, position, cutoff2, child1distance2, child1face, child1uv);
+                child1point = findNearestPoint(mesh, child1, position, cutoff2, child1distance2, child1face, child1uv);
                 if (child2BoundsDist2 < child1distance2 && child2BoundsDist2 < cutoff2)
-                    child2point = child2->findNearestPoint(mesh, position, cutoff2, child2distance2, child2face, child2uv);
+                    child2point = findNearestPoint(mesh, child2, position, cutoff2, child2distance2, child2face, child2uv);
             }
         }
         else {
             if (child2BoundsDist2 < cutoff2) {
-                child2point = child2->findNearestPoint(mesh, position, cutoff2, child2distance2, child2face, child2uv);
+                child2point = findNearestPoint(mesh, child2, position, cutoff2, child2distance2, child2face, child2uv);
                 if (child1BoundsDist2 < child2distance2 && child1BoundsDist2 < cutoff2)
-                    child1point = child1->findNearestPoint(mesh, position, cutoff2, child1distance2, child1face, child1uv);
+                    child1point = findNearestPoint(mesh, child1, position, cutoff2, child1distance2, child1face, child1uv);
             }
         }
-        if (   child1distance2 <= child2distance2*(1+tol) 
+        // Neither child may have been searched if both are beyond the cutoff.
+        if (   child1distance2 != MostPositiveReal
+            && child1distance2 <= child2distance2*(1+tol) 
             && child2distance2 <= child1distance2*(1+tol)) {
             // Decide based on angle which one to use.
             
@@ -848,9 +1390,10 @@ Vec3 OBBTreeNodeImpl::findNearestPoint
     }    
     // This is a leaf node, so check each triangle for its distance to the point.
     
+    const int* triangles = getFaces(n);
     distance2 = MostPositiveReal;
     Vec3 nearestPoint;
-    for (int i = 0; i < (int) triangles.size(); i++) {
+    for (int i = 0; i < getNumFaces(n); i++) {
         Vec2 triangleUV;
         Vec3 p = mesh.findNearestPointToFace(position, triangles[i], triangleUV);
         Vec3 offset = p-position;
@@ -866,38 +1409,39 @@ Vec3 OBBTreeNodeImpl::findNearestPoint
     return nearestPoint;
 }
 
-bool OBBTreeNodeImpl::
-intersectsRay(const ContactGeometry::TriangleMesh::Impl& mesh,
+bool OBBTreeImpl::
+intersectsRay(const ContactGeometry::TriangleMesh::Impl& mesh, int n,
               const Vec3& origin, const UnitVec3& direction, Real& distance, 
               int& face, Vec2& uv) const {
-    if (child1 != NULL) {
+    if (!isLeaf(n)) {
+        const int child1 = getFirstChild(n), child2 = getSecondChild(n);
         // Recursively check the child nodes.
         
         Real child1distance, child2distance;
         int child1face, child2face;
         Vec2 child1uv, child2uv;
-        bool child1intersects = child1->bounds.intersectsRay(origin, direction, child1distance);
-        bool child2intersects = child2->bounds.intersectsRay(origin, direction, child2distance);
+        bool child1intersects = intersectsRay(child1, origin, direction, child1distance);
+        bool child2intersects = intersectsRay(child2, origin, direction, child2distance);
         if (child1intersects) {
             if (child2intersects) {
                 // The ray intersects both child nodes.  First check the closer one.
                 
                 if (child1distance < child2distance) {
-                    child1intersects = child1->intersectsRay(mesh, origin,  direction, child1distance, child1face, child1uv);
+                    child1intersects = intersectsRay(mesh, child1, origin,  direction, child1distance, child1face, child1uv);
                     if (!child1intersects || child2distance < child1distance)
-                        child2intersects = child2->intersectsRay(mesh, origin,  direction, child2distance, child2face, child2uv);
+                        child2intersects = intersectsRay(mesh, child2, origin,  direction, child2distance, child2face, child2uv);
                 }
                 else {
-                    child2intersects = child2->intersectsRay(mesh, origin,  direction, child2distance, child2face, child2uv);
+                    child2intersects = intersectsRay(mesh, child2, origin,  direction, child2distance, child2face, child2uv);
                     if (!child2intersects || child1distance < child2distance)
-                        child1intersects = child1->intersectsRay(mesh, origin,  direction, child1distance, child1face, child1uv);
+                        child1intersects = intersectsRay(mesh, child1, origin,  direction, child1distance, child1face, child1uv);
                 }
             }
             else
-                child1intersects = child1->intersectsRay(mesh, origin,  direction, child1distance, child1face, child1uv);
+                child1intersects = intersectsRay(mesh, child1, origin,  direction, child1distance, child1face, child1uv);
         }
         else if (child2intersects)
-            child2intersects = child2->intersectsRay(mesh, origin,  direction, child2distance, child2face, child2uv);
+            child2intersects = intersectsRay(mesh, child2, origin,  direction, child2distance, child2face, child2uv);
         
         // If either one had an intersection, return the closer one.
         
@@ -919,8 +1463,9 @@ intersectsRay(const ContactGeometry::TriangleMesh::Impl& mesh,
     // This is a leaf node, so check each triangle for an intersection with the 
     // ray.
     
+    const int* triangles = getFaces(n);
     bool foundIntersection = false;
-    for (int i = 0; i < (int) triangles.size(); i++) {
+    for (int i = 0; i < getNumFaces(n); i++) {
         const UnitVec3& faceNormal = mesh.faces[triangles[i]].normal;
         Real vd = ~faceNormal*direction;
         if (vd == 0.0)
@@ -994,39 +1539,39 @@ intersectsRay(const ContactGeometry::TriangleMesh::Impl& mesh,
 //==============================================================================
 
 ContactGeometry::TriangleMesh::OBBTreeNode::
-OBBTreeNode(const OBBTreeNodeImpl& impl) : impl(&impl) {}
+OBBTreeNode(const OBBTreeImpl& tree, int index) : tree(&tree), index(index) {}
 
-const OrientedBoundingBox& 
+OrientedBoundingBox 
 ContactGeometry::TriangleMesh::OBBTreeNode::getBounds() const {
-    return impl->bounds;
+    return tree->getBounds(index);
 }
 
 bool ContactGeometry::TriangleMesh::OBBTreeNode::isLeafNode() const {
-    return (impl->child1 == NULL);
+    return tree->isLeaf(index);
 }
 
 const ContactGeometry::TriangleMesh::OBBTreeNode 
 ContactGeometry::TriangleMesh::OBBTreeNode::getFirstChildNode() const {
-    SimTK_ASSERT_ALWAYS(impl->child1, 
+    SimTK_ASSERT_ALWAYS(!tree->isLeaf(index), 
         "Called getFirstChildNode() on a leaf node");
-    return OBBTreeNode(*impl->child1);
+    return OBBTreeNode(*tree, tree->getFirstChild(index));
 }
 
 const ContactGeometry::TriangleMesh::OBBTreeNode 
 ContactGeometry::TriangleMesh::OBBTreeNode::getSecondChildNode() const {
-    SimTK_ASSERT_ALWAYS(impl->child2, 
-        "Called getFirstChildNode() on a leaf node");
-    return OBBTreeNode(*impl->child2);
+    SimTK_ASSERT_ALWAYS(!tree->isLeaf(index), 
+        "Called getSecondChildNode() on a leaf node");
+    return OBBTreeNode(*tree, tree->getSecondChild(index));
 }
 
-const Array_<int>& ContactGeometry::TriangleMesh::OBBTreeNode::
+ArrayViewConst_<int> ContactGeometry::TriangleMesh::OBBTreeNode::
 getTriangles() const {
-    SimTK_ASSERT_ALWAYS(impl->child2 == NULL, 
+    SimTK_ASSERT_ALWAYS(tree->isLeaf(index), 
         "Called getTriangles() on a non-leaf node");
-    return impl->triangles;
+    const int* first = tree->getFaces(index);
+    return ArrayViewConst_<int>(first, first + tree->getNumFaces(index));
 }
 
 int ContactGeometry::TriangleMesh::OBBTreeNode::getNumTriangles() const {
-    return impl->numTriangles;
+    return tree->getNumFaces(index);
 }
-
@@ -27,6 +27,9 @@
 #include "simmath/internal/common.h"
 #include "simmath/internal/Contact.h"
 
+#include <mutex>
+#include <set>
+
 namespace SimTK {
 
 
@@ -40,14 +43,16 @@ public:
                 ContactSurfaceIndex     surf2,
                 Contact::Condition      condition=Contact::Unknown) 
     :   m_referenceCount(0), m_condition(condition), 
-        m_id(), m_surf1(surf1), m_surf2(surf2), m_X_S1S2() {}
+        m_id(), m_surf1(surf1), m_surf2(surf2), m_X_S1S2(), 
+        m_simplexSize(0), m_hasWitnessPoints(false) {}
 
     ContactImpl(ContactSurfaceIndex     surf1, 
                 ContactSurfaceIndex     surf2,
                 const Transform&        X_S1S2,
                 Contact::Condition      condition=Contact::Unknown) 
     :   m_referenceCount(0), m_condition(condition), 
-        m_id(), m_surf1(surf1), m_surf2(surf2), m_X_S1S2(X_S1S2) {}
+        m_id(), m_surf1(surf1), m_surf2(surf2), m_X_S1S2(X_S1S2),
+        m_simplexSize(0), m_hasWitnessPoints(false) {}
 
     void setTransform(const Transform& X_S1S2) {m_X_S1S2 = X_S1S2;}
     const Transform& getTransform() const {return m_X_S1S2;}
@@ -58,6 +63,32 @@ public:
     void setContactId(ContactId id) {m_id=id;}
     ContactId getContactId() const {return m_id;}
 
+    /* A tracker that iterates on a simplex of support points can leave the
+    support directions it finished with here, expressed in surface 1's frame,
+    and start from them the next time it tracks this contact. */
+    void setSimplex(const UnitVec3* directions, int n) {
+        assert(0 <= n && n <= 4);
+        for (int i=0; i < n; ++i) m_simplex[i] = directions[i];
+        m_simplexSize = n;
+    }
+    int getSimplexSize() const {return m_simplexSize;}
+    const UnitVec3& getSimplexDirection(int i) const 
+    {   assert(0 <= i && i < m_simplexSize); return m_simplex[i]; }
+
+    /* A tracker can also leave the points it found on each surface, each 
+    measured and expressed in its own surface's frame. If the surfaces have
+    hardly moved relative to each other by the next step, those are already
+    nearly the answer. */
+    void setWitnessPoints(const Vec3& point1_S1, const Vec3& point2_S2) {
+        m_witness1 = point1_S1; m_witness2 = point2_S2; 
+        m_hasWitnessPoints = true;
+    }
+    bool hasWitnessPoints() const {return m_hasWitnessPoints;}
+    const Vec3& getWitnessPoint1() const 
+    {   assert(m_hasWitnessPoints); return m_witness1; }
+    const Vec3& getWitnessPoint2() const 
+    {   assert(m_hasWitnessPoints); return m_witness2; }
+
     virtual ~ContactImpl() {
         assert(m_referenceCount == 0);
     }
@@ -95,6 +126,11 @@ friend class Contact;
     ContactSurfaceIndex m_surf1,
                         m_surf2;
     Transform           m_X_S1S2;
+    UnitVec3            m_simplex[4];
+    int                 m_simplexSize;
+    Vec3                m_witness1,     // in S1
+                        m_witness2;     // in S2
+    bool                m_hasWitnessPoints;
 };
 
 
@@ -233,12 +269,27 @@ friend class BrickHalfSpaceContact;
 /** This is the internal implementation class for TriangleMeshContact. **/
 class TriangleMeshContactImpl : public ContactImpl {
 public:
+    TriangleMeshContactImpl(ContactSurfaceIndex     surf1, 
+                            ContactSurfaceIndex     surf2,
+                            const Transform&        X_S1S2,
+                            const MeshFaceSet&      faces1, 
+                            const MeshFaceSet&      faces2);
+    TriangleMeshContactImpl(ContactSurfaceIndex     surf1, 
+                            ContactSurfaceIndex     surf2,
+                            const Transform&        X_S1S2,
+                            const Array_<int>&      faceList1, 
+                            const Array_<int>&      faceList2);
     TriangleMeshContactImpl(ContactSurfaceIndex     surf1, 
                             ContactSurfaceIndex     surf2,
                             const Transform&        X_S1S2,
                             const std::set<int>&    faces1, 
                             const std::set<int>&    faces2);
 
+    // The std::set forms are only built if someone asks for them.
+    const std::set<int>& getFaceSet1() const;
+    const std::set<int>& getFaceSet2() const;
+    void buildFaceSets() const;
+
     ContactTypeId getTypeId() const override {return classTypeId();}
     static ContactTypeId classTypeId() {
         static const ContactTypeId tid = createNewContactTypeId();
@@ -248,8 +299,11 @@ public:
 private:
 friend class TriangleMeshContact;
 
-    const std::set<int> faces1;
-    const std::set<int> faces2;
+    Array_<int>                 faceList1;  // ascending
+    Array_<int>                 faceList2;
+    mutable std::set<int>       faces1;
+    mutable std::set<int>       faces2;
+    mutable std::once_flag      facesBuilt;
 };
 
 
@@ -23,13 +23,18 @@
 
 #include "SimTKmath.h"
 
+#include "ContactGeometryImpl.h"
+#include "ContactImpl.h"
+
 #include <algorithm>
 using std::pair; using std::make_pair;
 #include <iostream>
 using std::cout; using std::endl;
 #include <set>
+#include <utility>
 
 // Define this if you want to see voluminous output from MPR (XenoCollide)
+// and GJK
 //#define MPR_DEBUG
 
 
@@ -316,6 +321,533 @@ estimateConvexImplicitPairContactUsingMPR
 }
 
 
+//------------------------------------------------------------------------------
+//              ESTIMATE IMPLICIT PAIR CONTACT USING GJK AND EPA
+//------------------------------------------------------------------------------
+// Generate a rough guess at the contact points from the support functions
+// alone. Point P is returned in A's frame and point Q is in B's frame, but all
+// the work here is done in frame A. GJK (Gilbert, Johnson & Keerthi) walks a
+// simplex of support points of the Minkowski difference A-B toward the origin.
+// Either it finds a support plane that separates the origin from A-B, which
+// proves there is no contact, or it converges on the point of A-B nearest the 
+// origin, or it encloses the origin in a tetrahedron. In the last case EPA
+// (the Expanding Polytope Algorithm; see van den Bergen, G. "Proximity
+// Queries and Penetration Depth Computation on 3D Game Objects", GDC 2001)
+// grows that tetrahedron until its face nearest the origin is on the 
+// boundary of A-B; that gives the penetration direction and points.
+//
+// As with MPR, on smooth shapes neither iteration terminates exactly so we
+// stop at a modest accuracy and leave the polishing to Newton. The simplex
+// GJK finished with is returned as its support directions, which remain good
+// starting directions after the shapes have moved a little.
+
+namespace {
+
+// A vertex of the simplex or polytope: the Minkowski difference support
+// point v=A-B in direction dir, with the points on A and B that produced it.
+struct SupportVertex {
+    void compute(const ContactGeometry& shapeA, const ContactGeometry& shapeB,
+                 const Transform& X_AB, const UnitVec3& dirInA) {
+        dir = dirInA;
+        A = shapeA.calcSupportPoint(dirInA);
+        B = shapeB.calcSupportPoint(-(~X_AB.R()*dirInA));
+        v = A - X_AB*B;
+    }
+
+    UnitVec3 dir; // support direction, exp. in A
+    Vec3 A; // support point on A in direction dir, exp. in A
+    Vec3 B; // support point on B in direction -dir, exp. in B
+    Vec3 v; // A-B, exp. in A
+};
+
+const int MaxGJKIters = 32;
+const int MaxEPAIters = 32;
+
+// Given simplex vertices s[0..n-1], find the point v of the simplex nearest
+// the origin and the barycentric weights w[] that produce it, then reduce the
+// simplex to the vertices with nonzero weight. Returns false if the simplex is
+// a tetrahedron containing the origin, in which case v is meaningless. A
+// degenerate simplex loses its newest vertex, so GJK can't get stuck on one.
+bool findNearestOnSimplex(SupportVertex s[4], int& n, Real w[4], Vec3& v) {
+    if (n == 4) {
+        const Vec3 a=s[0].v, b=s[1].v, c=s[2].v, d=s[3].v;
+        const Real det = ~(b-a)*((c-a)%(d-a));
+        const Real size = (b-a).norm()*(c-a).norm()*(d-a).norm();
+        if (std::abs(det) <= SignificantReal*size) {
+            n = 3;
+            return findNearestOnSimplex(s, n, w, v);
+        }
+        // Check the origin against the face opposite each vertex in turn.
+        // (i,j,k) opposite l.
+        static const int face[4][4] = {{1,2,3,0},{0,2,3,1},{0,1,3,2},
+                                       {0,1,2,3}};
+        Real best2 = MostPositiveReal; 
+        SupportVertex bestS[4]; int bestN = 0; Real bestW[4];
+        for (int f=0; f < 4; ++f) {
+            const Vec3& pi=s[face[f][0]].v; const Vec3& pj=s[face[f][1]].v;
+            const Vec3& pk=s[face[f][2]].v; const Vec3& pl=s[face[f][3]].v;
+            const Vec3 normal = (pj-pi) % (pk-pi);
+            if ((~normal*(-pi)) * (~normal*(pl-pi)) >= 0)
+                continue; // origin is on the same side as the 4th vertex
+            SupportVertex t[4] = {s[face[f][0]], s[face[f][1]], 
+                                  s[face[f][2]]};
+            int m = 3; Real tw[4]; Vec3 tv;
+            findNearestOnSimplex(t, m, tw, tv);
+            if (tv.normSqr() < best2) {
+                best2 = tv.normSqr(); v = tv; bestN = m;
+                for (int i=0; i < m; ++i) {bestS[i] = t[i]; bestW[i] = tw[i];}
+            }
+        }
+        if (bestN == 0) 
+            return false; // origin inside
+        n = bestN;
+        for (int i=0; i < n; ++i) {s[i] = bestS[i]; w[i] = bestW[i];}
+        return true;
+    }
+
+    if (n == 3) { // See Ericson, "Real-Time Collision Detection" 5.1.5.
+        const Vec3 a=s[0].v, b=s[1].v, c=s[2].v;
+        const Vec3 ab = b-a, ac = c-a;
+        if ((ab%ac).normSqr() <= SignificantReal*ab.normSqr()*ac.normSqr()) {
+            n = 2;
+            return findNearestOnSimplex(s, n, w, v);
+        }
+        const Real d1 = -~ab*a, d2 = -~ac*a;
+        if (d1 <= 0 && d2 <= 0) 
+        {   n = 1; w[0] = 1; v = a; return true; }
+        const Real d3 = -~ab*b, d4 = -~ac*b;
+        if (d3 >= 0 && d4 <= d3) 
+        {   s[0] = s[1]; n = 1; w[0] = 1; v = b; return true; }
+        const Real vc = d1*d4 - d3*d2;
+        if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+            const Real t = d1/(d1-d3);
+            n = 2; w[0] = 1-t; w[1] = t; v = a + t*ab; return true;
+        }
+        const Real d5 = -~ab*c, d6 = -~ac*c;
+        if (d6 >= 0 && d5 <= d6) 
+        {   s[0] = s[2]; n = 1; w[0] = 1; v = c; return true; }
+        const Real vb = d5*d2 - d1*d6;
+        if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+            const Real t = d2/(d2-d6);
+            s[1] = s[2]; n = 2; w[0] = 1-t; w[1] = t; v = a + t*ac; 
+            return true;
+        }
+        const Real va = d3*d6 - d5*d4;
+        if (va <= 0 && d4-d3 >= 0 && d5-d6 >= 0) {
+            const Real t = (d4-d3)/((d4-d3) + (d5-d6));
+            s[0] = s[1]; s[1] = s[2]; n = 2; w[0] = 1-t; w[1] = t; 
+            v = b + t*(c-b); return true;
+        }
+        const Real denom = 1/(va+vb+vc);
+        w[1] = vb*denom; w[2] = vc*denom; w[0] = 1-w[1]-w[2];
+        v = a + w[1]*ab + w[2]*ac;
+        return true;
+    }
+
+    if (n == 2) {
+        const Vec3 a=s[0].v, ab=s[1].v-a;
+        const Real len2 = ab.normSqr();
+        const Real t = len2 > 0 ? -(~ab*a)/len2 : 0;
+        if (t <= 0) {n = 1; w[0] = 1; v = a; return true;}
+        if (t >= 1) {s[0] = s[1]; n = 1; w[0] = 1; v = s[0].v; return true;}
+        w[0] = 1-t; w[1] = t; v = a + t*ab;
+        return true;
+    }
+
+    w[0] = 1; v = s[0].v;
+    return true;
+}
+
+// A face of the EPA polytope, with its outward unit normal and its distance
+// from the origin (which is inside the polytope).
+struct PolytopeFace {
+    PolytopeFace() {}
+    PolytopeFace(const Array_<SupportVertex>& verts, int a, int b, int c) {
+        vertex[0] = a; vertex[1] = b; vertex[2] = c;
+        const Vec3 n = (verts[b].v-verts[a].v) % (verts[c].v-verts[a].v);
+        const Real len = n.norm();
+        degenerate = !(len > 0);
+        normal = degenerate ? UnitVec3(XAxis) : UnitVec3(n/len, true);
+        distance = ~normal*verts[a].v;
+    }
+    int      vertex[3]; // counterclockwise seen from outside
+    UnitVec3 normal;
+    Real     distance;
+    bool     degenerate;
+};
+
+// Expand the tetrahedron s[0..3], which contains the origin, into a polytope
+// whose face nearest the origin lies on the boundary of the Minkowski
+// difference, to the given accuracy. Then the origin's projection onto that
+// face maps back to the deepest points of A and B.
+void findPenetrationUsingEPA
+   (const ContactGeometry& shapeA, const ContactGeometry& shapeB, 
+    const Transform& X_AB, const SupportVertex s[4], Real accuracy,
+    Vec3& pointP, Vec3& pointQ, UnitVec3& dirInA, int& numIterations)
+{
+    Array_<SupportVertex> verts(s, s+4);
+    Array_<PolytopeFace> faces;
+    static const int tet[4][3] = {{0,1,2},{0,3,1},{0,2,3},{1,3,2}};
+    const bool flip = ~(s[1].v-s[0].v)*((s[2].v-s[0].v)%(s[3].v-s[0].v)) > 0;
+    for (int f=0; f < 4; ++f)
+        faces.push_back(flip ? PolytopeFace(verts,tet[f][0],tet[f][2],tet[f][1])
+                             : PolytopeFace(verts,tet[f][0],tet[f][1],tet[f][2]));
+
+    Array_<std::pair<int,int> > horizon;
+    int nearest = 0;
+    for (numIterations=0; numIterations < MaxEPAIters; ++numIterations) {
+        nearest = -1;
+        for (int f=0; f < (int)faces.size(); ++f)
+            if (!faces[f].degenerate && (nearest < 0 
+                || faces[f].distance < faces[nearest].distance))
+                nearest = f;
+        if (nearest < 0) break; // shouldn't happen
+        const PolytopeFace face = faces[nearest];
+
+        SupportVertex w;
+        w.compute(shapeA, shapeB, X_AB, face.normal);
+        if (~w.v*face.normal - face.distance <= accuracy)
+            break; // this face is close enough to the boundary
+
+        // Remove every face that w can see and stitch the hole shut with
+        // new faces that share w. The hole's rim is made of the edges that
+        // belong to just one of the removed faces.
+        horizon.clear();
+        for (int f=0; f < (int)faces.size(); ) {
+            if (~faces[f].normal*(w.v - verts[faces[f].vertex[0]].v) <= 0)
+            {   ++f; continue; }
+            for (int e=0; e < 3; ++e) {
+                const std::pair<int,int> edge(faces[f].vertex[e], 
+                                              faces[f].vertex[(e+1)%3]);
+                const std::pair<int,int> reversed(edge.second, edge.first);
+                Array_<std::pair<int,int> >::iterator p = 
+                    std::find(horizon.begin(), horizon.end(), reversed);
+                if (p != horizon.end()) horizon.erase(p);
+                else horizon.push_back(edge);
+            }
+            faces[f] = faces.back(); faces.pop_back();
+        }
+        verts.push_back(w);
+        const int iw = (int)verts.size()-1;
+        for (unsigned i=0; i < horizon.size(); ++i)
+            faces.push_back(PolytopeFace(verts, horizon[i].first, 
+                                         horizon[i].second, iw));
+        nearest = -1;
+    }
+    if (nearest < 0) {
+        nearest = 0;
+        for (int f=1; f < (int)faces.size(); ++f)
+            if (faces[f].distance < faces[nearest].distance)
+                nearest = f;
+    }
+
+    // Barycentric coordinates of the origin's projection onto the face.
+    const PolytopeFace& face = faces[nearest];
+    const SupportVertex& a = verts[face.vertex[0]];
+    const SupportVertex& b = verts[face.vertex[1]];
+    const SupportVertex& c = verts[face.vertex[2]];
+    const Vec3 p = face.distance*face.normal;
+    const Real area = ~face.normal*((b.v-a.v)%(c.v-a.v));
+    Real u = 1, v = 0, wt = 0;
+    if (area > 0) {
+        u = ~face.normal*((b.v-p)%(c.v-p))/area;
+        v = ~face.normal*((c.v-p)%(a.v-p))/area;
+        wt = 1-u-v;
+    }
+    pointP = u*a.A + v*b.A + wt*c.A;
+    pointQ = u*a.B + v*b.B + wt*c.B;
+    dirInA = face.normal;
+}
+
+}
+
+
+/*static*/ bool ContactTracker::
+estimateConvexImplicitPairContactUsingGJK
+   (const ContactGeometry& shapeA, const ContactGeometry& shapeB, 
+    const Transform& X_AB, UnitVec3 simplex[4], int& simplexSize,
+    Vec3& pointP, Vec3& pointQ, UnitVec3& dirInA, int& numIterations)
+{
+    numIterations = 0;
+
+    // The same rough scaling as MPR uses.
+    Vec3 cA, cB; Real rA, rB;
+    shapeA.getBoundingSphere(cA,rA); shapeB.getBoundingSphere(cB,rB);
+    const Real lengthScale = Real(0.25)*std::min(rA,rB);
+    const Real accuracy = MPRAccuracy*lengthScale;
+
+    // Start from the previous simplex if we have one, dropping any vertex
+    // that has landed on top of another. Otherwise start from the direction
+    // from B's origin toward A's, along which A-B most nearly reaches
+    // the origin.
+    SupportVertex s[4]; int n = 0;
+    for (int i=0; i < simplexSize; ++i) {
+        s[n].compute(shapeA, shapeB, X_AB, simplex[i]);
+        bool duplicate = false;
+        for (int j=0; j < n; ++j)
+            if ((s[j].v - s[n].v).normSqr() <= square(SignificantReal*lengthScale))
+                duplicate = true;
+        if (!duplicate) ++n;
+    }
+    if (n == 0) {
+        const Vec3 p_AB = X_AB.p();
+        s[0].compute(shapeA, shapeB, X_AB, 
+                     p_AB == 0 ? UnitVec3(XAxis) : UnitVec3(p_AB));
+        n = 1;
+    }
+
+    // Test for NaN once and get out to avoid getting stuck in loops below.
+    if (s[0].v.isNaN()) {
+        pointP = pointQ = NaN;
+        dirInA = UnitVec3();
+        simplexSize = 0;
+        return false;
+    }
+
+    Real w[4]; Vec3 v;
+    while (true) {
+        ++numIterations;
+        if (!findNearestOnSimplex(s, n, w, v)) {
+            // The origin is inside the tetrahedron so the shapes overlap.
+            for (int i=0; i < 4; ++i) simplex[i] = s[i].dir;
+            simplexSize = 4;
+            int numEPAIters;
+            findPenetrationUsingEPA(shapeA, shapeB, X_AB, s, accuracy,
+                                    pointP, pointQ, dirInA, numEPAIters);
+            numIterations += numEPAIters;
+            return true;
+        }
+
+        const Real dist = v.norm();
+        if (dist <= SignificantReal*lengthScale) 
+            break; // touching; the origin is on the simplex
+        const UnitVec3 dir(-v/dist, true); // toward the origin
+
+        SupportVertex next;
+        next.compute(shapeA, shapeB, X_AB, dir);
+        const Real depth = ~next.v*dir; // -(lower bound on separation)
+        if (depth <= 0) { // origin is outside this support plane
+            pointP = next.A; pointQ = next.B; dirInA = dir;
+            for (int i=0; i < n; ++i) simplex[i] = s[i].dir;
+            simplexSize = n;
+            return false;
+        }
+        // The separation is somewhere between -depth and dist. We're done if 
+        // that's narrow enough, or if we have run out of patience.
+        if (dist + depth <= accuracy || numIterations >= MaxGJKIters)
+            break;
+        s[n++] = next;
+    }
+
+    // The shapes are touching or nearly so; report the nearest points.
+    pointP = pointQ = Vec3(0);
+    for (int i=0; i < n; ++i) {
+        pointP += w[i]*s[i].A;
+        pointQ += w[i]*s[i].B;
+        simplex[i] = s[i].dir;
+    }
+    simplexSize = n;
+    dirInA = v == 0 ? s[0].dir : UnitVec3(-v);
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------
+//                        CALC SEPARATION LOWER BOUND
+//------------------------------------------------------------------------------
+// Each case below produces a distance that can't exceed the true separation.
+// The half space occupies x>0 in its own frame, so a surface's deepest point
+// is its support point in the +x direction; for a mesh that is one of its 
+// vertices. A sphere's separation from a mesh is the signed distance of its
+// center less its radius; any other surface can stand in its bounding sphere
+// there, at some cost in tightness. For two finite convex shapes we run GJK
+// to convergence rather than stopping at the first separating plane as the
+// contact estimate does: each support plane gives a lower bound and the 
+// simplex gives an upper bound, and we stop when they are close enough.
+
+namespace {
+
+const int MaxConservativeAdvancementIters = 100;
+
+bool isFiniteConvex(const ContactGeometry& shape) {
+    Vec3 center; Real radius;
+    shape.getBoundingSphere(center, radius);
+    return shape.isConvex() && isFinite(radius);
+}
+
+Real calcHalfSpaceSeparation(const ContactGeometry& shapeB, 
+                             const Transform& X_AB) {
+    if (ContactGeometry::HalfSpace::isInstance(shapeB))
+        return -Infinity; // only parallel half spaces could be apart
+    if (ContactGeometry::TriangleMesh::isInstance(shapeB)) {
+        const ContactGeometry::TriangleMesh& mesh = 
+            ContactGeometry::TriangleMesh::getAs(shapeB);
+        Real deepest = MostNegativeReal;
+        for (int i=0; i < mesh.getNumVertices(); ++i)
+            deepest = std::max(deepest, 
+                               (X_AB*mesh.getVertexPosition(i))[0]);
+        return -deepest;
+    }
+    if (isFiniteConvex(shapeB)) {
+        const UnitVec3 x_B(~X_AB.R()*Vec3(1,0,0), true);
+        return -(X_AB*shapeB.calcSupportPoint(x_B))[0];
+    }
+    Vec3 center; Real radius;
+    shapeB.getBoundingSphere(center, radius);
+    return -((X_AB*center)[0] + radius);
+}
+
+// Signed distance of a point from a mesh surface, negative inside.
+Real calcMeshSignedDistance(const ContactGeometry::TriangleMesh& mesh,
+                            const Vec3& point) {
+    bool inside; UnitVec3 normal;
+    const Vec3 nearest = mesh.findNearestPoint(point, inside, normal);
+    const Real distance = (point-nearest).norm();
+    return inside ? -distance : distance;
+}
+
+// Shape B, or its bounding sphere, against mesh A.
+Real calcMeshSeparation(const ContactGeometry::TriangleMesh& meshA,
+                        const ContactGeometry& shapeB, 
+                        const Transform& X_AB) {
+    Vec3 center; Real radius;
+    shapeB.getBoundingSphere(center, radius);
+    return calcMeshSignedDistance(meshA, X_AB*center) - radius;
+}
+
+Real calcConvexPairSeparation(const ContactGeometry& shapeA, 
+                              const ContactGeometry& shapeB,
+                              const Transform& X_AB, Real accuracy) {
+    const Vec3 p_AB = X_AB.p();
+    SupportVertex s[4]; int n = 1;
+    s[0].compute(shapeA, shapeB, X_AB, 
+                 p_AB == 0 ? UnitVec3(XAxis) : UnitVec3(p_AB));
+    if (s[0].v.isNaN())
+        return NaN;
+
+    Real lower = 0;
+    for (int iter=0; iter < MaxGJKIters; ++iter) {
+        Real w[4]; Vec3 v;
+        if (!findNearestOnSimplex(s, n, w, v))
+            return 0; // overlapping
+        const Real dist = v.norm(); // upper bound on the separation
+        if (dist - lower <= accuracy)
+            break;
+        const UnitVec3 dir(-v/dist, true);
+        SupportVertex next;
+        next.compute(shapeA, shapeB, X_AB, dir);
+        // Every point of A-B is behind this support plane.
+        lower = std::max(lower, Real(-~next.v*dir));
+        s[n++] = next;
+    }
+    return lower;
+}
+
+// Advance a pose by constant spatial velocity V_GS for time t.
+Transform advancePose(const Transform& X_GS, const SpatialVec& V_GS, Real t) {
+    const Real angle = V_GS[0].norm()*t;
+    const Vec3 p = X_GS.p() + t*V_GS[1];
+    if (angle == 0)
+        return Transform(X_GS.R(), p);
+    return Transform(Rotation(angle, UnitVec3(V_GS[0]))*X_GS.R(), p);
+}
+
+// Bound on the speed of any point of the surface due to its spinning about
+// its origin with angular velocity w.
+Real calcSpinSpeedBound(const ContactGeometry& shape, const Vec3& w) {
+    const Real rate = w.norm();
+    if (rate == 0)
+        return 0;
+    Vec3 center; Real radius;
+    shape.getBoundingSphere(center, radius);
+    return rate*(center.norm() + radius);
+}
+
+}
+
+/*static*/ Real ContactTracker::
+calcSeparationLowerBound
+   (const Transform& X_GS1, const ContactGeometry& surface1,
+    const Transform& X_GS2, const ContactGeometry& surface2,
+    Real accuracy)
+{
+    const Transform X_12 = ~X_GS1*X_GS2;
+    if (ContactGeometry::HalfSpace::isInstance(surface1))
+        return calcHalfSpaceSeparation(surface2, X_12);
+    if (ContactGeometry::HalfSpace::isInstance(surface2))
+        return calcHalfSpaceSeparation(surface1, ~X_12);
+
+    const bool isMesh1 = ContactGeometry::TriangleMesh::isInstance(surface1);
+    const bool isMesh2 = ContactGeometry::TriangleMesh::isInstance(surface2);
+    Vec3 center1, center2; Real radius1, radius2;
+    surface1.getBoundingSphere(center1, radius1);
+    surface2.getBoundingSphere(center2, radius2);
+    // Use the smaller mesh's bounding sphere against the other.
+    if (isMesh1 && (!isMesh2 || radius2 <= radius1))
+        return calcMeshSeparation
+           (ContactGeometry::TriangleMesh::getAs(surface1), surface2, X_12);
+    if (isMesh2)
+        return calcMeshSeparation
+           (ContactGeometry::TriangleMesh::getAs(surface2), surface1, ~X_12);
+
+    if (!(ContactGeometry::Sphere::isInstance(surface1) 
+          && ContactGeometry::Sphere::isInstance(surface2))
+        && isFiniteConvex(surface1) && isFiniteConvex(surface2))
+        return calcConvexPairSeparation(surface1, surface2, X_12, accuracy);
+
+    // Exact for two spheres.
+    return (X_GS1*center1 - X_GS2*center2).norm() - radius1 - radius2;
+}
+
+
+
+//------------------------------------------------------------------------------
+//                            CALC TIME OF IMPACT
+//------------------------------------------------------------------------------
+// Conservative advancement; see Mirtich, B. "Timewarp Rigid Body Simulation",
+// SIGGRAPH 2000. No point of one surface can approach the other faster than 
+// the surfaces' relative origin speed plus each one's spin rate times its 
+// reach from its origin, so the surfaces can't touch before the current 
+// separation bound has been covered at that speed.
+/*static*/ bool ContactTracker::
+calcTimeOfImpact
+   (const Transform& X_GS1, const SpatialVec& V_GS1, 
+    const ContactGeometry& surface1,
+    const Transform& X_GS2, const SpatialVec& V_GS2, 
+    const ContactGeometry& surface2,
+    Real maxTime, Real tolerance, Real& timeOfImpact, int& numIterations)
+{
+    timeOfImpact = NaN;
+    numIterations = 0;
+    const Real speed = (V_GS1[1]-V_GS2[1]).norm() 
+                       + calcSpinSpeedBound(surface1, V_GS1[0])
+                       + calcSpinSpeedBound(surface2, V_GS2[0]);
+    if (!isFinite(speed))
+        return false;
+
+    Real t = 0;
+    while (numIterations < MaxConservativeAdvancementIters) {
+        ++numIterations;
+        const Real separation = calcSeparationLowerBound
+           (advancePose(X_GS1, V_GS1, t), surface1,
+            advancePose(X_GS2, V_GS2, t), surface2, tolerance);
+        if (!(separation > tolerance)) { // also catches NaN
+            timeOfImpact = t;
+            return true;
+        }
+        if (speed == 0)
+            return false;
+        t += separation/speed;
+        if (t > maxTime)
+            return false;
+    }
+    // Still creeping closer; report the contact early rather than miss it.
+    timeOfImpact = t;
+    return true;
+}
+
+
 //------------------------------------------------------------------------------
 //                            REFINE IMPLICIT PAIR
 //------------------------------------------------------------------------------
@@ -768,6 +1300,43 @@ bool ContactTracker::SphereSphere::trackContact
 
 
 
+//==============================================================================
+//                    REUSE PRIOR TRIANGLE MESH CONTACT
+//==============================================================================
+// A TriangleMeshContact found last time at exactly the same relative transform
+// must have exactly the same faces, so a mesh that is at rest on something
+// needn't be searched again. Returns true if the prior contact was reused.
+// Workspace for the mesh trackers' sets of inside faces. Trackers may be 
+// called from several threads at once so each thread has its own. They grow
+// to fit the largest meshes seen and are then reused, so once a simulation
+// is under way tracking mesh contact doesn't allocate except to store the
+// faces in the new Contact.
+static MeshFaceSet& updFaceWorkspace(int which, int numMeshFaces) {
+    static thread_local MeshFaceSet workspace[2];
+    workspace[which].reset(numMeshFaces);
+    return workspace[which];
+}
+
+static bool reusePriorTriangleMeshContact(const Contact&   priorStatus,
+                                          const Transform& X_S1S2,
+                                          Contact&         currentStatus)
+{
+    if (!TriangleMeshContact::isInstance(priorStatus))
+        return false;
+    const Transform& X_S1S2prior = priorStatus.getTransform();
+    if (!(X_S1S2prior.p() == X_S1S2.p() && X_S1S2prior.R() == X_S1S2.R()))
+        return false;
+
+    const TriangleMeshContact& prior = TriangleMeshContact::getAs(priorStatus);
+    currentStatus = TriangleMeshContact(prior.getSurface1(), 
+                                        prior.getSurface2(), X_S1S2,
+                                        prior.getSurface1FaceList(), 
+                                        prior.getSurface2FaceList());
+    return true;
+}
+
+
+
 //==============================================================================
 //                  HALFSPACE - TRIANGLE MESH CONTACT TRACKER
 //==============================================================================
@@ -796,6 +1365,8 @@ bool ContactTracker::HalfSpaceTriangleMesh::trackContact
 
     // Transform giving mesh (S2) frame in the halfspace (S1) frame.
     const Transform X_HM = (~X_GH)*X_GM; 
+    if (reusePriorTriangleMeshContact(priorStatus, X_HM, currentStatus))
+        return true; // nothing has moved
 
     // Normal is halfspace -x direction; xdir is first column of R_MH.
     // That's a unit vector and -unitvec is also a unit vector so this
@@ -806,7 +1377,7 @@ bool ContactTracker::HalfSpaceTriangleMesh::trackContact
     const Real hsFaceHeight_M = dot((~X_HM).p(), hsNormal_M);
     // Now collect all the faces that are all or partially below the 
     // halfspace surface.
-    std::set<int> insideFaces;
+    MeshFaceSet& insideFaces = updFaceWorkspace(0, mesh.getNumFaces());
     processBox(mesh, mesh.getOBBTreeNode(), X_HM, 
                hsNormal_M, hsFaceHeight_M, insideFaces);
     
@@ -818,7 +1389,7 @@ bool ContactTracker::HalfSpaceTriangleMesh::trackContact
     currentStatus = TriangleMeshContact(priorStatus.getSurface1(), 
                                         priorStatus.getSurface2(), 
                                         X_HM, 
-                                        std::set<int>(), insideFaces);
+                                        MeshFaceSet(), insideFaces);
     return true; // success
 }
 
@@ -829,10 +1400,10 @@ void ContactTracker::HalfSpaceTriangleMesh::processBox
    (const ContactGeometry::TriangleMesh&              mesh, 
     const ContactGeometry::TriangleMesh::OBBTreeNode& node, 
     const Transform& X_HM, const UnitVec3& hsNormal_M, Real hsFaceHeight_M, 
-    std::set<int>& insideFaces) const 
+    MeshFaceSet& insideFaces) const 
 {   // First check against the node's bounding box.
     
-    const OrientedBoundingBox& bounds = node.getBounds();
+    const OrientedBoundingBox bounds = node.getBounds();
     const Transform& X_MB = bounds.getTransform(); // box frame in mesh
     const Vec3 p_BC = bounds.getSize()/2; // from box origin corner to center
     // Express the half space normal in the box frame, then reflect it into
@@ -869,7 +1440,7 @@ void ContactTracker::HalfSpaceTriangleMesh::processBox
     
     // This is a leaf OBB node that is penetrating, so some of its triangles
     // may be penetrating.
-    const Array_<int>& triangles = node.getTriangles();
+    const ArrayViewConst_<int> triangles = node.getTriangles();
     for (int i = 0; i < (int) triangles.size(); i++) {
         for (int vx=0; vx < 3; ++vx) {
             const int   vertex         = mesh.getFaceVertex(triangles[i], vx);
@@ -885,10 +1456,10 @@ void ContactTracker::HalfSpaceTriangleMesh::processBox
 
 void ContactTracker::HalfSpaceTriangleMesh::addAllTriangles
    (const ContactGeometry::TriangleMesh::OBBTreeNode& node, 
-    std::set<int>& insideFaces) const 
+    MeshFaceSet& insideFaces) const 
 {
     if (node.isLeafNode()) {
-        const Array_<int>& triangles = node.getTriangles();
+        const ArrayViewConst_<int> triangles = node.getTriangles();
         for (int i = 0; i < (int) triangles.size(); i++)
             insideFaces.insert(triangles[i]);
     }
@@ -930,10 +1501,22 @@ bool ContactTracker::SphereTriangleMesh::trackContact
 
     // Transform giving mesh (M) frame in the sphere (S) frame.
     const Transform X_SM = ~X_GS*X_GM; 
+    if (reusePriorTriangleMeshContact(priorStatus, X_SM, currentStatus))
+        return true; // nothing has moved
 
     // Want the sphere center measured and expressed in the mesh frame.
     const Vec3 p_MC = (~X_SM).p();
-    std::set<int> insideFaces;
+
+    // If the mesh has a distance field it can usually tell us right away 
+    // that no face comes within the sphere.
+    Real distance, maxError;
+    if (   mesh.estimateSignedDistance(p_MC, distance, maxError)
+        && std::abs(distance) - maxError >= sphere.getRadius()) {
+        currentStatus.clear(); // not touching
+        return true; // successful return
+    }
+
+    MeshFaceSet& insideFaces = updFaceWorkspace(0, mesh.getNumFaces());
     processBox(mesh, mesh.getOBBTreeNode(), p_MC, square(sphere.getRadius()), 
                insideFaces);
     
@@ -945,7 +1528,7 @@ bool ContactTracker::SphereTriangleMesh::trackContact
     currentStatus = TriangleMeshContact(priorStatus.getSurface1(), 
                                         priorStatus.getSurface2(), 
                                         X_SM, 
-                                        std::set<int>(), insideFaces);
+                                        MeshFaceSet(), insideFaces);
     return true; // success
 }
 
@@ -956,7 +1539,7 @@ void ContactTracker::SphereTriangleMesh::processBox
    (const ContactGeometry::TriangleMesh&              mesh, 
     const ContactGeometry::TriangleMesh::OBBTreeNode& node, 
     const Vec3& center_M, Real radius2, 
-    std::set<int>& insideFaces) const 
+    MeshFaceSet& insideFaces) const 
 {   // First check against the node's bounding box.
 
     const Vec3 nearest_M = node.getBounds().findNearestPoint(center_M);
@@ -973,7 +1556,7 @@ void ContactTracker::SphereTriangleMesh::processBox
     }
     
     // This is a leaf node that may be penetrating; check the triangles.
-    const Array_<int>& triangles = node.getTriangles();
+    const ArrayViewConst_<int> triangles = node.getTriangles();
     for (unsigned i = 0; i < triangles.size(); i++) {
         Vec2 uv;
         Vec3 nearest_M = mesh.findNearestPointToFace
@@ -1015,17 +1598,15 @@ bool ContactTracker::TriangleMeshTriangleMesh::trackContact
 
     // Transform giving mesh2 (M2) frame in the mesh1 (M1) frame.
     const Transform X_M1M2 = ~X_GM1*X_GM2; 
-    std::set<int> insideFaces1, insideFaces2;
+    if (reusePriorTriangleMeshContact(priorStatus, X_M1M2, currentStatus))
+        return true; // nothing has moved
 
-    // Get M2's bounding box in M1's frame.
-    const OrientedBoundingBox 
-        mesh2Bounds_M1 = X_M1M2*mesh2.getOBBTreeNode().getBounds();
+    MeshFaceSet& insideFaces1 = updFaceWorkspace(0, mesh1.getNumFaces());
+    MeshFaceSet& insideFaces2 = updFaceWorkspace(1, mesh2.getNumFaces());
 
     // Find the faces that are actually intersecting faces on the other
     // surface (this doesn't yet include faces that may be completely buried).
-    findIntersectingFaces(mesh1, mesh2, 
-                          mesh1.getOBBTreeNode(), mesh2.getOBBTreeNode(), 
-                          mesh2Bounds_M1, X_M1M2, insideFaces1, insideFaces2);
+    findIntersectingFaces(mesh1, mesh2, X_M1M2, insideFaces1, insideFaces2);
     
     // It should never be the case that one set of faces is empty and the
     // other isn't, however it is conceivable that roundoff error could cause
@@ -1048,70 +1629,63 @@ bool ContactTracker::TriangleMeshTriangleMesh::trackContact
     return true; // success
 }
 
+// Order leaf pairs by their mesh2 leaf so that each of those leaves' faces
+// need be transformed into the mesh1 frame only once.
+namespace {
+struct CompareSecondLeaf {
+    bool operator()(const std::pair<int,int>& p1, 
+                    const std::pair<int,int>& p2) const
+    {   return p1.second < p2.second 
+            || (p1.second == p2.second && p1.first < p2.first); }
+};
+}
+
 void ContactTracker::TriangleMeshTriangleMesh::
 findIntersectingFaces
    (const ContactGeometry::TriangleMesh&                mesh1, 
     const ContactGeometry::TriangleMesh&                mesh2,
-    const ContactGeometry::TriangleMesh::OBBTreeNode&   node1, 
-    const ContactGeometry::TriangleMesh::OBBTreeNode&   node2, 
-    const OrientedBoundingBox&                          node2Bounds_M1,
     const Transform&                                    X_M1M2, 
-    std::set<int>&                                      triangles1, 
-    std::set<int>&                                      triangles2) const 
-{   // See if the bounding boxes intersect.
-    
-    if (!node1.getBounds().intersectsBox(node2Bounds_M1))
-        return;
-    
-    // If either node is not a leaf node, process the children recursively.
-    
-    if (!node1.isLeafNode()) {
-        if (!node2.isLeafNode()) {
-            const OrientedBoundingBox firstChildBounds = 
-                X_M1M2*node2.getFirstChildNode().getBounds();
-            const OrientedBoundingBox secondChildBounds = 
-                X_M1M2*node2.getSecondChildNode().getBounds();
-            findIntersectingFaces(mesh1, mesh2, node1.getFirstChildNode(), node2.getFirstChildNode(), firstChildBounds, X_M1M2, triangles1, triangles2);
-            findIntersectingFaces(mesh1, mesh2, node1.getFirstChildNode(), node2.getSecondChildNode(), secondChildBounds, X_M1M2, triangles1, triangles2);
-            findIntersectingFaces(mesh1, mesh2, node1.getSecondChildNode(), node2.getFirstChildNode(), firstChildBounds, X_M1M2, triangles1, triangles2);
-            findIntersectingFaces(mesh1, mesh2, node1.getSecondChildNode(), node2.getSecondChildNode(), secondChildBounds, X_M1M2, triangles1, triangles2);
-        }
-        else {
-            findIntersectingFaces(mesh1, mesh2, node1.getFirstChildNode(), node2, node2Bounds_M1, X_M1M2, triangles1, triangles2);
-            findIntersectingFaces(mesh1, mesh2, node1.getSecondChildNode(), node2, node2Bounds_M1, X_M1M2, triangles1, triangles2);
+    MeshFaceSet&                                        triangles1, 
+    MeshFaceSet&                                        triangles2) const 
+{   // Find all the pairs of leaf nodes whose bounding boxes intersect.
+    const OBBTreeImpl& tree1 = mesh1.getImpl().getOBBTree();
+    const OBBTreeImpl& tree2 = mesh2.getImpl().getOBBTree();
+    Array_< std::pair<int,int> > leafPairs;
+    tree1.findOverlappingLeaves(tree2, X_M1M2, leafPairs);
+    std::sort(leafPairs.begin(), leafPairs.end(), CompareSecondLeaf());
+
+    // Check the triangles of each pair of leaf nodes for intersections.
+    Array_<Geo::Triangle> node2triangles;
+    for (unsigned k = 0; k < leafPairs.size(); k++) {
+        const int leaf2 = leafPairs[k].second;
+        const int* faces2 = tree2.getFaces(leaf2);
+        const int numFaces2 = tree2.getNumFaces(leaf2);
+        if (k == 0 || leaf2 != leafPairs[k-1].second) {
+            node2triangles.clear();
+            for (int i = 0; i < numFaces2; i++) {
+                const int face2 = faces2[i];
+                node2triangles.push_back(Geo::Triangle(
+                    X_M1M2*mesh2.getVertexPosition(mesh2.getFaceVertex(face2, 0)),
+                    X_M1M2*mesh2.getVertexPosition(mesh2.getFaceVertex(face2, 1)),
+                    X_M1M2*mesh2.getVertexPosition(mesh2.getFaceVertex(face2, 2))));
+            }
         }
-        return;
-    }
-    else if (!node2.isLeafNode()) {
-        const OrientedBoundingBox firstChildBounds = 
-            X_M1M2*node2.getFirstChildNode().getBounds();
-        const OrientedBoundingBox secondChildBounds = 
-            X_M1M2*node2.getSecondChildNode().getBounds();
-        findIntersectingFaces(mesh1, mesh2, node1, node2.getFirstChildNode(), firstChildBounds, X_M1M2, triangles1, triangles2);
-        findIntersectingFaces(mesh1, mesh2, node1, node2.getSecondChildNode(), secondChildBounds, X_M1M2, triangles1, triangles2);
-        return;
-    }
-    
-    // These are both leaf nodes, so check triangles for intersections.
-    
-    const Array_<int>& node1triangles = node1.getTriangles();
-    const Array_<int>& node2triangles = node2.getTriangles();
-    for (unsigned i = 0; i < node2triangles.size(); i++) {
-        const int face2 = node2triangles[i];
-        Vec3 a1 = X_M1M2*mesh2.getVertexPosition(mesh2.getFaceVertex(face2, 0));
-        Vec3 a2 = X_M1M2*mesh2.getVertexPosition(mesh2.getFaceVertex(face2, 1));
-        Vec3 a3 = X_M1M2*mesh2.getVertexPosition(mesh2.getFaceVertex(face2, 2));
-        const Geo::Triangle A(a1,a2,a3);
-        for (unsigned j = 0; j < node1triangles.size(); j++) {
-            const int face1 = node1triangles[j];
-            const Vec3& b1 = mesh1.getVertexPosition(mesh1.getFaceVertex(face1, 0));
-            const Vec3& b2 = mesh1.getVertexPosition(mesh1.getFaceVertex(face1, 1));
-            const Vec3& b3 = mesh1.getVertexPosition(mesh1.getFaceVertex(face1, 2));
-            const Geo::Triangle B(b1,b2,b3);
-            if (A.overlapsTriangle(B)) 
-            {   // The triangles intersect.
-                triangles1.insert(face1);
-                triangles2.insert(face2);
+
+        const int* faces1 = tree1.getFaces(leafPairs[k].first);
+        const int numFaces1 = tree1.getNumFaces(leafPairs[k].first);
+        for (int i = 0; i < numFaces2; i++) {
+            const Geo::Triangle& A = node2triangles[i];
+            for (int j = 0; j < numFaces1; j++) {
+                const int face1 = faces1[j];
+                const Vec3& b1 = mesh1.getVertexPosition(mesh1.getFaceVertex(face1, 0));
+                const Vec3& b2 = mesh1.getVertexPosition(mesh1.getFaceVertex(face1, 1));
+                const Vec3& b3 = mesh1.getVertexPosition(mesh1.getFaceVertex(face1, 2));
+                const Geo::Triangle B(b1,b2,b3);
+                if (A.overlapsTriangle(B)) 
+                {   // The triangles intersect.
+                    triangles1.insert(face1);
+                    triangles2.insert(faces2[i]);
+                }
             }
         }
     }
@@ -1126,15 +1700,16 @@ void ContactTracker::TriangleMeshTriangleMesh::
 findBuriedFaces(const ContactGeometry::TriangleMesh&    mesh,       // M 
                 const ContactGeometry::TriangleMesh&    otherMesh,  // O
                 const Transform&                        X_OM, 
-                std::set<int>&                          insideFaces) const 
+                MeshFaceSet&                            insideFaces) const 
 {  
     // Find which faces are inside.
     // We're passed in the list of Boundary faces, that is, those faces of
     // "mesh" that intersect faces of "otherMesh".
-    Array_<int> faceType(mesh.getNumFaces(), Unknown);
-    for (std::set<int>::iterator iter = insideFaces.begin(); 
-                                 iter != insideFaces.end(); ++iter)
-        faceType[*iter] = Boundary;
+    static thread_local Array_<int> faceType; // reused like the face sets
+    faceType.clear();
+    faceType.resize(mesh.getNumFaces(), Unknown);
+    for (int i = 0; i < insideFaces.size(); i++)
+        faceType[insideFaces[i]] = Boundary;
 
     for (int i = 0; i < (int) faceType.size(); i++) {
         if (faceType[i] == Unknown) {
@@ -1169,7 +1744,7 @@ static const int MaxRecursionDepth = 500;
 void ContactTracker::TriangleMeshTriangleMesh::
 tagFaces(const ContactGeometry::TriangleMesh&   mesh, 
          Array_<int>&                           faceType,
-         std::set<int>&                         triangles, 
+         MeshFaceSet&                           triangles, 
          int                                    index,
          int                                    depth) const 
 {
@@ -1266,6 +1841,25 @@ bool ContactTracker::HalfSpaceConvexImplicit::trackContact
 //               CONVEX IMPLICIT SURFACE PAIR CONTACT TRACKER
 //==============================================================================
 // This will return an elliptical point contact.
+
+// Decide whether B has moved so little relative to A, from X_AB0 to X_AB,
+// that contact points found at X_AB0 still make a good starting guess. The 
+// point found on B must have moved less than the accuracy that GJK and MPR
+// aim for, and B must have turned so little that the contact can't have slid
+// any farther than that around B's surface.
+static bool hasHardlyMoved(const ContactGeometry& shapeA, 
+                           const ContactGeometry& shapeB,
+                           const Transform& X_AB0, const Transform& X_AB,
+                           const Vec3& pointQ_B)
+{
+    Vec3 cA, cB; Real rA, rB;
+    shapeA.getBoundingSphere(cA,rA); shapeB.getBoundingSphere(cB,rB);
+    const Real tol = MPRAccuracy*Real(0.25)*std::min(rA,rB);
+    const Real shift = (X_AB*pointQ_B - X_AB0*pointQ_B).norm();
+    const Real turn = (X_AB.R() - X_AB0.R()).norm(); // Frobenius
+    return shift + turn*rB <= tol;
+}
+
 bool ContactTracker::ConvexImplicitPair::trackContact
    (const Contact&         priorStatus,
     const Transform&       X_GA, 
@@ -1284,34 +1878,77 @@ bool ContactTracker::ConvexImplicitPair::trackContact
     const Transform X_AB = ~X_GA*X_GB; // 63 flops
     const Rotation& R_AB = X_AB.R();
 
-    // 1. Get a rough guess at the contact points P and Q and contact normal.
+    // 1. If we were tracking this contact last time and B has hardly moved
+    //    relative to A since then, the points we found then are nearly right
+    //    already and Newton can polish them directly. That is the usual case
+    //    for resting contact.
+    const Real accuracyRequested = SignificantReal;
+    Real accuracyAchieved = Infinity; int numNewtonIters = 0;
     Vec3 pointP_A, pointQ_B; // on A and B, resp.
-    UnitVec3 norm_A;
-    int numMPRIters;
-    const bool mightBeContact = estimateConvexImplicitPairContactUsingMPR
-                                   (shapeA, shapeB, X_AB,
-                                    pointP_A, pointQ_B, norm_A, numMPRIters);
+    bool converged = false;
+    UnitVec3 simplex[4]; int simplexSize = 0;
+    if (!priorStatus.isEmpty()) {
+        const ContactImpl& prior = priorStatus.getImpl();
+        simplexSize = prior.getSimplexSize();
+        for (int i=0; i < simplexSize; ++i)
+            simplex[i] = prior.getSimplexDirection(i);
+        if (   prior.hasWitnessPoints() 
+            && hasHardlyMoved(shapeA, shapeB, priorStatus.getTransform(), 
+                              X_AB, prior.getWitnessPoint2())) {
+            pointP_A = prior.getWitnessPoint1();
+            pointQ_B = prior.getWitnessPoint2();
+            converged = refineImplicitPair(shapeA, pointP_A, shapeB, pointQ_B,
+                X_AB, accuracyRequested, accuracyAchieved, numNewtonIters);
+        }
+    }
 
-    #ifdef MPR_DEBUG
-    std::cout << "MPR: " << (mightBeContact?"MAYBE":"NO") << std::endl;
-    std::cout << "  P=" << X_GA*pointP_A << " Q=" << X_GB*pointQ_B << std::endl;
-    std::cout << "  N=" << X_GA.R()*norm_A << std::endl;
-    #endif
+    // 2. Otherwise get a rough guess at the contact points P and Q and 
+    //    contact normal, starting from the simplex we finished with last time
+    //    if we have one.
+    if (!converged) {
+        UnitVec3 norm_A;
+        int numGJKIters;
+        const bool mightBeContact = estimateConvexImplicitPairContactUsingGJK
+           (shapeA, shapeB, X_AB, simplex, simplexSize,
+            pointP_A, pointQ_B, norm_A, numGJKIters);
 
-    if (!mightBeContact) {
-        currentStatus.clear(); // definitely not touching
-        return true; // successful return
-    }
+        #ifdef MPR_DEBUG
+        std::cout << "GJK: " << (mightBeContact?"MAYBE":"NO") << std::endl;
+        std::cout << "  P=" << X_GA*pointP_A << " Q=" << X_GB*pointQ_B 
+                  << std::endl;
+        std::cout << "  N=" << X_GA.R()*norm_A << std::endl;
+        #endif
 
-    // 2. Refine the contact points to near machine precision.
-    const Real accuracyRequested = SignificantReal;
-    Real accuracyAchieved; int numNewtonIters;
-    bool converged = refineImplicitPair(shapeA, pointP_A, shapeB, pointQ_B,
-        X_AB, accuracyRequested, accuracyAchieved, numNewtonIters);
+        if (!mightBeContact) {
+            currentStatus.clear(); // definitely not touching
+            return true; // successful return
+        }
+
+        // 3. Refine the contact points to near machine precision. In the rare
+        //    case that Newton can't get there from the GJK estimate, try 
+        //    again from MPR's and keep whichever is better.
+        converged = refineImplicitPair(shapeA, pointP_A, shapeB, pointQ_B, 
+            X_AB, accuracyRequested, accuracyAchieved, numNewtonIters);
+        if (!converged) {
+            Vec3 mprP_A, mprQ_B; UnitVec3 mprNorm_A; int numMPRIters;
+            if (!estimateConvexImplicitPairContactUsingMPR(shapeA, shapeB, 
+                        X_AB, mprP_A, mprQ_B, mprNorm_A, numMPRIters)) {
+                currentStatus.clear(); // MPR found a separating plane
+                return true;
+            }
+            Real mprAccuracy; int numMPRNewtonIters;
+            refineImplicitPair(shapeA, mprP_A, shapeB, mprQ_B, X_AB, 
+                accuracyRequested, mprAccuracy, numMPRNewtonIters);
+            if (mprAccuracy < accuracyAchieved) {
+                pointP_A = mprP_A; pointQ_B = mprQ_B;
+                accuracyAchieved = mprAccuracy;
+            }
+        }
+    }
 
     const Vec3 pointQ_A = X_AB*pointQ_B;  // Q on B, measured & expressed in A
 
-    // 3. Compute the curvatures and surface normals of the two surfaces at 
+    // 4. Compute the curvatures and surface normals of the two surfaces at 
     //    P and Q. Once we have the first normal we can check whether there was
     //    actually any contact and duck out early if not.
     Rotation R_AP; Vec2 curvatureP;
@@ -1323,8 +1960,8 @@ bool ContactTracker::ConvexImplicitPair::trackContact
     const Real depth = dot(pointP_A-pointQ_A, R_AP.z());
 
     #ifdef MPR_DEBUG
-    printf("MPR %2d iters, Newton %2d iters->accuracy=%g depth=%g\n",
-        numMPRIters, numNewtonIters, accuracyAchieved, depth);
+    printf("Newton %2d iters->accuracy=%g depth=%g\n",
+        numNewtonIters, accuracyAchieved, depth);
     #endif  
 
     if (depth <= 0) {
@@ -1338,7 +1975,7 @@ bool ContactTracker::ConvexImplicitPair::trackContact
     shapeB.calcCurvature(pointQ_B, curvatureQ, R_BQ);
     const UnitVec3 maxDirB_A(R_AB*R_BQ.x()); // re-express in A
 
-    // 4. Compute the effective contact frame C and corresponding relative
+    // 5. Compute the effective contact frame C and corresponding relative
     //    curvatures.
     Transform X_AC; Vec2 curvatureC;
 
@@ -1350,10 +1987,13 @@ bool ContactTracker::ConvexImplicitPair::trackContact
                                         maxDirB_A, curvatureQ, 
                                         X_AC.updR(), curvatureC);
 
-    // 5. Return the elliptical point contact for force generation.
+    // 6. Return the elliptical point contact for force generation, keeping 
+    //    what we need to get a quick start next time.
     currentStatus = EllipticalPointContact(priorStatus.getSurface1(),
                                            priorStatus.getSurface2(),
                                            X_AB, X_AC, curvatureC, depth);
+    currentStatus.updImpl().setSimplex(simplex, simplexSize);
+    currentStatus.updImpl().setWitnessPoints(pointP_A, pointQ_B);
     return true; // success
 }
 
@@ -0,0 +1,313 @@
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/internal/common.h"
+#include "simmath/internal/ContactGeometry.h"
+
+#include "ContactGeometryImpl.h"
+
+#include <cmath>
+#include <utility>
+
+// SSE2 is always available on x86-64; on 32 bit x86 it depends on the
+// instruction set chosen at build time (see BUILD_INST_SET in CMake).
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SimTK_OBB_OVERLAP_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+using namespace SimTK;
+
+namespace {
+
+//==============================================================================
+//                               UNPACKED BOX
+//==============================================================================
+// A node's box in the frame in which the boxes are being compared: its
+// axes (the columns of a rotation matrix, stored by rows), its center, and
+// its half-dimensions. This is done often enough that we work straight from
+// the packed node rather than going through getBounds().
+struct UnpackedBox {
+    Real    R[9];
+    Real    center[3];
+    Real    half[3];
+};
+
+// X_FM, if given, re-expresses the box from the mesh frame M in frame F.
+void unpackBox(const OBBTreeImpl::Node& node, const Transform* X_FM,
+               UnpackedBox& box) {
+    Real w = node.q[0], x = node.q[1], y = node.q[2], z = node.q[3];
+    const Real scale = 1/std::sqrt(w*w + x*x + y*y + z*z);
+    w *= scale; x *= scale; y *= scale; z *= scale;
+    const Real R_MB[9] = {1-2*(y*y+z*z), 2*(x*y-w*z),   2*(x*z+w*y),
+                          2*(x*y+w*z),   1-2*(x*x+z*z), 2*(y*z-w*x),
+                          2*(x*z-w*y),   2*(y*z+w*x),   1-2*(x*x+y*y)};
+    Real mid[3];
+    for (int i = 0; i < 3; i++) {
+        mid[i] = (Real(node.lo[i]) + Real(node.hi[i]))/2;
+        box.half[i] = (Real(node.hi[i]) - Real(node.lo[i]))/2;
+    }
+    Real center_M[3];
+    for (int i = 0; i < 3; i++)
+        center_M[i] = R_MB[3*i]*mid[0] + R_MB[3*i+1]*mid[1] 
+                    + R_MB[3*i+2]*mid[2];
+    if (!X_FM) {
+        for (int i = 0; i < 9; i++)
+            box.R[i] = R_MB[i];
+        for (int i = 0; i < 3; i++)
+            box.center[i] = center_M[i];
+        return;
+    }
+    const Mat33& R_FM = X_FM->R().asMat33();
+    const Vec3& p_FM = X_FM->p();
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++)
+            box.R[3*i+j] = R_FM(i,0)*R_MB[j] + R_FM(i,1)*R_MB[3+j] 
+                         + R_FM(i,2)*R_MB[6+j];
+        box.center[i] = p_FM[i] + R_FM(i,0)*center_M[0] 
+                      + R_FM(i,1)*center_M[1] + R_FM(i,2)*center_M[2];
+    }
+}
+
+//==============================================================================
+//                          SEPARATING AXIS TEST
+//==============================================================================
+// The 15 axis test of Gottschalk, Lin and Manocha, "OBBTree: a hierarchical
+// structure for rapid interference detection," SIGGRAPH 1996, with the early
+// acceptance used by OrientedBoundingBox::intersectsBox() when one box's
+// center lies inside the other's slabs. It is written once for a batch of
+// lanes: V holds one value per lane, a plain Real for one box pair at a time
+// or an SSE2 register for two, and M is the matching mask type. A lane can
+// only stop once all lanes are decided, so separation and acceptance are
+// accumulated as masks. A little slop is added to the rotation terms so
+// that nearly parallel edges can't produce a false separation from roundoff.
+
+inline Real add(Real a, Real b) {return a+b;}
+inline Real sub(Real a, Real b) {return a-b;}
+inline Real mul(Real a, Real b) {return a*b;}
+inline Real abs(Real a)         {return std::abs(a);}
+inline bool isGreater(Real a, Real b)  {return a > b;}
+inline bool notGreater(Real a, Real b) {return !(a > b);}
+inline bool either(bool a, bool b)     {return a || b;}
+inline bool both(bool a, bool b)       {return a && b;}
+inline bool butNot(bool a, bool b)     {return a && !b;}
+inline bool allSet(bool a)             {return a;}
+
+#ifdef SimTK_OBB_OVERLAP_USE_SSE2
+inline __m128d add(__m128d a, __m128d b) {return _mm_add_pd(a,b);}
+inline __m128d sub(__m128d a, __m128d b) {return _mm_sub_pd(a,b);}
+inline __m128d mul(__m128d a, __m128d b) {return _mm_mul_pd(a,b);}
+inline __m128d abs(__m128d a) {return _mm_andnot_pd(_mm_set1_pd(-0.), a);}
+inline __m128d isGreater(__m128d a, __m128d b)  {return _mm_cmpgt_pd(a,b);}
+inline __m128d notGreater(__m128d a, __m128d b) {return _mm_cmple_pd(a,b);}
+inline __m128d either(__m128d a, __m128d b)     {return _mm_or_pd(a,b);}
+inline __m128d both(__m128d a, __m128d b)       {return _mm_and_pd(a,b);}
+inline __m128d butNot(__m128d a, __m128d b)     {return _mm_andnot_pd(b,a);}
+inline bool allSet(__m128d a) {return _mm_movemask_pd(a) == 3;}
+#endif
+
+// Box A's axes, center and half-dimensions are RA, cA and a; box B's are RB,
+// cB and b, all expressed in a common frame.
+template <class V, class M>
+M separated(const V RA[9], const V cA[3], const V a[3],
+            const V RB[9], const V cB[3], const V b[3], const V& slop) {
+    // R[i][j] = A axis i . B axis j; t is B's center relative to A's along
+    // A's axes.
+    V R[3][3], AbsR[3][3], t[3];
+    V d[3];
+    for (int k = 0; k < 3; k++)
+        d[k] = sub(cB[k], cA[k]);
+    for (int i = 0; i < 3; i++) {
+        t[i] = add(add(mul(RA[i], d[0]), mul(RA[3+i], d[1])),
+                   mul(RA[6+i], d[2]));
+        for (int j = 0; j < 3; j++) {
+            R[i][j] = add(add(mul(RA[i], RB[j]), mul(RA[3+i], RB[3+j])),
+                          mul(RA[6+i], RB[6+j]));
+            AbsR[i][j] = add(abs(R[i][j]), slop);
+        }
+    }
+
+    // A's axes.
+    M sep = isGreater(abs(t[0]), add(a[0], add(add(mul(b[0], AbsR[0][0]),
+                      mul(b[1], AbsR[0][1])), mul(b[2], AbsR[0][2]))));
+    M inside = notGreater(abs(t[0]), a[0]);
+    for (int i = 1; i < 3; i++) {
+        sep = either(sep, isGreater(abs(t[i]),
+                add(a[i], add(add(mul(b[0], AbsR[i][0]),
+                    mul(b[1], AbsR[i][1])), mul(b[2], AbsR[i][2])))));
+        inside = both(inside, notGreater(abs(t[i]), a[i]));
+    }
+    M accept = inside;
+    if (allSet(either(sep, accept)))
+        return butNot(sep, accept);
+
+    // B's axes.
+    V s = abs(add(add(mul(t[0], R[0][0]), mul(t[1], R[1][0])),
+                  mul(t[2], R[2][0])));
+    sep = either(sep, isGreater(s, add(b[0], add(add(mul(a[0], AbsR[0][0]),
+                 mul(a[1], AbsR[1][0])), mul(a[2], AbsR[2][0])))));
+    inside = notGreater(s, b[0]);
+    for (int j = 1; j < 3; j++) {
+        s = abs(add(add(mul(t[0], R[0][j]), mul(t[1], R[1][j])),
+                    mul(t[2], R[2][j])));
+        sep = either(sep, isGreater(s, add(b[j], add(add(mul(a[0], AbsR[0][j]),
+                     mul(a[1], AbsR[1][j])), mul(a[2], AbsR[2][j])))));
+        inside = both(inside, notGreater(s, b[j]));
+    }
+    accept = either(accept, inside);
+    if (allSet(either(sep, accept)))
+        return butNot(sep, accept);
+
+    // Cross products of one axis from each.
+    for (int i = 0; i < 3; i++) {
+        const int i1 = (i+1)%3, i2 = (i+2)%3;
+        for (int j = 0; j < 3; j++) {
+            const int j1 = (j+1)%3, j2 = (j+2)%3;
+            const V ra = add(mul(a[i1], AbsR[i2][j]), mul(a[i2], AbsR[i1][j]));
+            const V rb = add(mul(b[j1], AbsR[i][j2]), mul(b[j2], AbsR[i][j1]));
+            const V dist = abs(sub(mul(t[i2], R[i1][j]), mul(t[i1], R[i2][j])));
+            sep = either(sep, isGreater(dist, add(ra, rb)));
+        }
+    }
+    return butNot(sep, accept);
+}
+
+const Real Slop = 1e-12;
+
+bool overlaps(const UnpackedBox& A, const UnpackedBox& B) {
+    return !separated<Real,bool>(A.R, A.center, A.half,
+                                 B.R, B.center, B.half, Slop);
+}
+
+#ifdef SimTK_OBB_OVERLAP_USE_SSE2
+// One box per lane, stored as structure of arrays.
+struct BoxLanes {
+    __m128d R[9], center[3], half[3];
+};
+
+void loadLanes(const UnpackedBox& box0, const UnpackedBox& box1,
+               BoxLanes& lanes) {
+    for (int i = 0; i < 9; i++)
+        lanes.R[i] = _mm_set_pd(box1.R[i], box0.R[i]);
+    for (int i = 0; i < 3; i++) {
+        lanes.center[i] = _mm_set_pd(box1.center[i], box0.center[i]);
+        lanes.half[i]   = _mm_set_pd(box1.half[i],   box0.half[i]);
+    }
+}
+
+int separatedLanes(const BoxLanes& A, const BoxLanes& B) {
+    return _mm_movemask_pd(separated<__m128d,__m128d>
+        (A.R, A.center, A.half, B.R, B.center, B.half, _mm_set1_pd(Slop)));
+}
+#endif
+
+// Test each of boxes A[0..numA) against each of B[0..numB), setting
+// overlap[i][j]. With SSE2 the pairs are tested two at a time, with the box
+// that is common to both pairs loaded into both lanes.
+void overlaps(const UnpackedBox A[2], int numA, 
+              const UnpackedBox B[2], int numB, bool overlap[2][2]) {
+#ifdef SimTK_OBB_OVERLAP_USE_SSE2
+    BoxLanes lanesA, lanesB;
+    if (numB == 2) {
+        loadLanes(B[0], B[1], lanesB);
+        for (int i = 0; i < numA; i++) {
+            loadLanes(A[i], A[i], lanesA);
+            const int mask = separatedLanes(lanesA, lanesB);
+            overlap[i][0] = !(mask & 1);
+            overlap[i][1] = !(mask & 2);
+        }
+        return;
+    }
+    if (numA == 2) {
+        loadLanes(A[0], A[1], lanesA);
+        loadLanes(B[0], B[0], lanesB);
+        const int mask = separatedLanes(lanesA, lanesB);
+        overlap[0][0] = !(mask & 1);
+        overlap[1][0] = !(mask & 2);
+        return;
+    }
+#endif
+    for (int i = 0; i < numA; i++)
+        for (int j = 0; j < numB; j++)
+            overlap[i][j] = overlaps(A[i], B[j]);
+}
+
+}
+
+//==============================================================================
+//                     OBB TREE IMPL :: FIND OVERLAPPING LEAVES
+//==============================================================================
+// Iterative dual-tree traversal. Each pair taken off the stack is known to
+// overlap; we split whichever nodes aren't leaves (both if neither is), test
+// all the resulting child pairs as one batch, and keep the ones that still
+// overlap. This visits exactly the node pairs that the old recursive
+// traversal did, just in a different order.
+void OBBTreeImpl::findOverlappingLeaves
+   (const OBBTreeImpl& other, const Transform& X_MO,
+    Array_< std::pair<int,int> >& leafPairs) const
+{
+    UnpackedBox rootA, rootB;
+    unpackBox(nodes[0], 0, rootA);
+    unpackBox(other.nodes[0], &X_MO, rootB);
+    if (!overlaps(rootA, rootB))
+        return;
+
+    Array_< std::pair<int,int> > stack;
+    stack.push_back(std::make_pair(0, 0));
+    while (!stack.empty()) {
+        const std::pair<int,int> pair = stack.back();
+        stack.pop_back();
+        const int n1 = pair.first, n2 = pair.second;
+        if (isLeaf(n1) && other.isLeaf(n2)) {
+            leafPairs.push_back(pair);
+            continue;
+        }
+
+        // Children (or the node itself, if it is a leaf) on each side.
+        int kids1[2] = {n1, n1}, kids2[2] = {n2, n2};
+        int num1 = 1, num2 = 1;
+        if (!isLeaf(n1)) {
+            kids1[0] = getFirstChild(n1); kids1[1] = getSecondChild(n1);
+            num1 = 2;
+        }
+        if (!other.isLeaf(n2)) {
+            kids2[0] = other.getFirstChild(n2);
+            kids2[1] = other.getSecondChild(n2);
+            num2 = 2;
+        }
+        UnpackedBox boxes1[2], boxes2[2];
+        for (int i = 0; i < num1; i++)
+            unpackBox(nodes[kids1[i]], 0, boxes1[i]);
+        for (int j = 0; j < num2; j++)
+            unpackBox(other.nodes[kids2[j]], &X_MO, boxes2[j]);
+
+        bool overlap[2][2];
+        overlaps(boxes1, num1, boxes2, num2, overlap);
+        for (int i = num1-1; i >= 0; i--) // so the first pair is popped first
+            for (int j = num2-1; j >= 0; j--)
+                if (overlap[i][j])
+                    stack.push_back(std::make_pair(kids1[i], kids2[j]));
+    }
+}
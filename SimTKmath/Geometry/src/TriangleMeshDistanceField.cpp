@@ -0,0 +1,169 @@
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/internal/common.h"
+#include "simmath/internal/ContactGeometry.h"
+
+#include "ContactGeometryImpl.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace SimTK;
+
+// Don't let a badly chosen cell size eat all of memory.
+static const double MaxBlocks = 1e7;
+
+// Samples are stored in single precision; this allows for their roundoff.
+static const Real SampleTol = 1e-6;
+
+//==============================================================================
+//                         DISTANCE FIELD IMPL :: BUILD
+//==============================================================================
+// The exact signed distance of a point from the mesh surface, negative inside,
+// using the same inside test as findNearestPoint().
+static Real calcSignedDistance(const ContactGeometry::TriangleMesh::Impl& mesh,
+                               const Vec3& position) {
+    bool inside;
+    int face;
+    Vec2 uv;
+    const Vec3 nearest = mesh.findNearestPoint(position, inside, face, uv);
+    const Real distance = (position-nearest).norm();
+    return inside ? -distance : distance;
+}
+
+void DistanceFieldImpl::build(const ContactGeometry::TriangleMesh::Impl& mesh,
+                              Real cellSize) {
+    clear();
+    Vec3 lo(MostPositiveReal), hi(MostNegativeReal);
+    for (int i = 0; i < (int) mesh.vertices.size(); i++) {
+        const Vec3& pos = mesh.vertices[i].pos;
+        for (int j = 0; j < 3; j++) {
+            lo[j] = std::min(lo[j], pos[j]);
+            hi[j] = std::max(hi[j], pos[j]);
+        }
+    }
+
+    // Leave a block of room all around the mesh.
+    const Real blockSize = BlockSize*cellSize;
+    double totalBlocks = 1;
+    int nb[3];
+    for (int j = 0; j < 3; j++) {
+        totalBlocks *= std::ceil((hi[j]-lo[j])/blockSize) + 2;
+        SimTK_ERRCHK2_ALWAYS(totalBlocks <= MaxBlocks,
+            "ContactGeometry::TriangleMesh::createDistanceField()",
+            "A cell size of %g would need more than %g blocks; use a larger "
+            "cell size.", cellSize, MaxBlocks);
+        nb[j] = (int) std::ceil((hi[j]-lo[j])/blockSize) + 2;
+    }
+
+    DistanceFieldImpl field;
+    field.origin = lo - Vec3(blockSize);
+    field.cellSize = cellSize;
+    for (int j = 0; j < 3; j++)
+        field.numBlocks[j] = nb[j];
+    field.blocks.resize(nb[0]*nb[1]*nb[2]);
+    field.farDistance.resize(field.blocks.size());
+
+    // A block whose center is farther from the surface than this can't have
+    // any point within a cell diagonal of the surface, so it can't have the
+    // surface passing through any of its cells.
+    const Real halfDiagonal = std::sqrt(Real(3))*blockSize/2;
+    const Real band = halfDiagonal + std::sqrt(Real(3))*cellSize;
+    const int n = BlockSize+1;
+    for (int bx = 0; bx < nb[0]; bx++)
+      for (int by = 0; by < nb[1]; by++)
+        for (int bz = 0; bz < nb[2]; bz++) {
+            const int b = (bx*nb[1] + by)*nb[2] + bz;
+            const Vec3 corner = field.origin + blockSize*Vec3(bx, by, bz);
+            const Real centerDistance =
+                calcSignedDistance(mesh, corner + Vec3(blockSize/2));
+            field.farDistance[b] = (float) centerDistance;
+            if (std::abs(centerDistance) > band) {
+                field.blocks[b] = -1;
+                continue;
+            }
+            field.blocks[b] = (int) field.samples.size();
+            for (int i = 0; i < n; i++)
+                for (int j = 0; j < n; j++)
+                    for (int k = 0; k < n; k++)
+                        field.samples.push_back((float) calcSignedDistance
+                           (mesh, corner + cellSize*Vec3(i, j, k)));
+        }
+    field.farError = halfDiagonal*(1+SampleTol);
+    *this = field;
+}
+
+void DistanceFieldImpl::clear() {
+    blocks.clear();
+    farDistance.clear();
+    samples.clear();
+}
+
+//==============================================================================
+//                  DISTANCE FIELD IMPL :: ESTIMATE SIGNED DISTANCE
+//==============================================================================
+// Signed distance is Lipschitz continuous with constant 1, so trilinear
+// interpolation of exact samples at the corners of a cell is in error by no
+// more than the distance to the farthest corner, a cell diagonal. That 
+// relies on the inside test getting the samples' signs right, which it does
+// for a closed mesh.
+bool DistanceFieldImpl::estimateSignedDistance
+   (const Vec3& position, Real& distance, Real& maxError) const
+{
+    if (blocks.empty())
+        return false;
+    int cell[3];
+    Real frac[3];
+    for (int j = 0; j < 3; j++) {
+        const Real x = (position[j]-origin[j])/cellSize;
+        const int numCells = numBlocks[j]*BlockSize;
+        if (!(x >= 0 && x < numCells)) // also catches NaN
+            return false;
+        cell[j] = std::min((int) x, numCells-1);
+        frac[j] = x - cell[j];
+    }
+    const int b = ((cell[0]/BlockSize)*numBlocks[1] + cell[1]/BlockSize)
+                  *numBlocks[2] + cell[2]/BlockSize;
+    if (blocks[b] < 0) {
+        distance = farDistance[b];
+        maxError = farError + SampleTol*std::abs(distance);
+        return true;
+    }
+
+    const int n = BlockSize+1;
+    const float* s = &samples[blocks[b]]
+        + ((cell[0]%BlockSize)*n + cell[1]%BlockSize)*n + cell[2]%BlockSize;
+    const Real c[8] = {s[0],   s[1],   s[n],   s[n+1],
+                       s[n*n], s[n*n+1], s[n*n+n], s[n*n+n+1]};
+    const Real x = frac[0], y = frac[1], z = frac[2];
+    const Real c00 = c[0] + z*(c[1]-c[0]), c01 = c[2] + z*(c[3]-c[2]);
+    const Real c10 = c[4] + z*(c[5]-c[4]), c11 = c[6] + z*(c[7]-c[6]);
+    const Real c0 = c00 + y*(c01-c00), c1 = c10 + y*(c11-c10);
+    distance = c0 + x*(c1-c0);
+
+    const Real diagonal = std::sqrt(Real(3))*cellSize;
+    maxError = diagonal*(1+SampleTol) + SampleTol*std::abs(distance);
+    return true;
+}
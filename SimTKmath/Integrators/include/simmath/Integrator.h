@@ -36,6 +36,7 @@ namespace SimTK {
 
     
 class IntegratorRep;
+class IntegratorTelemetry;
 
 /** An Integrator is an object that can advance the State of a System 
 through time. This is an abstract class. Subclasses implement a variety of 
@@ -401,6 +402,15 @@ public:
     /// matrix recomputed at each iteration if you want.
     void setForceFullNewton(bool forceFullNewton);
 
+    /// (Advanced) Send a record describing every step attempt to the given
+    /// telemetry sink, which must outlive its use here; pass null (the
+    /// default) to turn telemetry off. A TimeStepper using this Integrator
+    /// also records the events it handles in the same sink. See
+    /// IntegratorTelemetry for details.
+    void setTelemetry(IntegratorTelemetry* telemetry);
+    /// (Advanced) Return the telemetry sink in use, or null if none.
+    IntegratorTelemetry* getTelemetry() const;
+
     /// OBSOLETE: use getSuccessfulStepStatusString().
     static String successfulStepStatusString(SuccessfulStepStatus stat)
     {   return getSuccessfulStepStatusString(stat); }
@@ -0,0 +1,149 @@
+#ifndef SimTK_SIMMATH_INTEGRATOR_TELEMETRY_H_
+#define SimTK_SIMMATH_INTEGRATOR_TELEMETRY_H_
+
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/internal/common.h"
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+
+namespace SimTK {
+
+/** This is a fixed-capacity ring buffer that receives one record for every
+step attempted by an Integrator and for every batch of events handled by a
+TimeStepper, for use in tuning accuracy and tolerance settings. Telemetry is
+off by default; you turn it on by giving the Integrator a sink with
+Integrator::setTelemetry(). When no sink is set, the only cost is a null
+pointer test per step.
+
+The buffer is lock free for a single producer (the thread running the
+Integrator) and a single consumer, so you can drain it from another thread
+while the simulation is running. If the consumer falls behind, new records
+are discarded rather than blocking the simulation; getNumDropped() tells you
+how many were lost.
+
+Example:
+@code
+    IntegratorTelemetry telemetry(1 << 16);
+    integ.setTelemetry(&telemetry);
+    ts.stepTo(10);
+    std::ofstream log("steps.bin", std::ios::binary);
+    telemetry.writeBinary(log);
+@endcode
+
+Only integrators derived from the common explicit integrator implementation
+(all those supplied with Simbody except CPodesIntegrator) produce step
+records. **/
+class SimTK_SIMMATH_EXPORT IntegratorTelemetry {
+public:
+    /** What a Record describes. **/
+    enum Kind {
+        StepAccepted        = 0, ///< step succeeded and time advanced
+        ErrorTestFailed     = 1, ///< step rejected; error norm too large
+        ConvergenceFailed   = 2, ///< step rejected; iteration didn't converge
+        EventsHandled       = 3  ///< TimeStepper invoked event handlers
+    };
+
+    /** One telemetry record. This is a plain struct of fixed size so that it
+    can be copied cheaply and written directly to a binary log. The counts are
+    the number of realizations and projections performed since the previous
+    record, so summing them over a log gives the Integrator totals. **/
+    struct Record {
+        double          time;           ///< t at start of step, or event time
+        double          stepSize;       ///< step size attempted
+        double          errorNorm;      ///< compared with accuracy; NaN for events
+        std::int32_t    kind;           ///< one of the Kind values
+        std::int32_t    worstComponent; ///< y index with largest error, or -1
+        std::int32_t    numIterations;  ///< iterations used by the step
+        std::int32_t    numRealizations;
+        std::int32_t    numProjections; ///< q and u projections
+        std::int32_t    numEvents;      ///< event ids handled, or 0
+    };
+
+    /** Create a telemetry sink that can hold at least \a capacity undrained
+    records; the capacity is rounded up to a power of two. **/
+    explicit IntegratorTelemetry(int capacity = 4096);
+    ~IntegratorTelemetry();
+
+    /** Return the number of records that can be held before new ones are
+    dropped. **/
+    int getCapacity() const {return (int)(mask+1);}
+
+    /** Add a record. This is called by the producer thread only. Returns false
+    and counts the record as dropped if the buffer is full. **/
+    bool push(const Record& record);
+
+    /** Remove the oldest record, if any, into \a record. This is called by the
+    consumer thread only. Returns false if the buffer was empty. **/
+    bool pop(Record& record);
+
+    /** Remove all currently available records and append them to
+    \a records. Returns the number of records removed. Consumer only. **/
+    int drain(Array_<Record>& records);
+
+    /** Return the number of records currently waiting to be drained. This is
+    approximate if the producer is running. **/
+    int size() const;
+
+    /** Return the number of records that were discarded because the buffer
+    was full. **/
+    std::int64_t getNumDropped() const
+    {   return numDropped.load(std::memory_order_relaxed); }
+
+    /** Drain the buffer into a compact binary log on \a o, which should be
+    opened in binary mode. The log is a 16-byte header (magic "SimTKitl",
+    format version, record size) followed by the raw records in native byte
+    order. Returns the number of records written. Consumer only. **/
+    int writeBinary(std::ostream& o);
+
+    /** Read a log written by writeBinary(), appending its records to
+    \a records. Throws if the header isn't recognized. **/
+    static void readBinary(std::istream& i, Array_<Record>& records);
+
+    /** Return a readable name for a Kind, for use in reports. **/
+    static const char* getKindName(Kind kind);
+
+private:
+    // This class is not copyable.
+    IntegratorTelemetry(const IntegratorTelemetry&) = delete;
+    IntegratorTelemetry& operator=(const IntegratorTelemetry&) = delete;
+
+    Record*                     buffer;
+    std::uint64_t               mask;
+    // Padding keeps the producer's and consumer's indices on separate cache
+    // lines so they don't contend.
+    char                        pad0[64];
+    std::atomic<std::uint64_t>  head; // next slot to write (producer)
+    char                        pad1[64];
+    std::atomic<std::uint64_t>  tail; // next slot to read (consumer)
+    char                        pad2[64];
+    std::atomic<std::int64_t>   numDropped;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMMATH_INTEGRATOR_TELEMETRY_H_
@@ -0,0 +1,154 @@
+#ifndef SimTK_SIMMATH_PARAREAL_DRIVER_H_
+#define SimTK_SIMMATH_PARAREAL_DRIVER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/internal/common.h"
+
+#include <iosfwd>
+
+namespace SimTK {
+
+class PararealDriverRep;
+
+/** This class advances a System over a long time interval using the
+Parareal parallel-in-time algorithm, so that several processors can work on
+a single trajectory.
+
+The interval [t0,tFinal] is divided into N equal time slices. A cheap,
+inaccurate "coarse" integrator (for example explicit Euler with large fixed
+steps) is run serially across all the slices to predict the State at each
+slice boundary. Then an accurate "fine" integrator is run on every slice
+concurrently, each starting from the current prediction for that slice's
+initial State. The predictions are corrected using the difference between
+the fine and coarse results: <pre>
+    U[n+1] = G(U_new[n]) + F(U_old[n]) - G(U_old[n])
+</pre> where F and G are the fine and coarse propagators. This is repeated
+until the boundary States stop changing. After k iterations the first k
+slices are guaranteed to agree with a serial fine solution, so the method
+always terminates after at most N iterations; it pays off only when it
+converges in many fewer iterations than there are slices.
+
+Each slice is advanced by its own Integrator and TimeStepper, so event
+handlers will be invoked within a slice as usual. However, the correction
+above is applied only to the continuous variables y=(q,u,z); discrete
+variables are taken from the coarse solution. Parareal is therefore best
+suited to smooth, conservative or dissipative systems without discrete
+state changes. Position and velocity constraints are re-enforced after
+every correction since a linear combination of States does not in general
+satisfy them.
+
+Example:
+@code
+    PararealDriver parareal(system);
+    parareal.setCoarseIntegrator(PararealDriver::ExplicitEuler, 1e-2);
+    parareal.setFineIntegrator(PararealDriver::RungeKuttaMerson, 1e-6);
+    parareal.setNumTimeSlices(32);
+    parareal.simulate(initState, 10.);
+    parareal.writeConvergenceReport(std::cout);
+    const State& finalState = parareal.getState();
+@endcode **/
+class SimTK_SIMMATH_EXPORT PararealDriver {
+public:
+    /** The integration methods that can be used for the coarse and fine
+    propagators. Each slice gets its own instance. **/
+    enum Method {
+        ExplicitEuler       = 1,
+        RungeKutta2         = 2,
+        RungeKutta3         = 3,
+        RungeKuttaMerson    = 4,
+        RungeKuttaFeldberg  = 5,
+        SemiExplicitEuler2  = 6,
+        Verlet              = 7
+    };
+
+    /** Create a Parareal driver for this System. The defaults are 16 time
+    slices, explicit Euler with 10 fixed steps per slice as the coarse
+    propagator, and Runge-Kutta-Merson with accuracy 1e-6 as the fine
+    propagator. **/
+    explicit PararealDriver(const System& system);
+    ~PararealDriver();
+
+    /** Set the number of time slices N into which the simulation interval is
+    divided. This is the available parallelism; ideally it is a small multiple
+    of the number of processors. **/
+    void setNumTimeSlices(int numSlices);
+    /** Use this fixed-step method for the serial coarse propagator. If
+    \a stepSize is larger than a time slice, one step per slice is taken. **/
+    void setCoarseIntegrator(Method method, Real stepSize);
+    /** Use this error-controlled method for the parallel fine propagator. The
+    accuracy is also used as the constraint tolerance. **/
+    void setFineIntegrator(Method method, Real accuracy);
+    /** Parareal has converged when no slice boundary State changes by more
+    than this relative amount in an iteration. The default is 10 times the
+    fine integrator accuracy. **/
+    void setConvergenceTolerance(Real tol);
+    /** Stop after this many iterations even if not converged. The default
+    (and maximum useful value) is the number of slices. **/
+    void setMaxIterations(int maxIterations);
+    /** Limit the number of threads used for the fine propagators. The
+    default is the number of processors. **/
+    void setNumThreads(int numThreads);
+
+    /** Run the Parareal iteration from \a initState to \a tFinal. Returns true
+    if the iteration converged; otherwise the best available result is still
+    accessible from getState(). **/
+    bool simulate(const State& initState, Real tFinal);
+
+    /** Return the State at the end of the simulation. **/
+    const State& getState() const;
+    /** Return the State at slice boundary n, 0 <= n <= N, where boundary 0 is
+    the initial State and boundary N the final one. **/
+    const State& getSliceState(int n) const;
+
+    int  getNumTimeSlices() const;
+    /** Return true if the most recent call to simulate() converged. **/
+    bool isConverged() const;
+    /** Return the number of Parareal iterations (parallel fine sweeps) that
+    were performed by the most recent call to simulate(). **/
+    int  getNumIterations() const;
+    /** Return the largest relative change in any slice boundary State that
+    was made by iteration k, 0 <= k < getNumIterations(). **/
+    Real getCorrectionNorm(int k) const;
+    /** Return the total number of steps taken by all the fine integrators
+    in all iterations. **/
+    int  getNumFineSteps() const;
+    /** Return the total number of steps taken by the coarse integrator. **/
+    int  getNumCoarseSteps() const;
+    /** Write a human-readable summary of the iterations of the most recent
+    simulation, including the correction made at each iteration. **/
+    void writeConvergenceReport(std::ostream& o) const;
+
+private:
+    // This class is not copyable.
+    PararealDriver(const PararealDriver&) = delete;
+    PararealDriver& operator=(const PararealDriver&) = delete;
+
+    PararealDriverRep* rep;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMMATH_PARAREAL_DRIVER_H_
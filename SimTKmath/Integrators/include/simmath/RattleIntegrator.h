@@ -0,0 +1,91 @@
+#ifndef SimTK_SIMMATH_RATTLE_INTEGRATOR_H_
+#define SimTK_SIMMATH_RATTLE_INTEGRATOR_H_
+
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/internal/common.h"
+#include "simmath/Integrator.h"
+
+namespace SimTK {
+
+class RattleIntegratorRep;
+
+/** This is a fixed-step, second order variational integrator intended for
+long-duration simulation of conservative systems, including systems with
+holonomic constraints.
+
+Like VerletIntegrator used in fixed step mode, this method is time-reversible
+and (for systems without constraints or velocity-dependent forces) symplectic.
+Unlike VerletIntegrator, which integrates velocities with an error-controlled
+trapezoid rule and projects only when constraint errors become large, this
+integrator treats the constraints as part of the discrete variational
+principle: the position constraint projection is applied after every drift
+and the velocity constraint projection after every kick, as in the RATTLE
+method for constrained Hamiltonian systems. The result is that for
+unconstrained conservative systems the energy error stays bounded (it
+oscillates but does not drift) over very long simulations, even at step sizes
+much larger than a variable-step Runge-Kutta method would need to achieve
+comparable energy behavior. With constraints, see the note on projections
+below.
+
+There is no error estimator for this integrator so it cannot adjust the
+step size. The step size may be reduced to isolate events, and the method is
+capable of interpolation if you want reports at shorter intervals than the
+step size. Any reduction of the step size interrupts the symplectic behavior
+briefly, so for best results choose a step size that evenly divides your
+reporting interval.
+
+<h3>Theory</h3>
+
+Each step is a half kick, a drift, and a second half kick: <pre>
+    u*  = u0 + h/2 udot(q0,u0)
+    q1  = q0 + h N(q0) u*         then project q1 onto position constraints
+    u1  = u* + h/2 udot(q1,u1)    then project u1 onto velocity constraints
+</pre> The second kick is implicit in u when there are velocity-dependent
+accelerations (including the Coriolis terms that appear in internal
+coordinates); we solve it with functional iteration, which converges in one
+iteration when accelerations depend only on positions. Auxiliary variables z
+are advanced with the trapezoid rule in the same iteration. The projections
+use the same local coordinate projection as the other Simbody integrators.
+The velocity projection is the orthogonal (mass-weighted) one that corresponds
+to the second RATTLE multiplier. The position projection however moves q1
+along the constraint gradient evaluated at q1 rather than at q0 as in exact
+RATTLE (SHAKE), so with position constraints the method is only approximately
+symmetric and there can be a slow energy drift that vanishes rapidly as the
+step size is reduced. The projected change in q is fed back into the half-step
+velocity u* so that the drift is much smaller than it would be otherwise.
+
+See Hairer, Lubich & Wanner, Geometric Numerical Integration, 2nd ed. 2006,
+section VII.1.4 for a discussion of RATTLE and its variational origin. **/
+class SimTK_SIMMATH_EXPORT RattleIntegrator : public Integrator {
+public:
+    /** Create a RattleIntegrator for integrating a System with fixed size
+    steps. **/
+    RattleIntegrator(const System& sys, Real stepSize);
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMMATH_RATTLE_INTEGRATOR_H_
@@ -0,0 +1,91 @@
+#ifndef SimTK_SIMMATH_ROSENBROCK_W_INTEGRATOR_H_
+#define SimTK_SIMMATH_ROSENBROCK_W_INTEGRATOR_H_
+
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/internal/common.h"
+#include "simmath/Integrator.h"
+
+namespace SimTK {
+
+class RosenbrockWIntegratorRep;
+
+/** This is an error-controlled, linearly implicit (Rosenbrock-W) integrator
+for moderately stiff systems, such as those with compliant contact.
+
+Explicit Runge-Kutta methods are limited to very small steps by stiff force
+elements like Hunt-Crossley or elastic foundation contact, regardless of the
+accuracy requested. Fully implicit methods like CPodesIntegrator remove that
+limit but solve a nonlinear system with Newton iterations at every step. A
+Rosenbrock method instead solves a fixed number of linear systems per step
+with the same matrix W = I - gamma*h*J, where J is an approximation to the
+Jacobian df/dy of the system's state derivatives. That requires one LU
+factorization per step and no iteration. Because this is a W-method, its
+order does not depend on J being exact, so a Jacobian is formed only
+occasionally and reused for many steps while the step size changes.
+
+The method is the two-stage, second order, L-stable ROS2 of Verwer et al.,
+with gamma = 1 + 1/sqrt(2): <pre>
+    W k1 = f(t0, y0)
+    W k2 = f(t0+h, y0 + h k1) - 2 k1
+    y1   = y0 + h (3/2 k1 + 1/2 k2)
+</pre> The embedded first order solution y0 + h k1 (linearly implicit Euler)
+provides the error estimate. Position and velocity constraints are handled
+by projection after each step, in the same way as the explicit integrators.
+
+J is formed by finite differencing the system's state derivatives, which
+costs one realization through Stage::Acceleration per state variable. It is
+recomputed when an error test failure occurs on a step that was using an old
+Jacobian, and otherwise after a fixed number of steps (see
+setJacobianReuseLimit()). For systems with many state variables and mild
+stiffness an explicit integrator will usually be faster.
+
+See J.G. Verwer, E.J. Spee, J.G. Blom, W. Hundsdorfer, "A second-order
+Rosenbrock method applied to photochemical dispersion problems", SIAM J. Sci.
+Comput. 20(4):1456-1480, 1999, and Hairer & Wanner, Solving ODEs II, 2nd
+rev. ed., section IV.7. **/
+class SimTK_SIMMATH_EXPORT RosenbrockWIntegrator : public Integrator {
+public:
+    /** Create a RosenbrockWIntegrator for integrating a System with variable
+    size steps. **/
+    explicit RosenbrockWIntegrator(const System& sys);
+    /** Create a RosenbrockWIntegrator for integrating a System with fixed size
+    steps. **/
+    RosenbrockWIntegrator(const System& sys, Real stepSize);
+
+    /** Form a new Jacobian at least every \a numSteps steps, even if all
+    the steps are succeeding. The default is 20; use 1 to form a Jacobian at
+    every step. **/
+    void setJacobianReuseLimit(int numSteps);
+    /** Return the number of Jacobians formed since the last initialize(). **/
+    int getNumJacobianEvaluations() const;
+    /** Return the number of LU factorizations of the iteration matrix since
+    the last initialize(). **/
+    int getNumFactorizations() const;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMMATH_ROSENBROCK_W_INTEGRATOR_H_
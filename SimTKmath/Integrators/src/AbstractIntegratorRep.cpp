@@ -209,6 +209,42 @@ bool AbstractIntegratorRep::attemptDAEStep
 
 
 
+//==============================================================================
+//                              CALC STAGE Y
+//==============================================================================
+// The y's and ydots we're given are always full Vectors belonging to a State
+// or to an integrator temporary so they should be contiguous, but we'll check
+// and fall back to ordinary Vector arithmetic if not.
+void AbstractIntegratorRep::calcStageY
+   (const Vector& y0, Real h, int nTerms, const Real c[],
+    const Vector* const f[], Vector& out)
+{
+    const int n = y0.size();
+    assert(out.size() == n);
+    const Real* fdata[8];
+    bool allContiguous = nTerms <= 8 && y0.hasContiguousData()
+                                     && out.hasContiguousData();
+    for (int k=0; allContiguous && k < nTerms; ++k) {
+        assert(f[k]->size() == n);
+        allContiguous = f[k]->hasContiguousData();
+        fdata[k] = f[k]->getContiguousScalarData();
+    }
+
+    if (allContiguous) {
+        VectorKernels::calcLinearCombination
+           (y0.getContiguousScalarData(), h, nTerms, c, fdata, n,
+            out.updContiguousScalarData());
+        return;
+    }
+
+    out = y0;
+    for (int k=0; k < nTerms; ++k)
+        if (c[k] != 0)
+            out += (h*c[k]) * (*f[k]);
+}
+
+
+
 //==============================================================================
 //                                  STEP TO
 //==============================================================================
@@ -574,6 +610,18 @@ bool AbstractIntegratorRep::takeOneStep(Real tMax, Real tReport)
             if (isNaN(actualInitialStepSizeTaken))
                     actualInitialStepSizeTaken = lastStepSize;
         }
+
+        if (getTelemetry()) {
+            IntegratorTelemetry::Record r;
+            r.time = t0; r.stepSize = t1-t0; r.errorNorm = errNorm;
+            r.kind = stepSucceeded ? IntegratorTelemetry::StepAccepted
+                   : converged     ? IntegratorTelemetry::ErrorTestFailed
+                                   : IntegratorTelemetry::ConvergenceFailed;
+            r.worstComponent = worstY;
+            r.numIterations = numIterations;
+            r.numEvents = 0;
+            recordTelemetry(r);
+        }
     } while (!stepSucceeded);
     
     // The step succeeded. Check for event triggers. If there aren't any, we're
@@ -118,6 +118,16 @@ protected:
         return false;
     }
 
+    // Explicit Runge-Kutta methods form each stage as a linear combination
+    //      out = y0 + h*(c[0]*f[0] + ... + c[nTerms-1]*f[nTerms-1])
+    // of the starting y and some previously-computed stage derivatives. This
+    // evaluates that with vectorized kernels and no temporaries. All the
+    // Vectors must be the same size already, and out must not be one of the
+    // f's (it may be y0).
+    static void calcStageY(const Vector& y0, Real h, int nTerms,
+                           const Real c[], const Vector* const f[],
+                           Vector& out);
+
 
     /**
      * Evaluate the error that occurred in the step we just attempted, and 
@@ -282,6 +282,12 @@ bool Integrator::isInfinityNormInUse() const
 void Integrator::setForceFullNewton(bool forceFullNewton) {
     updRep().userForceFullNewton = forceFullNewton ? 1 : 0;
 }
+void Integrator::setTelemetry(IntegratorTelemetry* telemetry) {
+    updRep().setTelemetry(telemetry);
+}
+IntegratorTelemetry* Integrator::getTelemetry() const {
+    return getRep().getTelemetry();
+}
 void Integrator::setReturnEveryInternalStep(bool shouldReturn) {
     updRep().userReturnEveryInternalStep = shouldReturn ? 1 : 0;
 }
@@ -318,7 +324,8 @@ int Integrator::getMethodMaxOrder() const {
 IntegratorRep::IntegratorRep
        (Integrator*               handle,
         const System&             system)
-  : myHandle(handle), sys(system)
+  : myHandle(handle), sys(system), telemetry(nullptr),
+    telemetryRealizations(0), telemetryProjections(0)
 {
     invalidateIntegratorInternalState();
     initializeUserStuff();
@@ -32,6 +32,7 @@
 
 #include "SimTKcommon.h"
 #include "simmath/Integrator.h"
+#include "simmath/IntegratorTelemetry.h"
 
 #include <exception>
 #include <limits>
@@ -949,6 +950,29 @@ protected:
     int getNumQProjectionFailures() const {return statsQProjectionFailures;} 
     int getNumUProjectionFailures() const {return statsUProjectionFailures;} 
 
+    IntegratorTelemetry* getTelemetry() const {return telemetry;}
+    void setTelemetry(IntegratorTelemetry* sink) {
+        telemetry = sink;
+        if (telemetry) {
+            telemetryRealizations = statsRealizations;
+            telemetryProjections  = statsQProjections + statsUProjections;
+        }
+    }
+
+    // Send a record to the telemetry sink; the realization and projection
+    // counts are filled in here as the change since the previous record.
+    // Callers should check getTelemetry() first so that nothing is done when
+    // telemetry is off.
+    void recordTelemetry(IntegratorTelemetry::Record& record) const {
+        assert(telemetry);
+        const int nproj = statsQProjections + statsUProjections;
+        record.numRealizations = statsRealizations - telemetryRealizations;
+        record.numProjections  = nproj - telemetryProjections;
+        telemetryRealizations  = statsRealizations;
+        telemetryProjections   = nproj;
+        telemetry->push(record);
+    }
+
 private:
     class EventSorter {
     public:
@@ -1004,6 +1028,11 @@ protected:
     mutable int statsQProjections, statsUProjections;
     mutable int statsRealizations;
     mutable int statsRealizationFailures;
+
+    // Optional per-step telemetry sink, not owned; null when disabled. We
+    // remember the counters at the last record so we can report changes.
+    IntegratorTelemetry* telemetry;
+    mutable int telemetryRealizations, telemetryProjections;
 private:
 
         // SYSTEM INFORMATION
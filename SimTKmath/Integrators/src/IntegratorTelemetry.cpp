@@ -0,0 +1,139 @@
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/IntegratorTelemetry.h"
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+using namespace SimTK;
+
+static const char           LogMagic[8]  = {'S','i','m','T','K','i','t','l'};
+static const std::uint32_t  LogVersion   = 1;
+
+IntegratorTelemetry::IntegratorTelemetry(int capacity)
+:   buffer(nullptr), mask(0), head(0), tail(0), numDropped(0) {
+    SimTK_APIARGCHECK1_ALWAYS(capacity > 0, "IntegratorTelemetry",
+        "IntegratorTelemetry", "Capacity must be positive but was %d.",
+        capacity);
+    std::uint64_t n = 1;
+    while (n < (std::uint64_t)capacity)
+        n <<= 1;
+    buffer = new Record[n];
+    mask = n-1;
+}
+
+IntegratorTelemetry::~IntegratorTelemetry() {
+    delete[] buffer;
+}
+
+// The producer owns head and the consumer owns tail. Each publishes its index
+// with a release store after touching the slot, and reads the other's index
+// with an acquire load, so a slot is never read and written at the same time.
+bool IntegratorTelemetry::push(const Record& record) {
+    const std::uint64_t h = head.load(std::memory_order_relaxed);
+    const std::uint64_t t = tail.load(std::memory_order_acquire);
+    if (h - t > mask) { // full
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    buffer[h & mask] = record;
+    head.store(h+1, std::memory_order_release);
+    return true;
+}
+
+bool IntegratorTelemetry::pop(Record& record) {
+    const std::uint64_t t = tail.load(std::memory_order_relaxed);
+    const std::uint64_t h = head.load(std::memory_order_acquire);
+    if (t == h)
+        return false;
+    record = buffer[t & mask];
+    tail.store(t+1, std::memory_order_release);
+    return true;
+}
+
+int IntegratorTelemetry::drain(Array_<Record>& records) {
+    const std::uint64_t t = tail.load(std::memory_order_relaxed);
+    const std::uint64_t h = head.load(std::memory_order_acquire);
+    for (std::uint64_t i = t; i != h; ++i)
+        records.push_back(buffer[i & mask]);
+    tail.store(h, std::memory_order_release);
+    return (int)(h - t);
+}
+
+int IntegratorTelemetry::size() const {
+    const std::uint64_t t = tail.load(std::memory_order_acquire);
+    const std::uint64_t h = head.load(std::memory_order_acquire);
+    return (int)(h - t);
+}
+
+int IntegratorTelemetry::writeBinary(std::ostream& o) {
+    const std::uint32_t recordSize = sizeof(Record);
+    o.write(LogMagic, sizeof(LogMagic));
+    o.write((const char*)&LogVersion, sizeof(LogVersion));
+    o.write((const char*)&recordSize, sizeof(recordSize));
+
+    // Write directly from the ring in at most two contiguous pieces.
+    const std::uint64_t t = tail.load(std::memory_order_relaxed);
+    const std::uint64_t h = head.load(std::memory_order_acquire);
+    const std::uint64_t n = h - t, first = t & mask;
+    const std::uint64_t n1 = std::min(n, mask+1 - first);
+    o.write((const char*)&buffer[first], n1*sizeof(Record));
+    o.write((const char*)&buffer[0], (n-n1)*sizeof(Record));
+    tail.store(h, std::memory_order_release);
+
+    SimTK_ERRCHK_ALWAYS(o.good(), "IntegratorTelemetry::writeBinary()",
+        "Failed to write telemetry log.");
+    return (int)n;
+}
+
+void IntegratorTelemetry::readBinary(std::istream& i, Array_<Record>& records) {
+    char magic[8]; std::uint32_t version=0, recordSize=0;
+    i.read(magic, sizeof(magic));
+    i.read((char*)&version, sizeof(version));
+    i.read((char*)&recordSize, sizeof(recordSize));
+    SimTK_ERRCHK_ALWAYS(i.good()
+                        && std::memcmp(magic, LogMagic, sizeof(magic))==0,
+        "IntegratorTelemetry::readBinary()",
+        "Input is not an integrator telemetry log.");
+    SimTK_ERRCHK2_ALWAYS(version==LogVersion && recordSize==sizeof(Record),
+        "IntegratorTelemetry::readBinary()",
+        "Unsupported telemetry log version %u or record size %u.",
+        (unsigned)version, (unsigned)recordSize);
+
+    Record r;
+    while (i.read((char*)&r, sizeof(Record)))
+        records.push_back(r);
+}
+
+const char* IntegratorTelemetry::getKindName(Kind kind) {
+    switch (kind) {
+    case StepAccepted:      return "StepAccepted";
+    case ErrorTestFailed:   return "ErrorTestFailed";
+    case ConvergenceFailed: return "ConvergenceFailed";
+    case EventsHandled:     return "EventsHandled";
+    }
+    return "UNKNOWN";
+}
@@ -0,0 +1,324 @@
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+#include "simmath/PararealDriver.h"
+#include "simmath/TimeStepper.h"
+#include "simmath/ExplicitEulerIntegrator.h"
+#include "simmath/RungeKutta2Integrator.h"
+#include "simmath/RungeKutta3Integrator.h"
+#include "simmath/RungeKuttaMersonIntegrator.h"
+#include "simmath/RungeKuttaFeldbergIntegrator.h"
+#include "simmath/SemiExplicitEuler2Integrator.h"
+#include "simmath/VerletIntegrator.h"
+
+#include "PararealDriverRep.h"
+
+#include <algorithm>
+#include <exception>
+#include <ostream>
+
+using namespace SimTK;
+
+//==============================================================================
+//                            PARAREAL DRIVER
+//==============================================================================
+
+PararealDriver::PararealDriver(const System& system)
+:   rep(new PararealDriverRep(system)) {}
+
+PararealDriver::~PararealDriver() {delete rep;}
+
+void PararealDriver::setNumTimeSlices(int numSlices) {
+    SimTK_APIARGCHECK1_ALWAYS(numSlices >= 1, "PararealDriver",
+        "setNumTimeSlices", "Number of slices must be at least 1 but was %d.",
+        numSlices);
+    rep->numSlices = numSlices;
+}
+
+void PararealDriver::setCoarseIntegrator(Method method, Real stepSize) {
+    SimTK_APIARGCHECK1_ALWAYS(stepSize > 0, "PararealDriver",
+        "setCoarseIntegrator", "Step size must be positive but was %g.",
+        stepSize);
+    rep->coarseMethod = method;
+    rep->coarseStepSize = stepSize;
+}
+
+void PararealDriver::setFineIntegrator(Method method, Real accuracy) {
+    SimTK_APIARGCHECK1_ALWAYS(accuracy > 0, "PararealDriver",
+        "setFineIntegrator", "Accuracy must be positive but was %g.",
+        accuracy);
+    rep->fineMethod = method;
+    rep->fineAccuracy = accuracy;
+}
+
+void PararealDriver::setConvergenceTolerance(Real tol) {
+    SimTK_APIARGCHECK1_ALWAYS(tol > 0, "PararealDriver",
+        "setConvergenceTolerance", "Tolerance must be positive but was %g.",
+        tol);
+    rep->convergenceTol = tol;
+}
+
+void PararealDriver::setMaxIterations(int maxIterations) {
+    SimTK_APIARGCHECK1_ALWAYS(maxIterations >= 1, "PararealDriver",
+        "setMaxIterations", "Must allow at least one iteration but got %d.",
+        maxIterations);
+    rep->maxIterations = maxIterations;
+}
+
+void PararealDriver::setNumThreads(int numThreads) {
+    SimTK_APIARGCHECK1_ALWAYS(numThreads >= 1, "PararealDriver",
+        "setNumThreads", "Number of threads must be at least 1 but was %d.",
+        numThreads);
+    rep->numThreads = numThreads;
+}
+
+bool PararealDriver::simulate(const State& initState, Real tFinal)
+{   return rep->simulate(initState, tFinal); }
+
+const State& PararealDriver::getState() const {
+    SimTK_ERRCHK_ALWAYS(!rep->U.empty(), "PararealDriver::getState()",
+        "There is no result until simulate() has been called.");
+    return rep->U.back();
+}
+
+const State& PararealDriver::getSliceState(int n) const {
+    SimTK_INDEXCHECK_ALWAYS(n, (int)rep->U.size(),
+                            "PararealDriver::getSliceState()");
+    return rep->U[n];
+}
+
+int PararealDriver::getNumTimeSlices() const {return rep->numSlices;}
+bool PararealDriver::isConverged() const {return rep->converged;}
+int PararealDriver::getNumIterations() const
+{   return (int)rep->corrections.size(); }
+
+Real PararealDriver::getCorrectionNorm(int k) const {
+    SimTK_INDEXCHECK_ALWAYS(k, (int)rep->corrections.size(),
+                            "PararealDriver::getCorrectionNorm()");
+    return rep->corrections[k];
+}
+
+int PararealDriver::getNumFineSteps() const {return rep->numFineSteps;}
+int PararealDriver::getNumCoarseSteps() const {return rep->numCoarseSteps;}
+
+void PararealDriver::writeConvergenceReport(std::ostream& o) const {
+    const PararealDriverRep& r = *rep;
+    o << "Parareal: " << r.numSlices << " slices, "
+      << getNumIterations() << " iterations, "
+      << (r.converged ? "converged" : "NOT converged") << "\n";
+    for (int k=0; k < getNumIterations(); ++k)
+        o << "  iteration " << k << ": max relative correction "
+          << r.corrections[k] << "\n";
+    o << "  fine steps " << r.numFineSteps
+      << ", coarse steps " << r.numCoarseSteps << std::endl;
+}
+
+
+
+//==============================================================================
+//                          PARAREAL DRIVER REP
+//==============================================================================
+
+PararealDriverRep::PararealDriverRep(const System& system)
+:   system(system), numSlices(16),
+    coarseMethod(PararealDriver::ExplicitEuler),
+    fineMethod(PararealDriver::RungeKuttaMerson),
+    coarseStepSize(NaN), fineAccuracy(1e-6), convergenceTol(NaN),
+    maxIterations(-1), numThreads(0),
+    converged(false), numFineSteps(0), numCoarseSteps(0) {}
+
+Integrator* PararealDriverRep::createIntegrator
+   (PararealDriver::Method method) const {
+    switch (method) {
+    case PararealDriver::ExplicitEuler:
+        return new ExplicitEulerIntegrator(system);
+    case PararealDriver::RungeKutta2:
+        return new RungeKutta2Integrator(system);
+    case PararealDriver::RungeKutta3:
+        return new RungeKutta3Integrator(system);
+    case PararealDriver::RungeKuttaMerson:
+        return new RungeKuttaMersonIntegrator(system);
+    case PararealDriver::RungeKuttaFeldberg:
+        return new RungeKuttaFeldbergIntegrator(system);
+    case PararealDriver::SemiExplicitEuler2:
+        return new SemiExplicitEuler2Integrator(system);
+    case PararealDriver::Verlet:
+        return new VerletIntegrator(system);
+    }
+    SimTK_ERRCHK1_ALWAYS(!"unknown method", "PararealDriver",
+        "Unrecognized integration method %d.", (int)method);
+    return nullptr;
+}
+
+// Advance a TimeStepper to tEnd, letting it handle any events on the way.
+static void advanceTo(TimeStepper& ts, Real tEnd) {
+    while (ts.getState().getTime() < tEnd
+           && !ts.getIntegrator().isSimulationOver())
+        ts.stepTo(tEnd);
+}
+
+void PararealDriverRep::runCoarseSlice(int n, State& out) {
+    TimeStepper ts(system, *coarse);
+    ts.initialize(U[n]);
+    advanceTo(ts, sliceTimes[n+1]);
+    out = ts.getState();
+    numCoarseSteps += coarse->getNumStepsTaken(); // reset by initialize()
+}
+
+void PararealDriverRep::runFineSlice(int n) {
+    try {
+        TimeStepper ts(system, *fine[n]);
+        ts.initialize(U[n]);
+        advanceTo(ts, sliceTimes[n+1]);
+        F[n] = ts.getState();
+        fineStepCounts[n] += fine[n]->getNumStepsTaken();
+    } catch (const std::exception& e) {
+        fineFailures[n] = e.what();
+    }
+}
+
+// Relative change, scaled so that small values are measured absolutely:
+//      max_i |ynew_i - yold_i| / max(|yold_i|, 1)
+Real PararealDriverRep::calcRelativeChange
+   (const Vector& yNew, const Vector& yOld) const {
+    Real maxChange = 0;
+    for (int i=0; i < yNew.size(); ++i) {
+        const Real change = std::abs(yNew[i]-yOld[i])
+                            / std::max(std::abs(yOld[i]),Real(1));
+        if (!isFinite(change))
+            return Infinity; // don't let a NaN look like convergence
+        maxChange = std::max(maxChange, change);
+    }
+    return maxChange;
+}
+
+namespace {
+class FineSliceTask : public ParallelExecutor::Task {
+public:
+    FineSliceTask(PararealDriverRep& rep, int firstSlice)
+    :   rep(rep), firstSlice(firstSlice) {}
+    void execute(int index) override {rep.runFineSlice(firstSlice + index);}
+private:
+    PararealDriverRep&  rep;
+    const int           firstSlice;
+};
+}
+
+bool PararealDriverRep::simulate(const State& initState, Real tFinal) {
+    const Real t0 = initState.getTime();
+    SimTK_APIARGCHECK2_ALWAYS(tFinal > t0, "PararealDriver", "simulate",
+        "Final time %g must be later than the initial time %g.", tFinal, t0);
+
+    const int  N        = numSlices;
+    const Real dt       = (tFinal-t0)/N;
+    const Real tol      = isNaN(convergenceTol) ? 10*fineAccuracy
+                                                : convergenceTol;
+    const int  maxIters = maxIterations < 0 ? N : std::min(maxIterations, N);
+
+    // Slice boundaries; make sure the last one is exactly tFinal.
+    sliceTimes.resize(N+1);
+    for (int n=0; n < N; ++n) sliceTimes[n] = t0 + n*dt;
+    sliceTimes[N] = tFinal;
+
+    coarse.reset(createIntegrator(coarseMethod));
+    coarse->setFixedStepSize(isNaN(coarseStepSize) ? dt/10
+                                                   : std::min(coarseStepSize,dt));
+    coarse->setConstraintTolerance(fineAccuracy);
+    fine.resize(N);
+    for (auto& integ : fine) {
+        integ.reset(createIntegrator(fineMethod));
+        integ->setAccuracy(fineAccuracy);
+        integ->setConstraintTolerance(fineAccuracy);
+    }
+    fineFailures.assign(N, std::string());
+    fineStepCounts.assign(N, 0);
+    numCoarseSteps = 0;
+
+    U.resize(N+1); F.resize(N); G.resize(N);
+    corrections.clear();
+    converged = false;
+
+    // Initial serial prediction with the coarse integrator.
+    U[0] = initState;
+    for (int n=0; n < N; ++n) {
+        runCoarseSlice(n, G[n]);
+        U[n+1] = G[n];
+        SimTK_ERRCHK2_ALWAYS(isFinite(U[n+1].getY().normRMS()),
+            "PararealDriver::simulate()",
+            "The coarse integrator produced a non-finite state at t=%g (time "
+            "slice %d); its step size is probably too large.",
+            sliceTimes[n+1], n);
+    }
+
+    const int nThreads = numThreads > 0 ? numThreads
+                       : std::max(ParallelExecutor::getNumProcessors(), 1);
+    ParallelExecutor executor(std::min(nThreads, N));
+
+    // After iteration k, boundaries 0..k+1 agree with the serial fine
+    // solution so we only need to work on slices k and later.
+    for (int k=0; k < maxIters; ++k) {
+        FineSliceTask task(*this, k);
+        executor.execute(task, N-k);
+        for (int n=k; n < N; ++n)
+            SimTK_ERRCHK2_ALWAYS(fineFailures[n].empty(),
+                "PararealDriver::simulate()",
+                "Fine integration of time slice %d failed: %s", n,
+                fineFailures[n].c_str());
+
+        // Serial correction sweep. For slice k the boundary U[k] did not
+        // change in the last sweep so the new coarse result is the same as
+        // the old one and U[k+1] just becomes the fine result.
+        Real maxChange = 0;
+        State Gnew;
+        for (int n=k; n < N; ++n) {
+            if (n == k) Gnew = G[n];
+            else runCoarseSlice(n, Gnew);
+
+            State Unew = Gnew; // discrete variables come from here
+            Unew.updY() = Gnew.getY() + F[n].getY() - G[n].getY();
+            system.project(Unew, fineAccuracy);
+
+            maxChange = std::max(maxChange,
+                                 calcRelativeChange(Unew.getY(),
+                                                    U[n+1].getY()));
+            U[n+1] = Unew;
+            G[n]   = Gnew;
+        }
+        corrections.push_back(maxChange);
+        SimTK_ERRCHK1_ALWAYS(isFinite(maxChange), "PararealDriver::simulate()",
+            "The Parareal iteration diverged in iteration %d; the coarse "
+            "integrator step size is probably too large.", k);
+
+        if (maxChange <= tol || k+1 == N) {
+            converged = true;
+            break;
+        }
+    }
+
+    numFineSteps = 0;
+    for (int n=0; n < N; ++n)
+        numFineSteps += fineStepCounts[n];
+    return converged;
+}
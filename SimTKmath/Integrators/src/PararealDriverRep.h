@@ -0,0 +1,89 @@
+#ifndef SimTK_SIMMATH_PARAREAL_DRIVER_REP_H_
+#define SimTK_SIMMATH_PARAREAL_DRIVER_REP_H_
+
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+#include "simmath/Integrator.h"
+#include "simmath/PararealDriver.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SimTK {
+
+//==============================================================================
+//                          PARAREAL DRIVER REP
+//==============================================================================
+// Boundary States U[n], n=0..N, and the fine and coarse propagation results
+// F[n] and G[n] for slice n (that is, starting from U[n] and ending at time
+// t[n+1]), n=0..N-1. Each slice has its own fine integrator so that they can
+// run concurrently; the coarse integrator is only used serially.
+class PararealDriverRep {
+public:
+    explicit PararealDriverRep(const System& system);
+    // default destructor, no copy or copy assign
+
+    bool simulate(const State& initState, Real tFinal);
+
+    // Integrate slice n with the fine integrator, from U[n] into F[n]. This
+    // is called concurrently for different slices.
+    void runFineSlice(int n);
+
+private:
+friend class PararealDriver;
+
+    Integrator* createIntegrator(PararealDriver::Method method) const;
+    void runCoarseSlice(int n, State& out);
+    Real calcRelativeChange(const Vector& yNew, const Vector& yOld) const;
+
+    const System&   system;
+
+    // Settings.
+    int                     numSlices;
+    PararealDriver::Method  coarseMethod, fineMethod;
+    Real                    coarseStepSize;  // NaN means use default
+    Real                    fineAccuracy;
+    Real                    convergenceTol;  // NaN means use default
+    int                     maxIterations;   // -1 means numSlices
+    int                     numThreads;      // 0 means numProcessors
+
+    // Results.
+    Array_<Real>    sliceTimes;
+    Array_<State>   U, F, G;
+    Array_<Real>    corrections;
+    bool            converged;
+    int             numFineSteps, numCoarseSteps;
+
+    std::unique_ptr<Integrator>                 coarse;
+    std::vector<std::unique_ptr<Integrator>>    fine;
+    std::vector<std::string>                    fineFailures;
+    std::vector<int>                            fineStepCounts;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMMATH_PARAREAL_DRIVER_REP_H_
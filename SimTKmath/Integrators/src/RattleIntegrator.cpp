@@ -0,0 +1,182 @@
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "simmath/RattleIntegrator.h"
+
+#include "IntegratorRep.h"
+#include "RattleIntegratorRep.h"
+
+using namespace SimTK;
+
+//==============================================================================
+//                            RATTLE INTEGRATOR
+//==============================================================================
+
+RattleIntegrator::RattleIntegrator(const System& sys, Real stepSize) {
+    rep = new RattleIntegratorRep(this, sys);
+    setFixedStepSize(stepSize);
+}
+
+
+//==============================================================================
+//                          RATTLE INTEGRATOR REP
+//==============================================================================
+RattleIntegratorRep::RattleIntegratorRep(Integrator* handle, const System& sys)
+:   AbstractIntegratorRep(handle, sys, 2, 2, "Rattle",  false)
+{
+}
+
+
+
+//==============================================================================
+//                            ATTEMPT DAE STEP
+//==============================================================================
+// Rattle overrides the entire DAE step because the constraint projections are
+// part of the method: positions are projected after the drift and velocities
+// after the final kick, every step. There is no error estimate.
+bool RattleIntegratorRep::attemptDAEStep
+   (Real t1, Vector& yErrEst, int& errOrder, int& numIterations)
+{
+    const System& system   = getSystem();
+    State& advanced = updAdvancedState();
+    Vector dummyErrEst; // we don't have an error estimate to project
+
+    statsStepsAttempted++;
+
+    const Real    t0        = getPreviousTime();       // nicer names
+    const Vector& q0        = getPreviousQ();
+    const Vector& u0        = getPreviousU();
+    const Vector& z0        = getPreviousZ();
+    const Vector& udot0     = getPreviousUDot();
+    const Vector& zdot0     = getPreviousZDot();
+
+    const Real h = t1-t0;
+
+    const int nq = advanced.getNQ();
+
+    numIterations = 0;
+    errOrder = 2;
+
+    // We will catch any exceptions thrown by realize() or project() and treat
+    // that as a failure to converge. There is no error control here so the
+    // step will be accepted anyway, but the statistics will show the problem.
+
+  try
+  {
+    // First half kick: u* = u0 + h/2 udot(q0,u0). The previous state's
+    // derivatives already include the constraint forces at t0.
+    Vector uHalf = u0 + (h/2)*udot0;
+
+    // Drift: q1 = q0 + h N(q0) u*. We need N evaluated at q0 so put q0 back
+    // in the advanced state first in case it was mangled by an earlier trial.
+    advanced.updQ() = q0;
+    advanced.updU() = uHalf;
+    advanced.updTime() = t1;
+    system.realize(advanced, Stage::Position); // old q, new t
+
+    Vector qdotHalf(nq);
+    system.multiplyByN(advanced, uHalf, qdotHalf);
+    advanced.updQ() = q0 + h*qdotHalf;
+    system.prescribeQ(advanced);
+    system.realize(advanced, Stage::Position); // new q, new t
+
+    // Position constraint projection (the SHAKE half of RATTLE). Note that we
+    // do not use a projection limit here as Verlet does; the discrete flow
+    // has to be returned to the constraint manifold after every drift.
+    const Vector qUnprojected = advanced.getQ();
+    bool anyChanges;
+    if (!localProjectQAndQErrEstNoThrow(advanced, dummyErrEst, anyChanges))
+        return false; // convergence failure for this step
+
+    // The position projection is the constraint impulse of the first half
+    // kick; it has to be reflected in the half-step velocity too or the
+    // method is neither symmetric nor symplectic. We have q1 = q0 + h N u*
+    // so the change dq made by the projection requires u* += N^+ dq / h.
+    // (We don't rely on anyChanges here since not every System reports it.)
+    const Vector dq = advanced.getQ() - qUnprojected;
+    if (dq.normInf() != 0) {
+        Vector du(advanced.getNU());
+        system.multiplyByNPInv(advanced, dq, du);
+        uHalf += du/h;
+    }
+
+    // Second half kick, implicit in u and z:
+    //      u1 = u* + h/2 udot(q1,u1)
+    //      z1 = z0 + h/2 (zdot0 + zdot(q1,u1,z1))
+    // Start from the explicit guess using the accelerations at t0.
+    advanced.updU() = uHalf + (h/2)*udot0;
+    advanced.updZ() = z0 + h*zdot0;
+    system.prescribeU(advanced);
+    system.realize(advanced, Stage::Velocity);
+    realizeStateDerivatives(advanced);
+
+    // The functional iteration converges immediately if accelerations depend
+    // only on q; otherwise it converges linearly with rate about h/2 times
+    // the norm of d udot/du. We want tight convergence here since any residual
+    // would appear as energy drift.
+    const Real tol = std::min(Real(1e-10), Real(0.01)*getAccuracyInUse());
+    Vector usave, zsave; // temporaries
+    bool converged = false;
+    Real prevChange = Infinity; // use this to quit early
+    for (int i = 0; !converged && i < 20; ++i) {
+        ++numIterations;
+        usave = advanced.getU();
+        zsave = advanced.getZ();
+
+        // Get these references now -- as soon as we change u or z they
+        // will be invalid.
+        const Vector& udot1 = advanced.getUDot();
+        const Vector& zdot1 = advanced.getZDot();
+
+        advanced.setU(uHalf + (h/2)*udot1);
+        advanced.setZ(z0 + (h/2)*(zdot0 + zdot1));
+
+        system.prescribeU(advanced);
+        system.realize(advanced, Stage::Velocity);
+        realizeStateDerivatives(advanced);
+
+        // Convergence is the ratio of the norm of the last change to the norm
+        // of the values prior to that change; TinyReal keeps us out of
+        // trouble if we started at zero.
+        const Real convergenceU = (advanced.getU()-usave).norm()
+                                  / (usave.norm()+TinyReal);
+        const Real convergenceZ = (advanced.getZ()-zsave).norm()
+                                  / (zsave.norm()+TinyReal);
+        const Real change = std::max(convergenceU,convergenceZ);
+        converged = (change <= tol);
+        if (i > 1 && (change > prevChange))
+            break; // we're headed the wrong way after two iterations -- give up
+        prevChange = change;
+    }
+
+    // Velocity constraint projection (the second RATTLE multiplier).
+    if (!localProjectUAndUErrEstNoThrow(advanced, dummyErrEst, anyChanges))
+        return false; // convergence failure for this step
+
+    return converged;
+  }
+  catch (const std::exception&) {
+    return false;
+  }
+}
+
@@ -0,0 +1,208 @@
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "simmath/Integrator.h"
+#include "simmath/RosenbrockWIntegrator.h"
+
+#include "IntegratorRep.h"
+#include "RosenbrockWIntegratorRep.h"
+
+using namespace SimTK;
+
+//==============================================================================
+//                         ROSENBROCK W INTEGRATOR
+//==============================================================================
+
+RosenbrockWIntegrator::RosenbrockWIntegrator(const System& sys) {
+    rep = new RosenbrockWIntegratorRep(this, sys);
+}
+
+RosenbrockWIntegrator::RosenbrockWIntegrator(const System& sys, Real stepSize) {
+    rep = new RosenbrockWIntegratorRep(this, sys);
+    setFixedStepSize(stepSize);
+}
+
+void RosenbrockWIntegrator::setJacobianReuseLimit(int numSteps) {
+    SimTK_APIARGCHECK1_ALWAYS(numSteps >= 1, "RosenbrockWIntegrator",
+        "setJacobianReuseLimit", "The limit must be at least 1 but was %d.",
+        numSteps);
+    dynamic_cast<RosenbrockWIntegratorRep&>(*rep)
+        .setJacobianReuseLimit(numSteps);
+}
+
+int RosenbrockWIntegrator::getNumJacobianEvaluations() const {
+    return dynamic_cast<const RosenbrockWIntegratorRep&>(*rep)
+        .getNumJacobianEvaluations();
+}
+
+int RosenbrockWIntegrator::getNumFactorizations() const {
+    return dynamic_cast<const RosenbrockWIntegratorRep&>(*rep)
+        .getNumFactorizations();
+}
+
+
+//==============================================================================
+//                       ROSENBROCK W INTEGRATOR REP
+//==============================================================================
+RosenbrockWIntegratorRep::RosenbrockWIntegratorRep
+   (Integrator* handle, const System& sys)
+:   AbstractIntegratorRep(handle, sys, 2, 2, "RosenbrockW",  true),
+    jacobianReuseLimit(20), jacobianTime(NaN), stepsSinceJacobian(0),
+    lastAttemptT0(NaN),
+    statsJacobianEvaluations(0), statsFactorizations(0)
+{
+}
+
+void RosenbrockWIntegratorRep::resetMethodStatistics() {
+    AbstractIntegratorRep::resetMethodStatistics();
+    statsJacobianEvaluations = statsFactorizations = 0;
+}
+
+void RosenbrockWIntegratorRep::methodInitialize(const State& state) {
+    AbstractIntegratorRep::methodInitialize(state);
+    jacobianTime = lastAttemptT0 = NaN;
+}
+
+void RosenbrockWIntegratorRep::methodReinitialize
+   (Stage stage, bool shouldTerminate) {
+    AbstractIntegratorRep::methodReinitialize(stage, shouldTerminate);
+    jacobianTime = lastAttemptT0 = NaN;
+}
+
+
+
+//==============================================================================
+//                             CALC JACOBIAN
+//==============================================================================
+// Column j of J is (f(y0 + d_j e_j) - f0)/d_j. The increment is scaled to
+// the size of y_j with a floor of 1 so that it is never tiny relative to the
+// problem; for the usual mix of angles, lengths and rates that is adequate.
+// Each column costs a realization through Acceleration stage.
+void RosenbrockWIntegratorRep::calcJacobian
+   (Real t0, const Vector& y0, const Vector& f0)
+{
+    const int ny = y0.size();
+    const Real sqrtEps = std::sqrt(NTraits<Real>::getEps());
+
+    jacobian.resize(ny, ny);
+    Vector& yp = ytmp[3];
+    yp = y0;
+    for (int j=0; j < ny; ++j) {
+        const Real yj = y0[j];
+        const Real dy = sqrtEps*std::max(Real(1), std::abs(yj));
+        yp[j] = yj + dy;
+        setAdvancedStateAndRealizeDerivatives(t0, yp);
+        const Vector& fp = getAdvancedState().getYDot();
+        const Real ooDy = 1/(yp[j]-yj); // the increment actually applied
+        for (int i=0; i < ny; ++i)
+            jacobian(i,j) = ooDy*(fp[i]-f0[i]);
+        yp[j] = yj;
+    }
+
+    jacobianTime = t0;
+    stepsSinceJacobian = 0;
+    ++statsJacobianEvaluations;
+}
+
+
+
+//==============================================================================
+//                            ATTEMPT ODE STEP
+//==============================================================================
+// See the RosenbrockWIntegrator class documentation for the method. We are
+// given f0=f(t0,y0), which is left over from the end of the previous step.
+// The second order result is propagated and y1-y1hat, where y1hat=y0+h*k1 is
+// the linearly implicit Euler solution, is the error estimate, which goes as
+// h^2.
+bool RosenbrockWIntegratorRep::attemptODEStep
+   (Real t1, Vector& y1err, int& errOrder, int& numIterations)
+{
+    const Real t0 = getPreviousTime();
+    assert(t1 > t0);
+
+    statsStepsAttempted++;
+    errOrder = 2;
+    numIterations = 1;
+
+    const Vector& y0 = getPreviousY();
+    const Vector& f0 = getPreviousYDot();
+    const int ny = y0.size();
+    if (ytmp[0].size() != ny)
+        for (int i=0; i<NTemps; ++i)
+            ytmp[i].resize(ny);
+    if (ny == 0) { // nothing to integrate, but time still advances
+        setAdvancedStateAndRealizeKinematics(t1, y0);
+        return true;
+    }
+    Vector& k1 = ytmp[0]; // rename temps
+    Vector& k2 = ytmp[1];
+    Vector& r  = ytmp[2];
+
+    const Real h = t1-t0;
+    const Real gamma = 1 + 1/std::sqrt(Real(2));
+
+    // We're retrying a step if we've already been called for this t0. If the
+    // Jacobian came from an earlier step it may be the reason the step
+    // failed so form a fresh one; otherwise the step size was just too big.
+    if (isNaN(jacobianTime) || stepsSinceJacobian >= jacobianReuseLimit
+        || (t0 == lastAttemptT0 && jacobianTime != t0))
+        calcJacobian(t0, y0, f0);
+    if (t0 != lastAttemptT0) {
+        ++stepsSinceJacobian;
+        lastAttemptT0 = t0;
+    }
+
+    // W = I - gamma*h*J.
+    W.resize(ny, ny);
+    const Real ghJ = -gamma*h;
+    for (int j=0; j < ny; ++j)
+        for (int i=0; i < ny; ++i)
+            W(i,j) = ghJ*jacobian(i,j);
+    for (int i=0; i < ny; ++i)
+        W(i,i) += 1;
+    luW.factor(W);
+    ++statsFactorizations;
+
+    luW.solve(f0, k1);
+
+    for (int i=0; i < ny; ++i)
+        r[i] = y0[i] + h*k1[i];
+    setAdvancedStateAndRealizeDerivatives(t1, r);
+    const Vector& f1 = getAdvancedState().getYDot();
+    for (int i=0; i < ny; ++i)
+        r[i] = f1[i] - 2*k1[i];
+    luW.solve(r, k2);
+
+    // Final value. Evaluate through kinematics only since the caller will
+    // project before the end of the step.
+    for (int i=0; i < ny; ++i)
+        r[i] = y0[i] + h*(Real(1.5)*k1[i] + Real(0.5)*k2[i]);
+    setAdvancedStateAndRealizeKinematics(t1, r);
+
+    // y1 - y1hat = h/2 (k1 + k2).
+    for (int i=0; i < ny; ++i)
+        y1err[i] = std::abs((h/2)*(k1[i] + k2[i]));
+
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef SimTK_SIMMATH_ROSENBROCK_W_INTEGRATOR_REP_H_
+#define SimTK_SIMMATH_ROSENBROCK_W_INTEGRATOR_REP_H_
+
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "simmath/LinearAlgebra.h"
+
+#include "AbstractIntegratorRep.h"
+
+namespace SimTK {
+
+class RosenbrockWIntegratorRep : public AbstractIntegratorRep {
+public:
+    RosenbrockWIntegratorRep(Integrator* handle, const System& sys);
+
+    void setJacobianReuseLimit(int numSteps) {jacobianReuseLimit = numSteps;}
+    int getNumJacobianEvaluations() const {return statsJacobianEvaluations;}
+    int getNumFactorizations() const {return statsFactorizations;}
+
+    void resetMethodStatistics() override;
+protected:
+    void methodInitialize(const State&) override;
+    void methodReinitialize(Stage stage, bool shouldTerminate) override;
+    bool attemptODEStep
+       (Real t1, Vector& yErrEst, int& errOrder, int& numIterations) override;
+private:
+    // Form J=df/dy at (t0,y0) by forward differences, given f0=f(t0,y0).
+    void calcJacobian(Real t0, const Vector& y0, const Vector& f0);
+
+    int         jacobianReuseLimit;
+
+    // The current Jacobian and how old it is. A NaN time means we don't have
+    // one; it is discarded whenever the integrator is reinitialized since
+    // event handlers may have made arbitrary changes.
+    Matrix      jacobian;
+    Real        jacobianTime;
+    int         stepsSinceJacobian;
+    Real        lastAttemptT0; // to recognize retries of a failed step
+
+    Matrix      W;
+    FactorLU    luW;
+
+    static const int NTemps = 4;
+    Vector      ytmp[NTemps];
+
+    int         statsJacobianEvaluations, statsFactorizations;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMMATH_ROSENBROCK_W_INTEGRATOR_REP_H_
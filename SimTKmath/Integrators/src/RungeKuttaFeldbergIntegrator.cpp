@@ -110,40 +110,50 @@ bool RungeKuttaFeldbergIntegratorRep::attemptODEStep
     if (ytmp[0].size() != y0.size())
         for (int i=0; i<NTemps; ++i)
             ytmp[i].resize(y0.size());
-    Vector& ysave = ytmp[0]; // rename temps
-    Vector& fa    = ytmp[1];
-    Vector& fb    = ytmp[2];
+    Vector& ystage = ytmp[5]; // rename temp
 
     const Real h = t1-t0;
 
-    // Calculate the intermediate states.
+    // Calculate the intermediate states. These are formed with calcStageY()
+    // rather than Vector expressions to avoid heap-allocating temporaries.
     
-    setAdvancedStateAndRealizeDerivatives(t0 + h*C21, 
-        y0 + h*C22*f0);
+    { const Real c[] = {C22};
+      const Vector* f[] = {&f0};
+      calcStageY(y0, h, 1, c, f, ystage); }
+    setAdvancedStateAndRealizeDerivatives(t0 + h*C21, ystage);
     ytmp[0] = getAdvancedState().getYDot();
 
-    setAdvancedStateAndRealizeDerivatives(t0 + h*C31, 
-        y0 + h*C32*f0 + h*C33*ytmp[0]);
+    { const Real c[] = {C32, C33};
+      const Vector* f[] = {&f0, &ytmp[0]};
+      calcStageY(y0, h, 2, c, f, ystage); }
+    setAdvancedStateAndRealizeDerivatives(t0 + h*C31, ystage);
     ytmp[1] = getAdvancedState().getYDot();
 
-    setAdvancedStateAndRealizeDerivatives(t0 + h*C41, 
-        y0 + h*C42*f0 + h*C43*ytmp[0] + h*C44*ytmp[1]);
+    { const Real c[] = {C42, C43, C44};
+      const Vector* f[] = {&f0, &ytmp[0], &ytmp[1]};
+      calcStageY(y0, h, 3, c, f, ystage); }
+    setAdvancedStateAndRealizeDerivatives(t0 + h*C41, ystage);
     ytmp[2] = getAdvancedState().getYDot();
 
-    setAdvancedStateAndRealizeDerivatives(t0 + h*C51, 
-        y0 + h*C52*f0 + h*C53*ytmp[0] + h*C54*ytmp[1] + h*C55*ytmp[2]);
+    { const Real c[] = {C52, C53, C54, C55};
+      const Vector* f[] = {&f0, &ytmp[0], &ytmp[1], &ytmp[2]};
+      calcStageY(y0, h, 4, c, f, ystage); }
+    setAdvancedStateAndRealizeDerivatives(t0 + h*C51, ystage);
     ytmp[3] = getAdvancedState().getYDot();
 
-    setAdvancedStateAndRealizeDerivatives(t0 + h*C61, 
-        y0 + h*C62*f0 + h*C63*ytmp[0] + h*C64*ytmp[1] + h*C65*ytmp[2] 
-           + h*C66*ytmp[3]);
+    { const Real c[] = {C62, C63, C64, C65, C66};
+      const Vector* f[] = {&f0, &ytmp[0], &ytmp[1], &ytmp[2], &ytmp[3]};
+      calcStageY(y0, h, 5, c, f, ystage); }
+    setAdvancedStateAndRealizeDerivatives(t0 + h*C61, ystage);
     ytmp[4] = getAdvancedState().getYDot();
     
     // Calculate the final state but don't evaluate the derivatives. That
     // would be a wasted stage since the caller will muck with the state before
     // the end of the step.
-    setAdvancedStateAndRealizeKinematics(t1, 
-        y0 + h*CY1*f0 + h*CY2*ytmp[1] + h*CY3*ytmp[2] + h*CY4*ytmp[3]);
+    { const Real c[] = {CY1, CY2, CY3, CY4};
+      const Vector* f[] = {&f0, &ytmp[1], &ytmp[2], &ytmp[3]};
+      calcStageY(y0, h, 4, c, f, ystage); }
+    setAdvancedStateAndRealizeKinematics(t1, ystage);
     // YErr is valid now, but not YDot.
     
     // Calculate the error estimate.
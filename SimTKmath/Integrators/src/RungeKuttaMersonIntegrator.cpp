@@ -96,23 +96,37 @@ bool RungeKuttaMersonIntegratorRep::attemptODEStep
     if (ytmp[0].size() != y0.size())
         for (int i=0; i<NTemps; ++i)
             ytmp[i].resize(y0.size());
-    Vector& ysave = ytmp[0]; // rename temps
-    Vector& fa    = ytmp[1];
-    Vector& fb    = ytmp[2];
+    Vector& ysave  = ytmp[0]; // rename temps
+    Vector& fa     = ytmp[1];
+    Vector& fb     = ytmp[2];
+    Vector& ystage = ytmp[3];
 
     const Real h = t1-t0;
 
-    setAdvancedStateAndRealizeDerivatives(t0+h/3, y0 + (h/3)*f0);
+    // The stages are formed with calcStageY() rather than Vector expressions
+    // to avoid heap-allocating temporaries in every stage.
+    { const Real c[] = {Real(1)/3};             // y0 + h/3 f0
+      const Vector* f[] = {&f0};
+      calcStageY(y0, h, 1, c, f, ystage); }
+    setAdvancedStateAndRealizeDerivatives(t0+h/3, ystage);
     fa = getAdvancedState().getYDot(); // fa=f1
 
-    setAdvancedStateAndRealizeDerivatives(t0+h/3, y0 + (h/6)*(f0+fa)); // f0+f1
+    { const Real c[] = {Real(1)/6, Real(1)/6};  // y0 + h/6 (f0+f1)
+      const Vector* f[] = {&f0, &fa};
+      calcStageY(y0, h, 2, c, f, ystage); }
+    setAdvancedStateAndRealizeDerivatives(t0+h/3, ystage);
     fa = getAdvancedState().getYDot(); // fa=f2
 
-    setAdvancedStateAndRealizeDerivatives(t0+h/2, y0 + (h/8)*(f0 + 3*fa)); // f0+3f2
+    { const Real c[] = {Real(1)/8, Real(3)/8};  // y0 + h/8 (f0+3f2)
+      const Vector* f[] = {&f0, &fa};
+      calcStageY(y0, h, 2, c, f, ystage); }
+    setAdvancedStateAndRealizeDerivatives(t0+h/2, ystage);
     fb = getAdvancedState().getYDot(); // fb=f3
 
     // We'll need this for error estimation.
-    ysave = y0 + (h/2)*(f0 - 3*fa + 4*fb); // f0-3f2+4f3
+    { const Real c[] = {Real(1)/2, Real(-3)/2, Real(2)}; // h/2 (f0-3f2+4f3)
+      const Vector* f[] = {&f0, &fa, &fb};
+      calcStageY(y0, h, 3, c, f, ysave); }
     setAdvancedStateAndRealizeDerivatives(t1, ysave);
     fa = getAdvancedState().getYDot(); // fa=f4
 
@@ -121,7 +135,10 @@ bool RungeKuttaMersonIntegratorRep::attemptODEStep
     // Evaluate through kinematics only; it is a waste of a stage to 
     // evaluate derivatives here since the caller will muck with this before
     // the end of the step.
-    setAdvancedStateAndRealizeKinematics(t1, y0 + (h/6)*(f0 + 4*fb + fa));
+    { const Real c[] = {Real(1)/6, Real(2)/3, Real(1)/6}; // h/6 (f0+4f3+f4)
+      const Vector* f[] = {&f0, &fb, &fa};
+      calcStageY(y0, h, 3, c, f, ystage); }
+    setAdvancedStateAndRealizeKinematics(t1, ystage);
     // YErr is valid now
 
     // This is an embedded 3rd-order estimate y1hat=y(t0+h)+O(h^4). (Apparently
@@ -130,6 +130,7 @@ Integrator::SuccessfulStepStatus TimeStepperRep::stepTo(Real time) {
 
         Stage lowestModified = Stage::Report;
         bool shouldTerminate;
+        int numEventsHandled = 0; // just for telemetry
         switch (status) {
             case Integrator::ReachedStepLimit: {
                 if (reportAllSignificantStates)
@@ -158,6 +159,7 @@ Integrator::SuccessfulStepStatus TimeStepperRep::stepTo(Real time) {
                                     Event::Cause::Scheduled,
                                     scheduledEventIds,
                                     handleOpts, results);
+                numEventsHandled = (int)scheduledEventIds.size();
                 lowestModified = results.getLowestModifiedStage();
                 shouldTerminate = 
                     results.getExitStatus()==HandleEventsResults::ShouldTerminate;
@@ -181,6 +183,7 @@ Integrator::SuccessfulStepStatus TimeStepperRep::stepTo(Real time) {
                                     Event::Cause::Triggered,
                                     integ->getTriggeredEvents(),
                                     handleOpts, results);
+                numEventsHandled = (int)integ->getTriggeredEvents().size();
                 lowestModified = results.getLowestModifiedStage();
                 shouldTerminate = 
                     results.getExitStatus()==HandleEventsResults::ShouldTerminate;
@@ -199,6 +202,16 @@ Integrator::SuccessfulStepStatus TimeStepperRep::stepTo(Real time) {
             }
             default: assert(!"Unrecognized return from stepTo()");
         }
+
+        if (integ->getTelemetry()) {
+            IntegratorTelemetry::Record r;
+            r.time = integ->getTime(); r.stepSize = 0; r.errorNorm = NaN;
+            r.kind = IntegratorTelemetry::EventsHandled;
+            r.worstComponent = -1; r.numIterations = 0;
+            r.numRealizations = r.numProjections = 0;
+            r.numEvents = numEventsHandled;
+            integ->getTelemetry()->push(r);
+        }
         integ->reinitialize(lowestModified, shouldTerminate);
         if (reportAllSignificantStates)
             return status;
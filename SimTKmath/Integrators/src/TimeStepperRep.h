@@ -34,6 +34,7 @@
 
 #include "simmath/Integrator.h"
 #include "simmath/TimeStepper.h"
+#include "simmath/IntegratorTelemetry.h"
 
 #include <exception>
 
@@ -43,6 +43,7 @@
 #include "simmath/internal/GeodesicIntegrator.h"
 #include "simmath/internal/ContactGeometry.h"
 #include "simmath/internal/OrientedBoundingBox.h"
+#include "simmath/internal/MeshFaceSet.h"
 #include "simmath/internal/Contact.h"
 #include "simmath/internal/ContactTracker.h"
 #include "simmath/internal/CollisionDetectionAlgorithm.h"
@@ -52,7 +53,9 @@
 #include "simmath/Optimizer.h"
 #include "simmath/MultibodyGraphMaker.h"
 #include "simmath/Integrator.h"
+#include "simmath/IntegratorTelemetry.h"
 #include "simmath/TimeStepper.h"
+#include "simmath/PararealDriver.h"
 #include "simmath/CPodesIntegrator.h"
 #include "simmath/RungeKuttaMersonIntegrator.h"
 #include "simmath/RungeKuttaFeldbergIntegrator.h"
@@ -62,5 +65,7 @@
 #include "simmath/VerletIntegrator.h"
 #include "simmath/SemiExplicitEulerIntegrator.h"
 #include "simmath/SemiExplicitEuler2Integrator.h"
+#include "simmath/RattleIntegrator.h"
+#include "simmath/RosenbrockWIntegrator.h"
 
 #endif // SimTK_SIMMATH_H_
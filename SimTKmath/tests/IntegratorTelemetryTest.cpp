@@ -0,0 +1,186 @@
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "SimTKmath.h"
+#include "SimTKcommon/Testing.h"
+
+#include "PendulumSystem.h"
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace SimTK;
+using std::cout; using std::endl;
+
+class TickHandler : public ScheduledEventHandler {
+public:
+    Real getNextEventTime(const State& s, bool) const override
+    {   return std::floor(s.getTime()) + 1; }
+    void handleEvent(State&, Real, bool&) const override {}
+};
+
+// The step records must agree with the Integrator's own statistics, and the
+// TimeStepper must record each scheduled event.
+static void testStepRecords() {
+    PendulumSystem sys;
+    sys.addEventHandler(new TickHandler());
+    sys.realizeTopology();
+    const Real qi[] = {1,0};
+    const Real ui[] = {0,0};
+    sys.setDefaultTimeAndState(0, Vector(2, qi), Vector(2, ui));
+
+    IntegratorTelemetry telemetry(1 << 14);
+    RungeKuttaMersonIntegrator integ(sys);
+    integ.setAccuracy(1e-4);
+    SimTK_TEST(integ.getTelemetry() == nullptr);
+    integ.setTelemetry(&telemetry);
+    SimTK_TEST(integ.getTelemetry() == &telemetry);
+
+    TimeStepper ts(sys, integ);
+    ts.initialize(sys.getDefaultState());
+    ts.stepTo(5.5);
+
+    Array_<IntegratorTelemetry::Record> records;
+    SimTK_TEST(telemetry.drain(records) == (int)records.size());
+    SimTK_TEST(telemetry.size() == 0);
+    SimTK_TEST(telemetry.getNumDropped() == 0);
+
+    int accepted=0, errFailures=0, convFailures=0, events=0, projections=0;
+    const Real acc = integ.getAccuracyInUse();
+    Real tPrev = -1;
+    for (const auto& r : records) {
+        switch (r.kind) {
+        case IntegratorTelemetry::StepAccepted:
+            ++accepted;
+            SimTK_TEST(r.stepSize > 0 && r.errorNorm <= acc);
+            SimTK_TEST(r.time >= tPrev); tPrev = r.time;
+            break;
+        case IntegratorTelemetry::ErrorTestFailed:
+            ++errFailures;
+            SimTK_TEST(r.errorNorm > acc);
+            SimTK_TEST(0 <= r.worstComponent && r.worstComponent < 4);
+            break;
+        case IntegratorTelemetry::ConvergenceFailed: ++convFailures; break;
+        case IntegratorTelemetry::EventsHandled:
+            ++events;
+            SimTK_TEST(r.numEvents == 1);
+            SimTK_TEST_EQ(r.time, (Real)events);
+            break;
+        default: SimTK_TEST(!"bad kind");
+        }
+        projections += r.numProjections;
+    }
+
+    SimTK_TEST(accepted == integ.getNumStepsTaken());
+    SimTK_TEST(errFailures == integ.getNumErrorTestFailures());
+    SimTK_TEST(convFailures == integ.getNumConvergenceTestFailures());
+    SimTK_TEST(projections <= integ.getNumProjections());
+    SimTK_TEST(events == 5);
+
+    // Turning telemetry off stops the records.
+    integ.setTelemetry(nullptr);
+    ts.stepTo(7);
+    SimTK_TEST(telemetry.size() == 0);
+}
+
+// Records that don't fit are dropped, not overwritten, and a binary log
+// reproduces exactly what was drained.
+static void testBufferAndLog() {
+    IntegratorTelemetry telemetry(100);
+    SimTK_TEST(telemetry.getCapacity() == 128);
+    SimTK_TEST_MUST_THROW(IntegratorTelemetry(0));
+
+    IntegratorTelemetry::Record r = {};
+    for (int i=0; i < 130; ++i) {
+        r.time = i; r.numEvents = i;
+        SimTK_TEST(telemetry.push(r) == (i < 128));
+    }
+    SimTK_TEST(telemetry.getNumDropped() == 2);
+
+    // Move the tail so that the log must be written from a wrapped buffer.
+    IntegratorTelemetry::Record out;
+    for (int i=0; i < 100; ++i) {
+        SimTK_TEST(telemetry.pop(out));
+        SimTK_TEST(out.numEvents == i);
+    }
+    for (int i=128; i < 150; ++i) {
+        r.time = i; r.numEvents = i;
+        SimTK_TEST(telemetry.push(r));
+    }
+
+    std::stringstream log;
+    SimTK_TEST(telemetry.writeBinary(log) == 50);
+    SimTK_TEST(telemetry.size() == 0);
+    SimTK_TEST(!telemetry.pop(out));
+
+    Array_<IntegratorTelemetry::Record> records;
+    IntegratorTelemetry::readBinary(log, records);
+    SimTK_TEST(records.size() == 50);
+    for (int i=0; i < 50; ++i) {
+        SimTK_TEST(records[i].numEvents == 100+i);
+        SimTK_TEST_EQ(records[i].time, (double)(100+i));
+    }
+
+    std::stringstream junk("not a telemetry log at all");
+    SimTK_TEST_MUST_THROW(IntegratorTelemetry::readBinary(junk, records));
+}
+
+// One thread produces while another drains; every record must arrive exactly
+// once and in order.
+static void testConcurrentDrain() {
+    IntegratorTelemetry telemetry(64);
+    const int N = 20000;
+    std::thread producer([&telemetry]() {
+        IntegratorTelemetry::Record r = {};
+        for (int i=0; i < N; ++i) {
+            r.numEvents = i;
+            while (!telemetry.push(r))
+                std::this_thread::yield();
+        }
+    });
+
+    // The producer retries so the drop counter counts its retries; what
+    // matters here is that nothing is lost or reordered.
+    int next = 0; bool inOrder = true;
+    Array_<IntegratorTelemetry::Record> records;
+    while (next < N) {
+        records.clear();
+        if (telemetry.drain(records) == 0)
+            std::this_thread::yield();
+        for (const auto& r : records)
+            inOrder = inOrder && (r.numEvents == next++);
+    }
+    producer.join();
+    SimTK_TEST(inOrder);
+    SimTK_TEST(telemetry.size() == 0);
+}
+
+int main() {
+    SimTK_START_TEST("IntegratorTelemetryTest");
+        SimTK_SUBTEST(testStepRecords);
+        SimTK_SUBTEST(testBufferAndLog);
+        SimTK_SUBTEST(testConcurrentDrain);
+    SimTK_END_TEST();
+}
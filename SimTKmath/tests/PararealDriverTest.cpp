@@ -0,0 +1,121 @@
+/* -------------------------------------------------------------------------- *
+ *                        Simbody(tm): SimTKmath                              *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "SimTKmath.h"
+#include "SimTKcommon/Testing.h"
+
+#include "PendulumSystem.h"
+
+#include <iostream>
+
+using namespace SimTK;
+using std::cout; using std::endl;
+
+// Integrate the constrained pendulum serially with the fine integrator and
+// compare that with a Parareal solution.
+static State integrateSerially(const PendulumSystem& sys, Real accuracy,
+                               Real tFinal) {
+    RungeKuttaMersonIntegrator integ(sys);
+    integ.setAccuracy(accuracy);
+    integ.setConstraintTolerance(accuracy);
+    TimeStepper ts(sys, integ);
+    ts.initialize(sys.getDefaultState());
+    ts.stepTo(tFinal);
+    return ts.getState();
+}
+
+static void testConvergence() {
+    PendulumSystem sys;
+    sys.realizeTopology();
+    const Real qi[] = {1,0}; // (x,y)=(1,0)
+    const Real ui[] = {0,0}; // v=0
+    sys.setDefaultTimeAndState(0, Vector(2, qi), Vector(2, ui));
+
+    const Real tFinal = 5, accuracy = 1e-8;
+    const State serial = integrateSerially(sys, accuracy, tFinal);
+
+    PararealDriver parareal(sys);
+    parareal.setNumTimeSlices(10);
+    parareal.setCoarseIntegrator(PararealDriver::RungeKutta2, 0.05);
+    parareal.setFineIntegrator(PararealDriver::RungeKuttaMerson, accuracy);
+    parareal.setConvergenceTolerance(1e-7);
+    SimTK_TEST(parareal.simulate(sys.getDefaultState(), tFinal));
+    parareal.writeConvergenceReport(cout);
+
+    SimTK_TEST(parareal.isConverged());
+    SimTK_TEST(parareal.getNumIterations() < parareal.getNumTimeSlices());
+    SimTK_TEST(parareal.getNumFineSteps() > 0);
+    SimTK_TEST(parareal.getNumCoarseSteps() > 0);
+
+    // The last correction must be much smaller than the first one.
+    const int k = parareal.getNumIterations();
+    SimTK_TEST(parareal.getCorrectionNorm(k-1)
+               < 1e-2*parareal.getCorrectionNorm(0));
+
+    const State& sFinal = parareal.getState();
+    SimTK_TEST_EQ(sFinal.getTime(), tFinal);
+    SimTK_TEST_EQ_TOL(sFinal.getQ(), serial.getQ(), 1e-5);
+    SimTK_TEST_EQ_TOL(sFinal.getU(), serial.getU(), 1e-5);
+
+    // Boundary states are at the slice times and are on the constraint
+    // manifold (pendulum length 1).
+    for (int n=0; n <= parareal.getNumTimeSlices(); ++n) {
+        const State& s = parareal.getSliceState(n);
+        SimTK_TEST_EQ(s.getTime(), n*tFinal/10);
+        SimTK_TEST_EQ_TOL(std::sqrt(square(s.getQ()[0])+square(s.getQ()[1])),
+                          1, 1e-6);
+    }
+}
+
+// With a tolerance that can't be met, Parareal must run exactly N iterations,
+// after which it is the same as running the fine integrator slice by slice.
+static void testWorstCase() {
+    PendulumSystem sys;
+    sys.realizeTopology();
+    const Real qi[] = {0,-1};
+    const Real ui[] = {2,0};
+    sys.setDefaultTimeAndState(0, Vector(2, qi), Vector(2, ui));
+
+    PararealDriver parareal(sys);
+    parareal.setNumTimeSlices(4);
+    parareal.setCoarseIntegrator(PararealDriver::ExplicitEuler, 0.25);
+    parareal.setFineIntegrator(PararealDriver::RungeKuttaMerson, 1e-6);
+    parareal.setConvergenceTolerance(1e-30);
+    parareal.setNumThreads(2);
+    SimTK_TEST(parareal.simulate(sys.getDefaultState(), 2));
+    SimTK_TEST(parareal.getNumIterations() == 4);
+
+    const State serial = integrateSerially(sys, 1e-6, 2);
+    SimTK_TEST_EQ_TOL(parareal.getState().getQ(), serial.getQ(), 1e-4);
+
+    SimTK_TEST_MUST_THROW(parareal.getSliceState(5));
+    SimTK_TEST_MUST_THROW(parareal.setNumTimeSlices(0));
+}
+
+int main() {
+    SimTK_START_TEST("PararealDriverTest");
+        SimTK_SUBTEST(testConvergence);
+        SimTK_SUBTEST(testWorstCase);
+    SimTK_END_TEST();
+}
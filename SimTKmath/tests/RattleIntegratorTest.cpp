@@ -0,0 +1,111 @@
+/* -------------------------------------------------------------------------- *
+ *                          Simbody(tm): SimTKmath                            *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "IntegratorTestFramework.h"
+#include "simmath/RattleIntegrator.h"
+
+// Run a conservative (no event handlers) constrained pendulum for many
+// periods at a fixed step and verify that the energy error stays small.
+static void testEnergyConservation() {
+    PendulumSystem sys;
+    sys.realizeTopology();
+
+    const Real qi[] = {1,0}; // (x,y)=(1,0)
+    const Real ui[] = {0,0}; // v=0
+    sys.setDefaultMass(10);
+    sys.setDefaultTimeAndState(0, Vector(2, qi), Vector(2, ui));
+
+    const Real m = sys.getDefaultMass(), g = sys.getDefaultGravity();
+    const auto calcEnergy = [m,g](const State& s) {
+        const Vector& q = s.getQ(); const Vector& u = s.getU();
+        return m*(u[0]*u[0]+u[1]*u[1])/2 + m*g*q[1];
+    };
+
+    RattleIntegrator integ(sys, 0.002);
+    integ.setConstraintTolerance(1e-8);
+    TimeStepper ts(sys, integ);
+    ts.initialize(sys.getDefaultState());
+
+    const Real E0 = calcEnergy(ts.getState());
+    const Real Escale = m*g*sys.getDefaultLength(); // E0 is zero here
+    Real maxErrFirst = 0, maxErrLast = 0;
+    for (int i=1; i <= 1000; ++i) {
+        ts.stepTo(i*Real(0.5));
+        const Real err = std::abs(calcEnergy(ts.getState()) - E0)/Escale;
+        if (i <= 100) maxErrFirst = std::max(maxErrFirst, err);
+        if (i > 900)  maxErrLast  = std::max(maxErrLast,  err);
+    }
+    cout << "Rattle energy error first 50s=" << maxErrFirst
+         << " last 50s=" << maxErrLast << endl;
+    // The pendulum's position projection is not exactly along the RATTLE
+    // direction so we can't insist on zero drift, but it must be small over
+    // 80 periods or so.
+    ASSERT(maxErrFirst < 1e-3);
+    ASSERT(maxErrLast < 1e-3);
+}
+
+int main () {
+  try {
+    testEnergyConservation();
+
+    PendulumSystem sys;
+    sys.addEventHandler(new ZeroVelocityHandler(sys));
+    sys.addEventHandler(PeriodicHandler::handler = new PeriodicHandler());
+    sys.addEventHandler(new ZeroPositionHandler(sys));
+    sys.addEventReporter(PeriodicReporter::reporter = new PeriodicReporter(sys));
+    sys.addEventReporter(new OnceOnlyEventReporter());
+    sys.addEventReporter(new DiscontinuousReporter());
+    sys.realizeTopology();
+
+    // Test with various intervals for the event handler and event reporter, 
+    // ones that are either large or small compared to the expected internal 
+    // step size of the integrator.
+
+    #ifndef NDEBUG
+        const int NumIters = 4;
+    #else
+        const int NumIters = 1; // takes too long in Debug
+    #endif
+
+    for (int i = 0; i < 4; ++i) {
+        PeriodicHandler::handler->setEventInterval
+           (i == 0 || i == 1 ? 0.01 : 2.0);
+        PeriodicReporter::reporter->setEventInterval
+           (i == 0 || i == 2 ? 0.015 : 1.5);
+        
+        // Test the integrator in both normal and single step modes.
+        
+        const Real FixedStepSize = 1e-4;
+        RattleIntegrator integ(sys, FixedStepSize);
+        testIntegrator(integ, sys);
+        integ.setReturnEveryInternalStep(true);
+        testIntegrator(integ, sys);
+    }
+    cout << "Done" << endl;
+    return 0;
+  }
+  catch (std::exception& e) {
+    std::printf("FAILED: %s\n", e.what());
+    return 1;
+  }
+}
@@ -22,6 +22,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "SimTKmath.h"
+#include "simmath/internal/OBBTree.h"
 #include <vector>
 #include <exception>
 
@@ -462,6 +463,228 @@ void testProjectDownhillToNearestPoint(const ContactGeometry& geom, Real r) {
 }
 
 
+// Find the contact between two convex implicit shapes the slow way, from an
+// MPR estimate refined by Newton. Returns the depth, or zero if not touching.
+Real findImplicitPairDepth(const ContactGeometry& shapeA, 
+                           const ContactGeometry& shapeB, const Transform& X_AB) {
+    Vec3 pointP, pointQ;
+    UnitVec3 dir;
+    int numIterations;
+    if (!ContactTracker::estimateConvexImplicitPairContactUsingMPR
+            (shapeA, shapeB, X_AB, pointP, pointQ, dir, numIterations))
+        return 0;
+    Real accuracy;
+    ContactTracker::refineImplicitPair(shapeA, pointP, shapeB, pointQ, X_AB, 
+                                       SignificantReal, accuracy, numIterations);
+    bool inside;
+    UnitVec3 normal;
+    shapeA.findNearestPoint(pointP, inside, normal);
+    return std::max(Real(0), ~(pointP-X_AB*pointQ)*normal);
+}
+
+void testConvexImplicitPair() {
+    const ContactTracker::ConvexImplicitPair tracker
+       (ContactGeometry::Ellipsoid::classTypeId(), 
+        ContactGeometry::Ellipsoid::classTypeId());
+    const UntrackedContact untracked(ContactSurfaceIndex(0), 
+                                     ContactSurfaceIndex(1));
+    Random::Uniform random(-1, 1);
+    random.setSeed(7);
+
+    // Two spheres have an exact answer.
+    const ContactGeometry::Sphere sphereA(1), sphereB(0.5);
+    for (int i = 0; i < 100; i++) {
+        const Vec3 p(random.getValue(), random.getValue(), random.getValue());
+        const Transform X_GB(Rotation(random.getValue(), UnitVec3(1, 2, 3)), 
+                             1.5*p);
+        Contact contact;
+        ASSERT(tracker.trackContact(untracked, Transform(), sphereA, 
+                                    X_GB, sphereB, 0, contact));
+        const Real depth = 1.5 - X_GB.p().norm();
+        if (depth > TOL)
+            assertEqual(depth, EllipticalPointContact::getAs(contact).getDepth());
+        else if (depth < -TOL)
+            ASSERT(contact.isEmpty());
+    }
+
+    // Ellipsoids must agree with MPR and Newton, both when starting fresh and
+    // when starting from the previous contact as the ellipsoids move. Deep 
+    // penetrations can have several solutions, and the two methods needn't
+    // find the same one, so compare those only with each other.
+    const ContactGeometry::Ellipsoid ellipsoidA(Vec3(1, 0.6, 0.4)), 
+                                     ellipsoidB(Vec3(0.5, 0.8, 0.3));
+    int numContacts = 0;
+    for (int i = 0; i < 100; i++) {
+        const Vec3 p(random.getValue(), random.getValue(), random.getValue());
+        const UnitVec3 axis(random.getValue(), random.getValue(), 1);
+        Contact prior = untracked;
+        for (int step = 0; step < 5; step++) {
+            const Transform X_GB(Rotation(0.5*i + 0.02*step, axis), 
+                                 1.2*p + Vec3(0.01*step, 0, 0));
+            const Real depth = findImplicitPairDepth(ellipsoidA, ellipsoidB, X_GB);
+            Contact fresh, warm;
+            ASSERT(tracker.trackContact(untracked, Transform(), ellipsoidA, 
+                                        X_GB, ellipsoidB, 0, fresh));
+            ASSERT(tracker.trackContact(prior, Transform(), ellipsoidA, 
+                                        X_GB, ellipsoidB, 0, warm));
+            if (depth > TOL) {
+                const Real freshDepth = EllipticalPointContact::getAs(fresh).getDepth();
+                assertEqual(freshDepth, EllipticalPointContact::getAs(warm).getDepth());
+                if (depth < 0.1)
+                    assertEqual(depth, freshDepth);
+                numContacts++;
+            }
+            else if (depth == 0) {
+                ASSERT(fresh.isEmpty() && warm.isEmpty());
+            }
+            prior = warm.isEmpty() ? Contact(untracked) : warm;
+        }
+    }
+    ASSERT(numContacts > 100);
+
+    // A resting contact barely moves from step to step; the tracker can 
+    // start from where it was last time but must get the same answer.
+    Contact prior = untracked;
+    for (int step = 0; step < 20; step++) {
+        const Transform X_GB(Rotation(1e-5*step, ZAxis), 
+                             Vec3(0.9, 0.5, 0) + Vec3(0, 1e-5*step, 0));
+        Contact fresh, warm;
+        ASSERT(tracker.trackContact(untracked, Transform(), ellipsoidA, 
+                                    X_GB, ellipsoidB, 0, fresh));
+        ASSERT(tracker.trackContact(prior, Transform(), ellipsoidA, 
+                                    X_GB, ellipsoidB, 0, warm));
+        assertEqual(findImplicitPairDepth(ellipsoidA, ellipsoidB, X_GB),
+                    EllipticalPointContact::getAs(warm).getDepth());
+        assertEqual(EllipticalPointContact::getAs(fresh).getContactFrame().p(),
+                    EllipticalPointContact::getAs(warm).getContactFrame().p());
+        prior = warm;
+    }
+}
+
+
+// Separation bounds must never exceed the true separation, and conservative
+// advancement must find an impact no later than it happens, including for a
+// sphere fast enough to pass right through a thin plate between time steps.
+void testTimeOfImpact() {
+    const SpatialVec still(Vec3(0), Vec3(0));
+    const ContactGeometry::Sphere sphereA(1), sphereB(0.5);
+    const Transform X_GB(Vec3(5, 0, 0));
+    assertEqual(3.5, ContactTracker::calcSeparationLowerBound
+                        (Transform(), sphereA, X_GB, sphereB, 1e-6));
+
+    // Sphere B approaches at 10; they touch at t=0.35.
+    const Real tol = 1e-3;
+    Real toi; int numIterations;
+    const SpatialVec V_GB(Vec3(0), Vec3(-10, 0, 0));
+    ASSERT(ContactTracker::calcTimeOfImpact(Transform(), still, sphereA,
+                X_GB, V_GB, sphereB, 1, tol, toi, numIterations));
+    ASSERT(0.35 - tol/10 <= toi && toi <= 0.35);
+    ASSERT(!ContactTracker::calcTimeOfImpact(Transform(), still, sphereA,
+                X_GB, V_GB, sphereB, 0.3, tol, toi, numIterations));
+    ASSERT(!ContactTracker::calcTimeOfImpact(Transform(), still, sphereA,
+                X_GB, -V_GB, sphereB, 1, tol, toi, numIterations));
+    // Spinning as well makes the bound more conservative but no later.
+    const SpatialVec V_GBspin(Vec3(0, 0, 20), Vec3(-10, 0, 0));
+    ASSERT(ContactTracker::calcTimeOfImpact(Transform(), still, sphereA,
+                X_GB, V_GBspin, sphereB, 1, tol, toi, numIterations));
+    ASSERT(0.35 - tol/10 <= toi && toi <= 0.35);
+
+    // An ellipsoid falling at 2 onto a half space with normal +y touches at
+    // t=(3-0.6)/2.
+    const ContactGeometry::HalfSpace halfSpace;
+    const ContactGeometry::Ellipsoid ellipsoid(Vec3(1, 0.6, 0.4));
+    const Transform X_GH(Rotation(-Pi/2, ZAxis), Vec3(0));
+    const Transform X_GE(Vec3(0.3, 3, -2));
+    assertEqual(2.4, ContactTracker::calcSeparationLowerBound
+                        (X_GH, halfSpace, X_GE, ellipsoid, 1e-6));
+    ASSERT(ContactTracker::calcTimeOfImpact(X_GH, still, halfSpace,
+                X_GE, SpatialVec(Vec3(0), Vec3(0, -2, 0)), ellipsoid, 
+                5, tol, toi, numIterations));
+    ASSERT(1.2 - tol/2 <= toi && toi <= 1.2);
+
+    // Two finite convex shapes use GJK.
+    const ContactGeometry::Brick brick(Vec3(0.5));
+    const Real bound = ContactTracker::calcSeparationLowerBound
+                        (Transform(), brick, Transform(Vec3(3, 0, 0)),
+                         ellipsoid, 1e-4);
+    ASSERT(1.5 - 1e-4 <= bound && bound <= 1.5);
+    ASSERT(ContactTracker::calcSeparationLowerBound
+              (Transform(), brick, Transform(Vec3(1.2, 0, 0)), ellipsoid, 
+               1e-4) <= 0);
+
+    // A small sphere falling at 100 onto a plate 0.02 thick would be below 
+    // it one 0.02s step later, never having been seen touching it.
+    const ContactGeometry::TriangleMesh plate
+       (PolygonalMesh::createBrickMesh(Vec3(1, 0.01, 1)));
+    const ContactGeometry::Sphere ball(0.1);
+    const Transform X_GS(Vec3(0.2, 1, 0.3));
+    const SpatialVec V_GS(Vec3(0), Vec3(0, -100, 0));
+    assertEqual(0.89, ContactTracker::calcSeparationLowerBound
+                        (Transform(), plate, X_GS, ball, 1e-6));
+    ASSERT(ContactTracker::calcSeparationLowerBound
+              (Transform(), plate, Transform(Vec3(0.2, -1, 0.3)), ball, 1e-6) 
+           > 0);
+    ASSERT(ContactTracker::calcTimeOfImpact(Transform(), still, plate,
+                X_GS, V_GS, ball, 0.02, tol, toi, numIterations));
+    ASSERT(0.0089 - tol/100 <= toi && toi <= 0.0089);
+}
+
+
+// Every sampled point of a height map must lie within the bounds reported for
+// any rectangle containing it, and within the bounding sphere.
+void checkHeightBounds(const BicubicSurface& surface, Random::Uniform& random) {
+    const ContactGeometry::SmoothHeightMap map(surface);
+    const Vec2 low(-1, -2), high(3, 2);
+    Real minZ, maxZ;
+    ASSERT(!map.findHeightBounds(Vec2(4, 0), Vec2(5, 1), minZ, maxZ));
+    ASSERT(map.findHeightBounds(Vec2(-10), Vec2(10), minZ, maxZ));
+    const Real allMin = minZ, allMax = maxZ;
+    Vec3 center; Real radius;
+    map.getBoundingSphere(center, radius);
+    BicubicSurface::PatchHint hint;
+    for (int i = 0; i < 200; i++) {
+        Vec2 a(random.getValue(), random.getValue());
+        Vec2 b(random.getValue(), random.getValue());
+        a = low + (high-low).elementwiseMultiply((a+Vec2(1))/2);
+        b = a + Real(0.02*(i%20))*(high-low).elementwiseMultiply(b+Vec2(1));
+        ASSERT(map.findHeightBounds(a, b, minZ, maxZ));
+        ASSERT(allMin <= minZ && maxZ <= allMax);
+        for (int j = 0; j < 10; j++) {
+            const Vec2 t((random.getValue()+1)/2, (random.getValue()+1)/2);
+            Vec2 xy = a + (b-a).elementwiseMultiply(t);
+            xy = Vec2(std::min(xy[0], high[0]), std::min(xy[1], high[1]));
+            const Real z = surface.calcValue(xy, hint);
+            ASSERT(minZ <= z && z <= maxZ);
+            ASSERT((Vec3(xy[0], xy[1], z) - center).norm() <= radius);
+        }
+    }
+}
+
+void testSmoothHeightMap() {
+    Random::Uniform random(-1, 1);
+    random.setSeed(11);
+    const int nx = 41, ny = 37;
+    Matrix f(nx, ny);
+    for (int i = 0; i < nx; i++)
+        for (int j = 0; j < ny; j++)
+            f(i, j) = random.getValue() + std::sin(0.3*i)*std::cos(0.2*j);
+
+    // A regular grid, and the same samples on an irregular one.
+    const Vec2 spacing(Real(4)/(nx-1), Real(4)/(ny-1));
+    const BicubicSurface regular(Vec2(-1, -2), spacing, f);
+    checkHeightBounds(regular, random);
+    Vector x(nx), y(ny);
+    for (int i = 0; i < nx; i++)
+        x[i] = -1 + 4*std::pow(Real(i)/(nx-1), Real(1.5));
+    for (int j = 0; j < ny; j++)
+        y[j] = -2 + 4*std::pow(Real(j)/(ny-1), Real(0.7));
+    checkHeightBounds(BicubicSurface(x, y, f), random);
+
+    // The OBB tree isn't built until it is asked for.
+    const ContactGeometry::SmoothHeightMap map(regular);
+    ASSERT(map.getOBBTree().getRoot().getNumChildren() == 2);
+}
+
 int main() {
     try {
         testHalfSpace();
@@ -475,6 +698,9 @@ int main() {
 //        testAnalyticalCylinderGeodesic();
         testProjectDownhillToNearestPoint(ContactGeometry::Sphere(r), r);
         testProjectDownhillToNearestPoint(ContactGeometry::Ellipsoid(Vec3(1.5, 2.2, 3.1)), r);
+        testConvexImplicitPair();
+        testTimeOfImpact();
+        testSmoothHeightMap();
 //        testProjectDownhillToNearestPoint(ContactGeometry::Torus(3*r, r), 3*r);
     }
     catch(const std::exception& e) {
@@ -22,6 +22,12 @@
  * -------------------------------------------------------------------------- */
 
 #include "SimTKmath.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
 #include <vector>
 #include <exception>
 
@@ -156,7 +162,7 @@ void addOctohedron(vector<Vec3>& vertices, vector<int>& faceIndices, Vec3 offset
 
 void validateOBBTree(const ContactGeometry::TriangleMesh& mesh, ContactGeometry::TriangleMesh::OBBTreeNode node, ContactGeometry::TriangleMesh::OBBTreeNode parent, vector<int>& faceReferenceCount) {
     if (node.isLeafNode()) {
-        const Array_<int>& triangles = node.getTriangles();
+        const ArrayViewConst_<int> triangles = node.getTriangles();
         SimTK_TEST(triangles.size() > 0);
         SimTK_TEST(triangles.size() == node.getNumTriangles());
         for (int i = 0; i < (int) triangles.size(); i++) {
@@ -201,6 +207,243 @@ void testOBBTree() {
         SimTK_TEST(faceReferenceCount[i] == 1);
 }
 
+// A torus made from an n by n grid of quads, each split into two triangles.
+void makeTorus(int n, vector<Vec3>& vertices, vector<int>& faceIndices) {
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++) {
+            Real u = 2*Pi*i/n, v = 2*Pi*j/n;
+            Real r = 0.4*(1+0.05*std::sin(7*u)*std::sin(5*v)), R = 1+r*std::cos(v);
+            vertices.push_back(Vec3(R*std::cos(u), R*std::sin(u), r*std::sin(v)));
+        }
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++) {
+            int a = i*n+j, b = ((i+1)%n)*n+j, c = ((i+1)%n)*n+(j+1)%n, d = i*n+(j+1)%n;
+            int quad[6] = {a, b, c, a, c, d};
+            faceIndices.insert(faceIndices.end(), quad, quad+6);
+        }
+}
+
+bool sameOBBTree(ContactGeometry::TriangleMesh::OBBTreeNode node1, ContactGeometry::TriangleMesh::OBBTreeNode node2) {
+    if (node1.isLeafNode() != node2.isLeafNode() || node1.getNumTriangles() != node2.getNumTriangles())
+        return false;
+    const OrientedBoundingBox box1 = node1.getBounds(), box2 = node2.getBounds();
+    if (box1.getSize() != box2.getSize() || box1.getTransform().p() != box2.getTransform().p() || box1.getTransform().R() != box2.getTransform().R())
+        return false;
+    if (node1.isLeafNode())
+        return node1.getTriangles() == node2.getTriangles();
+    return sameOBBTree(node1.getFirstChildNode(), node2.getFirstChildNode())
+        && sameOBBTree(node1.getSecondChildNode(), node2.getSecondChildNode());
+}
+
+void testOBBTreeOptions() {
+    typedef ContactGeometry::TriangleMesh::OBBTreeOptions OBBTreeOptions;
+    vector<Vec3> vertices;
+    vector<int> faceIndices;
+    makeTorus(101, vertices, faceIndices); // big enough to use threads
+    ContactGeometry::TriangleMesh serial(vertices, faceIndices, false, OBBTreeOptions().setNumThreads(1));
+    vector<int> faceReferenceCount(serial.getNumFaces(), 0);
+    validateOBBTree(serial, serial.getOBBTreeNode(), serial.getOBBTreeNode(), faceReferenceCount);
+    for (int i = 0; i < (int) faceReferenceCount.size(); i++)
+        SimTK_TEST(faceReferenceCount[i] == 1);
+
+    // The tree must not depend on the number of threads, and the default 
+    // options must give the same tree as always.
+    ContactGeometry::TriangleMesh parallel(vertices, faceIndices, false, OBBTreeOptions().setNumThreads(4));
+    SimTK_TEST(sameOBBTree(serial.getOBBTreeNode(), parallel.getOBBTreeNode()));
+    ContactGeometry::TriangleMesh standard(vertices, faceIndices);
+    SimTK_TEST(sameOBBTree(serial.getOBBTreeNode(), standard.getOBBTreeNode()));
+
+    // The surface area heuristic gives a different tree, but it must be a 
+    // valid one that produces the same answers.
+    OBBTreeOptions sahOptions = OBBTreeOptions().setSplitMethod(OBBTreeOptions::SurfaceAreaSplit);
+    ContactGeometry::TriangleMesh sah(vertices, faceIndices, false, sahOptions);
+    SimTK_TEST(!sameOBBTree(serial.getOBBTreeNode(), sah.getOBBTreeNode()));
+    SimTK_TEST(sameOBBTree(sah.getOBBTreeNode(), ContactGeometry::TriangleMesh(vertices, faceIndices, false, OBBTreeOptions(sahOptions).setNumThreads(1)).getOBBTreeNode()));
+    faceReferenceCount.assign(sah.getNumFaces(), 0);
+    validateOBBTree(sah, sah.getOBBTreeNode(), sah.getOBBTreeNode(), faceReferenceCount);
+    for (int i = 0; i < (int) faceReferenceCount.size(); i++)
+        SimTK_TEST(faceReferenceCount[i] == 1);
+    Random::Uniform random(-1.5, 1.5);
+    for (int i = 0; i < 100; i++) {
+        Vec3 pos(random.getValue(), random.getValue(), random.getValue()/2);
+        bool inside1, inside2;
+        UnitVec3 normal1, normal2;
+        Vec3 nearest1 = serial.findNearestPoint(pos, inside1, normal1);
+        Vec3 nearest2 = sah.findNearestPoint(pos, inside2, normal2);
+        SimTK_TEST_EQ((nearest1-pos).norm(), (nearest2-pos).norm());
+        SimTK_TEST(inside1 == inside2);
+        Real distance1 = 0, distance2 = 0;
+        SimTK_TEST(serial.intersectsRay(Vec3(3, 0, 0), UnitVec3(pos-Vec3(3, 0, 0)), distance1, normal1)
+                   == sah.intersectsRay(Vec3(3, 0, 0), UnitVec3(pos-Vec3(3, 0, 0)), distance2, normal2));
+        SimTK_TEST_EQ(distance1, distance2);
+    }
+
+    // The first construction writes the cache file and the second reads it.
+    const string cacheFile = "TestTriangleMesh.obbtree";
+    std::remove(cacheFile.c_str());
+    ContactGeometry::TriangleMesh writer(vertices, faceIndices, false, OBBTreeOptions(sahOptions).setCacheFile(cacheFile));
+    SimTK_TEST(sameOBBTree(sah.getOBBTreeNode(), writer.getOBBTreeNode()));
+    ContactGeometry::TriangleMesh reader(vertices, faceIndices, false, OBBTreeOptions(sahOptions).setCacheFile(cacheFile));
+    SimTK_TEST(sameOBBTree(sah.getOBBTreeNode(), reader.getOBBTreeNode()));
+
+    // A cache for a different split method or a different mesh is ignored.
+    ContactGeometry::TriangleMesh median(vertices, faceIndices, false, OBBTreeOptions().setCacheFile(cacheFile));
+    SimTK_TEST(sameOBBTree(serial.getOBBTreeNode(), median.getOBBTreeNode()));
+    vector<Vec3> moved(vertices);
+    moved[17] *= 1.01;
+    ContactGeometry::TriangleMesh other(moved, faceIndices, false, OBBTreeOptions().setCacheFile(cacheFile));
+    SimTK_TEST(sameOBBTree(ContactGeometry::TriangleMesh(moved, faceIndices).getOBBTreeNode(), other.getOBBTreeNode()));
+
+    // So is a damaged one.
+    {
+        std::ifstream in(cacheFile.c_str(), std::ios::binary);
+        string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::ofstream out(cacheFile.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), contents.size()/2);
+    }
+    ContactGeometry::TriangleMesh truncated(moved, faceIndices, false, OBBTreeOptions().setCacheFile(cacheFile));
+    SimTK_TEST(sameOBBTree(other.getOBBTreeNode(), truncated.getOBBTreeNode()));
+    std::remove(cacheFile.c_str());
+}
+
+// Every pair of faces that actually intersect must be found by the mesh-mesh
+// contact tracker, whose tree traversal is only allowed to discard box pairs
+// that are certainly separated.
+void testMeshMeshContact() {
+    vector<Vec3> vertices;
+    vector<int> faceIndices;
+    makeTorus(24, vertices, faceIndices);
+    ContactGeometry::TriangleMesh mesh1(vertices, faceIndices);
+    ContactGeometry::TriangleMesh mesh2(vertices, faceIndices, false, ContactGeometry::TriangleMesh::OBBTreeOptions().setSplitMethod(ContactGeometry::TriangleMesh::OBBTreeOptions::SurfaceAreaSplit));
+    const ContactTracker::TriangleMeshTriangleMesh tracker;
+    const UntrackedContact prior(ContactSurfaceIndex(0), ContactSurfaceIndex(1));
+    Random::Uniform random(-1, 1);
+    random.setSeed(5);
+    int numTouching = 0;
+    for (int k = 0; k < 20; k++) {
+        const Transform X_GM2(Rotation(Pi*random.getValue(), UnitVec3(random.getValue(), random.getValue(), random.getValue())),
+                              Vec3(random.getValue(), random.getValue(), random.getValue()/2));
+        Contact contact;
+        SimTK_TEST(tracker.trackContact(prior, Transform(), mesh1, X_GM2, mesh2, 0, contact));
+        set<int> faces1, faces2;
+        if (TriangleMeshContact::isInstance(contact)) {
+            faces1 = TriangleMeshContact::getAs(contact).getSurface1Faces();
+            faces2 = TriangleMeshContact::getAs(contact).getSurface2Faces();
+            numTouching++;
+
+            // The lists hold the same faces in ascending order.
+            const Array_<int>& list1 = TriangleMeshContact::getAs(contact).getSurface1FaceList();
+            const Array_<int>& list2 = TriangleMeshContact::getAs(contact).getSurface2FaceList();
+            SimTK_TEST(list1.size() == faces1.size() && std::equal(list1.begin(), list1.end(), faces1.begin()));
+            SimTK_TEST(list2.size() == faces2.size() && std::equal(list2.begin(), list2.end(), faces2.begin()));
+
+            // Nothing has moved, so tracking again must find the same faces.
+            Contact again;
+            SimTK_TEST(tracker.trackContact(contact, Transform(), mesh1, X_GM2, mesh2, 0, again));
+            SimTK_TEST(TriangleMeshContact::getAs(again).getSurface1Faces() == faces1);
+            SimTK_TEST(TriangleMeshContact::getAs(again).getSurface2Faces() == faces2);
+        }
+        for (int i = 0; i < mesh2.getNumFaces(); i++) {
+            const Geo::Triangle A(X_GM2*mesh2.getVertexPosition(mesh2.getFaceVertex(i, 0)),
+                                  X_GM2*mesh2.getVertexPosition(mesh2.getFaceVertex(i, 1)),
+                                  X_GM2*mesh2.getVertexPosition(mesh2.getFaceVertex(i, 2)));
+            for (int j = 0; j < mesh1.getNumFaces(); j++) {
+                const Geo::Triangle B(mesh1.getVertexPosition(mesh1.getFaceVertex(j, 0)),
+                                      mesh1.getVertexPosition(mesh1.getFaceVertex(j, 1)),
+                                      mesh1.getVertexPosition(mesh1.getFaceVertex(j, 2)));
+                if (A.overlapsTriangle(B)) {
+                    SimTK_TEST(faces1.count(j) == 1);
+                    SimTK_TEST(faces2.count(i) == 1);
+                }
+            }
+        }
+    }
+    SimTK_TEST(numTouching > 10);
+}
+
+void testMeshFaceSet() {
+    MeshFaceSet faces(100);
+    SimTK_TEST(faces.empty() && faces.getNumMeshFaces() == 100);
+    SimTK_TEST(faces.insert(70));
+    SimTK_TEST(faces.insert(3));
+    SimTK_TEST(!faces.insert(70));
+    SimTK_TEST(faces.insert(31));
+    SimTK_TEST(faces.insert(32));
+    SimTK_TEST(faces.size() == 4);
+    SimTK_TEST(faces.contains(3) && faces.contains(31) && faces.contains(32) && faces.contains(70));
+    SimTK_TEST(!faces.contains(0) && !faces.contains(33) && !faces.contains(99));
+    SimTK_TEST(faces[0] == 70 && faces[1] == 3); // in insertion order
+    faces.sortFaces();
+    const int sorted[] = {3, 31, 32, 70};
+    SimTK_TEST(std::equal(faces.begin(), faces.end(), sorted));
+
+    // Resetting empties the set, even for a smaller mesh.
+    faces.reset(50);
+    SimTK_TEST(faces.empty() && faces.getNumMeshFaces() == 50);
+    for (int i = 0; i < 50; i++) {
+        SimTK_TEST(!faces.contains(i));
+    }
+    faces.insert(49);
+    faces.reset(200);
+    SimTK_TEST(faces.empty() && !faces.contains(49) && !faces.contains(199));
+    SimTK_TEST(faces.insert(199) && faces.contains(199));
+    faces.clear();
+    SimTK_TEST(faces.empty() && !faces.contains(199) && faces.getNumMeshFaces() == 200);
+}
+
+void testDistanceField() {
+    vector<Vec3> vertices;
+    vector<int> faceIndices;
+    makeTorus(40, vertices, faceIndices);
+    const ContactGeometry::TriangleMesh plain(vertices, faceIndices);
+    ContactGeometry::TriangleMesh mesh(plain);
+    SimTK_TEST(!mesh.hasDistanceField());
+    Real distance, maxError;
+    SimTK_TEST(!mesh.estimateSignedDistance(Vec3(0), distance, maxError));
+    SimTK_TEST_MUST_THROW(mesh.createDistanceField(0));
+    const Real cellSize = 0.04;
+    mesh.createDistanceField(cellSize);
+    SimTK_TEST(mesh.hasDistanceField());
+    SimTK_TEST(!mesh.estimateSignedDistance(Vec3(10, 0, 0), distance, maxError));
+
+    // The estimates must be within their error bounds, which should be about
+    // a cell diagonal near the surface. Nearest points and sphere contacts 
+    // must not change.
+    const ContactTracker::SphereTriangleMesh tracker;
+    const UntrackedContact prior(ContactSurfaceIndex(0), ContactSurfaceIndex(1));
+    const ContactGeometry::Sphere sphere(0.1);
+    Random::Uniform random(-1.5, 1.5);
+    random.setSeed(3);
+    int numNear = 0, numTouching = 0;
+    for (int i = 0; i < 2000; i++) {
+        const Vec3 pos(random.getValue(), random.getValue(), random.getValue()/3);
+        bool inside1, inside2;
+        int face1, face2;
+        Vec2 uv1, uv2;
+        const Vec3 nearest1 = plain.findNearestPoint(pos, inside1, face1, uv1);
+        const Vec3 nearest2 = mesh.findNearestPoint(pos, inside2, face2, uv2);
+        SimTK_TEST(nearest1 == nearest2 && inside1 == inside2 && face1 == face2 && uv1 == uv2);
+        SimTK_TEST(mesh.estimateSignedDistance(pos, distance, maxError));
+        const Real exact = inside1 ? -(pos-nearest1).norm() : (pos-nearest1).norm();
+        SimTK_TEST(std::abs(exact-distance) <= maxError);
+        if (std::abs(exact) < 2*cellSize) {
+            SimTK_TEST(maxError < 2*cellSize);
+            numNear++;
+        }
+
+        Contact contact1, contact2;
+        tracker.trackContact(prior, Transform(pos), sphere, Transform(), plain, 0, contact1);
+        tracker.trackContact(prior, Transform(pos), sphere, Transform(), mesh, 0, contact2);
+        SimTK_TEST(TriangleMeshContact::isInstance(contact1) == TriangleMeshContact::isInstance(contact2));
+        if (TriangleMeshContact::isInstance(contact1)) {
+            SimTK_TEST(TriangleMeshContact::getAs(contact1).getSurface2Faces() == TriangleMeshContact::getAs(contact2).getSurface2Faces());
+            numTouching++;
+        }
+    }
+    SimTK_TEST(numNear > 10 && numTouching > 100);
+}
+
 void testRayIntersection() {
     // Create an octrohedral mesh.
     
@@ -312,9 +555,13 @@ int main() {
         SimTK_SUBTEST(testTriangleMesh);
         SimTK_SUBTEST(testIncorrectMeshes);
         SimTK_SUBTEST(testOBBTree);
+        SimTK_SUBTEST(testOBBTreeOptions);
+        SimTK_SUBTEST(testMeshMeshContact);
+        SimTK_SUBTEST(testMeshFaceSet);
         SimTK_SUBTEST(testRayIntersection);
         SimTK_SUBTEST(testSmoothMesh);
         SimTK_SUBTEST(testFindNearestPoint);
         SimTK_SUBTEST(testBoundingSphere);
+        SimTK_SUBTEST(testDistanceField);
     SimTK_END_TEST();
 }
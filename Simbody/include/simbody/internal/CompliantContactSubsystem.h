@@ -85,6 +85,21 @@ has not been set.
 @see getDissipatedEnergy(),setDissipatedEnergy(),setTrackDissipatedEnergy() **/
 bool getTrackDissipatedEnergy() const;
 
+/** Set the number of threads this subsystem can use to calculate contact
+forces. Each active Contact's force is calculated independently and the
+results are combined in Contact order afterwards, so the forces are
+bitwise identical regardless of the number of threads. By default this is
+the number of processors (including hyperthreads) on the machine; set it to
+1 to do all the work on the calling thread. Threads are used only when there
+are enough contacts, or expensive enough ones (mesh contacts), to be worth
+the overhead. 
+@note This method should NOT be called while realizing Stage::Dynamics.
+@see ContactTrackerSubsystem::setNumberOfThreads() **/
+void setNumberOfThreads(unsigned numThreads);
+/** Return the maximum number of threads this subsystem can use to calculate
+contact forces. **/
+int getNumberOfThreads() const;
+
 /** Determine how many of the active Contacts are currently generating
 contact forces. You can call this at Velocity stage or later; the contact
 forces will be realized first if necessary before we report how many there 
@@ -807,14 +822,14 @@ void calcContactForceAndDetails
 
 void calcWeightedPatchCentroid
    (const ContactGeometry::TriangleMesh&    mesh,
-    const std::set<int>&                    insideFaces,
+    const Array_<int>&                      insideFaces,
     Vec3&                                   weightedPatchCentroid,
     Real&                                   patchArea) const;
                        
 void processOneMesh
    (const State&                            state,
     const ContactGeometry::TriangleMesh&    mesh,
-    const std::set<int>&                    insideFaces,
+    const Array_<int>&                      insideFaces,
     const Transform&                        X_MO, 
     const SpatialVec&                       V_MO,
     const ContactGeometry&                  other,
@@ -218,9 +218,21 @@ public:
     this should be the same Vec3 you got from getPositionInfo(). **/
     virtual void setInstanceParameter(State& state, const Vec3& pos) const {}
 
+    /** Append to \a bodies the mobilized bodies whose motion this contact
+    restricts; Ground may be among them. A time stepper uses this to find out
+    which bodies are interacting, for example to put a group of resting 
+    bodies to sleep together. The default appends nothing, meaning that the
+    bodies aren't known. This requires only Stage::Topology. **/
+    virtual void 
+    getConstrainedBodies(Array_<MobilizedBodyIndex>& bodies) const {}
 
     void setMyIndex(UnilateralContactIndex cx) {m_myIx = cx;}
     UnilateralContactIndex getMyIndex() const {return m_myIx;}
+protected:
+    /** Append the bodies and mobilizers restricted by one of the Constraints
+    used to implement a contact. **/
+    static void appendConstrainedBodies(const Constraint&             constraint,
+                                        Array_<MobilizedBodyIndex>&   bodies);
 private:
     Real                    m_sign; // 1 or -1
     UnilateralContactIndex  m_myIx;
@@ -375,6 +387,9 @@ public:
 
     MultiplierIndex getContactMultiplierIndex(const State& s) const override;
 
+    void getConstrainedBodies(Array_<MobilizedBodyIndex>& bodies) const 
+        override {appendConstrainedBodies(m_upper, bodies);}
+
 private:
     MobilizedBody                   m_mobod;
     Real                            m_defaultUpperLimit;
@@ -432,6 +447,10 @@ public:
     }
 
     MultiplierIndex getContactMultiplierIndex(const State& s) const override;
+
+    void getConstrainedBodies(Array_<MobilizedBodyIndex>& bodies) const 
+        override {appendConstrainedBodies(m_lower, bodies);}
+
 private:
     MobilizedBody                   m_mobod;
     Real                            m_defaultLowerLimit;
@@ -491,6 +510,10 @@ public:
     }
 
     MultiplierIndex getContactMultiplierIndex(const State& s) const override;
+
+    void getConstrainedBodies(Array_<MobilizedBodyIndex>& bodies) const 
+        override {appendConstrainedBodies(m_rod, bodies);}
+
 private:
     Real                            m_minCOR;
     Constraint::Rod                 m_rod;
@@ -553,6 +576,9 @@ public:
 
     MultiplierIndex getContactMultiplierIndex(const State& s) const override;
 
+    void getConstrainedBodies(Array_<MobilizedBodyIndex>& bodies) const 
+        override {appendConstrainedBodies(m_ptInPlane, bodies);}
+
 private:
     MobilizedBody               m_planeBody;    // body P
     const Rotation              m_frame;        // z is normal; expressed in P
@@ -645,6 +671,9 @@ public:
                                       MultiplierIndex& ix_x, 
                                       MultiplierIndex& ix_y) const override;
 
+    void getConstrainedBodies(Array_<MobilizedBodyIndex>& bodies) const 
+        override {appendConstrainedBodies(m_ptInPlane, bodies);}
+
 private:
     MobilizedBody               m_planeBody;    // body P
     const Rotation              m_frame;        // z is normal; expressed in P
@@ -737,6 +766,9 @@ public:
                                       MultiplierIndex& ix_x, 
                                       MultiplierIndex& ix_y) const override;
 
+    void getConstrainedBodies(Array_<MobilizedBodyIndex>& bodies) const 
+        override {appendConstrainedBodies(m_sphereOnPlane, bodies);}
+
 private:
     Real                        m_minCOR;
     Real                        m_mu_s, m_mu_d, m_mu_v;
@@ -827,6 +859,9 @@ public:
                                       MultiplierIndex& ix_x, 
                                       MultiplierIndex& ix_y) const override;
 
+    void getConstrainedBodies(Array_<MobilizedBodyIndex>& bodies) const 
+        override {appendConstrainedBodies(m_sphereOnSphere, bodies);}
+
 private:
     Real                        m_minCOR;
     Real                        m_mu_s, m_mu_d, m_mu_v;
@@ -923,6 +958,9 @@ public:
                                       MultiplierIndex& ix_x, 
                                       MultiplierIndex& ix_y) const override;
 
+    void getConstrainedBodies(Array_<MobilizedBodyIndex>& bodies) const 
+        override {appendConstrainedBodies(m_lineOnLine, bodies);}
+
 private:
     Real                        m_minCOR;
     Real                        m_mu_s, m_mu_d, m_mu_v;
@@ -218,6 +218,87 @@ const Transform& getContactSurfaceTransform(ContactSurfaceIndex surfIx) const;
 /**@}**/
 
 
+/**@name                        Broad phase
+The broad phase uses a bounding sphere ("bubble") around each contact surface
+to find the pairs of surfaces that might be touching; only those pairs are
+passed to a ContactTracker. You can choose how that search is done. **/
+/**@{**/
+
+/** These are the available broad phase algorithms. Both produce exactly the
+same set of candidate surface pairs; they differ only in cost. **/
+enum BroadPhase {
+    /** Keep the bubbles' bounding box endpoints sorted along all three axes
+    from one evaluation to the next, repairing the order by insertion sort,
+    along with the persistent set of overlapping pairs. This is very cheap
+    when surfaces move only a little between evaluations, as they do during
+    time stepping, but the cost grows with the number of endpoint swaps when
+    many surfaces are moving past one another. This is the default. **/
+    SweepAndPrune = 0,
+    /** Keep the bubbles' bounding boxes in a balanced bounding volume tree
+    that persists from one evaluation to the next. Boxes are fattened so that
+    a surface can move a little without changing the tree; otherwise only the
+    moved surfaces are reinserted. Prefer this for scenes with thousands of
+    surfaces. **/
+    DynamicTree = 1
+};
+
+/** Select the broad phase algorithm to be used. This is a Topology-stage
+change, so you must call realizeTopology() again afterwards. **/
+void setBroadPhase(BroadPhase method);
+
+/** Return the broad phase algorithm currently in use. **/
+BroadPhase getBroadPhase() const;
+/**@}**/
+
+
+/**@name                        Multithreading
+Each candidate pair of surfaces found by the broad phase is examined by its
+ContactTracker independently of the others, so this narrow phase work can be
+spread over several threads. The resulting contacts, including their
+ContactIds, are identical regardless of the number of threads. **/
+/**@{**/
+
+/** Set the number of threads the ContactTrackerSubsystem can use for narrow
+phase contact tracking. By default this is the number of processors
+(including hyperthreads) on the machine; set it to 1 to do all the tracking on
+the calling thread. Threads are used only when there are enough candidate
+pairs, or expensive enough ones (involving meshes), to be worth the overhead.
+
+@note This method should NOT be called while realizing Stage::Dynamics. **/
+void setNumberOfThreads(unsigned numThreads);
+
+/** Return the maximum number of threads the ContactTrackerSubsystem can use
+for narrow phase contact tracking. **/
+int getNumberOfThreads() const;
+/**@}**/
+
+
+/**@name                    Continuous collision detection
+A small, fast surface can pass right through a thin one during a single 
+time step without either surface ever seeing the other, unless the step is
+kept short enough. Rather than shortening the step for the whole system, 
+you can ask here how long a step the current surface velocities permit; only 
+pairs of surfaces that could move past one another are looked at closely. 
+An ImpactStepLimiter event handler will apply this limit to a TimeStepper's
+integrator for you. **/
+/**@{**/
+
+/** Return the longest step, up to \a maxStep, that can be taken from the 
+given \a state without any pair of surfaces, moving at their current 
+velocities, passing into one another by more than a quarter of the smaller
+one's bounding radius, so that any contact that begins during the step will
+still be seen when it ends. Pairs that can't approach one another by that 
+much during \a maxStep are skipped; the others get a conservative time of 
+impact query from ContactTracker::calcTimeOfImpact(). If the step is limited,
+\a surface1 and \a surface2 are set to the pair that limited it; otherwise
+they are invalid. The \a state must be realized through Stage::Velocity. **/
+Real calcMaxStepWithoutTunneling(const State&         state, 
+                                 Real                 maxStep,
+                                 ContactSurfaceIndex& surface1,
+                                 ContactSurfaceIndex& surface2) const;
+/**@}**/
+
+
 /**@name                     Contact Tracker management
 Most users won't need to use these methods. **/
 /**@{**/
@@ -291,6 +372,42 @@ const ContactTrackerSubsystemImpl& getImpl() const;
 
 
 
+
+//==============================================================================
+//                           IMPACT STEP LIMITER
+//==============================================================================
+/** This scheduled event handler keeps a TimeStepper's integrator from taking
+a step so long that a fast surface could pass through another one unseen.
+At each step it schedules a do-nothing event at the end of the longest step
+allowed by ContactTrackerSubsystem::calcMaxStepWithoutTunneling(), so that 
+the integrator stops there; the integrator's own step size control is
+otherwise unaffected. Only surfaces at risk of tunneling limit the step. 
+
+The \a lookAhead interval is the longest step this will allow, and the
+window over which impacts are looked for, so make it no shorter than the
+steps you expect the integrator to take. **/
+class SimTK_SIMBODY_EXPORT ImpactStepLimiter : public ScheduledEventHandler {
+public:
+/** Add this to a MultibodySystem with 
+`system.addEventHandler(new ImpactStepLimiter(tracker, lookAhead))`. **/
+ImpactStepLimiter(const ContactTrackerSubsystem& tracker, Real lookAhead);
+
+/** Return the time at the end of the longest safe step from \a state, or 
+infinity if \a state hasn't been realized through Stage::Velocity. **/
+Real getNextEventTime(const State& state, 
+                      bool includeCurrentTime) const override;
+
+/** Nothing happens at these events; the integrator just stops there. **/
+void handleEvent(State& state, Real accuracy, 
+                 bool& shouldTerminate) const override;
+
+private:
+const ContactTrackerSubsystem&  m_tracker;
+Real                            m_lookAhead;
+};
+
+
+
 //==============================================================================
 //                            CONTACT SNAPSHOT
 //==============================================================================
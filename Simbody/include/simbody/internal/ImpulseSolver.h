@@ -114,6 +114,7 @@ public:
     struct BoundedRT;
     struct ConstraintLtdFrictionRT;
     struct StateLtdFrictionRT;
+    class  SparseMatrix;
 
     // How to treat a unilateral contact (input to solver).
     enum ContactType {TypeNA=-1, Observing=0, Known=1, Participating=2};
@@ -131,13 +132,21 @@ public:
                   int maxIters) 
     :   m_maxRollingTangVel(roll2slipTransitionSpeed),
         m_convergenceTol(convergenceTol),
-        m_maxIters(maxIters)
+        m_maxIters(maxIters),
+        m_useInitialGuess(false)
     {
         clearStats();
     }
 
     virtual ~ImpulseSolver() {}
 
+    /** Return a new solver of the same concrete type and settings, or null if
+    this solver can't be copied. A solver keeps working storage from one 
+    solve to the next so can't be shared by threads; a time stepper that 
+    solves independent groups of constraints concurrently gives each group 
+    its own copy. The caller takes ownership. The default returns null. **/
+    virtual ImpulseSolver* clone() const {return 0;}
+
     void setMaxRollingSpeed(Real roll2slipTransitionSpeed) {
         assert(roll2slipTransitionSpeed >= 0);
         m_maxRollingTangVel = roll2slipTransitionSpeed; 
@@ -156,6 +165,15 @@ public:
     }
     int getMaxIterations() const {return m_maxIters;}
 
+    /** Set whether solve() should take the values of the participating 
+    multipliers in \a pi on entry as its initial guess. The guess is used only
+    if \a pi has length m on entry; otherwise the solve starts from zero as 
+    usual. A good guess, such as the previous step's impulses for contacts
+    that persist, can greatly reduce the number of iterations needed. The
+    default is not to use a guess. **/
+    void setUseInitialGuess(bool useGuess) {m_useInitialGuess = useGuess;}
+    bool getUseInitialGuess() const {return m_useInitialGuess;}
+
     // We'll keep stats separately for different "phases". The meaning of a
     // phase is up to the caller.
     static const int MaxNumPhases = 3;
@@ -173,7 +191,36 @@ public:
         m_nSolves[phase] = m_nIters[phase] = m_nFail[phase] = 0;
     }
 
-    /** Solve. **/
+    /** Return the number of calls to solve() for this phase since stats were
+    last cleared, the total number of iterations they took, and the number 
+    that failed to converge. What counts as an iteration depends on the 
+    concrete solver. **/
+    long long getNumSolves(int phase) const 
+    {   checkPhase(phase); return m_nSolves[phase]; }
+    long long getNumIterations(int phase) const 
+    {   checkPhase(phase); return m_nIters[phase]; }
+    long long getNumFailures(int phase) const 
+    {   checkPhase(phase); return m_nFail[phase]; }
+    /** Same as above for solveBilateral(). **/
+    long long getNumBilateralSolves() const {return m_nBilateralSolves;}
+    long long getNumBilateralIterations() const {return m_nBilateralIters;}
+    long long getNumBilateralFailures() const {return m_nBilateralFail;}
+
+    /** Add another solver's stats into this one's, for example those of a 
+    copy made with clone(). **/
+    void accumulateStats(const ImpulseSolver& other) const {
+        for (int i=0; i < MaxNumPhases; ++i) {
+            m_nSolves[i] += other.m_nSolves[i];
+            m_nIters[i]  += other.m_nIters[i];
+            m_nFail[i]   += other.m_nFail[i];
+        }
+        m_nBilateralSolves += other.m_nBilateralSolves;
+        m_nBilateralIters  += other.m_nBilateralIters;
+        m_nBilateralFail   += other.m_nBilateralFail;
+    }
+
+    /** Solve. On return \a pi holds the unknown impulse; on entry it may 
+    hold an initial guess, see setUseInitialGuess(). **/
     virtual bool solve
        (int                                 phase,
         const Array_<MultiplierIndex>&      participating, // p<=m of these 
@@ -222,6 +269,40 @@ public:
         Vector&                             pi     // m, unknown result
         ) const = 0;
 
+    /** Same as the solve() above but with A given as a SparseMatrix, for 
+    large systems in which each constraint equation is coupled to only a few
+    others. A concrete %ImpulseSolver should override this to work on the 
+    sparse matrix directly; the default makes a dense copy of A and calls the
+    dense solve(). **/
+    virtual bool solve
+       (int                                 phase,
+        const Array_<MultiplierIndex>&      participating,
+        const SparseMatrix&                 A,
+        const Vector&                       D,
+        const Array_<MultiplierIndex>&      expanding,
+        Vector&                             piExpand,
+        Vector&                             verrStart,
+        Vector&                             verrApplied,
+        Vector&                             pi,
+        Array_<UncondRT>&                   unconditional,
+        Array_<UniContactRT>&               uniContact,
+        Array_<UniSpeedRT>&                 uniSpeed,
+        Array_<BoundedRT>&                  bounded,
+        Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+        Array_<StateLtdFrictionRT>&         stateLtdFriction
+        ) const;
+
+    /** Same as the solveBilateral() above but with A given as a 
+    SparseMatrix. The default makes a dense copy of A and calls the dense
+    solveBilateral(). **/
+    virtual bool solveBilateral
+       (const Array_<MultiplierIndex>&      participating,
+        const SparseMatrix&                 A,
+        const Vector&                       D,
+        const Vector&                       rhs,
+        Vector&                             pi
+        ) const;
+
     // Printable names for the enum values for debugging.
     static const char* getContactTypeName(ContactType ct);
     static const char* getUniCondName(UniCond uc);
@@ -233,9 +314,16 @@ public:
                                 const Array_<UniContactRT>& uniContacts);
 
 protected:
+    static void checkPhase(int phase) {
+        SimTK_ERRCHK2(0<=phase&&phase<MaxNumPhases,
+            "ImpulseSolver::getStats(phase)",
+            "Phase must be 0..%d but was %d\n", MaxNumPhases-1, phase);
+    }
+
     Real m_maxRollingTangVel; // Sliding above this speed if solver cares.
     Real m_convergenceTol;    // Meaning depends on concrete solver.
     int  m_maxIters;          // Meaning depends on concrete solver.
+    bool m_useInitialGuess;   // Start from incoming pi if it has length m.
 
     mutable long long m_nSolves[MaxNumPhases];
     mutable long long m_nIters[MaxNumPhases];
@@ -363,6 +451,65 @@ struct ImpulseSolver::StateLtdFrictionRT {
     Array_<Real>            m_Fimpulse; // same size as m_Fk
 };
 
+/** A symmetric mXm matrix, such as A=G M\ ~G, that stores only its 
+structural nonzeros. An entry A(i,j) is structurally nonzero when 
+constraint equations i and j act on a common mobility; in a large system of 
+loosely-connected bodies nearly all entries are zero. Both triangles are 
+stored, by column, so column j can also be read as row j. Build the matrix 
+by calling clear() and then, for each column in order, appendEntry() for 
+its nonzeros in increasing row order followed by finishColumn(). **/
+class SimTK_SIMBODY_EXPORT ImpulseSolver::SparseMatrix {
+public:
+    SparseMatrix() {clear(0);}
+
+    /** Make this an empty mXm matrix, ready for its first column. **/
+    void clear(int m) {
+        m_size = m;
+        m_colStart.clear(); m_colStart.push_back(0);
+        m_rows.clear(); m_values.clear();
+    }
+    /** Add entry A(row,j) where j is the column currently being built. Rows
+    must be supplied in increasing order. **/
+    void appendEntry(int row, Real value) {
+        assert(0 <= row && row < m_size);
+        assert((int)m_rows.size() == m_colStart.back() || m_rows.back() < row);
+        m_rows.push_back(row); m_values.push_back(value);
+    }
+    /** Finish the current column and start the next one. **/
+    void finishColumn() {
+        assert((int)m_colStart.size() <= m_size);
+        m_colStart.push_back((int)m_rows.size());
+    }
+
+    int nrow() const {return m_size;}
+    int ncol() const {return m_size;}
+    /** Return the number of stored entries, counting both triangles. **/
+    int getNumEntries() const {return (int)m_rows.size();}
+
+    /** The entries of column j are numbered from getColumnBegin(j) up to 
+    but not including getColumnEnd(j). **/
+    int getColumnBegin(int j) const {return m_colStart[j];}
+    int getColumnEnd(int j) const {return m_colStart[j+1];}
+    int getEntryRow(int k) const {return m_rows[k];}
+    Real getEntryValue(int k) const {return m_values[k];}
+
+    /** Return A(i,j), which is zero if it isn't stored. This is a binary 
+    search through column j. **/
+    Real operator()(int i, int j) const;
+
+    /** Calculate Ax = A*x. **/
+    void multiply(const Vector& x, Vector& Ax) const;
+
+    /** Return A as a dense matrix. **/
+    Matrix toDense() const;
+
+private:
+    int             m_size;
+    Array_<int>     m_colStart; // m+1 once all columns are finished
+    Array_<int>     m_rows;
+    Array_<Real>    m_values;
+};
+
 } // namespace SimTK
 
 #endif // SimTK_SIMBODY_IMPULSE_SOLVER_H_
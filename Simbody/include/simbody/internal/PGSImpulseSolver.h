@@ -58,7 +58,51 @@ public:
     :   ImpulseSolver(roll2slipTransitionSpeed,
                       1e-6, // default PGS convergence tolerance
                       100), // default PGS max number iterations
-        m_SOR(1.2) {}
+        m_SOR(1.2), m_sweepMode(Serial), 
+        m_executor(new ParallelExecutor()), m_numColors(0) {}
+
+    PGSImpulseSolver* clone() const override 
+    {   return new PGSImpulseSolver(*this); }
+
+    /** How each PGS iteration visits the unilateral contacts. The sweep 
+    modes other than Serial are used only when unilateral contacts are the 
+    only conditional constraints in the problem; otherwise the sweep is 
+    serial regardless. **/
+    enum SweepMode {
+        /** Update one contact after another, each seeing the latest values
+        of all the others. This is the default. **/
+        Serial  = 0,
+        /** Color the contacts so that no two contacts of the same color are
+        coupled through A, that is, they don't act on the same body nor on 
+        bodies connected by joints. All the contacts of one color are then 
+        updated concurrently, one color after another. This is still Gauss
+        Seidel, just in a different order, and the result does not depend on
+        the number of threads. **/
+        Colored = 1,
+        /** Update every contact concurrently from the previous iteration's 
+        values, under-relaxed by the number of colors so that the iteration
+        still converges. This is here for comparison; it usually needs many
+        more iterations than the Gauss Seidel sweeps. **/
+        Jacobi  = 2
+    };
+
+    /** Choose how each iteration visits the unilateral contacts. 
+    @see SweepMode **/
+    void setSweepMode(SweepMode mode) {m_sweepMode = mode;}
+    /** Return the current sweep mode. @see setSweepMode() **/
+    SweepMode getSweepMode() const {return m_sweepMode;}
+
+    /** Set the number of threads that may be used for the Colored and 
+    Jacobi sweep modes. By default this is the number of processors 
+    (including hyperthreads) on the machine. Threads are used only when there
+    are enough contacts of one color to be worth the overhead. **/
+    void setNumberOfThreads(unsigned numThreads);
+    /** Return the maximum number of threads that may be used. **/
+    int getNumberOfThreads() const;
+
+    /** Return the number of colors the contacts needed on the last solve() 
+    that used the Colored or Jacobi sweep mode. **/
+    int getNumColors() const {return m_numColors;}
 
     /** Solve with conditional constraints. In the common underdetermined
     case (redundant contact) we will return the first solution encountered but
@@ -94,8 +138,79 @@ public:
         Vector&                             pi     // m, unknown result
         ) const override;
 
+    /** Solve with conditional constraints and a sparse A. Each iteration
+    then costs time proportional to the number of nonzeros in A rather than 
+    to the square of the number of participating constraint equations. **/
+    bool solve
+       (int                                 phase,
+        const Array_<MultiplierIndex>&      participating,
+        const SparseMatrix&                 A,
+        const Vector&                       D, 
+        const Array_<MultiplierIndex>&      expanding,
+        Vector&                             piExpand,
+        Vector&                             verrStart,
+        Vector&                             verrApplied,
+        Vector&                             pi, 
+        Array_<UncondRT>&                   unconditional,
+        Array_<UniContactRT>&               uniContact,
+        Array_<UniSpeedRT>&                 uniSpeed,
+        Array_<BoundedRT>&                  bounded,
+        Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+        Array_<StateLtdFrictionRT>&         stateLtdFriction
+        ) const override;
+
+    /** Solve with only unconditional constraints and a sparse A. **/
+    bool solveBilateral
+       (const Array_<MultiplierIndex>&      participating,
+        const SparseMatrix&                 A,
+        const Vector&                       D,
+        const Vector&                       rhs,
+        Vector&                             pi
+        ) const override;
+
 private:
-    Real m_SOR; 
+    // The dense and sparse methods above share these implementations, which
+    // are instantiated for Matrix and SparseMatrix.
+    template <class AMatrix>
+    bool solveImpl
+       (int                                 phase,
+        const Array_<MultiplierIndex>&      participating,
+        const AMatrix&                      A,
+        const Vector&                       D, 
+        const Array_<MultiplierIndex>&      expanding,
+        Vector&                             piExpand,
+        Vector&                             verrStart,
+        Vector&                             verrApplied,
+        Vector&                             pi, 
+        Array_<UncondRT>&                   unconditional,
+        Array_<UniContactRT>&               uniContact,
+        Array_<UniSpeedRT>&                 uniSpeed,
+        Array_<BoundedRT>&                  bounded,
+        Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+        Array_<StateLtdFrictionRT>&         stateLtdFriction
+        ) const;
+
+    template <class AMatrix>
+    bool solveBilateralImpl
+       (const Array_<MultiplierIndex>&      participating,
+        const AMatrix&                      A,
+        const Vector&                       D,
+        const Vector&                       rhs,
+        Vector&                             pi
+        ) const;
+
+    // Color the non-observing unilateral contacts so that no two of the 
+    // same color are coupled through A. Returns the contacts of each color
+    // in increasing order.
+    void colorContacts(const SparseMatrix&           A,
+                       const Array_<UniContactRT>&   uniContact,
+                       Array_<Array_<int> >&         colors) const;
+
+    Real                                m_SOR; 
+    SweepMode                           m_sweepMode;
+    // These are updated by the const solve() methods.
+    mutable ClonePtr<ParallelExecutor>  m_executor;
+    mutable int                         m_numColors;
 };
 
 } // namespace SimTK
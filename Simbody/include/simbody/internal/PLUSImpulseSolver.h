@@ -41,6 +41,9 @@ public:
         m_cosMaxSlidingDirChange(std::cos(Pi/6)) // 30 degrees
     {}
 
+    PLUSImpulseSolver* clone() const override 
+    {   return new PLUSImpulseSolver(*this); }
+
     /** Solve with conditional constraints. **/
     bool solve
        (int                                 phase,
@@ -69,9 +72,69 @@ public:
         Vector&                             pi     // m, unknown result
         ) const override;
 
+    /** Solve with conditional constraints and a sparse A. The Newton 
+    Jacobian is still dense in the active constraint equations, but A itself
+    is never formed densely. **/
+    bool solve
+       (int                                 phase,
+        const Array_<MultiplierIndex>&      participating,
+        const SparseMatrix&                 A,
+        const Vector&                       D,
+        const Array_<MultiplierIndex>&      expanding,
+        Vector&                             piExpand,
+        Vector&                             verrStart,
+        Vector&                             verrApplied,
+        Vector&                             pi,  
+        Array_<UncondRT>&                   unconditional,
+        Array_<UniContactRT>&               uniContact,
+        Array_<UniSpeedRT>&                 uniSpeed,
+        Array_<BoundedRT>&                  bounded,
+        Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+        Array_<StateLtdFrictionRT>&         stateLtdFriction
+        ) const override;
+
+    /** Solve with only unconditional constraints and a sparse A. **/
+    bool solveBilateral
+       (const Array_<MultiplierIndex>&      participating,
+        const SparseMatrix&                 A,
+        const Vector&                       D,
+        const Vector&                       rhs,
+        Vector&                             pi
+        ) const override;
+
     SimTK_DEFINE_UNIQUE_LOCAL_INDEX_TYPE(PLUSImpulseSolver, ActiveIndex);
 
 private:
+    // The dense and sparse methods above share these implementations, which
+    // are instantiated for Matrix and SparseMatrix. So are the private 
+    // methods below that take A.
+    template <class AMatrix>
+    bool solveImpl
+       (int                                 phase,
+        const Array_<MultiplierIndex>&      participating,
+        const AMatrix&                      A,
+        const Vector&                       D,
+        const Array_<MultiplierIndex>&      expanding,
+        Vector&                             piExpand,
+        Vector&                             verrStart,
+        Vector&                             verrApplied,
+        Vector&                             pi,  
+        Array_<UncondRT>&                   unconditional,
+        Array_<UniContactRT>&               uniContact,
+        Array_<UniSpeedRT>&                 uniSpeed,
+        Array_<BoundedRT>&                  bounded,
+        Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+        Array_<StateLtdFrictionRT>&         stateLtdFriction
+        ) const;
+
+    template <class AMatrix>
+    bool solveBilateralImpl
+       (const Array_<MultiplierIndex>&      participating,
+        const AMatrix&                      A,
+        const Vector&                       D,
+        const Vector&                       rhs,
+        Vector&                             pi
+        ) const;
 
     // Given point P and line segment AB, find the point closest to P that lies
     // on AB, which we call Q. Returns stepLength, the ratio AQ:AB. In our case,
@@ -100,16 +163,20 @@ private:
     // Copy the active rows and columns of A into the Jacobian. These will
     // be the right values for the linear equations, but rows for nonlinear
     // equations (sliding, impending) will get overwritten. Initialize piActive 
-    // from pi.
-    void initializeNewton(const Matrix&               A,
+    // from pi. Active normals get a small separating impulse as their guess
+    // unless keepNormalGuess is set and they already have a nonzero one.
+    template <class AMatrix>
+    void initializeNewton(const AMatrix&              A,
                           const Vector&               piGuess,
                           const Vector&               verrApplied,
-                          const Array_<UniContactRT>& bounded) const;
+                          const Array_<UniContactRT>& bounded,
+                          bool                        keepNormalGuess) const;
 
     // Given a new piActive, update the impending slip directions and calculate
     // the new err(piActive).
+    template <class AMatrix>
     void updateDirectionsAndCalcCurrentError
-       (const Matrix& A, Array_<UniContactRT>& uniContact,
+       (const AMatrix& A, Array_<UniContactRT>& uniContact,
         const Vector& piELeft, const Vector& verrAppliedLeft,
         const Vector& piActive, 
         Vector& errActive) const;
@@ -117,7 +184,8 @@ private:
     // Replace rows of Jacobian for constraints corresponding to sliding or
     // impending slip frictional elements. This is the partial derivative of the
     // constraint error w.r.t. pi. Also set rhs m_verrActive.
-    void updateJacobianForSliding(const Matrix&               A,
+    template <class AMatrix>
+    void updateJacobianForSliding(const AMatrix&              A,
                                   const Array_<UniContactRT>& uniContact,
                                   const Vector& piELeft, 
                                   const Vector& verrAppliedLeft) const;
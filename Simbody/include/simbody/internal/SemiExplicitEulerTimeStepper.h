@@ -151,6 +151,101 @@ public:
     ImpulseSolverType getImpulseSolverType() const 
     {   return m_solverType; }
 
+    /** Set whether to split each step's constraint equations into islands
+    before solving them. Two constraint equations are in the same island if 
+    they are coupled through the mass matrix, that is, if they act on bodies 
+    that are connected by joints or by a chain of other proximal constraints.
+    Each island is then solved as its own small problem, using its own copy 
+    of the ImpulseSolver, and islands may be solved concurrently. This can 
+    be much faster when there are many independent groups of contacting
+    bodies. The result for each island does not depend on the others, nor on
+    the number of threads used. If the ImpulseSolver can't be copied the 
+    islands are still solved separately, but one after another. The default
+    is to use islands. **/
+    void setUseIslands(bool useIslands) {m_useIslands = useIslands;}
+    /** Return whether constraint equations are split into islands. 
+    @see setUseIslands() **/
+    bool getUseIslands() const {return m_useIslands;}
+    /** Return the number of islands the constraint equations were split into
+    on the last step, or zero if islands weren't used. **/
+    int getNumIslands() const {return (int)m_islands.size();}
+
+    /** Set whether the constraint compliance matrix A=G M\ ~G is built 
+    and handed to the ImpulseSolver as a sparse matrix. Entry A(i,j) can be 
+    nonzero only when constraint equations i and j act on bodies that are
+    connected by joints, so for many loosely-connected bodies A is mostly 
+    zero. The sparse matrix is built directly from the sparse rows of G 
+    without ever forming A densely, and its memory use and the cost of each 
+    PGS iteration are proportional to its nonzeros rather than to the square
+    of the number of constraint equations. Results agree with the dense
+    matrix to roundoff. The default is to use the sparse matrix. **/
+    void setUseSparseMatrix(bool useSparse) {m_useSparseMatrix = useSparse;}
+    /** Return whether the constraint compliance matrix is kept sparse.
+    @see setUseSparseMatrix() **/
+    bool getUseSparseMatrix() const {return m_useSparseMatrix;}
+
+    /** Set whether each step's impulse solve starts from the contact forces
+    found on the previous step. Contacts that were proximal on the last step
+    start with that step's normal and friction impulses, scaled for the new
+    step size; new contacts start from zero. For resting and sliding contacts
+    that change little from step to step this can greatly reduce the work 
+    done by the ImpulseSolver, whose statistics are available from 
+    getImpulseSolver(). The converged result is the same to within the 
+    solver's tolerance. This takes effect at the next initialize(). The
+    default is to use warm starting. **/
+    void setUseWarmStart(bool useWarmStart) {m_useWarmStart = useWarmStart;}
+    /** Return whether impulse solves are warm started.
+    @see setUseWarmStart() **/
+    bool getUseWarmStart() const {return m_useWarmStart;}
+
+    /** Set whether bodies that have come to rest are put to sleep. Bodies 
+    sleep a tree at a time, where each child of Ground and its descendents
+    form a tree, and trees that touched through a unilateral contact on the
+    last step sleep together as a group. A group falls asleep once every 
+    body in it has been slower than the sleep speed thresholds for the sleep
+    dwell time. Sleeping bodies are locked where they are, with zero 
+    velocity (see MobilizedBody::lock()), and their contacts with each other
+    and with Ground are neither tracked nor solved. A whole group is woken 
+    when one of its contacts with an awake body becomes proximal, or when 
+    the applied forces on one of its bodies change by more than the minimum
+    significant force. Trees with a locked body or a Motion never sleep, 
+    and nothing sleeps if any unilateral contact can't say which bodies it
+    touches (see UnilateralContact::getConstrainedBodies()). This takes 
+    effect at the next initialize(). The default is not to sleep. **/
+    void setUseSleeping(bool useSleeping) {m_useSleeping = useSleeping;}
+    /** Return whether resting bodies are put to sleep. 
+    @see setUseSleeping() **/
+    bool getUseSleeping() const {return m_useSleeping;}
+    /** Set the linear speed of a body's origin and its angular speed below 
+    which the body is considered to be resting. The defaults are 0.01 and 
+    0.05 (length/time and radians/time). @see setUseSleeping() **/
+    void setSleepSpeedThresholds(Real linearSpeed, Real angularSpeed);
+    /** @see setSleepSpeedThresholds() **/
+    Real getSleepLinearSpeedThreshold() const {return m_sleepLinearSpeed;}
+    /** @see setSleepSpeedThresholds() **/
+    Real getSleepAngularSpeedThreshold() const {return m_sleepAngularSpeed;}
+    /** Set how long all the bodies of a group must have been resting before
+    the group is put to sleep. The default is 0.5 time units.
+    @see setUseSleeping() **/
+    void setSleepDwellTime(Real dwellTime);
+    /** @see setSleepDwellTime() **/
+    Real getSleepDwellTime() const {return m_sleepDwellTime;}
+    /** Return the number of mobilized bodies that are asleep now. **/
+    int getNumSleepingBodies() const;
+    /** Return true if the given mobilized body is asleep now. Ground is never
+    asleep. **/
+    bool isSleeping(MobilizedBodyIndex mbx) const;
+
+    /** Set the number of threads that may be used to solve islands
+    concurrently. By default this is the number of processors (including
+    hyperthreads) on the machine; set it to 1 to do all the work on the 
+    calling thread. Threads are used only when there are enough constraint
+    equations to be worth the overhead. @see setUseIslands() **/
+    void setNumberOfThreads(unsigned numThreads);
+    /** Return the maximum number of threads that may be used to solve 
+    islands. **/
+    int getNumberOfThreads() const;
+
     /** Set the impact capture velocity to be used by default when a contact
     does not provide its own. This is the impact velocity below which the
     coefficient of restitution is to be treated as zero. This avoids a Zeno's
@@ -272,6 +367,7 @@ public:
     }
     /** (Advanced) Delete the existing ImpulseSolver if any. **/
     void clearImpulseSolver() {
+        clearIslandSolvers();
         delete m_solver; m_solver=0;
     }
 
@@ -387,6 +483,55 @@ private:
                                    Vector&      pverr, // in/out
                                    Vector&      positionImpulse);
 
+    // Calculate m_sparseGMInvGt, the sparse equivalent of calcProjectedMInv().
+    void calcSparseProjectedMInv(const State& s);
+
+    // Partition the m multipliers into islands that are not coupled through
+    // A=G M\ ~G nor through a shared unilateral contact. A is either 
+    // m_GMInvGt or m_sparseGMInvGt.
+    template <class AMatrix>
+    void findIslands(const AMatrix& A);
+    // Make sure there is a copy of the ImpulseSolver for each island; 
+    // returns false if the solver can't be copied.
+    bool allocateIslandSolvers();
+    void clearIslandSolvers();
+    void collectIslandSolverStats();
+
+    // Warm starting: fill in the compression phase's initial guess from the
+    // previous step's unilateral contact forces, and save this step's.
+    void guessCompressionImpulse(Real h, Vector& impulse) const;
+    void saveUniContactForces(const Vector& lambda);
+
+    // Sleeping: find the trees and the trees each unilateral contact 
+    // touches, then at the start of each step wake the sleeping groups that
+    // need it and put resting groups to sleep.
+    void initializeSleeping();
+    void updateSleeping(State& s);
+    void putToSleep(State& s, int group, const Array_<int>& trees);
+    void wakeUp(State& s, const Array_<int>& groups);
+    bool isTreeAsleep(int tree) const {return m_treeSleepGroup[tree] >= 0;}
+    bool isContactAsleep(UnilateralContactIndex ux) const;
+
+    // These have the same meaning as ImpulseSolver::solve() and 
+    // solveBilateral() with A=m_GMInvGt (or m_sparseGMInvGt) and D=m_D, but 
+    // solve each island separately if there is more than one.
+    bool solveImpulses
+       (int                                             phase,
+        const Array_<MultiplierIndex>&                  participating,
+        const Array_<MultiplierIndex>&                  expanding,
+        Vector&                                         piExpand,
+        Vector&                                         verrStart,
+        Vector&                                         verrApplied,
+        Vector&                                         pi,
+        Array_<ImpulseSolver::UncondRT>&                unconditional,
+        Array_<ImpulseSolver::UniContactRT>&            uniContact,
+        Array_<ImpulseSolver::UniSpeedRT>&              uniSpeed,
+        Array_<ImpulseSolver::BoundedRT>&               bounded,
+        Array_<ImpulseSolver::ConstraintLtdFrictionRT>& consLtdFriction,
+        Array_<ImpulseSolver::StateLtdFrictionRT>&      stateLtdFriction);
+    bool solveBilateralImpulses(const Array_<MultiplierIndex>& participating,
+                                const Vector& rhs, Vector& pi);
+
 
 private:
     const MultibodySystem&      m_mbs;
@@ -405,13 +550,39 @@ private:
     Real                        m_minSignificantForce;
 
     ImpulseSolver*              m_solver;
+    bool                        m_useIslands;
+    bool                        m_useSparseMatrix;
+    bool                        m_useWarmStart;
+    ClonePtr<ParallelExecutor>  m_executor;
+    bool                        m_useSleeping;
+    Real                        m_sleepLinearSpeed;
+    Real                        m_sleepAngularSpeed;
+    Real                        m_sleepDwellTime;
 
     // Persistent runtime data.
     State                       m_state;
     Vector                      m_emptyVector; // don't change this!
+    // Normal and friction force (multipliers) from the last step for each
+    // unilateral contact; NaN if it wasn't proximal then.
+    Array_<Vec3,UnilateralContactIndex> m_prevUniContactForce;
+
+    // Sleeping (see setUseSleeping()). Trees are numbered in order of their
+    // lowest body; Ground is in tree -1. A sleeping group is known by its 
+    // lowest tree. The applied forces on each sleeping body are those at 
+    // the start of the step after it fell asleep; NaN until then.
+    bool                                        m_canSleep;
+    Array_<int,MobilizedBodyIndex>              m_treeOf;
+    Array_<Array_<MobilizedBodyIndex> >         m_treeBodies;
+    Array_<bool>                                m_treeCanSleep;
+    Array_<Real>                                m_treeRestingSince; // or NaN
+    Array_<int>                                 m_treeSleepGroup; // or -1
+    Array_<Array_<int>,UnilateralContactIndex>  m_uniContactTrees;
+    Array_<SpatialVec,MobilizedBodyIndex>       m_sleepBodyForces;
+    Vector                                      m_sleepMobilityForces;
 
     // Step temporaries.
     Matrix                      m_GMInvGt; // G M\ ~G
+    ImpulseSolver::SparseMatrix m_sparseGMInvGt; // same, if sparse
     Vector                      m_D; // soft diagonal
     Vector                      m_deltaU;
     Vector                      m_verr;
@@ -419,6 +590,14 @@ private:
     Vector                      m_impulse;
     Vector                      m_genImpulse; // ~G*impulse
 
+    // Islands for this step, each a list of multipliers in increasing order,
+    // with the island and position within it of every multiplier. There is 
+    // a copy of the ImpulseSolver for each island.
+    Array_<Array_<MultiplierIndex> >                m_islands;
+    Array_<int,MultiplierIndex>                     m_islandOf;
+    Array_<int,MultiplierIndex>                     m_islandPos;
+    Array_<ImpulseSolver*>                          m_islandSolvers;
+
     Array_<UnilateralContactIndex>      m_proximalUniContacts, 
                                         m_distalUniContacts;
     Array_<StateLimitedFrictionIndex>   m_proximalStateLtdFriction,
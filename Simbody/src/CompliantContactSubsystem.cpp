@@ -36,6 +36,8 @@ patch analysis methods.
 #include "simbody/internal/SimbodyMatterSubsystem.h"
 #include "simbody/internal/MultibodySystem.h"
 
+#include "ContactParallelLoop.h"
+
 namespace SimTK {
 
 //==============================================================================
@@ -50,7 +52,8 @@ CompliantContactSubsystemImpl(const ContactTrackerSubsystem& tracker)
 :   ForceSubsystemRep("CompliantContactSubsystem", "0.0.1"),
     m_tracker(tracker), m_transitionVelocity(Real(0.01)), 
     m_ooTransitionVelocity(1/m_transitionVelocity), 
-    m_trackDissipatedEnergy(false), m_defaultGenerator(0) 
+    m_trackDissipatedEnergy(false), m_defaultGenerator(0),
+    m_executor(new ParallelExecutor())
 {   
 }
 
@@ -67,6 +70,13 @@ void setTrackDissipatedEnergy(bool shouldTrack) {
 }
 bool getTrackDissipatedEnergy() const {return m_trackDissipatedEnergy;}
 
+void setNumberOfThreads(unsigned numThreads) {
+    SimTK_APIARGCHECK_ALWAYS(numThreads > 0, "CompliantContactSubsystem",
+        "setNumberOfThreads", "Number of threads must be positive.");
+    m_executor = new ParallelExecutor(numThreads);
+}
+int getNumberOfThreads() const {return m_executor->getMaxThreads();}
+
 int getNumContactForces(const State& s) const {
     ensureForceCacheValid(s);
     const Array_<ContactForce>& forces = getForceCache(s);
@@ -356,6 +366,23 @@ void markForceCacheValid(const State& s) const
 
 void ensurePotentialEnergyCacheValid(const State&) const;
 void ensureForceCacheValid(const State&) const;
+void calcContactForce(const State&, const Contact&, ContactForce&) const;
+
+// Adapts calcContactForce() for runContactLoop().
+class CalcContactForces {
+public:
+    CalcContactForces(const CompliantContactSubsystemImpl& impl,
+                      const State& state, const ContactSnapshot& active,
+                      Array_<ContactForce>& forces)
+    :   impl(impl), state(state), active(active), forces(forces) {}
+    void operator()(int i) 
+    {   impl.calcContactForce(state, active.getContact(i), forces[i]); }
+private:
+    const CompliantContactSubsystemImpl&    impl;
+    const State&                            state;
+    const ContactSnapshot&                  active;
+    Array_<ContactForce>&                   forces;
+};
 
 
 
@@ -383,6 +410,9 @@ GeneratorMap                        m_generators;
 // this will either do nothing silently or throw an error.
 ContactForceGenerator*              m_defaultGenerator;
 
+// Spreads force generation over threads; threads are created on first use.
+mutable ClonePtr<ParallelExecutor>  m_executor;
+
     // TOPOLOGY "CACHE"
 
 // These must be set during realizeTopology and treated as const thereafter.
@@ -432,6 +462,48 @@ ensurePotentialEnergyCacheValid(const State& state) const {
 }
 
 
+// Calculate the force for one active contact, measured and expressed in
+// Ground, leaving it invalid if the contact isn't producing a force. This may
+// be called from several threads at once so it must not modify anything 
+// other than the supplied ContactForce.
+void CompliantContactSubsystemImpl::
+calcContactForce(const State& state, const Contact& contact, 
+                 ContactForce& force) const {
+    if (contact.getCondition() == Contact::Broken) {
+        // No need to generate forces; this will be gone next time.
+        return;
+    }
+    const ContactSurfaceIndex surf1(contact.getSurface1());
+    const ContactSurfaceIndex surf2(contact.getSurface2());
+    const MobilizedBody& mobod1 = m_tracker.getMobilizedBody(surf1);
+    const MobilizedBody& mobod2 = m_tracker.getMobilizedBody(surf2);
+
+    // TODO: These two are expensive (63 flops each) and shouldn't have 
+    // to be recalculated here since we must have used them in creating
+    // the Contact and X_S1S2.
+    const Transform X_GS1 = mobod1.findFrameTransformInGround
+        (state, m_tracker.getContactSurfaceTransform(surf1));
+    const Transform X_GS2 = mobod2.findFrameTransformInGround
+        (state, m_tracker.getContactSurfaceTransform(surf2));
+
+    const SpatialVec V_GS1 = mobod1.findFrameVelocityInGround
+        (state, m_tracker.getContactSurfaceTransform(surf1));
+    const SpatialVec V_GS2 = mobod2.findFrameVelocityInGround
+        (state, m_tracker.getContactSurfaceTransform(surf2));
+
+    // Calculate the relative velocity of S2 in S1, expressed in S1.
+    const SpatialVec V_S1S2 =
+        findRelativeVelocity(X_GS1, V_GS1, X_GS2, V_GS2);   // 51 flops
+
+    const ContactForceGenerator& generator = 
+        getForceGenerator(contact.getTypeId());
+    // Calculate the contact force measured and expressed in S1.
+    generator.calcContactForce(state, contact, V_S1S2, force);
+    // Re-express the contact force in Ground for later use.
+    if (force.isValid())
+        force.changeFrameInPlace(X_GS1); // switch to Ground
+}
+
 void CompliantContactSubsystemImpl::
 ensureForceCacheValid(const State& state) const {
     if (isForceCacheValid(state)) return;
@@ -439,52 +511,28 @@ ensureForceCacheValid(const State& state) const {
     SimTK_STAGECHECK_GE_ALWAYS(getStage(state), Stage::Velocity,
         "CompliantContactSubystemImpl::ensureForceCacheValid()");
 
-    Array_<ContactForce>& forces = updForceCache(state);
-    forces.clear();
-
-
     const ContactSnapshot& active = m_tracker.getActiveContacts(state);
     const int nContacts = active.getNumContacts();
-    for (int i=0; i<nContacts; ++i) {
-        const Contact& contact = active.getContact(i);
-        if (contact.getCondition() == Contact::Broken) {
-            // No need to generate forces; this will be gone next time.
-            continue;
-        }
-        const Transform& X_S1S2 = contact.getTransform();
-        const ContactSurfaceIndex surf1(contact.getSurface1());
-        const ContactSurfaceIndex surf2(contact.getSurface2());
-        const MobilizedBody& mobod1 = m_tracker.getMobilizedBody(surf1);
-        const MobilizedBody& mobod2 = m_tracker.getMobilizedBody(surf2);
-
-        // TODO: These two are expensive (63 flops each) and shouldn't have 
-        // to be recalculated here since we must have used them in creating
-        // the Contact and X_S1S2.
-        const Transform X_GS1 = mobod1.findFrameTransformInGround
-            (state, m_tracker.getContactSurfaceTransform(surf1));
-        const Transform X_GS2 = mobod2.findFrameTransformInGround
-            (state, m_tracker.getContactSurfaceTransform(surf2));
-
-        const SpatialVec V_GS1 = mobod1.findFrameVelocityInGround
-            (state, m_tracker.getContactSurfaceTransform(surf1));
-        const SpatialVec V_GS2 = mobod2.findFrameVelocityInGround
-            (state, m_tracker.getContactSurfaceTransform(surf2));
-
-        // Calculate the relative velocity of S2 in S1, expressed in S1.
-        const SpatialVec V_S1S2 =
-            findRelativeVelocity(X_GS1, V_GS1, X_GS2, V_GS2);   // 51 flops
+    int nMeshContacts = 0;
+    for (int i=0; i < nContacts; ++i)
+        if (active.getContact(i).getTypeId() 
+            == TriangleMeshContact::classTypeId())
+            ++nMeshContacts;
+
+    // Each contact's force goes in its own slot, possibly calculated on
+    // another thread. Then we keep the valid ones in Contact order so that
+    // the result doesn't depend on the number of threads.
+    Array_<ContactForce> slots(nContacts);
+    CalcContactForces calc(*this, state, active, slots);
+    runContactLoop(*m_executor, nContacts,
+                   nContacts >= MinContactsForThreads || nMeshContacts >= 2,
+                   calc);
 
-        const ContactForceGenerator& generator = 
-            getForceGenerator(contact.getTypeId());
-        forces.push_back(); // allocate a new garbage ContactForce
-        // Calculate the contact force measured and expressed in S1.
-        generator.calcContactForce(state, contact, V_S1S2, forces.back());
-        // Re-express the contact force in Ground for later use.
-        if (forces.back().isValid())
-            forces.back().changeFrameInPlace(X_GS1); // switch to Ground
-        else
-            forces.pop_back(); // never mind ...
-    }
+    Array_<ContactForce>& forces = updForceCache(state);
+    forces.clear();
+    for (int i=0; i < nContacts; ++i)
+        if (slots[i].isValid())
+            forces.push_back(slots[i]);
 
     markForceCacheValid(state);
 }
@@ -544,6 +592,10 @@ void CompliantContactSubsystem::setTrackDissipatedEnergy(bool shouldTrack)
 {   updImpl().setTrackDissipatedEnergy(shouldTrack); }
 bool CompliantContactSubsystem::getTrackDissipatedEnergy() const
 {   return getImpl().getTrackDissipatedEnergy(); }
+void CompliantContactSubsystem::setNumberOfThreads(unsigned numThreads)
+{   updImpl().setNumberOfThreads(numThreads); }
+int CompliantContactSubsystem::getNumberOfThreads() const
+{   return getImpl().getNumberOfThreads(); }
 
 int CompliantContactSubsystem::getNumContactForces(const State& s) const
 {   return getImpl().getNumContactForces(s); }
@@ -1619,7 +1671,7 @@ void ContactForceGenerator::ElasticFoundation::calcContactForceAndDetails
         const ContactGeometry::TriangleMesh& mesh1 = 
             ContactGeometry::TriangleMesh::getAs(shape1);
 
-        calcWeightedPatchCentroid(mesh1, contact.getSurface1Faces(),
+        calcWeightedPatchCentroid(mesh1, contact.getSurface1FaceList(),
                                   weightedPatchCentroid1_S1, patchArea1);
     }
     if (shape2.getTypeId() == ContactGeometry::TriangleMesh::classTypeId()) {
@@ -1627,7 +1679,7 @@ void ContactForceGenerator::ElasticFoundation::calcContactForceAndDetails
             ContactGeometry::TriangleMesh::getAs(shape2);
         Vec3 weightedPatchCentroid2_S2;
 
-        calcWeightedPatchCentroid(mesh2, contact.getSurface2Faces(),
+        calcWeightedPatchCentroid(mesh2, contact.getSurface2FaceList(),
                                   weightedPatchCentroid2_S2, patchArea2);
         // Remeasure patch2's weighted centroid from surface1's frame;
         // be sure to weight the new offset also.
@@ -1695,7 +1747,7 @@ void ContactForceGenerator::ElasticFoundation::calcContactForceAndDetails
             ContactGeometry::TriangleMesh::getAs(shape1);
 
         processOneMesh(state, 
-            mesh, contact.getSurface1Faces(),
+            mesh, contact.getSurface1FaceList(),
             X_S1S2, V_S1S2, shape2,
             s1, areaScale1,
             kh, c, us, ud, uv,
@@ -1725,7 +1777,7 @@ void ContactForceGenerator::ElasticFoundation::calcContactForceAndDetails
             wantDetails ? contactDetails_S1->size() : 0;
 
         processOneMesh(state, 
-            mesh, contact.getSurface2Faces(),
+            mesh, contact.getSurface2FaceList(),
             X_S2S1, V_S2S1, shape1,
             s2, areaScale2,
             kh, c, us, ud, uv,
@@ -1790,14 +1842,13 @@ void ContactForceGenerator::ElasticFoundation::calcContactForceAndDetails
 void ContactForceGenerator::ElasticFoundation::
 calcWeightedPatchCentroid
    (const ContactGeometry::TriangleMesh&    mesh,
-    const std::set<int>&                    insideFaces,
+    const Array_<int>&                      insideFaces,
     Vec3&                                   weightedPatchCentroid,
     Real&                                   patchArea) const
 {
     weightedPatchCentroid = Vec3(0); patchArea = 0;
-    for (std::set<int>::const_iterator iter = insideFaces.begin(); 
-                                       iter != insideFaces.end(); ++iter)
-    {   const int  face = *iter;
+    for (unsigned i=0; i < insideFaces.size(); ++i)
+    {   const int  face = insideFaces[i];
         const Real area = mesh.getFaceArea(face);
         weightedPatchCentroid   += area*mesh.findCentroid(face); 
         patchArea               += area; 
@@ -1824,7 +1875,7 @@ void ContactForceGenerator::ElasticFoundation::
 processOneMesh
    (const State&                            state,
     const ContactGeometry::TriangleMesh&    mesh,
-    const std::set<int>&                    insideFaces,
+    const Array_<int>&                      insideFaces,
     const Transform&                        X_MO, 
     const SpatialVec&                       V_MO,
     const ContactGeometry&                  other,
@@ -1861,19 +1912,32 @@ processOneMesh
     const Real vtrans   = subsys.getTransitionVelocity();
     const Real ooVtrans = subsys.getOOTransitionVelocity(); // 1/vtrans
 
+    // Non-null if the other surface is a mesh; it may have a distance field.
+    const ContactGeometry::TriangleMesh* otherMesh = 
+        ContactGeometry::TriangleMesh::isInstance(other) 
+        ? &ContactGeometry::TriangleMesh::getAs(other) : 0;
+
     // Now loop over all the faces again, evaluate the force from each 
     // spring, and apply it at the patch centroid.
     // This costs roughly 300 flops per contacting face.
-    for (std::set<int>::const_iterator iter = insideFaces.begin(); 
-                                       iter != insideFaces.end(); ++iter) 
-    {   const int   face        = *iter;
+    for (unsigned i=0; i < insideFaces.size(); ++i) 
+    {   const int   face        = insideFaces[i];
         const Vec3  springPos_M = mesh.findCentroid(face);
         const Real  faceArea    = areaScaleFactor*mesh.getFaceArea(face);
 
+        // A mesh with a distance field can rule out most springs that are
+        // outside the other surface without searching for the nearest point.
+        const Vec3  springPos_O = ~X_MO*springPos_M; // 18 flops
+        Real        estimate, maxError;
+        if (   otherMesh && otherMesh->estimateSignedDistance
+                                            (springPos_O, estimate, maxError)
+            && estimate > maxError)
+            continue;
+
         bool        inside;
         UnitVec3    normal_O; // not used
-        const Vec3  nearestPoint_O = // 18 flops + cost of findNearestPoint
-            other.findNearestPoint(~X_MO*springPos_M, inside, normal_O);
+        const Vec3  nearestPoint_O = // cost of findNearestPoint
+            other.findNearestPoint(springPos_O, inside, normal_O);
         if (!inside)
             continue;
         
@@ -30,6 +30,22 @@
 
 namespace SimTK {
 
+//==============================================================================
+//                            UNILATERAL CONTACT
+//==============================================================================
+void UnilateralContact::
+appendConstrainedBodies(const Constraint&           constraint,
+                        Array_<MobilizedBodyIndex>& bodies) {
+    const int nb = constraint.getNumConstrainedBodies();
+    for (ConstrainedBodyIndex cbx(0); cbx < nb; ++cbx)
+        bodies.push_back(constraint.getMobilizedBodyFromConstrainedBody(cbx)
+                         .getMobilizedBodyIndex());
+    const int nm = constraint.getNumConstrainedMobilizers();
+    for (ConstrainedMobilizerIndex cmx(0); cmx < nm; ++cmx)
+        bodies.push_back(constraint.getMobilizedBodyFromConstrainedMobilizer
+                         (cmx).getMobilizedBodyIndex());
+}
+
 //==============================================================================
 //                           HARD STOP UPPER / LOWER
 //==============================================================================
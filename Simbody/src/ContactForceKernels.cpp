@@ -0,0 +1,198 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+#include "simbody/internal/common.h"
+#include "simbody/internal/MobilizedBody.h"
+
+#include "ContactForceKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+// SSE2 is always available on x86-64; on 32 bit x86 it depends on the
+// instruction set chosen at build time (see BUILD_INST_SET in CMake). The
+// SSE2 kernels work two doubles at a time so aren't used for float builds.
+#if (defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && SimTK_DEFAULT_PRECISION == 2
+    #define SimTK_CONTACT_FORCE_KERNELS_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+using namespace SimTK;
+
+namespace {
+
+// Pointers to the batch arrays, so the kernels can work on raw lanes.
+struct Lanes {
+    explicit Lanes(ContactForceBatch& batch) 
+    :   k(batch.stiffness.cdata()), d(batch.depth.cdata()), 
+        c(batch.dissipation.cdata()), vn(batch.vnormal.cdata()), 
+        vs(batch.vslip.cdata()), us(batch.staticFriction.cdata()), 
+        ud(batch.dynamicFriction.cdata()), uv(batch.viscousFriction.cdata()) 
+    {   batch.normalForce.resize(batch.size());
+        batch.frictionForce.resize(batch.size());
+        fn = batch.normalForce.data(); ff = batch.frictionForce.data(); }
+
+    const Real *k, *d, *c, *vn, *vs, *us, *ud, *uv;
+    Real *fn, *ff;
+};
+
+//==============================================================================
+//                          PORTABLE IMPLEMENTATIONS
+//==============================================================================
+// One lane at a time. There are no branches: a negative normal force (the 
+// surfaces separating faster than the dissipation allows) is clamped to zero,
+// which makes the friction force zero, and lanes that aren't slipping are
+// masked out of the friction force. The mask is needed because the slip 
+// speed is divided by the transition velocity, which may be zero.
+
+// Returns the lane's potential energy. Depth is clamped at zero before 
+// taking the square root for the Hertz law.
+inline Real calcLanePortable(const Lanes& x, int i, bool hertz, Real invVt) {
+    const Real d = hertz ? std::max(x.d[i], Real(0)) : x.d[i];
+    const Real kd = hertz ? x.k[i]*d*std::sqrt(d) : x.k[i]*d;
+    const Real f = std::max(kd*(1 + x.c[i]*x.vn[i]), Real(0));
+    const Real vrel = x.vs[i]*invVt;
+    x.fn[i] = f;
+    const Real ff = f*(std::min(vrel, Real(1))
+                       *(x.ud[i] + 2*(x.us[i]-x.ud[i])/(1+vrel*vrel))
+                       + x.uv[i]*x.vs[i]);
+    x.ff[i] = x.vs[i] > 0 ? ff : Real(0);
+    return (hertz ? Real(0.4) : Real(0.5))*kd*d;
+}
+
+Real calcForcesPortable(const Lanes& x, int begin, int end, bool hertz,
+                        Real invVt) {
+    Real pe = 0;
+    for (int i=begin; i < end; ++i)
+        pe += calcLanePortable(x, i, hertz, invVt);
+    return pe;
+}
+
+#ifdef SimTK_CONTACT_FORCE_KERNELS_USE_SSE2
+//==============================================================================
+//                           SSE2 IMPLEMENTATIONS
+//==============================================================================
+// Two lanes per register, following the portable code operation for 
+// operation. Unaligned loads are used since the arrays only have malloc
+// alignment.
+
+inline double hsum(__m128d a) {
+    return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+}
+
+double calcForcesSSE2(const Lanes& x, int n, bool hertz, double invVt) {
+    const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1), 
+                  two = _mm_set1_pd(2), vtInv = _mm_set1_pd(invVt),
+                  peScale = _mm_set1_pd(hertz ? 0.4 : 0.5);
+    __m128d pe = zero;
+    int i=0;
+    for (; i+2 <= n; i += 2) {
+        __m128d d = _mm_loadu_pd(x.d+i);
+        __m128d kd;
+        if (hertz) {
+            d = _mm_max_pd(d, zero);
+            kd = _mm_mul_pd(_mm_mul_pd(_mm_loadu_pd(x.k+i), d),
+                            _mm_sqrt_pd(d));
+        } else
+            kd = _mm_mul_pd(_mm_loadu_pd(x.k+i), d);
+        const __m128d damp = _mm_add_pd(one, _mm_mul_pd(_mm_loadu_pd(x.c+i),
+                                                        _mm_loadu_pd(x.vn+i)));
+        const __m128d f = _mm_max_pd(_mm_mul_pd(kd, damp), zero);
+
+        const __m128d vs = _mm_loadu_pd(x.vs+i), ud = _mm_loadu_pd(x.ud+i);
+        const __m128d vrel = _mm_mul_pd(vs, vtInv);
+        const __m128d stribeck = _mm_div_pd
+           (_mm_mul_pd(two, _mm_sub_pd(_mm_loadu_pd(x.us+i), ud)),
+            _mm_add_pd(one, _mm_mul_pd(vrel, vrel)));
+        const __m128d mu = _mm_add_pd
+           (_mm_mul_pd(_mm_min_pd(vrel, one), _mm_add_pd(ud, stribeck)),
+            _mm_mul_pd(_mm_loadu_pd(x.uv+i), vs));
+        _mm_storeu_pd(x.fn+i, f);
+        _mm_storeu_pd(x.ff+i, _mm_and_pd(_mm_cmpgt_pd(vs, zero),
+                                         _mm_mul_pd(f, mu)));
+        pe = _mm_add_pd(pe, _mm_mul_pd(_mm_mul_pd(peScale, kd), d));
+    }
+    return hsum(pe) + calcForcesPortable(x, i, n, hertz, invVt);
+}
+#endif
+
+Real calcForces(ContactForceBatch& batch, bool hertz, 
+                Real transitionVelocity) {
+    const Lanes x(batch);
+    const Real invVt = 1/transitionVelocity;
+    #ifdef SimTK_CONTACT_FORCE_KERNELS_USE_SSE2
+    return calcForcesSSE2(x, batch.size(), hertz, invVt);
+    #else
+    return calcForcesPortable(x, 0, batch.size(), hertz, invVt);
+    #endif
+}
+
+} // anonymous namespace
+
+//==============================================================================
+//                            EXPORTED KERNELS
+//==============================================================================
+namespace SimTK {
+
+Real calcLinearContactForces(ContactForceBatch& batch, 
+                             Real transitionVelocity) {
+    return calcForces(batch, false, transitionVelocity);
+}
+
+Real calcHertzContactForces(ContactForceBatch& batch, 
+                            Real transitionVelocity) {
+    return calcForces(batch, true, transitionVelocity);
+}
+
+void applyContactForces(const ContactForceBatch& batch, const State& state,
+                        Vector_<SpatialVec>& bodyForces) {
+    for (int g=0; g < (int)batch.groups.size(); ++g) {
+        const ContactForceBatch::Group& group = batch.groups[g];
+        const int end = g+1 < (int)batch.groups.size() 
+                        ? batch.groups[g+1].begin : batch.size();
+        if (group.begin == end)
+            continue;
+
+        // Sum the forces and their moments about body2's origin, then shift
+        // the moment to body1's origin.
+        const Vec3& p1 = group.body1->getBodyOriginLocation(state);
+        const Vec3& p2 = group.body2->getBodyOriginLocation(state);
+        Vec3 force(0), moment2(0);
+        for (int i=group.begin; i < end; ++i) {
+            const Vec3 f = batch.normalForce[i]*batch.normal[i]
+                         + batch.frictionForce[i]*batch.slipDir[i];
+            force += f;
+            moment2 += (batch.point[i] - p2) % f;
+        }
+        const Vec3 moment1 = moment2 + (p2 - p1) % force;
+        bodyForces[group.body1->getMobilizedBodyIndex()] -= 
+            SpatialVec(moment1, force);
+        bodyForces[group.body2->getMobilizedBodyIndex()] += 
+            SpatialVec(moment2, force);
+    }
+}
+
+} // namespace SimTK
@@ -0,0 +1,131 @@
+#ifndef SimTK_SIMBODY_CONTACT_FORCE_KERNELS_H_
+#define SimTK_SIMBODY_CONTACT_FORCE_KERNELS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+namespace SimTK {
+
+class MobilizedBody;
+
+//==============================================================================
+//                           CONTACT FORCE BATCH
+//==============================================================================
+/* The contact points of a force element, gathered so that the contact force 
+law can be evaluated for all of them in one pass. Each contact point is a 
+lane in a structure of arrays; the force law kernels below read only the
+scalar inputs and write the force magnitudes, several lanes at a time where
+the instruction set allows. Points are added in groups, one per pair of 
+bodies in contact, and applyContactForces() then applies each group's forces
+to its bodies. clear() keeps the arrays' heap space so a batch that is reused
+doesn't allocate once it has grown. */
+class ContactForceBatch {
+public:
+    // The points added from begin up to the next group's begin act between
+    // these bodies; the body objects must outlive the batch's use.
+    struct Group {
+        int                  begin;
+        const MobilizedBody* body1;
+        const MobilizedBody* body2;
+    };
+
+    int size() const {return (int)stiffness.size();}
+
+    void clear() {
+        groups.clear();
+        stiffness.clear(); depth.clear(); dissipation.clear();
+        vnormal.clear(); vslip.clear();
+        staticFriction.clear(); dynamicFriction.clear(); 
+        viscousFriction.clear();
+        point.clear(); normal.clear(); slipDir.clear();
+        normalForce.clear(); frictionForce.clear();
+    }
+
+    // Start a group; the points added after this act between these bodies.
+    // If the current group is already for these bodies it is continued.
+    void addGroup(const MobilizedBody& body1, const MobilizedBody& body2) {
+        if (!groups.empty() && groups.back().body1 == &body1 
+                            && groups.back().body2 == &body2)
+            return;
+        const Group group = {size(), &body1, &body2};
+        groups.push_back(group);
+    }
+
+    // Add a contact point to the current group. On the second body the normal
+    // force acts along normal, and the friction force along slipDir, the
+    // direction in which the first body is slipping past the second; both 
+    // are unit vectors, although slipDir is ignored when vslip is zero. 
+    // vnormal is the first body's velocity relative to the second along 
+    // normal, so it is positive when the bodies are approaching.
+    void addPoint(Real stiffness_, Real depth_, Real dissipation_,
+                  Real vnormal_, Real vslip_, Real staticFriction_,
+                  Real dynamicFriction_, Real viscousFriction_,
+                  const Vec3& point_, const Vec3& normal_, 
+                  const Vec3& slipDir_) {
+        stiffness.push_back(stiffness_); depth.push_back(depth_);
+        dissipation.push_back(dissipation_);
+        vnormal.push_back(vnormal_); vslip.push_back(vslip_);
+        staticFriction.push_back(staticFriction_);
+        dynamicFriction.push_back(dynamicFriction_);
+        viscousFriction.push_back(viscousFriction_);
+        point.push_back(point_); normal.push_back(normal_);
+        slipDir.push_back(slipDir_);
+    }
+
+    Array_<Group> groups;
+    // Force law inputs.
+    Array_<Real> stiffness, depth, dissipation, vnormal, vslip;
+    Array_<Real> staticFriction, dynamicFriction, viscousFriction;
+    // Where and in what directions the forces act, in Ground.
+    Array_<Vec3> point, normal, slipDir;
+    // Force law outputs: the normal force, never negative, and the 
+    // magnitude of the friction force.
+    Array_<Real> normalForce, frictionForce;
+};
+
+/* Evaluate f = k d (1 + c v) for each point of the batch, where k is the
+stiffness, d the depth, c the dissipation and v the approach speed, along 
+with the friction force. Returns the total potential energy k d^2/2. This is
+the elastic foundation model, with stiffness including each spring's area. */
+Real calcLinearContactForces(ContactForceBatch& batch, 
+                             Real transitionVelocity);
+
+/* The same as calcLinearContactForces() but with the Hertz law 
+f = k d^(3/2) (1 + c v), and potential energy 2/5 k d^(5/2). This is the 
+Hunt-Crossley model, with stiffness including the curvature terms and c
+including the factor of 3/2. */
+Real calcHertzContactForces(ContactForceBatch& batch, 
+                            Real transitionVelocity);
+
+/* Apply the forces calculated by one of the kernels above to the bodies: in
+each group, each point's normal and friction forces act on body2, and their
+negatives on body1. A group's forces are summed first so that each of its
+bodies' entries in bodyForces is updated just once. */
+void applyContactForces(const ContactForceBatch& batch, const State& state,
+                        Vector_<SpatialVec>& bodyForces);
+
+} // namespace SimTK
+
+#endif // SimTK_SIMBODY_CONTACT_FORCE_KERNELS_H_
@@ -0,0 +1,107 @@
+#ifndef SimTK_SIMBODY_CONTACT_PARALLEL_LOOP_H_
+#define SimTK_SIMBODY_CONTACT_PARALLEL_LOOP_H_
+
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace SimTK {
+
+//==============================================================================
+//                          CONTACT PARALLEL LOOP
+//==============================================================================
+// Per-contact work in the contact subsystems (narrow phase tracking, force
+// generation) is independent from one contact to the next, so we can hand it
+// out to a ParallelExecutor's threads. To keep the results identical no
+// matter how many threads there are, body(i) must write its result only into
+// a slot reserved for item i; the caller then combines the slots serially in
+// index order. Nothing here depends on which thread ran which item.
+//
+// Below this many items the threading overhead isn't worth it unless the
+// caller knows the individual items are expensive (meshes, for example).
+static const int MinContactsForThreads = 32;
+
+namespace ContactParallelLoopHelper {
+template <class Body>
+class ChunkTask : public ParallelExecutor::Task {
+public:
+    ChunkTask(Body& body, int n, int nChunks)
+    :   body(body), n(n), nChunks(nChunks), errors(nChunks) {}
+
+    void execute(int chunk) override {
+        const int begin = (int)((long long)chunk*n/nChunks);
+        const int end   = (int)((long long)(chunk+1)*n/nChunks);
+        try {
+            for (int i=begin; i < end; ++i)
+                body(i);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    }
+
+    // Chunks are contiguous and each stops at its first failure, so the
+    // first chunk that failed holds the lowest-numbered failing item.
+    void rethrowFirstError() const {
+        for (int c=0; c < nChunks; ++c)
+            if (errors[c]) std::rethrow_exception(errors[c]);
+    }
+private:
+    Body&                           body;
+    const int                       n, nChunks;
+    Array_<std::exception_ptr>      errors;
+};
+}
+
+// Call body(i) for i=0..n-1. If useThreads is true the items are split into
+// contiguous chunks and run on the executor's threads; otherwise (or if we
+// are already running on some ParallelExecutor's worker thread, as happens
+// when a whole simulation is being run in parallel) they run here, in order.
+// If body throws, the exception from the lowest-numbered failing item is
+// rethrown on the calling thread once all the chunks are done, which is the
+// same exception a serial loop would have thrown.
+template <class Body>
+void runContactLoop(ParallelExecutor& executor, int n, bool useThreads,
+                    Body& body) {
+    const int nThreads = executor.getMaxThreads();
+    if (!useThreads || n < 2 || nThreads < 2
+        || ParallelExecutor::isWorkerThread()) {
+        for (int i=0; i < n; ++i)
+            body(i);
+        return;
+    }
+
+    // A few chunks per thread evens out the load when some items are much
+    // more expensive than others.
+    const int nChunks = std::min(n, 4*nThreads);
+    ContactParallelLoopHelper::ChunkTask<Body> task(body, n, nChunks);
+    executor.execute(task, nChunks);
+    task.rethrowFirstError();
+}
+
+} // namespace SimTK
+
+#endif // SimTK_SIMBODY_CONTACT_PARALLEL_LOOP_H_
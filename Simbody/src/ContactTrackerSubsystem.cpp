@@ -27,6 +27,10 @@
 #include "simbody/internal/SimbodyMatterSubsystem.h"
 #include "simbody/internal/ContactTrackerSubsystem.h"
 
+#include "ContactParallelLoop.h"
+#include "DynamicAABBTree.h"
+#include "IncrementalSweepAndPrune.h"
+
 #include <utility>
 using std::pair; using std::make_pair;
 #include <iostream>
@@ -67,21 +71,24 @@ static std::ostream& operator<<(std::ostream& o, const Bubble& bb) {
     return o;
 }
 
-// For spatial sorting of bubbles.
-class BubbleExtent {
-public:
-    BubbleExtent(Real start, Real end, BubbleIndex index) 
-    :   start(start), end(end), index(index) {}
-    BubbleExtent() {}
-    bool operator<(const BubbleExtent& e) const 
-    {   return start < e.start; }
-    Real        start, end; // span along chosen sort axis
-    BubbleIndex index;
+// Per-state data for the broad phase. This is kept in a cache entry so that
+// it persists from one evaluation to the next, and is copied along with the
+// State.
+//
+// For SweepAndPrune, candidates are the overlapping bubble pairs that passed
+// the static exclusion tests (same body, common clique) when they began to
+// overlap; the sweep and prune object tells us when pairs come and go.
+//
+// For DynamicTree, bubbles that have no finite bound (half spaces, for
+// example) aren't put in the tree; their proxy is -1.
+struct BroadPhaseCache {
+    IncrementalSweepAndPrune                    sweep;
+    std::set< pair<BubbleIndex,BubbleIndex> >   candidates;
+    Array_<Vec3>                                lo, hi; // temporaries
+
+    DynamicAABBTree                             tree;
+    Array_<int,BubbleIndex>                     proxy;
 };
-static std::ostream& operator<<(std::ostream& o, const BubbleExtent& bx) {
-    o << bx.index << ":(" << bx.start << "," << bx.end << ")";
-    return o;
-}
 
 typedef std::map< pair<ContactGeometryTypeId,ContactGeometryTypeId>,
                   pair<ContactTracker*,bool> > TrackerMap;
@@ -97,6 +104,15 @@ typedef std::map< pair<ContactGeometryTypeId,ContactGeometryTypeId>,
 typedef std::map<ContactSurfaceIndex,const Contact*> ContactSurfaceSet;
 typedef std::map<ContactSurfaceIndex,ContactSurfaceSet> PairMap;
 
+// One interesting pair of surfaces to be handed to a ContactTracker, with the
+// surfaces in the order that tracker requires. prev is the pair's currently
+// tracked Contact, or null if there isn't one.
+struct TrackingJob {
+    const ContactTracker*   tracker;
+    ContactSurfaceIndex     surf1, surf2;
+    const Contact*          prev;
+};
+
 std::ostream& operator<<(std::ostream& o, const ContactSurfaceSet& css) {
     ContactSurfaceSet::const_iterator p = css.begin();
     o << "{";
@@ -126,7 +142,9 @@ class ContactTrackerSubsystemImpl : public Subsystem::Guts {
 public:
 // Constructor registers a default set of Trackers to use with geometry
 // we know about. These can be overridden later.
-ContactTrackerSubsystemImpl() : m_defaultTracker(0) {
+ContactTrackerSubsystemImpl() 
+:   m_defaultTracker(0), m_broadPhase(ContactTrackerSubsystem::SweepAndPrune),
+    m_executor(new ParallelExecutor()) {
     adoptContactTracker(new ContactTracker::HalfSpaceSphere());
     adoptContactTracker(new ContactTracker::SphereSphere());
     adoptContactTracker(new ContactTracker::HalfSpaceEllipsoid());
@@ -224,6 +242,8 @@ int realizeSubsystemTopologyImpl(State& state) const override {
     wThis->m_predictedContactsIx = allocateAutoUpdateDiscreteVariable
         (state, Stage::Dynamics, new Value<ContactSnapshot>(), 
          Stage::Acceleration);  // update depends on accelerations
+    wThis->m_broadPhaseCacheIx = allocateLazyCacheEntry
+        (state, Stage::Topology, new Value<BroadPhaseCache>());
 
     const SimbodyMatterSubsystem& matter = getMatterSubsystem();
 
@@ -277,12 +297,7 @@ int realizeSubsystemVelocityImpl(const State& state) const override {
 // Adds new pairs to the existing set, if not already present.
 void addInBroadPhasePairs(const State& state, PairMap& pairs) const {
     const int numBubbles = getNumBubbles();
-    
-    // Perform a sweep-and-prune on a single axis to identify potential 
-    // contacts. First, find which axis has the most variation in body 
-    // locations. That is the axis we will use.
-    // TODO: this one-axis method is not good enough in general
-    
+
     Vector_<Vec3> centers(numBubbles);
     for (BubbleIndex bbx(0); bbx < numBubbles; ++bbx) {
         const Bubble&  bubb = m_bubbles[bbx];
@@ -290,69 +305,146 @@ void addInBroadPhasePairs(const State& state, PairMap& pairs) const {
         centers[bbx] = surf.mobod->getBodyTransform(state) 
                         * bubb.getCenter();
     }
-    Vec3 average = mean(centers);
-    Vec3 var(0);
-    for (BubbleIndex bbx(0); bbx < numBubbles; ++bbx)
-        var += abs(centers[bbx]-average);
-    int axis = (var[0] > var[1] ? 0 : 1);
-    if (var[2] > var[axis])
-        axis = 2;
-    
-    // Find the extent of each bubble along the axis and sort them by 
-    // starting location.
-    Array_<BubbleExtent,int> extents(numBubbles);
+
+    if (m_broadPhase == ContactTrackerSubsystem::DynamicTree)
+        addInDynamicTreePairs(state, centers, pairs);
+    else
+        addInSweepAndPrunePairs(state, centers, pairs);
+}
+
+// Update the sorted bubble box endpoints in the sweep and prune object,
+// which is cheap when the bubbles haven't moved much since the last time.
+// Pairs that have started or stopped overlapping are added to or removed
+// from the persistent candidate set, then we give all the candidates that
+// are actually touching to the narrow phase.
+void addInSweepAndPrunePairs(const State& state,
+                             const Vector_<Vec3>& centers,
+                             PairMap& pairs) const {
+    const int numBubbles = getNumBubbles();
+    BroadPhaseCache& cache = Value<BroadPhaseCache>::updDowncast
+        (updCacheEntry(state, m_broadPhaseCacheIx));
+
+    cache.lo.resize(numBubbles); cache.hi.resize(numBubbles);
     for (BubbleIndex bbx(0); bbx < numBubbles; ++bbx) {
         const Real radius = m_bubbles[bbx].getRadius();
-        const Real center = centers[bbx][axis];
-        extents[bbx] = BubbleExtent(center-radius, center+radius, bbx);
+        cache.lo[bbx] = centers[bbx] - radius;
+        cache.hi[bbx] = centers[bbx] + radius;
+    }
+
+    Array_<IncrementalSweepAndPrune::Pair> added, removed;
+    if (cache.sweep.getNumObjects() != numBubbles)
+        cache.candidates.clear();
+    cache.sweep.update(cache.lo, cache.hi, &added, &removed);
+
+    for (unsigned i=0; i < removed.size(); ++i)
+        cache.candidates.erase(make_pair(BubbleIndex(removed[i].first),
+                                         BubbleIndex(removed[i].second)));
+    for (unsigned i=0; i < added.size(); ++i) {
+        const BubbleIndex bbx1(added[i].first), bbx2(added[i].second);
+        if (!isExcluded(bbx1, bbx2))
+            cache.candidates.insert(make_pair(bbx1, bbx2));
     }
-    //cout << "Bubble extents:" << extents << "\n";
-
-    // Expensive: O(n log n)
-    std::sort(extents.begin(), extents.end());
-    
-    // Now sweep along the axis, finding potential contacts.
-    
-    for (int ex1=0; ex1 < numBubbles; ++ex1) {
-        const BubbleExtent& extent1 = extents[ex1];
-        const Bubble&       bubb1   = m_bubbles[extent1.index];
-        const Real          radius1 = bubb1.getRadius();
-        const Vec3&         center1 = centers[extent1.index];
-
-        // Loop over just the overlapping bubbles.
-        for (int ex2(ex1+1); ex2 < numBubbles; ++ex2) {
-            const BubbleExtent& extent2 = extents[ex2];
-            if (extent2.start > extent1.end)
-                break;  // no more bubbles can overlap with extent1
-
-            // These bubbles do overlap along this axis. See if they are
-            // actually touching.
-            const Bubble& bubb2   = m_bubbles[extent2.index];
-            const Real    radius2 = bubb2.getRadius();
-            const Vec3&   center2 = centers[extent2.index];
-            if ((center1-center2).normSqr() > square(radius1+radius2))
-                continue; // nope
-
-            // The bubbles are touching. We'll add the corresponding surfaces
-            // to the narrow-phase list unless there are relevant exclusions.
-            const Surface& surf1 = m_surfaces[bubb1.surface];
-            const Surface& surf2 = m_surfaces[bubb2.surface];
-            // Ignore if on the same body.
-            if (surf1.mobod == surf2.mobod) continue;
-            assert(bubb1.surface != bubb2.surface); // duh!
-            // Ignore if surfaces are in a common clique.
-            if (surf1.surface->isInSameClique(*surf2.surface)) continue;
-            // We'll need to do a narrow phase investigation of these two
-            // surfaces; use the lower-numbered one as the index to avoid
-            // duplicates.
-            ContactSurfaceIndex low=bubb1.surface, high=bubb2.surface;
-            if (low > high) std::swap(low,high);
-            ContactSurfaceSet& surfSet = pairs[low];
-            // Insert this pair with null Contact if the pair isn't already
-            // in the PairMap.
-            surfSet.insert(make_pair(high,(Contact*)0));
+
+    std::set< pair<BubbleIndex,BubbleIndex> >::const_iterator
+        p = cache.candidates.begin();
+    for (; p != cache.candidates.end(); ++p)
+        if (bubblesTouch(p->first, p->second, centers))
+            addSurfacePair(p->first, p->second, pairs);
+}
+
+// Bring the bounding volume tree up to date with the current bubble
+// positions, then traverse it against itself to find overlapping boxes.
+// Only surfaces that have left their fat boxes since the last evaluation
+// cause any change to the tree.
+void addInDynamicTreePairs(const State& state, 
+                           const Vector_<Vec3>& centers,
+                           PairMap& pairs) const {
+    const int numBubbles = getNumBubbles();
+    BroadPhaseCache& cache = Value<BroadPhaseCache>::updDowncast
+        (updCacheEntry(state, m_broadPhaseCacheIx));
+
+    const bool mustBuild = (cache.proxy.size() != numBubbles);
+    if (mustBuild) {
+        cache.tree.clear();
+        cache.proxy.resize(numBubbles);
+    }
+
+    Array_<BubbleIndex> unbounded;
+    for (BubbleIndex bbx(0); bbx < numBubbles; ++bbx) {
+        const Real radius = m_bubbles[bbx].getRadius();
+        if (!isFinite(radius)) {
+            cache.proxy[bbx] = -1;
+            unbounded.push_back(bbx);
+            continue;
         }
+        const Vec3 lo = centers[bbx] - radius, hi = centers[bbx] + radius;
+        const Real margin = FatMarginFraction*radius;
+        if (mustBuild)
+            cache.proxy[bbx] = cache.tree.createProxy(lo, hi, bbx, margin);
+        else
+            cache.tree.moveProxy(cache.proxy[bbx], lo, hi, margin);
     }
+
+    // Every pair of bubbles whose fat boxes overlap is a candidate.
+    struct Collector {
+        void operator()(int bubble1, int bubble2) {
+            impl.addPairIfTouching(BubbleIndex(bubble1), BubbleIndex(bubble2),
+                                   centers, pairs);
+        }
+        const ContactTrackerSubsystemImpl&  impl;
+        const Vector_<Vec3>&                centers;
+        PairMap&                            pairs;
+    } collector = {*this, centers, pairs};
+    cache.tree.queryAllPairs(collector);
+
+    // Unbounded bubbles may touch anything.
+    for (unsigned i=0; i < unbounded.size(); ++i)
+        for (BubbleIndex bbx(0); bbx < numBubbles; ++bbx)
+            if (bbx != unbounded[i])
+                addPairIfTouching(unbounded[i], bbx, centers, pairs);
+}
+
+// Return true if two distinct bubbles belong to surfaces that should never
+// be checked for contact.
+bool isExcluded(BubbleIndex bbx1, BubbleIndex bbx2) const {
+    const Bubble&  bubb1 = m_bubbles[bbx1];
+    const Bubble&  bubb2 = m_bubbles[bbx2];
+    const Surface& surf1 = m_surfaces[bubb1.surface];
+    const Surface& surf2 = m_surfaces[bubb2.surface];
+    // Ignore if on the same body.
+    if (surf1.mobod == surf2.mobod) return true;
+    assert(bubb1.surface != bubb2.surface); // duh!
+    // Ignore if surfaces are in a common clique.
+    return surf1.surface->isInSameClique(*surf2.surface);
+}
+
+// Return true if the spheres of two bubbles are touching.
+bool bubblesTouch(BubbleIndex bbx1, BubbleIndex bbx2,
+                  const Vector_<Vec3>& centers) const {
+    return (centers[bbx1]-centers[bbx2]).normSqr() 
+        <= square(m_bubbles[bbx1].getRadius()+m_bubbles[bbx2].getRadius());
+}
+
+// We'll need to do a narrow phase investigation of the surfaces of these two
+// bubbles; use the lower-numbered one as the index to avoid duplicates.
+void addSurfacePair(BubbleIndex bbx1, BubbleIndex bbx2, PairMap& pairs) const {
+    ContactSurfaceIndex low=m_bubbles[bbx1].surface, 
+                        high=m_bubbles[bbx2].surface;
+    if (low > high) std::swap(low,high);
+    ContactSurfaceSet& surfSet = pairs[low];
+    // Insert this pair with null Contact if the pair isn't already
+    // in the PairMap.
+    surfSet.insert(make_pair(high,(Contact*)0));
+}
+
+// Given two distinct bubbles, add the corresponding surface pair to the
+// narrow-phase list if the bubbles are touching, unless there are relevant
+// exclusions.
+void addPairIfTouching(BubbleIndex bbx1, BubbleIndex bbx2,
+                       const Vector_<Vec3>& centers,
+                       PairMap& pairs) const {
+    if (bubblesTouch(bbx1, bbx2, centers) && !isExcluded(bbx1, bbx2))
+        addSurfacePair(bbx1, bbx2, pairs);
 }
 
 // Call this any time after positions are known, to ensure that the active
@@ -408,71 +500,74 @@ void ensureActiveContactsUpdated(const State& state) const {
     addInBroadPhasePairs(state, interesting);
     //cout << "Interesting pairs:\n" << interesting << "\n";
 
+    // Flatten the interesting pairs into a list of tracking jobs, in
+    // PairMap order, each with its surfaces in the order the tracker wants.
+    const ContactGeometryTypeId meshTypeId =
+        ContactGeometry::TriangleMesh::classTypeId();
+    Array_<TrackingJob> jobs;
+    int nMeshJobs = 0;
     PairMap::const_iterator p = interesting.begin();
     for (; p != interesting.end(); ++p) {
         const ContactSurfaceIndex index1 = p->first;
-        const Transform transform1 = 
-            m_surfaces[index1].mobod->getBodyTransform(state)
-                * m_surfaces[index1].X_BS;
-        const ContactGeometry& geom1 = m_surfaces[index1].surface->getShape();
-        const ContactGeometryTypeId typeId1 = geom1.getTypeId();
+        const ContactGeometryTypeId typeId1 = 
+            m_surfaces[index1].surface->getShape().getTypeId();
 
         const ContactSurfaceSet& others = p->second;
         ContactSurfaceSet::const_iterator q = others.begin();
         for (; q != others.end(); ++q) {
             const ContactSurfaceIndex index2 = q->first;
-            const Transform transform2 = 
-                m_surfaces[index2].mobod->getBodyTransform(state)
-                    * m_surfaces[index2].X_BS;
-            const ContactGeometry& geom2 = 
-                m_surfaces[index2].surface->getShape();
-            const ContactGeometryTypeId typeId2 = geom2.getTypeId();
+            const ContactGeometryTypeId typeId2 = 
+                m_surfaces[index2].surface->getShape().getTypeId();
             if (!hasContactTracker(typeId1,typeId2))
                 continue; // No algorithm available for detecting collisions between these two objects.
             bool mustReverse;
-            const ContactTracker& tracker = 
-                getContactTracker(typeId1, typeId2, mustReverse);
-
-            // Put the surfaces in the order required by the tracker.
-            const ContactSurfaceIndex trackSurf1 = (mustReverse? index2:index1);
-            const ContactSurfaceIndex trackSurf2 = (mustReverse? index1:index2);
-
-            UntrackedContact untracked; // empty handle in case we need it
-            const Contact* prev = q->second;
-            if (prev && prev->getCondition() == Contact::Broken)
-                prev = 0; // that contact expired
-            if (!prev) { 
-                untracked = UntrackedContact(trackSurf1, trackSurf2);
-                prev = &untracked;
-            }
-            Contact next; // empty handle
-            if (mustReverse)
-                tracker.trackContact
-                   (*prev, transform2,geom2, transform1,geom1, 0/*TODO*/, next);
-            else
-                tracker.trackContact
-                   (*prev, transform1,geom1, transform2,geom2, 0/*TODO*/, next);
-
-            if (!next.isEmpty()) {
-                next.setSurfaces(trackSurf1,trackSurf2);
-                next.setContactId(prev->getCondition()==Contact::Untracked
-                                    ? Contact::createNewContactId()
-                                    : prev->getContactId()); // persistent
-                if (   prev->getCondition()==Contact::Untracked
-                    || prev->getCondition()==Contact::Anticipated)
-                    next.setCondition(Contact::NewContact);
-                else { // was NewContact or Ongoing; now Ongoing or Broken
-                    assert(prev->getCondition()==Contact::NewContact
-                           || prev->getCondition()==Contact::Ongoing);
-                    if (next.getTypeId() != BrokenContact::classTypeId())
-                        next.setCondition(Contact::Ongoing);
-                    // Condition will already by Broken for a BrokenContact
-                }
-                nextActive.adoptContact(next);
-            }
+            TrackingJob job;
+            job.tracker = &getContactTracker(typeId1, typeId2, mustReverse);
+            job.surf1 = (mustReverse? index2:index1);
+            job.surf2 = (mustReverse? index1:index2);
+            job.prev = q->second;
+            if (job.prev && job.prev->getCondition() == Contact::Broken)
+                job.prev = 0; // that contact expired
+            jobs.push_back(job);
+            if (typeId1 == meshTypeId || typeId2 == meshTypeId)
+                ++nMeshJobs;
         }
     }
 
+    // Run the trackers, possibly in parallel. Each job writes only its own
+    // slot so the outcome doesn't depend on the number of threads.
+    const int nJobs = (int)jobs.size();
+    Array_<Contact> tracked(nJobs);
+    TrackContactJobs track(*this, state, jobs, tracked);
+    runContactLoop(*m_executor, nJobs,
+                   nJobs >= MinContactsForThreads || nMeshJobs >= 2, track);
+
+    // Contact ids must be handed out in a repeatable order, so finish the
+    // new Contacts here serially.
+    for (int i=0; i < nJobs; ++i) {
+        Contact& next = tracked[i];
+        if (next.isEmpty())
+            continue;
+        const Contact* prev = jobs[i].prev;
+        const Contact::Condition prevCondition = 
+            prev ? prev->getCondition() : Contact::Untracked;
+        next.setSurfaces(jobs[i].surf1, jobs[i].surf2);
+        next.setContactId(prevCondition==Contact::Untracked
+                            ? Contact::createNewContactId()
+                            : prev->getContactId()); // persistent
+        if (   prevCondition==Contact::Untracked
+            || prevCondition==Contact::Anticipated)
+            next.setCondition(Contact::NewContact);
+        else { // was NewContact or Ongoing; now Ongoing or Broken
+            assert(prevCondition==Contact::NewContact
+                   || prevCondition==Contact::Ongoing);
+            if (next.getTypeId() != BrokenContact::classTypeId())
+                next.setCondition(Contact::Ongoing);
+            // Condition will already by Broken for a BrokenContact
+        }
+        nextActive.adoptContact(next);
+    }
+
     markDiscreteVarUpdateValueRealized(state, m_activeContactsIx);
 }
 
@@ -546,6 +641,20 @@ getContactTracker(ContactGeometryTypeId id1, ContactGeometryTypeId id2,
     return *m_defaultTracker;
 }
 
+void setBroadPhase(ContactTrackerSubsystem::BroadPhase method) {
+    invalidateSubsystemTopologyCache();
+    m_broadPhase = method;
+}
+ContactTrackerSubsystem::BroadPhase getBroadPhase() const 
+{   return m_broadPhase; }
+
+void setNumberOfThreads(unsigned numThreads) {
+    SimTK_APIARGCHECK_ALWAYS(numThreads > 0, "ContactTrackerSubsystem",
+        "setNumberOfThreads", "Number of threads must be positive.");
+    m_executor = new ParallelExecutor(numThreads);
+}
+int getNumberOfThreads() const {return m_executor->getMaxThreads();}
+
 int getNumSurfaces() const {return m_surfaces.size();}
 int getNumBubbles()  const {return m_bubbles.size();}
 
@@ -568,11 +677,128 @@ ContactSurfaceIndex getContactSurfaceIndex(MobilizedBodyIndex mobod,
     return ContactSurfaceIndex(info.first + contactSurfaceOrdinal);
 }
 
+// Each surface's pose and spatial velocity (of its own origin), its 
+// bounding sphere center in Ground, and a bound on the speed of any of its
+// points. Pairs that can't close by TunnelingFraction of the smaller 
+// bounding radius within the step are skipped, as are pairs whose swept
+// bounding spheres don't meet; only the rest need a time of impact query. 
+// Surfaces that aren't moving are checked only against moving ones.
+Real calcMaxStepWithoutTunneling(const State& state, Real maxStep,
+                                 ContactSurfaceIndex& limit1,
+                                 ContactSurfaceIndex& limit2) const {
+    limit1.invalidate(); limit2.invalidate();
+    const int nSurfs = getNumSurfaces();
+    Array_<Transform>  X_GS(nSurfs);
+    Array_<SpatialVec> V_GS(nSurfs);
+    Array_<Vec3>       center(nSurfs);
+    Array_<Real>       radius(nSurfs), speed(nSurfs);
+    for (ContactSurfaceIndex sx(0); sx < nSurfs; ++sx) {
+        const Surface& surf = m_surfaces[sx];
+        const Transform&  X_GB = surf.mobod->getBodyTransform(state);
+        const SpatialVec& V_GB = surf.mobod->getBodyVelocity(state);
+        const Vec3 p_BS_G = X_GB.R()*surf.X_BS.p();
+        X_GS[sx] = X_GB*surf.X_BS;
+        V_GS[sx] = SpatialVec(V_GB[0], V_GB[1] + V_GB[0] % p_BS_G);
+        Vec3 center_S;
+        surf.surface->getShape().getBoundingSphere(center_S, radius[sx]);
+        center[sx] = X_GS[sx]*center_S;
+        const Real rate = V_GB[0].norm();
+        speed[sx] = V_GS[sx][1].norm() 
+            + (rate == 0 ? Real(0) : rate*(center_S.norm() + radius[sx]));
+    }
+
+    Real step = maxStep;
+    for (ContactSurfaceIndex sx1(0); sx1 < nSurfs; ++sx1) {
+        if (speed[sx1] == 0)
+            continue;
+        const Surface& surf1 = m_surfaces[sx1];
+        const ContactGeometry& shape1 = surf1.surface->getShape();
+        for (ContactSurfaceIndex sx2(0); sx2 < nSurfs; ++sx2) {
+            if (sx2 == sx1 || (speed[sx2] != 0 && sx2 < sx1))
+                continue; // itself, or a moving pair already checked
+            const Surface& surf2 = m_surfaces[sx2];
+            const ContactGeometry& shape2 = surf2.surface->getShape();
+            const Real closing = speed[sx1] + speed[sx2];
+            const Real minRadius = std::min(radius[sx1], radius[sx2]);
+            if (!(closing*step > TunnelingFraction*minRadius))
+                continue; // also catches infinite speed
+            if ((center[sx1]-center[sx2]).norm() - radius[sx1] - radius[sx2]
+                    > closing*step)
+                continue;
+            if (surf1.mobod == surf2.mobod
+                || surf1.surface->isInSameClique(*surf2.surface)
+                || !hasContactTracker(shape1.getTypeId(), shape2.getTypeId()))
+                continue;
+
+            Real timeOfImpact; int numIterations;
+            if (!ContactTracker::calcTimeOfImpact
+                   (X_GS[sx1], V_GS[sx1], shape1, X_GS[sx2], V_GS[sx2], shape2,
+                    step, ImpactToleranceFraction*minRadius, 
+                    timeOfImpact, numIterations))
+                continue;
+            // Let the surfaces touch, but not get far into each other.
+            const Real allowed = 
+                timeOfImpact + TunnelingFraction*minRadius/closing;
+            if (allowed < step) {
+                step = allowed;
+                limit1 = sx1; limit2 = sx2;
+            }
+        }
+    }
+    return step;
+}
+
 SimTK_DOWNCAST(ContactTrackerSubsystemImpl, Subsystem::Guts);
 
 private:
 friend class ContactTrackerSubsystem;
 
+// A bubble's box in the dynamic tree is enlarged by this fraction of its
+// radius on each side.
+static const Real FatMarginFraction;
+
+// A step may carry a pair of surfaces into one another by this fraction of
+// the smaller one's bounding radius. Two surfaces within the given fraction
+// of that radius of one another are considered to be in contact.
+static const Real TunnelingFraction;
+static const Real ImpactToleranceFraction;
+
+// Run the narrow phase for one job, leaving the result in next (empty if
+// the surfaces aren't in contact). This may be called from several threads
+// at once so it must not modify anything else.
+void trackContact(const State& state, const TrackingJob& job,
+                  Contact& next) const {
+    const Surface& s1 = m_surfaces[job.surf1];
+    const Surface& s2 = m_surfaces[job.surf2];
+    const Transform X_GS1 = s1.mobod->getBodyTransform(state) * s1.X_BS;
+    const Transform X_GS2 = s2.mobod->getBodyTransform(state) * s2.X_BS;
+
+    UntrackedContact untracked; // empty handle in case we need it
+    const Contact* prev = job.prev;
+    if (!prev) { 
+        untracked = UntrackedContact(job.surf1, job.surf2);
+        prev = &untracked;
+    }
+    job.tracker->trackContact(*prev, X_GS1, s1.surface->getShape(),
+                                     X_GS2, s2.surface->getShape(),
+                              0/*TODO*/, next);
+}
+
+// Adapts trackContact() for runContactLoop().
+class TrackContactJobs {
+public:
+    TrackContactJobs(const ContactTrackerSubsystemImpl& impl, 
+                     const State& state, const Array_<TrackingJob>& jobs,
+                     Array_<Contact>& tracked)
+    :   impl(impl), state(state), jobs(jobs), tracked(tracked) {}
+    void operator()(int i) {impl.trackContact(state, jobs[i], tracked[i]);}
+private:
+    const ContactTrackerSubsystemImpl&  impl;
+    const State&                        state;
+    const Array_<TrackingJob>&          jobs;
+    Array_<Contact>&                    tracked;
+};
+
     // TOPOLOGY STATE
 // Always order the key with the lower numbered geometry type first but
 // if that is the reverse from how the tracker is defined then the bool 
@@ -581,6 +807,9 @@ friend class ContactTrackerSubsystem;
 // delete it when replacing or destructing.
 TrackerMap          m_contactTrackers;
 ContactTracker*     m_defaultTracker;
+ContactTrackerSubsystem::BroadPhase m_broadPhase;
+// Runs the narrow phase; threads are created on first use.
+mutable ClonePtr<ParallelExecutor> m_executor;
 
     // TOPOLOGY CACHE
 // The pair is the first assigned index, and the number of contact surfaces
@@ -591,8 +820,13 @@ Array_<Surface,ContactSurfaceIndex>     m_surfaces;
 Array_<Bubble,BubbleIndex>              m_bubbles;
 DiscreteVariableIndex                   m_activeContactsIx;
 DiscreteVariableIndex                   m_predictedContactsIx;
+CacheEntryIndex                         m_broadPhaseCacheIx;
 };
 
+const Real ContactTrackerSubsystemImpl::FatMarginFraction = Real(0.2);
+const Real ContactTrackerSubsystemImpl::TunnelingFraction = Real(0.25);
+const Real ContactTrackerSubsystemImpl::ImpactToleranceFraction = Real(0.05);
+
 } // namespace SimTK
 
 //==============================================================================
@@ -654,6 +888,27 @@ getContactSurfaceIndex(MobilizedBodyIndex mobod,
                        int contactSurfaceOrdinal) const
 {   return getImpl().getContactSurfaceIndex(mobod,contactSurfaceOrdinal); }
 
+void ContactTrackerSubsystem::setBroadPhase(BroadPhase method)
+{   updImpl().setBroadPhase(method); }
+
+ContactTrackerSubsystem::BroadPhase ContactTrackerSubsystem::
+getBroadPhase() const
+{   return getImpl().getBroadPhase(); }
+
+void ContactTrackerSubsystem::setNumberOfThreads(unsigned numThreads)
+{   updImpl().setNumberOfThreads(numThreads); }
+
+int ContactTrackerSubsystem::getNumberOfThreads() const
+{   return getImpl().getNumberOfThreads(); }
+
+Real ContactTrackerSubsystem::
+calcMaxStepWithoutTunneling(const State&         state, 
+                            Real                 maxStep,
+                            ContactSurfaceIndex& surface1,
+                            ContactSurfaceIndex& surface2) const
+{   return getImpl().calcMaxStepWithoutTunneling(state, maxStep, 
+                                                 surface1, surface2); }
+
 void ContactTrackerSubsystem::
 adoptContactTracker(ContactTracker* tracker)
 {   updImpl().adoptContactTracker(tracker); }
@@ -710,3 +965,30 @@ realizePredictedContacts(const State& state,
 }
 
 
+
+//==============================================================================
+//                           IMPACT STEP LIMITER
+//==============================================================================
+
+ImpactStepLimiter::ImpactStepLimiter(const ContactTrackerSubsystem& tracker,
+                                     Real lookAhead)
+:   m_tracker(tracker), m_lookAhead(lookAhead) {
+    SimTK_APIARGCHECK1_ALWAYS(lookAhead > 0, "ImpactStepLimiter", 
+        "ImpactStepLimiter", "The look ahead interval %g must be positive.",
+        lookAhead);
+}
+
+Real ImpactStepLimiter::
+getNextEventTime(const State& state, bool includeCurrentTime) const {
+    if (state.getSystemStage() < Stage::Velocity)
+        return Infinity;
+    ContactSurfaceIndex surface1, surface2;
+    return state.getTime() 
+        + m_tracker.calcMaxStepWithoutTunneling(state, m_lookAhead,
+                                                surface1, surface2);
+}
+
+void ImpactStepLimiter::
+handleEvent(State& state, Real accuracy, bool& shouldTerminate) const {
+    shouldTerminate = false;
+}
@@ -0,0 +1,287 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "DynamicAABBTree.h"
+
+#include <algorithm>
+
+using namespace SimTK;
+
+// The tree algorithms here follow the dynamic AABB tree in Erin Catto's
+// Box2D (zlib license), which in turn is based on Nathanael Presson's
+// btDbvt from Bullet.
+
+static Vec3 elementMin(const Vec3& a, const Vec3& b)
+{   return Vec3(std::min(a[0],b[0]), std::min(a[1],b[1]), std::min(a[2],b[2])); }
+static Vec3 elementMax(const Vec3& a, const Vec3& b)
+{   return Vec3(std::max(a[0],b[0]), std::max(a[1],b[1]), std::max(a[2],b[2])); }
+
+int DynamicAABBTree::allocateNode() {
+    int n;
+    if (freeList >= 0) {
+        n = freeList;
+        freeList = nodes[n].parent;
+    } else {
+        n = (int)nodes.size();
+        nodes.push_back(Node());
+    }
+    Node& node = nodes[n];
+    node.parent = node.child1 = node.child2 = -1;
+    node.height = 0;
+    node.userData = -1;
+    return n;
+}
+
+void DynamicAABBTree::freeNode(int n) {
+    nodes[n].parent = freeList;
+    nodes[n].height = -1;
+    freeList = n;
+}
+
+int DynamicAABBTree::createProxy(const Vec3& lo, const Vec3& hi, int userData,
+                                 Real margin) {
+    const int proxy = allocateNode();
+    Node& leaf = nodes[proxy];
+    leaf.lo = lo - margin; leaf.hi = hi + margin;
+    leaf.userData = userData;
+    insertLeaf(proxy);
+    ++numProxies;
+    return proxy;
+}
+
+void DynamicAABBTree::destroyProxy(int proxy) {
+    assert(nodes[proxy].isLeaf());
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --numProxies;
+}
+
+bool DynamicAABBTree::moveProxy(int proxy, const Vec3& lo, const Vec3& hi,
+                                Real margin) {
+    Node& leaf = nodes[proxy];
+    assert(leaf.isLeaf());
+    if (   leaf.lo[0] <= lo[0] && leaf.lo[1] <= lo[1] && leaf.lo[2] <= lo[2]
+        && hi[0] <= leaf.hi[0] && hi[1] <= leaf.hi[1] && hi[2] <= leaf.hi[2])
+        return false; // still inside the fat box
+
+    removeLeaf(proxy);
+    nodes[proxy].lo = lo - margin; nodes[proxy].hi = hi + margin;
+    insertLeaf(proxy);
+    return true;
+}
+
+// Walk down from the root choosing at each level whichever of (make a new
+// parent here, descend left, descend right) increases the total surface area
+// least, then pair the leaf with the node we end up at.
+void DynamicAABBTree::insertLeaf(int leaf) {
+    if (root < 0) {
+        root = leaf;
+        nodes[root].parent = -1;
+        return;
+    }
+
+    const Vec3 leafLo = nodes[leaf].lo, leafHi = nodes[leaf].hi;
+    int index = root;
+    while (!nodes[index].isLeaf()) {
+        const Node& node = nodes[index];
+        const int c1 = node.child1, c2 = node.child2;
+
+        const Real area = halfArea(node.lo, node.hi);
+        const Real combinedArea = halfArea(elementMin(node.lo, leafLo),
+                                           elementMax(node.hi, leafHi));
+        // Cost of creating a new parent for this node and the new leaf.
+        const Real cost = 2*combinedArea;
+        // Minimum cost of pushing the leaf further down the tree.
+        const Real inheritanceCost = 2*(combinedArea - area);
+
+        Real childCost[2];
+        const int child[2] = {c1, c2};
+        for (int i=0; i < 2; ++i) {
+            const Node& c = nodes[child[i]];
+            const Real newArea = halfArea(elementMin(c.lo, leafLo),
+                                          elementMax(c.hi, leafHi));
+            childCost[i] = (c.isLeaf() ? newArea
+                                       : newArea - halfArea(c.lo, c.hi))
+                           + inheritanceCost;
+        }
+
+        if (cost < childCost[0] && cost < childCost[1])
+            break;
+        index = childCost[0] < childCost[1] ? c1 : c2;
+    }
+
+    const int sibling = index;
+    const int newParent = allocateNode(); // may move the nodes
+    const int oldParent = nodes[sibling].parent;
+    Node& parent = nodes[newParent];
+    parent.parent = oldParent;
+    parent.lo = elementMin(nodes[sibling].lo, leafLo);
+    parent.hi = elementMax(nodes[sibling].hi, leafHi);
+    parent.height = nodes[sibling].height + 1;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent >= 0) {
+        if (nodes[oldParent].child1 == sibling)
+             nodes[oldParent].child1 = newParent;
+        else nodes[oldParent].child2 = newParent;
+    } else
+        root = newParent;
+
+    refitAncestors(nodes[leaf].parent);
+}
+
+// Replace the leaf's parent by the leaf's sibling.
+void DynamicAABBTree::removeLeaf(int leaf) {
+    if (leaf == root) {
+        root = -1;
+        return;
+    }
+    const int parent = nodes[leaf].parent;
+    const int grandParent = nodes[parent].parent;
+    const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2
+                                                     : nodes[parent].child1;
+    if (grandParent >= 0) {
+        if (nodes[grandParent].child1 == parent)
+             nodes[grandParent].child1 = sibling;
+        else nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        refitAncestors(grandParent);
+    } else {
+        root = sibling;
+        nodes[sibling].parent = -1;
+        freeNode(parent);
+    }
+}
+
+// Rebalance and recompute boxes and heights from node n up to the root.
+void DynamicAABBTree::refitAncestors(int n) {
+    while (n >= 0) {
+        n = balance(n);
+        Node& node = nodes[n];
+        const Node& c1 = nodes[node.child1];
+        const Node& c2 = nodes[node.child2];
+        node.height = 1 + std::max(c1.height, c2.height);
+        node.lo = elementMin(c1.lo, c2.lo);
+        node.hi = elementMax(c1.hi, c2.hi);
+        n = node.parent;
+    }
+}
+
+// If the subtrees of node a differ in height by more than one, rotate the
+// taller child up to take a's place.
+// Returns the index of the node now at a's position.
+int DynamicAABBTree::balance(int iA) {
+    Node& A = nodes[iA];
+    if (A.isLeaf() || A.height < 2)
+        return iA;
+
+    const int iB = A.child1, iC = A.child2;
+    Node& B = nodes[iB]; Node& C = nodes[iC];
+    const int imbalance = C.height - B.height;
+
+    // Rotate C up.
+    if (imbalance > 1) {
+        const int iF = C.child1, iG = C.child2;
+        Node& F = nodes[iF]; Node& G = nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        if (C.parent >= 0) {
+            if (nodes[C.parent].child1 == iA) nodes[C.parent].child1 = iC;
+            else                              nodes[C.parent].child2 = iC;
+        } else
+            root = iC;
+
+        // Keep the taller of F and G under C.
+        const int iKeep = F.height > G.height ? iF : iG;
+        const int iMove = F.height > G.height ? iG : iF;
+        Node& keep = nodes[iKeep]; Node& move = nodes[iMove];
+        C.child2 = iKeep;
+        A.child2 = iMove;
+        move.parent = iA;
+        A.lo = elementMin(B.lo, move.lo); A.hi = elementMax(B.hi, move.hi);
+        C.lo = elementMin(A.lo, keep.lo); C.hi = elementMax(A.hi, keep.hi);
+        A.height = 1 + std::max(B.height, move.height);
+        C.height = 1 + std::max(A.height, keep.height);
+        return iC;
+    }
+
+    // Rotate B up.
+    if (imbalance < -1) {
+        const int iD = B.child1, iE = B.child2;
+        Node& D = nodes[iD]; Node& E = nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        if (B.parent >= 0) {
+            if (nodes[B.parent].child1 == iA) nodes[B.parent].child1 = iB;
+            else                              nodes[B.parent].child2 = iB;
+        } else
+            root = iB;
+
+        const int iKeep = D.height > E.height ? iD : iE;
+        const int iMove = D.height > E.height ? iE : iD;
+        Node& keep = nodes[iKeep]; Node& move = nodes[iMove];
+        B.child2 = iKeep;
+        A.child1 = iMove;
+        move.parent = iA;
+        A.lo = elementMin(C.lo, move.lo); A.hi = elementMax(C.hi, move.hi);
+        B.lo = elementMin(A.lo, keep.lo); B.hi = elementMax(A.hi, keep.hi);
+        A.height = 1 + std::max(C.height, move.height);
+        B.height = 1 + std::max(A.height, keep.height);
+        return iB;
+    }
+
+    return iA;
+}
+
+// Returns the number of leaves in the subtree; clears ok on any violation.
+int DynamicAABBTree::validateSubtree(int n, bool& ok) const {
+    const Node& node = nodes[n];
+    if (node.isLeaf()) {
+        if (node.height != 0 || node.child2 >= 0) ok = false;
+        return 1;
+    }
+    const Node& c1 = nodes[node.child1];
+    const Node& c2 = nodes[node.child2];
+    if (c1.parent != n || c2.parent != n) ok = false;
+    if (node.height != 1 + std::max(c1.height, c2.height)) ok = false;
+    if (elementMin(c1.lo, c2.lo) != node.lo
+        || elementMax(c1.hi, c2.hi) != node.hi) ok = false;
+    return validateSubtree(node.child1, ok) + validateSubtree(node.child2, ok);
+}
+
+bool DynamicAABBTree::isValid() const {
+    if (root < 0)
+        return numProxies == 0;
+    bool ok = nodes[root].parent == -1;
+    const int nLeaves = validateSubtree(root, ok);
+    return ok && nLeaves == numProxies;
+}
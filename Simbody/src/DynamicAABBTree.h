@@ -0,0 +1,200 @@
+#ifndef SimTK_SIMBODY_DYNAMIC_AABB_TREE_H_
+#define SimTK_SIMBODY_DYNAMIC_AABB_TREE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+namespace SimTK {
+
+//==============================================================================
+//                            DYNAMIC AABB TREE
+//==============================================================================
+// A bounding volume hierarchy of axis-aligned boxes for broad phase contact
+// detection among moving objects. Each object ("proxy") is stored in a leaf
+// with a "fat" box that is larger than the object's actual bounds by some
+// margin, so that small motions don't change the tree at all. When an object
+// moves outside its fat box the leaf is removed and reinserted, and the
+// ancestor boxes are refit on the way up. Insertion chooses the sibling that
+// minimizes the increase in total box surface area, and rotations on the way
+// back up keep the tree roughly height balanced, so queries are O(log n) for
+// objects of similar size.
+//
+// Nodes live in a single array and refer to each other by index so the tree
+// can be copied cheaply (it is kept in a State cache entry). Proxy ids are
+// node indices and stay valid until the proxy is destroyed.
+class DynamicAABBTree {
+public:
+    DynamicAABBTree() {clear();}
+
+    void clear() {
+        nodes.clear();
+        root = freeList = -1;
+        numProxies = 0;
+    }
+
+    // Add an object with the given tight bounds and associated user data,
+    // expanding the box by margin on all sides. Returns the proxy id.
+    int createProxy(const Vec3& lo, const Vec3& hi, int userData, Real margin);
+    void destroyProxy(int proxy);
+
+    // Update the tight bounds of an object. Nothing happens if the new box is
+    // still inside the fat box; otherwise the proxy is reinserted with a new
+    // fat box and we return true.
+    bool moveProxy(int proxy, const Vec3& lo, const Vec3& hi, Real margin);
+
+    int getUserData(int proxy) const {return nodes[proxy].userData;}
+    const Vec3& getFatLow(int proxy) const {return nodes[proxy].lo;}
+    const Vec3& getFatHigh(int proxy) const {return nodes[proxy].hi;}
+
+    int getNumProxies() const {return numProxies;}
+    // Height of the tree; a leaf has height 0.
+    int getHeight() const {return root < 0 ? 0 : nodes[root].height;}
+
+    // Call f(userData) for every proxy whose fat box overlaps [lo,hi]. The
+    // traversal uses an explicit stack rather than recursion.
+    template <class F>
+    void query(const Vec3& lo, const Vec3& hi, F& f) const {
+        if (root < 0) return;
+        Stack stack;
+        stack.push(root);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.pop()];
+            if (!overlaps(node.lo, node.hi, lo, hi))
+                continue;
+            if (node.isLeaf()) {
+                f(node.userData);
+                continue;
+            }
+            stack.push(node.child1);
+            stack.push(node.child2);
+        }
+    }
+
+    // Call f(userData1, userData2) once for every pair of distinct proxies
+    // whose fat boxes overlap. This traverses the tree against itself, which
+    // visits each overlapping pair of subtrees once and is considerably
+    // cheaper than a query() per proxy.
+    template <class F>
+    void queryAllPairs(F& f) const {
+        if (root < 0) return;
+        Stack stack; // holds pairs of node indices
+        stack.push(root); stack.push(root);
+        while (!stack.empty()) {
+            const int b = stack.pop(), a = stack.pop();
+            const Node& A = nodes[a];
+            if (a == b) { // a subtree against itself
+                if (A.isLeaf()) continue;
+                stack.push(A.child1); stack.push(A.child1);
+                stack.push(A.child2); stack.push(A.child2);
+                stack.push(A.child1); stack.push(A.child2);
+                continue;
+            }
+            const Node& B = nodes[b];
+            if (!overlaps(A.lo, A.hi, B.lo, B.hi))
+                continue;
+            if (A.isLeaf() && B.isLeaf()) {
+                f(A.userData, B.userData);
+                continue;
+            }
+            // Descend into the taller subtree.
+            if (B.isLeaf() || (!A.isLeaf() && A.height >= B.height)) {
+                stack.push(A.child1); stack.push(b);
+                stack.push(A.child2); stack.push(b);
+            } else {
+                stack.push(a); stack.push(B.child1);
+                stack.push(a); stack.push(B.child2);
+            }
+        }
+    }
+
+    // Check the structural invariants; for testing and debugging.
+    bool isValid() const;
+
+private:
+    struct Node {
+        bool isLeaf() const {return child1 < 0;}
+        Vec3    lo, hi;
+        int     parent;     // or next free node if this one is free
+        int     child1, child2;
+        int     height;     // 0 for leaves, -1 for free nodes
+        int     userData;
+    };
+
+    // Traversal stack of node indices; starts out on the program stack and
+    // moves to the heap only for unusually deep traversals.
+    class Stack {
+    public:
+        Stack() : stack(fixed), top(0), capacity(FixedSize) {}
+        bool empty() const {return top == 0;}
+        int pop() {return stack[--top];}
+        void push(int n) {
+            if (top == capacity) {
+                if (stack == fixed)
+                    heap.assign(fixed, fixed+top);
+                heap.resize(2*capacity); // keeps the current entries
+                stack = heap.begin(); capacity *= 2;
+            }
+            stack[top++] = n;
+        }
+    private:
+        Stack(const Stack&) = delete;
+        Stack& operator=(const Stack&) = delete;
+        static const int FixedSize = 256;
+        int         fixed[FixedSize];
+        Array_<int> heap;
+        int*        stack;
+        int         top, capacity;
+    };
+
+    static bool overlaps(const Vec3& lo1, const Vec3& hi1,
+                         const Vec3& lo2, const Vec3& hi2) {
+        return !(   hi1[0] < lo2[0] || hi2[0] < lo1[0]
+                 || hi1[1] < lo2[1] || hi2[1] < lo1[1]
+                 || hi1[2] < lo2[2] || hi2[2] < lo1[2]);
+    }
+    // Half the surface area of a box; proportional to the probability that
+    // a random ray or small box hits it.
+    static Real halfArea(const Vec3& lo, const Vec3& hi) {
+        const Vec3 d = hi - lo;
+        return d[0]*d[1] + d[1]*d[2] + d[2]*d[0];
+    }
+
+    int  allocateNode();
+    void freeNode(int n);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int  balance(int a);
+    void refitAncestors(int n);
+    int  validateSubtree(int n, bool& ok) const;
+
+    Array_<Node>    nodes;
+    int             root;
+    int             freeList;
+    int             numProxies;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMBODY_DYNAMIC_AABB_TREE_H_
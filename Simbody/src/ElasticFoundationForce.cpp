@@ -27,8 +27,8 @@
 #include "simbody/internal/GeneralContactSubsystem.h"
 #include "simbody/internal/MobilizedBody.h"
 #include "ElasticFoundationForceImpl.h"
+#include "ContactForceKernels.h"
 #include <map>
-#include <set>
 
 namespace SimTK {
 
@@ -96,7 +96,13 @@ void ElasticFoundationForceImpl::calcForce
     const Array_<Contact>& contacts = subsystem.getContacts(state, set);
     Real& pe = Value<Real>::updDowncast
                 (subsystem.updCacheEntry(state, energyCacheIndex));
-    pe = 0.0;
+    ContactForceBatch& batch = Value<ContactForceBatch>::updDowncast
+                (subsystem.updCacheEntry(state, batchCacheIndex));
+    batch.clear();
+
+    // Gather the springs that are in contact, then evaluate the force law 
+    // for all of them at once.
+
     for (int i = 0; i < (int) contacts.size(); i++) {
         std::map<ContactSurfaceIndex, Parameters>::const_iterator iter1 = 
             parameters.find(contacts[i].getSurface1());
@@ -112,7 +118,7 @@ void ElasticFoundationForceImpl::calcForce
                 static_cast<const TriangleMeshContact&>(contacts[i]);
             processContact(state, contact.getSurface1(), 
                 contact.getSurface2(), iter1->second, 
-                contact.getSurface1Faces(), areaScale, bodyForces, pe);
+                contact.getSurface1FaceList(), areaScale, batch);
         }
 
         if (iter2 != parameters.end()) {
@@ -120,16 +126,19 @@ void ElasticFoundationForceImpl::calcForce
                 static_cast<const TriangleMeshContact&>(contacts[i]);
             processContact(state, contact.getSurface2(), 
                 contact.getSurface1(), iter2->second, 
-                contact.getSurface2Faces(), areaScale, bodyForces, pe);
+                contact.getSurface2FaceList(), areaScale, batch);
         }
     }
+
+    pe = calcLinearContactForces(batch, transitionVelocity);
+    applyContactForces(batch, state, bodyForces);
 }
 
 void ElasticFoundationForceImpl::processContact
    (const State& state, 
     ContactSurfaceIndex meshIndex, ContactSurfaceIndex otherBodyIndex, 
-    const Parameters& param, const std::set<int>& insideFaces,
-    Real areaScale, Vector_<SpatialVec>& bodyForces, Real& pe) const 
+    const Parameters& param, const Array_<int>& insideFaces,
+    Real areaScale, ContactForceBatch& batch) const 
 {
     const ContactGeometry& otherObject = subsystem.getBodyGeometry(set, otherBodyIndex);
     const MobilizedBody& body1 = subsystem.getBody(set, meshIndex);
@@ -137,15 +146,28 @@ void ElasticFoundationForceImpl::processContact
     const Transform t1g = body1.getBodyTransform(state)*subsystem.getBodyTransform(set, meshIndex); // mesh to ground
     const Transform t2g = body2.getBodyTransform(state)*subsystem.getBodyTransform(set, otherBodyIndex); // other object to ground
     const Transform t12 = ~t2g*t1g; // mesh to other object
+    const ContactGeometry::TriangleMesh* otherMesh = ContactGeometry::TriangleMesh::isInstance(otherObject)
+        ? &ContactGeometry::TriangleMesh::getAs(otherObject) : 0;
 
-    // Loop over all the springs, and evaluate the force from each one.
+    const SpatialVec& V1 = body1.getBodyVelocity(state);
+    const SpatialVec& V2 = body2.getBodyVelocity(state);
+    const Vec3& origin1 = body1.getBodyOriginLocation(state);
+    const Vec3& origin2 = body2.getBodyOriginLocation(state);
 
-    for (std::set<int>::const_iterator iter = insideFaces.begin(); 
-                                       iter != insideFaces.end(); ++iter) {
-        int face = *iter;
+    // Loop over all the springs, and gather the ones that are compressed.
+    // The force on the mesh is along the spring's displacement.
+
+    batch.addGroup(body2, body1);
+
+    for (unsigned i = 0; i < insideFaces.size(); i++) {
+        int face = insideFaces[i];
         UnitVec3 normal;
         bool inside;
-        Vec3 nearestPoint = otherObject.findNearestPoint(t12*param.springPosition[face], inside, normal);
+        const Vec3 springPos = t12*param.springPosition[face];
+        Real estimate, maxError;
+        if (otherMesh && otherMesh->estimateSignedDistance(springPos, estimate, maxError) && estimate > maxError)
+            continue; // certainly outside
+        Vec3 nearestPoint = otherObject.findNearestPoint(springPos, inside, normal);
         if (!inside)
             continue;
         
@@ -161,35 +183,19 @@ void ElasticFoundationForceImpl::processContact
         
         // Calculate the relative velocity of the two bodies at the contact point.
         
-        const Vec3 station1 = body1.findStationAtGroundPoint(state, nearestPoint);
-        const Vec3 station2 = body2.findStationAtGroundPoint(state, nearestPoint);
-        const Vec3 v1 = body1.findStationVelocityInGround(state, station1);
-        const Vec3 v2 = body2.findStationVelocityInGround(state, station2);
+        const Vec3 v1 = V1[1] + V1[0] % (nearestPoint-origin1);
+        const Vec3 v2 = V2[1] + V2[0] % (nearestPoint-origin2);
         const Vec3 v = v2-v1;
         const Real vnormal = dot(v, forceDir);
         const Vec3 vtangent = v-vnormal*forceDir;
-        
-        // Calculate the damping force.
+        const Real vslip = vtangent.norm();
         
         const Real area = areaScale * param.springArea[face];
-        const Real f = param.stiffness*area*distance*(1+param.dissipation*vnormal);
-        Vec3 force = (f > 0 ? f*forceDir : Vec3(0));
-        
-        // Calculate the friction force.
-        
-        const Real vslip = vtangent.norm();
-        if (f > 0 && vslip != 0) {
-            const Real vrel = vslip/transitionVelocity;
-            const Real ffriction = 
-                f*(std::min(vrel, Real(1))
-                 *(param.dynamicFriction+2*(param.staticFriction-param.dynamicFriction)
-                 /(1+vrel*vrel))+param.viscousFriction*vslip);
-            force += ffriction*vtangent/vslip;
-        }
-
-        body1.applyForceToBodyPoint(state, station1, force, bodyForces);
-        body2.applyForceToBodyPoint(state, station2, -force, bodyForces);
-        pe += param.stiffness*area*displacement.normSqr()/2;
+        batch.addPoint(param.stiffness*area, distance, param.dissipation,
+                       vnormal, vslip, param.staticFriction, 
+                       param.dynamicFriction, param.viscousFriction,
+                       nearestPoint, forceDir, 
+                       vslip != 0 ? vtangent/vslip : Vec3(0));
     }
 }
 
@@ -201,6 +207,8 @@ Real ElasticFoundationForceImpl::calcPotentialEnergy(const State& state) const {
 void ElasticFoundationForceImpl::realizeTopology(State& state) const {
     energyCacheIndex = subsystem.allocateCacheEntry
                         (state, Stage::Dynamics, new Value<Real>());
+    batchCacheIndex = subsystem.allocateCacheEntry
+                        (state, Stage::Dynamics, new Value<ContactForceBatch>());
 }
 
 
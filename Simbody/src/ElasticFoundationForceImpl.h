@@ -31,6 +31,8 @@
 
 namespace SimTK {
 
+class ContactForceBatch;
+
 class ElasticFoundationForceImpl : public ForceImpl {
 public:
     class Parameters;
@@ -49,9 +51,8 @@ public:
     void processContact(const State& state, ContactSurfaceIndex meshIndex, 
                         ContactSurfaceIndex otherBodyIndex, 
                         const Parameters& param, 
-                        const std::set<int>& insideFaces,
-                        Real areaScale,
-                        Vector_<SpatialVec>& bodyForces, Real& pe) const;
+                        const Array_<int>& insideFaces,
+                        Real areaScale, ContactForceBatch& batch) const;
 private:
     friend class ElasticFoundationForce;
     const GeneralContactSubsystem& subsystem;
@@ -59,6 +60,7 @@ private:
     std::map<ContactSurfaceIndex, Parameters> parameters;
     Real transitionVelocity;
     mutable CacheEntryIndex energyCacheIndex;
+    mutable CacheEntryIndex batchCacheIndex; // scratch space
 };
 
 class ElasticFoundationForceImpl::Parameters {
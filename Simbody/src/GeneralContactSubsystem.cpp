@@ -28,6 +28,8 @@
 #include "simbody/internal/MultibodySystem.h"
 #include "simbody/internal/SimbodyMatterSubsystem.h"
 
+#include "IncrementalSweepAndPrune.h"
+
 #include <algorithm>
 
 namespace SimTK {
@@ -47,18 +49,6 @@ public:
     mutable Array_<Real,ContactSurfaceIndex>    sphereRadii;
 };
 
-class ContactBodyExtent {
-public:
-    ContactBodyExtent(Real start, Real end, ContactSurfaceIndex index) 
-    :   start(start), end(end), index(index) {}
-    ContactBodyExtent() {}
-    bool operator<(const ContactBodyExtent& e) const 
-    {   return start < e.start; }
-    Real start, end;
-    ContactSurfaceIndex index;
-};
-
-
 //==============================================================================
 //                      GENERAL CONTACT SUBSYSTEM IMPL
 //==============================================================================
@@ -136,6 +126,8 @@ public:
     int realizeSubsystemTopologyImpl(State& state) const override {
         contactsCacheIndex = state.allocateCacheEntry(getMySubsystemIndex(), Stage::Dynamics, new Value<Array_<Array_<Contact> > >());
         contactsValidCacheIndex = state.allocateCacheEntry(getMySubsystemIndex(), Stage::Position, new Value<bool>());
+        // The sweep and prune data persists from one evaluation to the next.
+        sweepCacheIndex = state.allocateLazyCacheEntry(getMySubsystemIndex(), Stage::Topology, new Value<Array_<IncrementalSweepAndPrune> >());
         for (int i = 0; i < (int) sets.size(); ++i) {
             const ContactSet& set = sets[i];
             int numBodies = set.bodies.size();
@@ -159,8 +151,10 @@ public:
         if (contactsValid)
             return 0;
         Array_<Array_<Contact> >& contacts = Value<Array_<Array_<Contact> > >::updDowncast(updCacheEntry(state, contactsCacheIndex)).upd();
+        Array_<IncrementalSweepAndPrune>& sweeps = Value<Array_<IncrementalSweepAndPrune> >::updDowncast(updCacheEntry(state, sweepCacheIndex)).upd();
         int numSets = getNumContactSets();
         contacts.resize(numSets);
+        sweeps.resize(numSets);
         
         // Loop over all contact sets.
         
@@ -169,63 +163,54 @@ public:
             const ContactSet& set = sets[setIndex];
             int numBodies = set.bodies.size();
             
-            // Perform a sweep-and-prune on a single axis to identify potential contacts.  First, find which
-            // axis has the most variation in body locations.  That is the axis we will use.
+            // Update the sweep-and-prune data for the new body locations. The
+            // bodies have usually moved only a little since the last
+            // evaluation, so this is much cheaper than sorting from scratch.
             
-            Vector_<Vec3> centers(numBodies);
-            for (ContactSurfaceIndex i(0); i < numBodies; i++)
+            Array_<Vec3> centers(numBodies), lo(numBodies), hi(numBodies);
+            for (ContactSurfaceIndex i(0); i < numBodies; i++) {
                 centers[i] = set.bodies[i].getBodyTransform(state)*set.sphereCenters[i];
-            Vec3 average = mean(centers);
-            Vec3 var(0);
-            for (int i = 0; i < numBodies; i++)
-                var += abs(centers[i]-average);
-            int axis = (var[0] > var[1] ? 0 : 1);
-            if (var[2] > var[axis])
-                axis = 2;
-            
-            // Find the extent of each body along the axis and sort them by starting location.
-            
-            Array_<ContactBodyExtent> extents(numBodies);
-            for (ContactSurfaceIndex i(0); i < numBodies; i++)
-                extents[i] = ContactBodyExtent(centers[i][axis]-set.sphereRadii[i], centers[i][axis]+set.sphereRadii[i], i);
-            std::sort(extents.begin(), extents.end());
+                lo[i] = centers[i]-set.sphereRadii[i];
+                hi[i] = centers[i]+set.sphereRadii[i];
+            }
+            IncrementalSweepAndPrune& sweep = sweeps[setIndex];
+            sweep.update(lo, hi, NULL, NULL);
             
-            // Now sweep along the axis, finding potential contacts.
+            // Now look at each pair whose bounding boxes overlap.
             
-            for (int i = 0; i < numBodies; i++) {
-                const ContactSurfaceIndex index1 = extents[i].index;
+            const std::set<IncrementalSweepAndPrune::Pair>& pairs = sweep.getOverlappingPairs();
+            for (std::set<IncrementalSweepAndPrune::Pair>::const_iterator p = pairs.begin(); p != pairs.end(); ++p) {
+                // See if the bounding spheres overlap.
+                
+                const ContactSurfaceIndex index1(p->first), index2(p->second);
+                const Real sumRadius = set.sphereRadii[index1]+set.sphereRadii[index2];
+                if ((centers[index1]-centers[index2]).normSqr() > sumRadius*sumRadius)
+                    continue;
+                
+                // Do a full collision detection.
+
                 const Transform transform1 = set.bodies[index1].getBodyTransform(state)*set.transforms[index1];
                 const ContactGeometry& geom1 = set.geometry[index1];
                 const ContactGeometryTypeId typeId1 = geom1.getTypeId();
-                for (int j = i+1; j < numBodies && extents[j].start <= extents[i].end; j++) {
-                    // They overlap along this axis.  See if the bounding spheres overlap.
-                    
-                    const ContactSurfaceIndex index2 = extents[j].index;
-                    const Real sumRadius = set.sphereRadii[index1]+set.sphereRadii[index2];
-                    if ((centers[index1]-centers[index2]).normSqr() <= sumRadius*sumRadius) {
-                        // Do a full collision detection.
-
-                        const Transform transform2 = set.bodies[index2].getBodyTransform(state)*set.transforms[index2];
-                        const ContactGeometry& geom2 = set.geometry[index2];
-                        const ContactGeometryTypeId typeId2 = geom2.getTypeId();
-                        CollisionDetectionAlgorithm* algorithm = 
-                            CollisionDetectionAlgorithm::getAlgorithm
-                                                            (typeId1, typeId2);
-                        if (algorithm == NULL) {
-                            algorithm = CollisionDetectionAlgorithm::
-                                                getAlgorithm(typeId2, typeId1);
-                            if (algorithm == NULL)
-                                continue; // No algorithm available for detecting collisions between these two objects.
-                            algorithm->processObjects(index2, geom2, transform2,
-                                                      index1, geom1, transform1,
-                                                      contacts[setIndex]);
-                        }
-                        else {
-                            algorithm->processObjects(index1, geom1, transform1,
-                                                      index2, geom2, transform2,
-                                                      contacts[setIndex]);
-                        }
-                    }
+                const Transform transform2 = set.bodies[index2].getBodyTransform(state)*set.transforms[index2];
+                const ContactGeometry& geom2 = set.geometry[index2];
+                const ContactGeometryTypeId typeId2 = geom2.getTypeId();
+                CollisionDetectionAlgorithm* algorithm = 
+                    CollisionDetectionAlgorithm::getAlgorithm
+                                                    (typeId1, typeId2);
+                if (algorithm == NULL) {
+                    algorithm = CollisionDetectionAlgorithm::
+                                        getAlgorithm(typeId2, typeId1);
+                    if (algorithm == NULL)
+                        continue; // No algorithm available for detecting collisions between these two objects.
+                    algorithm->processObjects(index2, geom2, transform2,
+                                              index1, geom1, transform1,
+                                              contacts[setIndex]);
+                }
+                else {
+                    algorithm->processObjects(index1, geom1, transform1,
+                                              index2, geom2, transform2,
+                                              contacts[setIndex]);
                 }
             }
         }
@@ -240,6 +225,7 @@ private:
 
     mutable CacheEntryIndex contactsCacheIndex;
     mutable CacheEntryIndex contactsValidCacheIndex;
+    mutable CacheEntryIndex sweepCacheIndex;
 };
 
 
@@ -28,6 +28,7 @@
 #include "simbody/internal/MobilizedBody.h"
 
 #include "HuntCrossleyForceImpl.h"
+#include "ContactForceKernels.h"
 
 namespace SimTK {
 
@@ -102,7 +103,12 @@ void HuntCrossleyForceImpl::calcForce(const State& state, Vector_<SpatialVec>& b
                                       Vector_<Vec3>& particleForces, Vector& mobilityForces) const {
     const Array_<Contact>& contacts = subsystem.getContacts(state, set);
     Real& pe = Value<Real>::updDowncast(state.updCacheEntry(subsystem.getMySubsystemIndex(), energyCacheIndex)).upd();
-    pe = 0.0;
+    ContactForceBatch& batch = Value<ContactForceBatch>::updDowncast(state.updCacheEntry(subsystem.getMySubsystemIndex(), batchCacheIndex)).upd();
+    batch.clear();
+
+    // Gather the inputs to the force law for all the contacts, then evaluate
+    // it for all of them at once.
+
     for (int i = 0; i < (int) contacts.size(); i++) {
         if (!PointContact::isInstance(contacts[i]))
             continue;
@@ -118,54 +124,43 @@ void HuntCrossleyForceImpl::calcForce(const State& state, Vector_<SpatialVec>& b
         const Vec3& normal = contact.getNormal();
         const Vec3 location = contact.getLocation()+(depth*(Real(0.5)-s1))*normal;
         
-        // Calculate the Hertz force.
+        // The Hertz force is fH = 4/3 k sqrt(R k) depth^(3/2), and the 
+        // Hunt-Crossley force fH (1 + 3/2 c vnormal).
 
         const Real k = param1.stiffness*s1;
         const Real c = param1.dissipation*s1 + param2.dissipation*s2;
         const Real radius = contact.getEffectiveRadiusOfCurvature();
-        const Real fH = Real(4./3.)*k*depth*std::sqrt(radius*k*depth);
-        pe += Real(2./5.)*fH*depth;
         
         // Calculate the relative velocity of the two bodies at the contact point.
         
         const MobilizedBody& body1 = subsystem.getBody(set, contact.getSurface1());
         const MobilizedBody& body2 = subsystem.getBody(set, contact.getSurface2());
-        const Vec3 station1 = body1.findStationAtGroundPoint(state, location);
-        const Vec3 station2 = body2.findStationAtGroundPoint(state, location);
-        const Vec3 v1 = body1.findStationVelocityInGround(state, station1);
-        const Vec3 v2 = body2.findStationVelocityInGround(state, station2);
+        const SpatialVec& V1 = body1.getBodyVelocity(state);
+        const SpatialVec& V2 = body2.getBodyVelocity(state);
+        const Vec3 v1 = V1[1] + V1[0] % (location-body1.getBodyOriginLocation(state));
+        const Vec3 v2 = V2[1] + V2[0] % (location-body2.getBodyOriginLocation(state));
         const Vec3 v = v1-v2;
         const Real vnormal = dot(v, normal);
         const Vec3 vtangent = v-vnormal*normal;
-        
-        // Calculate the Hunt-Crossley force.
-        
-        const Real f = fH*(1+Real(1.5)*c*vnormal);
-        if (f <= 0) 
-            return;
-
-        Vec3 force = f*normal;
-        
-        // Calculate the friction force.
-        
         const Real vslip = vtangent.norm();
-        if (vslip != 0) {
-            const bool hasStatic = (param1.staticFriction != 0 || param2.staticFriction != 0);
-            const bool hasDynamic= (param1.dynamicFriction != 0 || param2.dynamicFriction != 0);
-            const bool hasViscous = (param1.viscousFriction != 0 || param2.viscousFriction != 0);
-            const Real us = hasStatic ? 2*param1.staticFriction*param2.staticFriction/(param1.staticFriction+param2.staticFriction) : 0;
-            const Real ud = hasDynamic ? 2*param1.dynamicFriction*param2.dynamicFriction/(param1.dynamicFriction+param2.dynamicFriction) : 0;
-            const Real uv = hasViscous ? 2*param1.viscousFriction*param2.viscousFriction/(param1.viscousFriction+param2.viscousFriction) : 0;
-            const Real vrel = vslip/getTransitionVelocity();
-            const Real ffriction = f*(std::min(vrel, Real(1))*(ud+2*(us-ud)/(1+vrel*vrel))+uv*vslip);
-            force += ffriction*vtangent/vslip;
-        }
         
-        // Apply the force to the bodies.
+        // Combine the friction coefficients.
         
-        body1.applyForceToBodyPoint(state, station1, -force, bodyForces);
-        body2.applyForceToBodyPoint(state, station2, force, bodyForces);
+        const bool hasStatic = (param1.staticFriction != 0 || param2.staticFriction != 0);
+        const bool hasDynamic= (param1.dynamicFriction != 0 || param2.dynamicFriction != 0);
+        const bool hasViscous = (param1.viscousFriction != 0 || param2.viscousFriction != 0);
+        const Real us = hasStatic ? 2*param1.staticFriction*param2.staticFriction/(param1.staticFriction+param2.staticFriction) : 0;
+        const Real ud = hasDynamic ? 2*param1.dynamicFriction*param2.dynamicFriction/(param1.dynamicFriction+param2.dynamicFriction) : 0;
+        const Real uv = hasViscous ? 2*param1.viscousFriction*param2.viscousFriction/(param1.viscousFriction+param2.viscousFriction) : 0;
+
+        batch.addGroup(body1, body2);
+        batch.addPoint(Real(4./3.)*k*std::sqrt(radius*k), depth, 
+                       Real(1.5)*c, vnormal, vslip, us, ud, uv, location, 
+                       normal, vslip != 0 ? vtangent/vslip : Vec3(0));
     }
+
+    pe = calcHertzContactForces(batch, getTransitionVelocity());
+    applyContactForces(batch, state, bodyForces);
 }
 
 Real HuntCrossleyForceImpl::calcPotentialEnergy(const State& state) const {
@@ -174,6 +169,7 @@ Real HuntCrossleyForceImpl::calcPotentialEnergy(const State& state) const {
 
 void HuntCrossleyForceImpl::realizeTopology(State& state) const {
         energyCacheIndex = state.allocateCacheEntry(subsystem.getMySubsystemIndex(), Stage::Dynamics, new Value<Real>());
+        batchCacheIndex = state.allocateCacheEntry(subsystem.getMySubsystemIndex(), Stage::Dynamics, new Value<ContactForceBatch>());
 }
 
 } // namespace SimTK
@@ -55,6 +55,7 @@ private:
     Array_<Parameters,ContactSurfaceIndex>  parameters;
     Real                                    transitionVelocity;
     mutable CacheEntryIndex                 energyCacheIndex;
+    mutable CacheEntryIndex                 batchCacheIndex; // scratch space
 };
 
 class HuntCrossleyForceImpl::Parameters {
@@ -24,6 +24,8 @@
 #include "simbody/internal/common.h"
 #include "simbody/internal/ImpulseSolver.h"
 
+#include <algorithm>
+
 namespace SimTK {
 
 // These static methods assume the "NA" value is -1 and the others count up
@@ -47,6 +49,39 @@ const char* ImpulseSolver::getBndCondName(BndCond bc) {
     return BndNA<=bc&&bc<=SlipHigh ? nm[bc+1] : "UNKNOWNBndCond";
 }
 
+bool ImpulseSolver::
+solve(int                                 phase,
+      const Array_<MultiplierIndex>&      participating,
+      const SparseMatrix&                 A,
+      const Vector&                       D,
+      const Array_<MultiplierIndex>&      expanding,
+      Vector&                             piExpand,
+      Vector&                             verrStart,
+      Vector&                             verrApplied,
+      Vector&                             pi,
+      Array_<UncondRT>&                   unconditional,
+      Array_<UniContactRT>&               uniContact,
+      Array_<UniSpeedRT>&                 uniSpeed,
+      Array_<BoundedRT>&                  bounded,
+      Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+      Array_<StateLtdFrictionRT>&         stateLtdFriction
+      ) const
+{
+    return solve(phase, participating, A.toDense(), D, expanding, piExpand,
+                 verrStart, verrApplied, pi, unconditional, uniContact,
+                 uniSpeed, bounded, consLtdFriction, stateLtdFriction);
+}
+
+bool ImpulseSolver::
+solveBilateral(const Array_<MultiplierIndex>&   participating,
+               const SparseMatrix&              A,
+               const Vector&                    D,
+               const Vector&                    rhs,
+               Vector&                          pi) const
+{
+    return solveBilateral(participating, A.toDense(), D, rhs, pi);
+}
+
 void ImpulseSolver::
 dumpUniContacts(const String& msg,
                 const Array_<UniContactRT>& uniContacts) 
@@ -76,4 +111,35 @@ dumpUniContacts(const String& msg,
     printf("------------------------------\n\n");
 }
 
+//==============================================================================
+//                              SPARSE MATRIX
+//==============================================================================
+Real ImpulseSolver::SparseMatrix::operator()(int i, int j) const {
+    assert(0 <= i && i < m_size && 0 <= j && j < m_size);
+    const int* begin = m_rows.begin() + m_colStart[j];
+    const int* end   = m_rows.begin() + m_colStart[j+1];
+    const int* p = std::lower_bound(begin, end, i);
+    return p != end && *p == i ? m_values[int(p - m_rows.begin())] : Real(0);
+}
+
+// A is symmetric so we can work down the columns.
+void ImpulseSolver::SparseMatrix::multiply(const Vector& x, Vector& Ax) const {
+    assert(x.size() == m_size);
+    Ax.resize(m_size);
+    for (int i=0; i < m_size; ++i) {
+        Real sum = 0;
+        for (int k=m_colStart[i]; k < m_colStart[i+1]; ++k)
+            sum += m_values[k]*x[m_rows[k]];
+        Ax[i] = sum;
+    }
+}
+
+Matrix ImpulseSolver::SparseMatrix::toDense() const {
+    Matrix A(m_size, m_size, Real(0));
+    for (int j=0; j < m_size; ++j)
+        for (int k=m_colStart[j]; k < m_colStart[j+1]; ++k)
+            A(m_rows[k], j) = m_values[k];
+    return A;
+}
+
 } // namespace SimTK
\ No newline at end of file
@@ -0,0 +1,159 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+#include "IncrementalSweepAndPrune.h"
+
+#include <algorithm>
+
+using namespace SimTK;
+
+void IncrementalSweepAndPrune::update
+   (const Array_<Vec3>& lo, const Array_<Vec3>& hi,
+    Array_<Pair>* added, Array_<Pair>* removed)
+{
+    assert(lo.size() == hi.size());
+
+    // NaNs can't be sorted. Drop everything and start over once the boxes
+    // are sensible again.
+    for (unsigned i=0; i < lo.size(); ++i)
+        if (lo[i].isNaN() || hi[i].isNaN()) {
+            if (removed)
+                removed->insert(removed->end(), pairs.begin(), pairs.end());
+            clear();
+            numObjects = -1;
+            return;
+        }
+
+    if ((int)lo.size() != numObjects) {
+        if (removed && numObjects >= 0)
+            removed->insert(removed->end(), pairs.begin(), pairs.end());
+        rebuild(lo, hi, added);
+        return;
+    }
+
+    numSwaps = 0;
+    for (int k=0; k < 3; ++k) {
+        Array_<Endpoint>& axis = endpoints[k];
+        const int n = (int)axis.size();
+
+        // Refresh the endpoint values in their old order.
+        for (int i=0; i < n; ++i) {
+            Endpoint& e = axis[i];
+            e.value = e.isMax ? hi[e.object][k] : lo[e.object][k];
+        }
+
+        // Insertion sort. Each time an endpoint moves left past one that
+        // belongs to another object, that pair's overlap along this axis
+        // may have changed.
+        for (int i=1; i < n; ++i) {
+            const Endpoint e = axis[i];
+            int j = i;
+            for (; j > 0 && precedes(e, axis[j-1]); --j) {
+                const Endpoint& f = axis[j-1];
+                if (e.object != f.object) {
+                    if (!e.isMax && f.isMax) {
+                        // Now overlapping along this axis; maybe on all.
+                        if (overlaps(lo, hi, e.object, f.object)) {
+                            const Pair p = makePair(e.object, f.object);
+                            if (pairs.insert(p).second && added)
+                                added->push_back(p);
+                        }
+                    } else if (e.isMax && !f.isMax) {
+                        // Separated along this axis.
+                        const Pair p = makePair(e.object, f.object);
+                        if (pairs.erase(p) && removed)
+                            removed->push_back(p);
+                    }
+                }
+                axis[j] = f;
+            }
+            axis[j] = e;
+            numSwaps += i-j;
+        }
+    }
+}
+
+// Sort from scratch and find the overlapping pairs by sweeping along the x
+// axis, testing each object against those whose x intervals are still open.
+void IncrementalSweepAndPrune::rebuild
+   (const Array_<Vec3>& lo, const Array_<Vec3>& hi, Array_<Pair>* added)
+{
+    numObjects = (int)lo.size();
+    numSwaps = 0;
+    pairs.clear();
+    for (int k=0; k < 3; ++k) {
+        Array_<Endpoint>& axis = endpoints[k];
+        axis.resize(2*numObjects);
+        for (int i=0; i < numObjects; ++i) {
+            Endpoint& emin = axis[2*i];
+            Endpoint& emax = axis[2*i+1];
+            emin.value = lo[i][k]; emin.object = i; emin.isMax = false;
+            emax.value = hi[i][k]; emax.object = i; emax.isMax = true;
+        }
+        std::sort(axis.begin(), axis.end(), precedes);
+    }
+
+    Array_<int> open;                   // objects whose x interval is open
+    Array_<int> where(numObjects, -1);  // position of each in open
+    const Array_<Endpoint>& axis = endpoints[0];
+    for (unsigned i=0; i < axis.size(); ++i) {
+        const int obj = axis[i].object;
+        if (axis[i].isMax) { // close; swap the last open object into its slot
+            const int slot = where[obj];
+            open[slot] = open.back();
+            where[open[slot]] = slot;
+            open.pop_back();
+            continue;
+        }
+        for (unsigned j=0; j < open.size(); ++j)
+            if (overlaps(lo, hi, obj, open[j]))
+                pairs.insert(makePair(obj, open[j]));
+        where[obj] = (int)open.size();
+        open.push_back(obj);
+    }
+
+    if (added)
+        added->insert(added->end(), pairs.begin(), pairs.end());
+}
+
+bool IncrementalSweepAndPrune::isValid
+   (const Array_<Vec3>& lo, const Array_<Vec3>& hi) const
+{
+    if ((int)lo.size() != numObjects)
+        return false;
+    for (int k=0; k < 3; ++k) {
+        const Array_<Endpoint>& axis = endpoints[k];
+        if ((int)axis.size() != 2*numObjects)
+            return false;
+        for (unsigned i=1; i < axis.size(); ++i)
+            if (precedes(axis[i], axis[i-1]))
+                return false;
+    }
+    std::set<Pair> expected;
+    for (int a=0; a < numObjects; ++a)
+        for (int b=a+1; b < numObjects; ++b)
+            if (overlaps(lo, hi, a, b))
+                expected.insert(Pair(a,b));
+    return expected == pairs;
+}
@@ -0,0 +1,115 @@
+#ifndef SimTK_SIMBODY_INCREMENTAL_SWEEP_AND_PRUNE_H_
+#define SimTK_SIMBODY_INCREMENTAL_SWEEP_AND_PRUNE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKcommon.h"
+
+#include <set>
+#include <utility>
+
+namespace SimTK {
+
+//==============================================================================
+//                        INCREMENTAL SWEEP AND PRUNE
+//==============================================================================
+// Broad phase contact detection among a fixed set of objects by keeping the
+// endpoints of their axis-aligned bounding boxes sorted along each of the
+// three axes, and maintaining the set of pairs whose boxes overlap. Objects
+// move only a little between one evaluation and the next, so the endpoint
+// lists are nearly sorted already; we repair them with insertion sort, which
+// is O(n) plus the number of swaps. A swap of one object's min endpoint with
+// another's max endpoint is the only way an overlap can begin or end, so we
+// update the pair set right there and report the change.
+//
+// The whole thing is copyable so that it can be kept in a State cache entry.
+// Objects are identified by their position in the arrays passed to update().
+class IncrementalSweepAndPrune {
+public:
+    // An overlapping pair of objects; always (lower,higher).
+    typedef std::pair<int,int> Pair;
+
+    IncrementalSweepAndPrune() {clear();}
+
+    void clear() {
+        for (int k=0; k < 3; ++k) endpoints[k].clear();
+        pairs.clear();
+        numObjects = 0;
+        numSwaps = 0;
+    }
+
+    // Supply the current boxes for all the objects. If the number of objects
+    // differs from the last call (in particular, the first time), everything
+    // is sorted and the pairs found from scratch; otherwise the previous
+    // order is repaired incrementally. Pairs that began or stopped
+    // overlapping are appended to added and removed if those are non-null.
+    // If any box contains a NaN, all pairs are removed and the next call
+    // starts from scratch.
+    void update(const Array_<Vec3>& lo, const Array_<Vec3>& hi,
+                Array_<Pair>* added, Array_<Pair>* removed);
+
+    // The pairs whose boxes overlapped at the last update(), in order.
+    const std::set<Pair>& getOverlappingPairs() const {return pairs;}
+
+    int getNumObjects() const {return numObjects;}
+    // Endpoint swaps done by the last update(); a measure of coherence.
+    long long getNumSwaps() const {return numSwaps;}
+
+    // Check the endpoint order and the pair set against a brute force
+    // computation from the given boxes; for testing and debugging.
+    bool isValid(const Array_<Vec3>& lo, const Array_<Vec3>& hi) const;
+
+private:
+    struct Endpoint {
+        Real    value;
+        int     object;
+        bool    isMax;
+    };
+    // Ties sort min endpoints first so that boxes that just touch count as
+    // overlapping.
+    static bool precedes(const Endpoint& e, const Endpoint& f) {
+        return e.value < f.value
+            || (e.value == f.value && !e.isMax && f.isMax);
+    }
+    static bool overlaps(const Array_<Vec3>& lo, const Array_<Vec3>& hi,
+                         int a, int b) {
+        for (int k=0; k < 3; ++k)
+            if (hi[a][k] < lo[b][k] || hi[b][k] < lo[a][k]) return false;
+        return true;
+    }
+    static Pair makePair(int a, int b)
+    {   return a < b ? Pair(a,b) : Pair(b,a); }
+
+    void rebuild(const Array_<Vec3>& lo, const Array_<Vec3>& hi,
+                 Array_<Pair>* added);
+
+    Array_<Endpoint>    endpoints[3];
+    std::set<Pair>      pairs;
+    int                 numObjects;
+    long long           numSwaps;
+};
+
+} // namespace SimTK
+
+#endif // SimTK_SIMBODY_INCREMENTAL_SWEEP_AND_PRUNE_H_
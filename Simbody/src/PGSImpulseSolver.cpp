@@ -25,6 +25,8 @@
 #include "simbody/internal/ImpulseSolver.h"
 #include "simbody/internal/PGSImpulseSolver.h"
 
+#include "ContactParallelLoop.h"
+
 #include <algorithm>
 
 #include <iostream>
@@ -101,11 +103,51 @@ void doRowSums(const Array_<int>& columns, // these are MultiplierIndex ints
     }
 }
 
+// Sparse versions of the above. A is symmetric so we can work down column
+// "row" instead of along the row. pi is nonzero only for participating
+// multipliers so we don't need to check the columns list; summing only over
+// the structural nonzeros of A gives the same result. The index lists are
+// taken as they come so that the caller's lists aren't copied.
+Real doRowSum(const Array_<MultiplierIndex>&     columns,
+              const MultiplierIndex&             row,
+              const ImpulseSolver::SparseMatrix& A,
+              const Vector&                      D,
+              const Vector&                      pi)
+{
+    Real rowSum = 0;
+    for (int k=A.getColumnBegin(row); k < A.getColumnEnd(row); ++k)
+        rowSum += A.getEntryValue(k)*pi[A.getEntryRow(k)];
+    if (D.size())
+        rowSum += D[row]*pi[row];
+    return rowSum;
+}
+
+template <class Columns, class Rows>
+void doRowSums(const Columns&                     columns,
+               const Rows&                        rows,
+               const ImpulseSolver::SparseMatrix& A, 
+               const Vector&                      D,
+               const Vector&                      pi,
+               Array_<Real>&                      sums)
+{
+    sums.resize(rows.size());
+    for (unsigned i=0; i<rows.size(); ++i) {
+        const int row = rows[i];
+        Real rowSum = 0;
+        for (int k=A.getColumnBegin(row); k < A.getColumnEnd(row); ++k)
+            rowSum += A.getEntryValue(k)*pi[A.getEntryRow(k)];
+        if (D.size())
+            rowSum += D[row]*pi[row];
+        sums[i] = rowSum;
+    }
+}
+
 // Given a rowSum, update one element of pi and return the squared error.
 // If the corresponding diagonal of A is nonpositive, we will quietly skip
 // the update.
+template <class AMatrix>
 inline Real doUpdate(const MultiplierIndex& row,
-                     const Matrix&          A,
+                     const AMatrix&         A,
                      const Vector&          D,
                      const Vector&          rhs,
                      const Real&            SOR, // successive over relaxation
@@ -122,8 +164,9 @@ inline Real doUpdate(const MultiplierIndex& row,
 
 // Same but now we're doing multiple row updates and return the sum of the
 // squared errors for those rows.
+template <class AMatrix>
 Real doUpdates(const Array_<int>& rows, // These are MultiplierIndex ints
-               const Matrix&                  A,
+               const AMatrix&                 A,
                const Vector&                  D,
                const Vector&                  rhs,
                const Real&                    SOR,
@@ -160,6 +203,45 @@ static Real multRowTimesSparseCol(const Matrix& A, MultiplierIndex row,
     return result;
 }
 
+// Calculate the full column Ax=A*sparseCol, where sparseCol has only the
+// indicated non-zero entries. Useful for A*piExpand.
+void multSparseCol(const Matrix& A, const Array_<MultiplierIndex>& nonZero,
+                   const Vector& sparseCol, Vector& Ax) 
+{
+    const int m = A.nrow();
+    Ax.resize(m);
+    for (MultiplierIndex mx(0); mx < m; ++mx)
+        Ax[mx] = multRowTimesSparseCol(A,mx,nonZero,sparseCol);
+}
+
+void multSparseCol(const ImpulseSolver::SparseMatrix& A, 
+                   const Array_<MultiplierIndex>& nonZero,
+                   const Vector& sparseCol, Vector& Ax) 
+{
+    Ax.resize(A.nrow()); Ax.setToZero();
+    for (unsigned nz(0); nz < nonZero.size(); ++nz) {
+        const MultiplierIndex mx = nonZero[nz];
+        for (int k=A.getColumnBegin(mx); k < A.getColumnEnd(mx); ++k)
+            Ax[A.getEntryRow(k)] += A.getEntryValue(k) * sparseCol[mx];
+    }
+}
+
+// Calculate verr -= A*pi.
+void subtractProduct(const Matrix& A, const Vector& pi, Vector& verr) {
+    verr -= A*pi;
+}
+void subtractProduct(const ImpulseSolver::SparseMatrix& A, const Vector& pi,
+                     Vector& verr) {
+    Vector Api;
+    A.multiply(pi, Api);
+    verr -= Api;
+}
+
+// For debugging output.
+inline const Matrix& denseOf(const Matrix& A) {return A;}
+inline Matrix denseOf(const ImpulseSolver::SparseMatrix& A) 
+{   return A.toDense(); }
+
 /** Given a unilateral multiplier pi and its sign convention, ensure that
 sign*pi<=0. Return true if any change is made. **/
 inline ImpulseSolver::UniCond boundUnilateral(Real sign, Real& pi) {
@@ -212,6 +294,169 @@ boundFriction(Real mu,
     for (unsigned i=0; i<IF.size(); ++i) pi[IF[i]] *= scale;
     return ImpulseSolver::Sliding;
 }
+
+// The parallel sweeps work on a sparse A so that each contact's update reads
+// only the multipliers it is coupled to; a dense A is copied.
+inline const ImpulseSolver::SparseMatrix& 
+sparseOf(const ImpulseSolver::SparseMatrix& A, ImpulseSolver::SparseMatrix&)
+{   return A; }
+const ImpulseSolver::SparseMatrix& 
+sparseOf(const Matrix& A, ImpulseSolver::SparseMatrix& S) {
+    const int m = A.nrow();
+    S.clear(m);
+    for (int j=0; j < m; ++j) {
+        for (int i=0; i < m; ++i)
+            if (A(i,j) != 0) S.appendEntry(i, A(i,j));
+        S.finishColumn();
+    }
+    return S;
+}
+
+// The multipliers that PGS updates for a unilateral contact.
+void getSweptMultipliers(const ImpulseSolver::UniContactRT& rt,
+                         Array_<MultiplierIndex>&           mults) {
+    mults.clear();
+    if (rt.m_type == ImpulseSolver::Observing)
+        return;
+    if (rt.m_type == ImpulseSolver::Participating)
+        mults.push_back(rt.m_Nk);
+    for (unsigned i=0; i < rt.m_Fk.size(); ++i)
+        mults.push_back(rt.m_Fk[i]);
+}
+
+// Adapts a parallel sweep over the unilateral contacts for runContactLoop().
+// Updating contact k writes only k's own multipliers and slots here, and 
+// reads only the multipliers of contacts coupled to k through A. In a Colored
+// sweep none of those are being updated at the same time; in a Jacobi sweep
+// all the row sums are formed before any multiplier changes. Either way the 
+// result doesn't depend on the number of threads. The squared errors are 
+// summed serially afterwards, in contact order.
+class ContactSweep {
+public:
+    enum Stage {Normals, Friction, RowSums, Updates};
+
+    ContactSweep(const ImpulseSolver::SparseMatrix&     A,
+                 const Vector&                          D,
+                 const Vector&                          rhs,
+                 const Vector&                          piExpand,
+                 Array_<ImpulseSolver::UniContactRT>&   uniContact,
+                 Vector&                                pi,
+                 int                                    nContacts)
+    :   A(A), D(D), rhs(rhs), piExpand(piExpand), uniContact(uniContact), 
+        pi(pi), er2(nContacts, Vec2(0)), rowSums(nContacts), 
+        stage(Normals), contacts(0), sor(1) {}
+
+    // One iteration. Colored: all normals a color at a time, then all the
+    // friction. Jacobi: every contact at once from the previous iterate.
+    void iterate(ParallelExecutor& executor, bool jacobi, 
+                 const Array_<Array_<int> >& colors, 
+                 const Array_<int>& allContacts, Real SOR) {
+        if (jacobi) {
+            const Real relax = SOR / std::max((int)colors.size(), 1);
+            run(executor, RowSums, allContacts, relax);
+            run(executor, Updates, allContacts, relax);
+            return;
+        }
+        for (unsigned c=0; c < colors.size(); ++c)
+            run(executor, Normals, colors[c], SOR);
+        for (unsigned c=0; c < colors.size(); ++c)
+            run(executor, Friction, colors[c], SOR);
+    }
+
+    // Same meaning as the sums in the serial sweep.
+    void sumErrors(Real& sum2all, Real& sum2enf) const {
+        for (unsigned k=0; k < er2.size(); ++k) {
+            const ImpulseSolver::UniContactRT& rt = uniContact[k];
+            if (rt.m_type == ImpulseSolver::Observing)
+                continue;
+            sum2all += er2[k][0] + er2[k][1];
+            if (   rt.m_type == ImpulseSolver::Participating 
+                && rt.m_contactCond == ImpulseSolver::UniActive)
+                sum2enf += er2[k][0];
+            if (rt.hasFriction() && rt.m_frictionCond == ImpulseSolver::Rolling)
+                sum2enf += er2[k][1];
+        }
+    }
+
+    void operator()(int i) {
+        const int k = (*contacts)[i];
+        ImpulseSolver::UniContactRT& rt = uniContact[k];
+        const bool normal = (rt.m_type == ImpulseSolver::Participating);
+        const Array_<MultiplierIndex>& Fk = rt.m_Fk;
+        Array_<Real>& sums = rowSums[k]; // normal first, then friction
+        switch (stage) {
+        case Normals:
+            if (normal) updateNormal(k, calcRowSum(rt.m_Nk));
+            break;
+        case Friction:
+            if (rt.hasFriction()) {
+                sums.resize(1+Fk.size());
+                for (unsigned f=0; f < Fk.size(); ++f)
+                    sums[1+f] = calcRowSum(Fk[f]);
+                updateFriction(k);
+            }
+            break;
+        case RowSums:
+            sums.resize(1+Fk.size());
+            sums[0] = normal ? calcRowSum(rt.m_Nk) : Real(0);
+            for (unsigned f=0; f < Fk.size(); ++f)
+                sums[1+f] = calcRowSum(Fk[f]);
+            break;
+        case Updates:
+            if (normal) updateNormal(k, sums[0]);
+            if (rt.hasFriction()) updateFriction(k);
+            break;
+        }
+    }
+
+private:
+    void run(ParallelExecutor& executor, Stage s, const Array_<int>& which,
+             Real relax) {
+        stage = s; contacts = &which; sor = relax;
+        const int n = (int)which.size();
+        runContactLoop(executor, n, n >= MinContactsForThreads, *this);
+    }
+
+    // A is symmetric so we can work down the column.
+    Real calcRowSum(MultiplierIndex row) const {
+        Real rowSum = 0;
+        for (int e=A.getColumnBegin(row); e < A.getColumnEnd(row); ++e)
+            rowSum += A.getEntryValue(e)*pi[A.getEntryRow(e)];
+        if (D.size())
+            rowSum += D[row]*pi[row];
+        return rowSum;
+    }
+
+    void updateNormal(int k, Real rowSum) {
+        ImpulseSolver::UniContactRT& rt = uniContact[k];
+        er2[k][0] = doUpdate(rt.m_Nk,A,D,rhs,sor,rowSum,pi);
+        rt.m_contactCond = boundUnilateral(rt.m_sign, pi[rt.m_Nk]);
+    }
+
+    // Uses the friction row sums already in rowSums[k][1..].
+    void updateFriction(int k) {
+        ImpulseSolver::UniContactRT& rt = uniContact[k];
+        const Array_<MultiplierIndex>& Fk = rt.m_Fk;
+        Real e2 = 0;
+        for (unsigned f=0; f < Fk.size(); ++f)
+            e2 += doUpdate(Fk[f],A,D,rhs,sor,rowSums[k][1+f],pi);
+        er2[k][1] = e2;
+        const Real N = std::abs(pi[rt.m_Nk] + piExpand[rt.m_Nk]);
+        rt.m_frictionCond = boundVector(rt.m_effMu*N, Fk, pi);
+    }
+
+    const ImpulseSolver::SparseMatrix&      A;
+    const Vector&                           D;
+    const Vector&                           rhs;
+    const Vector&                           piExpand;
+    Array_<ImpulseSolver::UniContactRT>&    uniContact;
+    Vector&                                 pi;
+    Array_<Vec2>                            er2; // normal, friction
+    Array_<Array_<Real> >                   rowSums;
+    Stage                                   stage;
+    const Array_<int>*                      contacts;
+    Real                                    sor;
+};
 }
 
 namespace SimTK {
@@ -280,13 +525,122 @@ Implicitly, complementarity conditions must hold:
 */
 
 
+//------------------------------------------------------------------------------
+//                           NUMBER OF THREADS
+//------------------------------------------------------------------------------
+void PGSImpulseSolver::setNumberOfThreads(unsigned numThreads) {
+    SimTK_APIARGCHECK_ALWAYS(numThreads > 0, "PGSImpulseSolver",
+        "setNumberOfThreads", "Number of threads must be positive.");
+    m_executor = new ParallelExecutor(numThreads);
+}
+
+int PGSImpulseSolver::getNumberOfThreads() const 
+{   return m_executor->getMaxThreads(); }
+
+
+//------------------------------------------------------------------------------
+//                            COLOR CONTACTS
+//------------------------------------------------------------------------------
+// Greedy coloring in contact order: each contact gets the lowest color not 
+// already used by a contact it is coupled to. That takes at most one more 
+// color than the largest number of contacts coupled to any one contact.
+void PGSImpulseSolver::
+colorContacts(const SparseMatrix&           A,
+              const Array_<UniContactRT>&   uniContact,
+              Array_<Array_<int> >&         colors) const
+{
+    const int nContacts = (int)uniContact.size();
+    Array_<MultiplierIndex> mults;
+
+    // Which contact's update sets each multiplier, if any.
+    Array_<int,MultiplierIndex> owner(A.nrow(), -1);
+    for (int k=0; k < nContacts; ++k) {
+        getSweptMultipliers(uniContact[k], mults);
+        for (unsigned i=0; i < mults.size(); ++i)
+            owner[mults[i]] = k;
+    }
+
+    Array_<int> colorOf(nContacts, -1);
+    Array_<int> usedBy; // usedBy[c]==k: a neighbor of contact k has color c
+    colors.clear();
+    for (int k=0; k < nContacts; ++k) {
+        getSweptMultipliers(uniContact[k], mults);
+        if (mults.empty())
+            continue;
+        for (unsigned i=0; i < mults.size(); ++i)
+            for (int e=A.getColumnBegin(mults[i]); 
+                 e < A.getColumnEnd(mults[i]); ++e) {
+                const int c = owner[MultiplierIndex(A.getEntryRow(e))];
+                if (c >= 0 && colorOf[c] >= 0)
+                    usedBy[colorOf[c]] = k;
+            }
+        int color = 0;
+        while (color < (int)colors.size() && usedBy[color] == k)
+            ++color;
+        if (color == (int)colors.size()) {
+            colors.push_back();
+            usedBy.push_back(-1);
+        }
+        colorOf[k] = color;
+        colors[color].push_back(k);
+    }
+}
+
+
 //------------------------------------------------------------------------------
 //                                 SOLVE
 //------------------------------------------------------------------------------
 bool PGSImpulseSolver::
 solve(int                                 phase,
+      const Array_<MultiplierIndex>&      participating,
+      const Matrix&                       A,
+      const Vector&                       D,
+      const Array_<MultiplierIndex>&      expanding,
+      Vector&                             piExpand,
+      Vector&                             verrStart,
+      Vector&                             verrApplied,
+      Vector&                             pi,
+      Array_<UncondRT>&                   unconditional,
+      Array_<UniContactRT>&               uniContact,
+      Array_<UniSpeedRT>&                 uniSpeed,
+      Array_<BoundedRT>&                  bounded,
+      Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+      Array_<StateLtdFrictionRT>&         stateLtdFriction
+      ) const 
+{
+    return solveImpl(phase, participating, A, D, expanding, piExpand,
+                     verrStart, verrApplied, pi, unconditional, uniContact,
+                     uniSpeed, bounded, consLtdFriction, stateLtdFriction);
+}
+
+bool PGSImpulseSolver::
+solve(int                                 phase,
+      const Array_<MultiplierIndex>&      participating,
+      const SparseMatrix&                 A,
+      const Vector&                       D,
+      const Array_<MultiplierIndex>&      expanding,
+      Vector&                             piExpand,
+      Vector&                             verrStart,
+      Vector&                             verrApplied,
+      Vector&                             pi,
+      Array_<UncondRT>&                   unconditional,
+      Array_<UniContactRT>&               uniContact,
+      Array_<UniSpeedRT>&                 uniSpeed,
+      Array_<BoundedRT>&                  bounded,
+      Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+      Array_<StateLtdFrictionRT>&         stateLtdFriction
+      ) const 
+{
+    return solveImpl(phase, participating, A, D, expanding, piExpand,
+                     verrStart, verrApplied, pi, unconditional, uniContact,
+                     uniSpeed, bounded, consLtdFriction, stateLtdFriction);
+}
+
+template <class AMatrix>
+bool PGSImpulseSolver::
+solveImpl(int                                 phase,
       const Array_<MultiplierIndex>&      participating, // p<=m of these 
-      const Matrix&                       A,     // m X m, symmetric
+      const AMatrix&                      A,     // m X m, symmetric
       const Vector&                       D,     // m, diag >= 0 added to A
       const Array_<MultiplierIndex>&      expanding,
       Vector&                             piExpand,   // m
@@ -306,8 +660,8 @@ solve(int                                 phase,
     ++m_nSolves[phase];
 
 #ifndef NDEBUG
-   {FactorQTZ fac(A);
-    cout << "A=" << A; cout << "D=" << D; 
+   {FactorQTZ fac(denseOf(A));
+    cout << "A=" << denseOf(A); cout << "D=" << D; 
     cout << "verrStart=" << verrStart << endl;
     cout << "verrApplied=" << verrApplied << endl;
     cout << "expanding mx=" << expanding << endl;
@@ -317,7 +671,7 @@ solve(int                                 phase,
     if (verrApplied.size()) verrDbg += verrApplied;
     fac.solve(verrDbg, x); 
     cout << "x=" << x << endl;
-    cout << "resid=" << A*x-verrDbg << endl;}
+    cout << "resid=" << denseOf(A)*x-verrDbg << endl;}
 #endif
 
     const int m=A.nrow();
@@ -330,8 +684,17 @@ solve(int                                 phase,
     const int nx = (int)expanding.size();
     assert(p<=m); assert(nx<=m);
     
-    pi.resize(m);
-    pi.setToZero(); // Use this for piUnknown
+    // Start the participating multipliers from the caller's guess if there
+    // is one; everything else starts at zero.
+    if (m_useInitialGuess && pi.size()==m) {
+        const Vector guess = pi;
+        pi.setToZero();
+        for (int i=0; i < p; ++i)
+            pi[participating[i]] = guess[participating[i]];
+    } else {
+        pi.resize(m);
+        pi.setToZero(); // Use this for piUnknown
+    }
 
     // If there are applied forces, add them to the rhs.
     if (verrApplied.size()) 
@@ -339,11 +702,12 @@ solve(int                                 phase,
 
     // Move expansion impulse to RHS. We will always apply the full expansion
     // impulse in one interval in this solver.
-    if (nx) 
-        for (MultiplierIndex mx(0); mx < m; ++mx) {
-            verrStart[mx] -= multRowTimesSparseCol(A,mx,expanding,piExpand)
-                             + D[mx]*piExpand[mx];
-        }
+    if (nx) {
+        Vector verrExpand;
+        multSparseCol(A,expanding,piExpand,verrExpand);
+        for (MultiplierIndex mx(0); mx < m; ++mx)
+            verrStart[mx] -= verrExpand[mx] + D[mx]*piExpand[mx];
+    }
 
     // Now rhs = verrStart + verrApplied - [A+D]*piExpand.
     #ifndef NDEBUG
@@ -388,6 +752,27 @@ solve(int                                 phase,
         return true;
     }
 
+    // The parallel sweeps know only about unilateral contacts; if there is
+    // anything else we sweep serially.
+    const bool sweepInParallel = m_sweepMode != Serial 
+        && mUncond == 0 && mUniSpeed == 0 && mBounded == 0 
+        && mStateLtd == 0 && mConsLtd == 0;
+    SparseMatrix sparseCopy;
+    const SparseMatrix& sparseA = 
+        sweepInParallel ? sparseOf(A, sparseCopy) : sparseCopy;
+    Array_<Array_<int> > colors;
+    Array_<int> allContacts; // non-observing, in order
+    if (sweepInParallel) {
+        colorContacts(sparseA, uniContact, colors);
+        m_numColors = (int)colors.size();
+        for (int k=0; k < mUniCont; ++k)
+            if (uniContact[k].m_type != Observing)
+                allContacts.push_back(k);
+    }
+    ContactSweep sweep(sparseA, D, verrStart, piExpand, uniContact, pi,
+                       sweepInParallel ? mUniCont : 0);
+    const int mSerialUniCont = sweepInParallel ? 0 : mUniCont;
+
     // Track total error for all included equations, and the error for just
     // those equations that are being enforced.
     bool converged = false;
@@ -408,8 +793,15 @@ solve(int                                 phase,
             sum2all += er2; sum2enf += er2;
         }
 
+        // UNILATERAL CONTACTS IN PARALLEL. These are the only constraints.
+        if (sweepInParallel) {
+            sweep.iterate(*m_executor, m_sweepMode == Jacobi, colors, 
+                          allContacts, sor);
+            sweep.sumErrors(sum2all, sum2enf);
+        }
+
         // UNILATERAL CONTACT NORMALS. Do all of these before any friction.
-        for (int k=0; k < mUniCont; ++k) {
+        for (int k=0; k < mSerialUniCont; ++k) {
             UniContactRT& rt = uniContact[k];
             if (rt.m_type != Participating)
                 continue;
@@ -424,7 +816,7 @@ solve(int                                 phase,
 
         // UNILATERAL CONTACT FRICTION. These are limited by the normal
         // multiplier or by a known normal force during Poisson expansion.
-        for (int k=0; k < mUniCont; ++k) {
+        for (int k=0; k < mSerialUniCont; ++k) {
             UniContactRT& rt = uniContact[k];
             if (rt.m_type == Observing || !rt.hasFriction())
                 continue;
@@ -519,7 +911,7 @@ solve(int                                 phase,
         ++m_nFail[phase];
     }
 
-    verrStart -= A*pi;
+    subtractProduct(A, pi, verrStart);
     verrStart -= D.elementwiseMultiply(pi);
     #ifndef NDEBUG
     cout << "FINAL@" << its << " pi=" << pi << " verr=" << verrStart
@@ -534,8 +926,33 @@ solve(int                                 phase,
 //------------------------------------------------------------------------------
 bool PGSImpulseSolver::
 solveBilateral
+   (const Array_<MultiplierIndex>&  participating,
+    const Matrix&                   A,
+    const Vector&                   D,
+    const Vector&                   rhs,
+    Vector&                         pi
+    ) const
+{
+    return solveBilateralImpl(participating, A, D, rhs, pi);
+}
+
+bool PGSImpulseSolver::
+solveBilateral
+   (const Array_<MultiplierIndex>&  participating,
+    const SparseMatrix&             A,
+    const Vector&                   D,
+    const Vector&                   rhs,
+    Vector&                         pi
+    ) const
+{
+    return solveBilateralImpl(participating, A, D, rhs, pi);
+}
+
+template <class AMatrix>
+bool PGSImpulseSolver::
+solveBilateralImpl
    (const Array_<MultiplierIndex>&  participating, // p<=m of these 
-    const Matrix&                   A,     // m X m, symmetric
+    const AMatrix&                  A,     // m X m, symmetric
     const Vector&                   D,     // m, diag>=0 added to A
     const Vector&                   rhs,   // m, RHS
     Vector&                         pi     // m, unknown result
@@ -617,13 +1034,15 @@ solveBilateral
     }
 
     #ifndef NDEBUG
-    cout << "A=" << A;
+    const Matrix Adense = denseOf(A);
+    cout << "A=" << Adense;
     cout << "D=" << D << endl;
     cout << "rhs=" << rhs << endl;
     cout << "active=" << participating << endl;
     cout << "-> pi=" << pi << endl;
-    if (D.size()) cout << "resid=" << A*pi+D.elementwiseMultiply(pi)-rhs << endl;
-    else cout << "resid=" << A*pi-rhs << endl;
+    if (D.size()) 
+        cout << "resid=" << Adense*pi+D.elementwiseMultiply(pi)-rhs << endl;
+    else cout << "resid=" << Adense*pi-rhs << endl;
     #endif
     SimTK_DEBUG("--------------------------------\n");
     return converged;
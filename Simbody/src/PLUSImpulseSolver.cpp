@@ -41,6 +41,7 @@ namespace {
 // column containing only active entries. Useful for A[r]*piActive.
 static Real multRowTimesActiveCol(const Matrix& A, MultiplierIndex row, 
            const Array_<MultiplierIndex,PLUSImpulseSolver::ActiveIndex>& active,
+           const Array_<PLUSImpulseSolver::ActiveIndex,MultiplierIndex>&, 
            const Vector& colActive) 
 {
     const RowVectorView Ar = A[row];
@@ -50,6 +51,24 @@ static Real multRowTimesActiveCol(const Matrix& A, MultiplierIndex row,
     return result;
 }
 
+// Sparse version. A is symmetric so we work down column "row" and use 
+// mult2active to pick out the active entries.
+static Real multRowTimesActiveCol
+   (const ImpulseSolver::SparseMatrix& A, MultiplierIndex row, 
+    const Array_<MultiplierIndex,PLUSImpulseSolver::ActiveIndex>&,
+    const Array_<PLUSImpulseSolver::ActiveIndex,MultiplierIndex>& mult2active,
+    const Vector& colActive) 
+{
+    Real result = 0;
+    for (int k=A.getColumnBegin(row); k < A.getColumnEnd(row); ++k) {
+        const PLUSImpulseSolver::ActiveIndex ax = 
+            mult2active[MultiplierIndex(A.getEntryRow(k))];
+        if (ax.isValid())
+            result += A.getEntryValue(k) * colActive[ax];
+    }
+    return result;
+}
+
 // Multiply the active entries of a row of the full matrix A (mXm) by a sparse,
 // full-length (m) column containing only the indicated non-zero entries. 
 // Useful for A[r]*piExpand.
@@ -66,6 +85,73 @@ static Real multRowTimesSparseCol(const Matrix& A, MultiplierIndex row,
     return result;
 }
 
+// Calculate the full column Ax=A*sparseCol, where sparseCol has only the
+// indicated non-zero entries. Useful for A*piExpand.
+static void multSparseCol(const Matrix& A, 
+                          const Array_<MultiplierIndex>& nonZero,
+                          const Vector& sparseCol, Vector& Ax) 
+{
+    const int m = A.nrow();
+    Ax.resize(m);
+    for (MultiplierIndex mx(0); mx < m; ++mx)
+        Ax[mx] = multRowTimesSparseCol(A,mx,nonZero,sparseCol);
+}
+
+static void multSparseCol(const ImpulseSolver::SparseMatrix& A, 
+                          const Array_<MultiplierIndex>& nonZero,
+                          const Vector& sparseCol, Vector& Ax) 
+{
+    Ax.resize(A.nrow()); Ax.setToZero();
+    for (unsigned nz(0); nz < nonZero.size(); ++nz) {
+        const MultiplierIndex mx = nonZero[nz];
+        for (int k=A.getColumnBegin(mx); k < A.getColumnEnd(mx); ++k)
+            Ax[A.getEntryRow(k)] += A.getEntryValue(k) * sparseCol[mx];
+    }
+}
+
+// Copy the rows and columns of A listed in active into the square matrix
+// Aactive; mult2active is the inverse of the active mapping.
+static void copyActiveBlock
+   (const Matrix& A,
+    const Array_<MultiplierIndex,PLUSImpulseSolver::ActiveIndex>& active,
+    const Array_<PLUSImpulseSolver::ActiveIndex,MultiplierIndex>&,
+    Matrix& Aactive)
+{
+    const int na = active.size();
+    Aactive.resize(na,na);
+    for (PLUSImpulseSolver::ActiveIndex aj(0); aj < na; ++aj) {
+        const MultiplierIndex mj = active[aj];
+        for (PLUSImpulseSolver::ActiveIndex ai(0); ai < na; ++ai) {
+            const MultiplierIndex mi = active[ai];
+            Aactive(ai,aj) = A(mi,mj);
+        }
+    }
+}
+
+static void copyActiveBlock
+   (const ImpulseSolver::SparseMatrix& A,
+    const Array_<MultiplierIndex,PLUSImpulseSolver::ActiveIndex>& active,
+    const Array_<PLUSImpulseSolver::ActiveIndex,MultiplierIndex>& mult2active,
+    Matrix& Aactive)
+{
+    const int na = active.size();
+    Aactive.resize(na,na); Aactive.setToZero();
+    for (PLUSImpulseSolver::ActiveIndex aj(0); aj < na; ++aj) {
+        const MultiplierIndex mj = active[aj];
+        for (int k=A.getColumnBegin(mj); k < A.getColumnEnd(mj); ++k) {
+            const PLUSImpulseSolver::ActiveIndex ai = 
+                mult2active[MultiplierIndex(A.getEntryRow(k))];
+            if (ai.isValid())
+                Aactive(ai,aj) = A.getEntryValue(k);
+        }
+    }
+}
+
+// For debugging output.
+inline const Matrix& denseOf(const Matrix& A) {return A;}
+inline Matrix denseOf(const ImpulseSolver::SparseMatrix& A) 
+{   return A.toDense(); }
+
 // Unpack an active column vector and add its values into a full column.
 static void addInActiveCol
    (const Array_<MultiplierIndex,PLUSImpulseSolver::ActiveIndex>& active,
@@ -139,6 +225,53 @@ solve(int                                 phase,
       const Matrix&                       A,
       const Vector&                       D,
       const Array_<MultiplierIndex>&      expanding,
+      Vector&                             piExpand,
+      Vector&                             verrStart,
+      Vector&                             verrApplied,
+      Vector&                             pi, 
+      Array_<UncondRT>&                   unconditional,
+      Array_<UniContactRT>&               uniContact,
+      Array_<UniSpeedRT>&                 uniSpeed,
+      Array_<BoundedRT>&                  bounded,
+      Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+      Array_<StateLtdFrictionRT>&         stateLtdFriction
+      ) const 
+{
+    return solveImpl(phase, participating, A, D, expanding, piExpand,
+                     verrStart, verrApplied, pi, unconditional, uniContact,
+                     uniSpeed, bounded, consLtdFriction, stateLtdFriction);
+}
+
+bool PLUSImpulseSolver::
+solve(int                                 phase,
+      const Array_<MultiplierIndex>&      participating, 
+      const SparseMatrix&                 A,
+      const Vector&                       D,
+      const Array_<MultiplierIndex>&      expanding,
+      Vector&                             piExpand,
+      Vector&                             verrStart,
+      Vector&                             verrApplied,
+      Vector&                             pi, 
+      Array_<UncondRT>&                   unconditional,
+      Array_<UniContactRT>&               uniContact,
+      Array_<UniSpeedRT>&                 uniSpeed,
+      Array_<BoundedRT>&                  bounded,
+      Array_<ConstraintLtdFrictionRT>&    consLtdFriction,
+      Array_<StateLtdFrictionRT>&         stateLtdFriction
+      ) const 
+{
+    return solveImpl(phase, participating, A, D, expanding, piExpand,
+                     verrStart, verrApplied, pi, unconditional, uniContact,
+                     uniSpeed, bounded, consLtdFriction, stateLtdFriction);
+}
+
+template <class AMatrix>
+bool PLUSImpulseSolver::
+solveImpl(int                                 phase,
+      const Array_<MultiplierIndex>&      participating, 
+      const AMatrix&                      A,
+      const Vector&                       D,
+      const Array_<MultiplierIndex>&      expanding,
       Vector&                             piExpand, // in/out
       Vector&                             verrStart,     // in/out
       Vector&                             verrApplied,
@@ -170,6 +303,11 @@ solve(int                                 phase,
     const int nx = (int)expanding.size();
     assert(p<=m); assert(nx<=m);
  
+    // A caller-supplied initial guess is used for the first sliding interval.
+    Vector piStart;
+    if (m_useInitialGuess && pi.size()==m)
+        piStart = pi;
+
     pi.resize(m);
     pi.setToZero(); // Use this for piUnknown
 
@@ -239,12 +377,11 @@ solve(int                                 phase,
         // Calculate remaining expansion impulse part of RHS verrE=A*piE.
         // This is how much we'll change verr if we get to apply the full
         // expansion impulse in this sliding interval.
-        if (nx)
-            for (MultiplierIndex mx(0); mx < m; ++mx) {
-                m_verrExpand[mx] = 
-                    -(  multRowTimesSparseCol(A,mx,expanding,piELeft)
-                      + D[mx]*piELeft[mx]);
-            }
+        if (nx) {
+            multSparseCol(A,expanding,piELeft,m_verrExpand);
+            for (MultiplierIndex mx(0); mx < m; ++mx)
+                m_verrExpand[mx] = -(m_verrExpand[mx] + D[mx]*piELeft[mx]);
+        }
 
         if (p == 0) {
             SimTK_DEBUG1("PLUS %d: nothing to do; converged in 0 iters.\n", phase);
@@ -268,6 +405,10 @@ solve(int                                 phase,
         #endif
 
         piGuess = 0; // Hold the best-guess impulse for this interval.
+        const bool haveStart = (interval == 1 && piStart.size() > 0);
+        if (haveStart)
+            for (int i=0; i < p; ++i)
+                piGuess[participating[i]] = piStart[participating[i]];
 
         // Determine step begin Rolling vs. Sliding and get slip directions.
         // Sets all non-Observer uni contacts to active or known.
@@ -295,7 +436,8 @@ solve(int                                 phase,
 
             m_mult2active.resize(m);
             fillMult2Active(m_active, m_mult2active);
-            initializeNewton(A, piGuess, verrApplied, uniContact);
+            initializeNewton(A, piGuess, verrApplied, uniContact,
+                             haveStart && its == 1);
             updateDirectionsAndCalcCurrentError(A, uniContact, 
                                                 piELeft, verrApplied,
                                                 m_piActive,m_errActive);
@@ -309,7 +451,7 @@ solve(int                                 phase,
             int newtIter = 0;
             SimTK_DEBUG1(">>>> Start NEWTON solve with errNorm=%g...\n", errNorm);
             while (errNorm > m_convergenceTol) {
-                ++newtIter;
+                ++newtIter; ++m_nIters[phase]; // stats count Newton iters
                 // Solve for deltaPi.
                 FactorQTZ fac(m_JacActive);
                 fac.solve(m_errActive, dpi);
@@ -574,9 +716,11 @@ solve(int                                 phase,
             const MultiplierIndex          Nk = rt.m_Nk;
             assert(Fk.size()==2); //TODO: generalize
             // Velocity change db=[Ax Ay]*(pi+piE). TODO: D?
-            Vec2 db(  multRowTimesActiveCol(A,Fk[0],m_active,m_piActive)
+            Vec2 db(  multRowTimesActiveCol(A,Fk[0],m_active,m_mult2active,
+                                            m_piActive)
                     - m_verrExpand[Fk[0]],
-                      multRowTimesActiveCol(A,Fk[1],m_active,m_piActive)
+                      multRowTimesActiveCol(A,Fk[1],m_active,m_mult2active,
+                                            m_piActive)
                     - m_verrExpand[Fk[1]]);
             Vec2 bend(rt.m_slipVel - db);
             if (hasAppliedImpulse)
@@ -670,7 +814,8 @@ solve(int                                 phase,
 
         // Update rhs. TODO: D*piActive
         for (MultiplierIndex mx(0); mx < m; ++mx) {
-            m_verrLeft[mx] -= multRowTimesActiveCol(A,mx,m_active,m_piActive)
+            m_verrLeft[mx] -= multRowTimesActiveCol(A,mx,m_active,m_mult2active,
+                                                    m_piActive)
                               - s*m_verrExpand[mx];
         }
         if (hasAppliedImpulse) {
@@ -713,8 +858,33 @@ solve(int                                 phase,
 //------------------------------------------------------------------------------
 bool PLUSImpulseSolver::
 solveBilateral
+   (const Array_<MultiplierIndex>&  participating,
+    const Matrix&                   A,
+    const Vector&                   D,
+    const Vector&                   rhs,
+    Vector&                         pi
+    ) const
+{
+    return solveBilateralImpl(participating, A, D, rhs, pi);
+}
+
+bool PLUSImpulseSolver::
+solveBilateral
+   (const Array_<MultiplierIndex>&  participating,
+    const SparseMatrix&             A,
+    const Vector&                   D,
+    const Vector&                   rhs,
+    Vector&                         pi
+    ) const
+{
+    return solveBilateralImpl(participating, A, D, rhs, pi);
+}
+
+template <class AMatrix>
+bool PLUSImpulseSolver::
+solveBilateralImpl
    (const Array_<MultiplierIndex>&  participating, // p<=m of these 
-    const Matrix&                   A,     // m X m, symmetric
+    const AMatrix&                  A,     // m X m, symmetric
     const Vector&                   D,     // m, diag>=0 added to A
     const Vector&                   rhs,   // m, RHS
     Vector&                         pi     // m, unknown result
@@ -747,15 +917,13 @@ solveBilateral
     //   bilateralActive = P*A*~P
     //   rhsActive       = P*rhs
     //   piActive = a place to put the result for just the active part
-    m_bilateralActive.resize(p,p);
+    m_active = participating; m_mult2active.resize(m);
+    fillMult2Active(m_active, m_mult2active);
+    copyActiveBlock(A, m_active, m_mult2active, m_bilateralActive);
     m_rhsActive.resize(p); m_piActive.resize(p);
     const bool hasD = (D.size() > 0);
     for (ActiveIndex aj(0); aj < p; ++aj) {
         const MultiplierIndex mj = participating[aj];
-        for (ActiveIndex ai(0); ai < p; ++ai) {
-            const MultiplierIndex mi = participating[ai];
-            m_bilateralActive(ai,aj) = A(mi,mj);
-        }
         if (hasD)
             m_bilateralActive(aj,aj) += D[mj];
         m_rhsActive[aj] = rhs[mj];
@@ -772,7 +940,8 @@ solveBilateral
     }
 
     #ifndef NDEBUG
-    cout << "A=" << A;
+    const Matrix Adense = denseOf(A);
+    cout << "A=" << Adense;
     cout << "D=" << D << endl;
     cout << "rcond(A+D)=" << pinv.getRCondEstimate() 
          << " rank=" << pinv.getRank() << endl;
@@ -781,8 +950,9 @@ solveBilateral
     cout << "-> piActive=" << m_piActive << endl;
     cout << "-> pi=" << pi << endl;
     cout << "resid active=" << m_bilateralActive*m_piActive-m_rhsActive << endl;
-    if (D.size()) cout << "resid=" << A*pi+D.elementwiseMultiply(pi)-rhs << endl;
-    else cout << "resid=" << A*pi-rhs << endl;
+    if (D.size()) 
+        cout << "resid=" << Adense*pi+D.elementwiseMultiply(pi)-rhs << endl;
+    else cout << "resid=" << Adense*pi-rhs << endl;
     #endif
     SimTK_DEBUG("--------------------------------\n");
     return true;
@@ -1023,21 +1193,20 @@ fillMult2Active(const Array_<MultiplierIndex,ActiveIndex>& active,
 // corresponding to linear equations since those won't change. Transfer
 // previous impulses pi to new piActive. Assumes m_active and m_mult2active
 // have been filled in.
+template <class AMatrix>
 void PLUSImpulseSolver::
-initializeNewton(const Matrix&                  A, 
+initializeNewton(const AMatrix&                 A, 
                  const Vector&                  pi, // m of these 
                  const Vector&                  verrApplied,
-                 const Array_<UniContactRT>&    uniContact) const { 
+                 const Array_<UniContactRT>&    uniContact,
+                 bool                           keepNormalGuess) const { 
     const int na = m_active.size();
     const bool hasAppliedImpulse = (verrApplied.size() > 0);
-    m_JacActive.resize(na,na); m_rhsActive.resize(na); m_piActive.resize(na);
+    copyActiveBlock(A, m_active, m_mult2active, m_JacActive);
+    m_rhsActive.resize(na); m_piActive.resize(na);
     m_errActive.resize(na);
     for (ActiveIndex aj(0); aj < na; ++aj) {
         const MultiplierIndex mj = m_active[aj];
-        for (ActiveIndex ai(0); ai < na; ++ai) {
-            const MultiplierIndex mi = m_active[ai];
-            m_JacActive(ai,aj) = A(mi,mj);
-        }
         m_rhsActive[aj] = m_verrLeft[mj] + m_verrExpand[mj];
         if (hasAppliedImpulse) m_rhsActive[aj] += verrApplied[mj];
         m_piActive[aj]  = pi[mj];
@@ -1053,6 +1222,8 @@ initializeNewton(const Matrix&                  A,
         const MultiplierIndex mz = rt.m_Nk;
         const ActiveIndex az = m_mult2active[mz];
         assert(az.isValid());
+        if (keepNormalGuess && m_piActive[az] != 0)
+            continue;
         // Don't use rt.m_sign here because it affects both pi & rhs; we just
         // want the signs to match.
         m_piActive[az] = .01*sign(m_rhsActive[az]); //-1,0,1
@@ -1075,9 +1246,10 @@ initializeNewton(const Matrix&                  A,
 //------------------------------------------------------------------------------
 // Calculate err(pi). For Impending slip frictional contacts we also revise
 // the slip direction based on the current values of pi and piExpand.
+template <class AMatrix>
 void PLUSImpulseSolver::
 updateDirectionsAndCalcCurrentError
-   (const Matrix& A,  Array_<UniContactRT>& uniContact, 
+   (const AMatrix& A,  Array_<UniContactRT>& uniContact, 
     const Vector& piELeft, const Vector& verrAppliedLeft,
     const Vector& piActive,
     Vector& errActive) const 
@@ -1092,7 +1264,8 @@ updateDirectionsAndCalcCurrentError
     for (ActiveIndex ai(0); ai < na; ++ai) {
         const MultiplierIndex mi = m_active[ai];
         // err = A pi - rhs (piExpand included in rhs)
-        errActive[ai] = multRowTimesActiveCol(A,mi,m_active,piActive)
+        errActive[ai] = multRowTimesActiveCol(A,mi,m_active,m_mult2active,
+                                              piActive)
                         - m_rhsActive[ai];
     }
 
@@ -1113,9 +1286,11 @@ updateDirectionsAndCalcCurrentError
 
         if (rt.m_frictionCond==Impending) {
             // Update slip direction to [Ax Ay]*(pi+piE) - verrApplied.
-            Vec2 d(multRowTimesActiveCol(A,mx,m_active,piActive)
+            Vec2 d(multRowTimesActiveCol(A,mx,m_active,m_mult2active,
+                                         piActive)
                    - m_verrExpand[mx],
-                   multRowTimesActiveCol(A,my,m_active,piActive)
+                   multRowTimesActiveCol(A,my,m_active,m_mult2active,
+                                         piActive)
                    - m_verrExpand[my]);
             if (hasAppliedImpulse)
                 d -= Vec2(verrAppliedLeft[mx],verrAppliedLeft[my]);
@@ -1174,8 +1349,9 @@ updateDirectionsAndCalcCurrentError
 // already been filled in since they can't change during the iteration. Only 
 // sliding and impending friction rows are potentially nonlinear and thus
 // subject to change during the Newton iterations.
+template <class AMatrix>
 void PLUSImpulseSolver::
-updateJacobianForSliding(const Matrix& A,
+updateJacobianForSliding(const AMatrix& A,
                          const Array_<UniContactRT>& uniContact,
                          const Vector& piELeft,
                          const Vector& verrAppliedLeft) const {
@@ -1206,7 +1382,6 @@ updateJacobianForSliding(const Matrix& A,
         m_JacActive[ax] = m_JacActive[ay] = 0; // zero the rows
         if (rt.m_frictionCond==Impending) {
             // Calculate terms for derivative of norm(d) w.r.t. pi.
-            const RowVectorView Ax = A[mx], Ay = A[my];
             const MultiplierIndex mz = rt.m_Nk;
             const Real pizE = rt.m_sign*piELeft[mz];
 
@@ -1214,7 +1389,7 @@ updateJacobianForSliding(const Matrix& A,
                 const ActiveIndex az=m_mult2active[mz];
                 assert(az.isValid());
                 const Real piz=rt.m_sign*m_piActive[az];
-                const Real Axz=Ax(mz), Ayz=Ay(mz);
+                const Real Axz=A(mx,mz), Ayz=A(my,mz);
                 const Real minz  = softmin0(piz, m_minSmoothness);
                 const Real dminz = dsoftmin0(piz, m_minSmoothness);
                 // errx=|d|pix + dx*mu*(pizE+softmin0(piz))   [erry similar]
@@ -1228,7 +1403,7 @@ updateJacobianForSliding(const Matrix& A,
                 for (ActiveIndex ai(0); ai<m_active.size(); ++ai) {
                     const MultiplierIndex mi = m_active[ai];
                     const Real pii=m_piActive[ai];
-                    const Real Axi=Ax(mi), Ayi=Ay(mi);
+                    const Real Axi=A(mx,mi), Ayi=A(my,mi);
                     const Real s = ~dhat*Vec2(Axi,Ayi);
                     m_JacActive(ax,ai) = s*pix + mu*Axi*(pizE+minz);
                     m_JacActive(ay,ai) = s*piy + mu*Ayi*(pizE+minz);
@@ -1250,7 +1425,7 @@ updateJacobianForSliding(const Matrix& A,
                 for (ActiveIndex ai(0); ai<m_active.size(); ++ai) {
                     const MultiplierIndex mi = m_active[ai];
                     const Real pii=m_piActive[ai];
-                    const Real Axi=Ax(mi), Ayi=Ay(mi);
+                    const Real Axi=A(mx,mi), Ayi=A(my,mi);
                     const Real s = ~dhat*Vec2(Axi,Ayi);
                     m_JacActive(ax,ai) = s*pix + mu*Axi*pizE;
                     m_JacActive(ay,ai) = s*piy + mu*Ayi*pizE;
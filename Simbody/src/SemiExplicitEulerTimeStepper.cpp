@@ -27,7 +27,9 @@
 #include "simbody/internal/SimbodyMatterSubsystem.h"
 
 #include "SimbodyMatterSubsystemRep.h"
+#include "ContactParallelLoop.h"
 
+#include <algorithm>
 #include <iostream>
 using std::cout; using std::endl;
 
@@ -48,6 +50,9 @@ namespace {
         DefImpulseSolverType   = SemiExplicitEulerTimeStepper::PLUS;
     const SemiExplicitEulerTimeStepper::PositionProjectionMethod 
         DefPosProjMethod = SemiExplicitEulerTimeStepper::Bilateral;
+    const Real  DefSleepLinearSpeed    = 1e-2;
+    const Real  DefSleepAngularSpeed   = 5e-2;
+    const Real  DefSleepDwellTime      = 0.5;
 }
 
 namespace SimTK {
@@ -68,9 +73,40 @@ SemiExplicitEulerTimeStepper(const MultibodySystem& mbs)
     m_defaultMinCORVelocity(0),     // means: use capture velocity
     m_defaultTransitionVelocity(0), // means: use 2 x constraintTol
     m_minSignificantForce(DefMinSignificantForce),
-    m_solver(0)
+    m_solver(0), m_useIslands(true), m_useSparseMatrix(true),
+    m_useWarmStart(true),
+    m_executor(new ParallelExecutor()),
+    m_useSleeping(false), m_sleepLinearSpeed(DefSleepLinearSpeed),
+    m_sleepAngularSpeed(DefSleepAngularSpeed),
+    m_sleepDwellTime(DefSleepDwellTime), m_canSleep(false)
 {}
 
+void SemiExplicitEulerTimeStepper::setNumberOfThreads(unsigned numThreads) {
+    SimTK_APIARGCHECK_ALWAYS(numThreads > 0, "SemiExplicitEulerTimeStepper",
+        "setNumberOfThreads", "Number of threads must be positive.");
+    m_executor = new ParallelExecutor(numThreads);
+}
+
+int SemiExplicitEulerTimeStepper::getNumberOfThreads() const 
+{   return m_executor->getMaxThreads(); }
+
+void SemiExplicitEulerTimeStepper::
+setSleepSpeedThresholds(Real linearSpeed, Real angularSpeed) {
+    SimTK_APIARGCHECK2_ALWAYS(linearSpeed >= 0 && angularSpeed >= 0, 
+        "SemiExplicitEulerTimeStepper", "setSleepSpeedThresholds",
+        "Speed thresholds must be nonnegative but were %g and %g.", 
+        linearSpeed, angularSpeed);
+    m_sleepLinearSpeed = linearSpeed;
+    m_sleepAngularSpeed = angularSpeed;
+}
+
+void SemiExplicitEulerTimeStepper::setSleepDwellTime(Real dwellTime) {
+    SimTK_APIARGCHECK1_ALWAYS(dwellTime >= 0, "SemiExplicitEulerTimeStepper",
+        "setSleepDwellTime", "Dwell time must be nonnegative but was %g.",
+        dwellTime);
+    m_sleepDwellTime = dwellTime;
+}
+
 
 //------------------------------------------------------------------------------
 //                                 STEP TO
@@ -85,7 +121,11 @@ stepTo(Real time) {
     const Real t0 = m_state.getTime();
     const Real h = time - t0;    // max timestep
 
-    // Kinematics should already be realized so this won't do anything.
+    // This may lock or unlock some bodies, lowering the stage.
+    if (m_canSleep)
+        updateSleeping(s);
+
+    // Kinematics should already be realized so this usually won't do anything.
     mbs.realize(s, Stage::Position); 
     // Determine which constraints will be involved for this step.
     findProximalConstraints(s);
@@ -114,8 +154,16 @@ stepTo(Real time) {
     // separate and no time is going by during an impact.
     calcCoefficientsOfFriction(s, verr0);
 
-    // Calculate the constraint compliance matrix A=GM\~G.
-    matter.calcProjectedMInv(s, m_GMInvGt); // m X m
+    // Calculate the constraint compliance matrix A=GM\~G. Independent groups
+    // of constraints can then be solved separately.
+    if (m_useSparseMatrix) {
+        calcSparseProjectedMInv(s); // m X m, sparse
+        if (m_useIslands) findIslands(m_sparseGMInvGt);
+    } else {
+        matter.calcProjectedMInv(s, m_GMInvGt); // m X m
+        if (m_useIslands) findIslands(m_GMInvGt);
+    }
+    if (!m_useIslands) m_islands.clear();
 
     // TODO: this is for soft constraints. D >= 0.
     m_D.resize(m); m_D.setToZero();
@@ -314,6 +362,8 @@ stepTo(Real time) {
     // that velocity is what's in verr0.
     Vector verrStart = verr0;
     // Use lambda as a temp here; we are really calculating lambda*h.
+    if (m_useWarmStart)
+        guessCompressionImpulse(h, lambda);
     doCompressionPhase(s, verrStart, m_verr, lambda);
     #ifndef NDEBUG
     cout << "   dynamics impulse=" << lambda << endl;
@@ -324,6 +374,8 @@ stepTo(Real time) {
     // Convert multipliers from impulses to forces. These are the multipliers
     // reported at end of step.
     lambda /= h;
+    if (m_useWarmStart)
+        saveUniContactForces(lambda);
 
     // Calculate constraint forces ~G*lambda (body frcs Fc, mobility frcs fc).
     Vector_<SpatialVec> Fc; Vector fc; 
@@ -731,9 +783,56 @@ void SemiExplicitEulerTimeStepper::initialize(const State& initState) {
                         "SemiExplicitEulerTimeStepper::initialize()",
                         "No ImpulseSolver available.");
 
+    // Island solvers are copied from this one as needed.
+    clearIslandSolvers();
+
     // Make sure the impulse solve knows our tolerance for slip velocity
     // during rolling.
     m_solver->setMaxRollingSpeed(getDefaultFrictionTransitionVelocityInUse());
+
+    // Start out with no contact forces to warm start from.
+    m_solver->setUseInitialGuess(m_useWarmStart);
+    const SimbodyMatterSubsystem& matter = m_mbs.getMatterSubsystem();
+    m_prevUniContactForce.clear();
+    m_prevUniContactForce.resize(matter.getNumUnilateralContacts(), 
+                                 Vec3(NaN));
+
+    // Everything starts out awake.
+    initializeSleeping();
+}
+
+//------------------------------------------------------------------------------
+//                          WARM START SUPPORT
+//------------------------------------------------------------------------------
+// Set the compression impulse guess to the last step's force times the new 
+// step size h for each unilateral contact that was proximal then; everything
+// else starts at zero.
+void SemiExplicitEulerTimeStepper::
+guessCompressionImpulse(Real h, Vector& impulse) const {
+    impulse.setToZero();
+    for (unsigned i=0; i < m_uniContact.size(); ++i) {
+        const ImpulseSolver::UniContactRT& rt = m_uniContact[i];
+        const Vec3& prev = m_prevUniContactForce[rt.m_ucx];
+        if (isNaN(prev[0]))
+            continue;
+        impulse[rt.m_Nk] = h*prev[0];
+        for (unsigned k=0; k < rt.m_Fk.size(); ++k)
+            impulse[rt.m_Fk[k]] = h*prev[1+k];
+    }
+}
+
+// Remember this step's unilateral contact forces by contact, since the 
+// multipliers are renumbered every step.
+void SemiExplicitEulerTimeStepper::
+saveUniContactForces(const Vector& lambda) {
+    m_prevUniContactForce.fill(Vec3(NaN));
+    for (unsigned i=0; i < m_uniContact.size(); ++i) {
+        const ImpulseSolver::UniContactRT& rt = m_uniContact[i];
+        Vec3& prev = m_prevUniContactForce[rt.m_ucx];
+        prev = Vec3(lambda[rt.m_Nk], 0, 0);
+        for (unsigned k=0; k < rt.m_Fk.size(); ++k)
+            prev[1+k] = lambda[rt.m_Fk[k]];
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -782,6 +881,11 @@ findProximalConstraints(const State& s) { //TODO: redo
     const int nLtdFrictions = matter.getNumStateLimitedFrictions();
 
     for (UnilateralContactIndex ux(0); ux < nUniContacts; ++ux) {
+        // Contacts among sleeping bodies and Ground aren't tracked.
+        if (isContactAsleep(ux)) {
+            m_distalUniContacts.push_back(ux);
+            continue;
+        }
         const UnilateralContact& contact = matter.getUnilateralContact(ux);
         if (contact.isProximal(s, m_consTol)) // may be scaled
             m_proximalUniContacts.push_back(ux);
@@ -1156,10 +1260,10 @@ doCompressionPhase(const State& s, Vector& verrStart, Vector& verrApplied,
     cout << "  verrStart=" << verrStart << endl;
     cout << "  verrApplied=" << verrApplied << endl;
 #endif
-    // TODO: improve initial guess
+    // compImpulse holds the initial guess if we're warm starting.
     m_expansionImpulse.setToZero(); //TODO: shouldn't need to zero this
-    bool converged = m_solver->solve(0,
-        m_allParticipating,m_GMInvGt,m_D,
+    bool converged = solveImpulses(0,
+        m_allParticipating,
         Array_<MultiplierIndex>(), m_expansionImpulse, 
         verrStart, verrApplied, 
         compImpulse,
@@ -1184,8 +1288,9 @@ doExpansionPhase(const State&   state,
                  Vector&        verrStart, 
                  Vector&        reactionImpulse) {
     // TODO: improve initial guess
-    bool converged = m_solver->solve(1,
-        m_participating,m_GMInvGt,m_D,
+    reactionImpulse.clear(); // start from zero
+    bool converged = solveImpulses(1,
+        m_participating,
         expanding,expansionImpulse, verrStart,m_emptyVector,
         reactionImpulse,
         m_unconditional,m_uniContact,m_uniSpeed,m_bounded,
@@ -1209,8 +1314,9 @@ doInducedImpactRound(const State& s,
 #ifndef NDEBUG
     printf("IMP t=%.15g verr=", s.getTime()); cout << verrStart << endl;
 #endif
-    bool converged = m_solver->solve(0,
-        m_participating,m_GMInvGt,m_D,
+    impulse.clear(); // start from zero
+    bool converged = solveImpulses(0,
+        m_participating,
         expanding,expansionImpulse, verrStart,m_emptyVector,
         impulse,
         m_unconditional,m_uniContact,m_uniSpeed,m_bounded,
@@ -1233,8 +1339,9 @@ doPositionCorrectionPhase(const State& state, Vector& pverr,
         SimTK_DEBUG1("UNILATERAL POSITION CORRECTION, %d participators\n",
                      (int)m_posParticipating.size());
         m_expansionImpulse.setToZero(); //TODO: shouldn't need to zero this
-        converged = m_solver->solve(2,
-            m_posParticipating,m_GMInvGt,m_D,
+        positionImpulse.clear(); // start from zero
+        converged = solveImpulses(2,
+            m_posParticipating,
             Array_<MultiplierIndex>(), m_expansionImpulse,
             pverr, m_emptyVector,
             positionImpulse,
@@ -1255,8 +1362,646 @@ doPositionCorrectionPhase(const State& state, Vector& pverr,
         }
         SimTK_DEBUG1("BILATERAL POSITION CORRECTION, %d participators\n",
                     (int)m_participating.size());
-        converged = m_solver->solveBilateral(m_participating,m_GMInvGt,m_D,
-                                             pverr, positionImpulse);
+        converged = solveBilateralImpulses(m_participating, pverr, 
+                                           positionImpulse);
+    }
+    return converged;
+}
+
+//------------------------------------------------------------------------------
+//                       CALC SPARSE PROJECTED M INV
+//------------------------------------------------------------------------------
+// Row j of G is ~G e_j, which is nonzero only for the few mobilities that 
+// constraint equation j acts on. Column j of A=G M\ ~G is G x with 
+// x = M\ ~G e_j; x is exactly zero for mobilities outside the subtrees 
+// containing those mobilities, and each nonzero x[k] contributes only to the
+// rows of G that use mobility k. So we keep G by rows and by columns 
+// (mobilities) and never touch the zeros of A. This costs one ~G and one M\ 
+// operator per constraint equation, the same as calcProjectedMInv().
+void SemiExplicitEulerTimeStepper::
+calcSparseProjectedMInv(const State& s) {
+    const SimbodyMatterSubsystem& matter = m_mbs.getMatterSubsystem();
+    const int m = s.getNMultipliers(), nu = s.getNU();
+
+    // Rows of G, and the number of rows that use each mobility.
+    Array_<int> rowStart(1, 0), rowMob, mobCount(nu, 0);
+    Array_<Real> rowVal;
+    Vector lambda(m, Real(0)), f, x;
+    for (int j=0; j < m; ++j) {
+        lambda[j] = 1;
+        matter.multiplyByGTranspose(s, lambda, f);
+        lambda[j] = 0;
+        for (int k=0; k < nu; ++k)
+            if (f[k] != 0) {
+                rowMob.push_back(k); rowVal.push_back(f[k]);
+                ++mobCount[k];
+            }
+        rowStart.push_back((int)rowMob.size());
+    }
+
+    // Columns of G, with rows in increasing order.
+    Array_<int> mobStart(nu+1), mobRow(rowMob.size());
+    Array_<Real> mobVal(rowMob.size());
+    mobStart[0] = 0;
+    for (int k=0; k < nu; ++k)
+        mobStart[k+1] = mobStart[k] + mobCount[k];
+    Array_<int> next(mobStart.begin(), mobStart.end()-1);
+    for (int i=0; i < m; ++i)
+        for (int e=rowStart[i]; e < rowStart[i+1]; ++e) {
+            const int pos = next[rowMob[e]]++;
+            mobRow[pos] = i; mobVal[pos] = rowVal[e];
+        }
+
+    // Accumulate each column of A in a dense m-vector, keeping track of 
+    // which rows were touched.
+    m_sparseGMInvGt.clear(m);
+    Vector column(m, Real(0));
+    Array_<bool> touched(m, false);
+    Array_<int> rows;
+    f.resize(nu);
+    for (int j=0; j < m; ++j) {
+        f.setToZero();
+        for (int e=rowStart[j]; e < rowStart[j+1]; ++e)
+            f[rowMob[e]] = rowVal[e];
+        matter.multiplyByMInv(s, f, x);
+        rows.clear();
+        for (int k=0; k < nu; ++k) {
+            if (x[k] == 0) continue;
+            for (int e=mobStart[k]; e < mobStart[k+1]; ++e) {
+                const int i = mobRow[e];
+                if (!touched[i]) {touched[i] = true; rows.push_back(i);}
+                column[i] += mobVal[e]*x[k];
+            }
+        }
+        std::sort(rows.begin(), rows.end());
+        for (unsigned r=0; r < rows.size(); ++r) {
+            const int i = rows[r];
+            m_sparseGMInvGt.appendEntry(i, column[i]);
+            column[i] = 0; touched[i] = false;
+        }
+        m_sparseGMInvGt.finishColumn();
+    }
+    SimTK_DEBUG3("%d multipliers; A has %d of %d entries.\n", m, 
+                 m_sparseGMInvGt.getNumEntries(), m*m);
+}
+
+//------------------------------------------------------------------------------
+//                              FIND ISLANDS
+//------------------------------------------------------------------------------
+// Two multipliers are coupled if their entry in A=G M\~G is non-zero; this is
+// exactly zero when the constraints act on bodies that have no joint path
+// between them other than through Ground. Multipliers belonging to the same
+// unilateral contact are kept together regardless so that the contact can be
+// handed to the solver as a unit. Islands are the connected components of
+// the coupling graph; each is listed in increasing multiplier order, and the
+// islands are ordered by their lowest multiplier.
+namespace {
+int findRoot(Array_<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+// The lower-numbered root survives.
+void unite(Array_<int>& parent, int i, int j) {
+    const int ri = findRoot(parent, i), rj = findRoot(parent, j);
+    if (ri < rj) parent[rj] = ri;
+    else if (rj < ri) parent[ri] = rj;
+}
+// Unite every pair of multipliers with a nonzero A(i,j).
+void uniteCoupled(const Matrix& A, Array_<int>& parent) {
+    const int m = A.nrow();
+    for (int j=0; j < m; ++j)
+        for (int i=j+1; i < m; ++i)
+            if (A(i,j) != 0) unite(parent, i, j);
+}
+void uniteCoupled(const ImpulseSolver::SparseMatrix& A, Array_<int>& parent) {
+    for (int j=0; j < A.ncol(); ++j)
+        for (int k=A.getColumnBegin(j); k < A.getColumnEnd(j); ++k)
+            unite(parent, A.getEntryRow(k), j);
+}
+}
+
+template <class AMatrix>
+void SemiExplicitEulerTimeStepper::
+findIslands(const AMatrix& A) {
+    const int m = A.nrow();
+    Array_<int> parent(m);
+    for (int i=0; i < m; ++i)
+        parent[i] = i;
+    uniteCoupled(A, parent);
+    for (unsigned k=0; k < m_uniContact.size(); ++k) {
+        const ImpulseSolver::UniContactRT& rt = m_uniContact[k];
+        for (unsigned f=0; f < rt.m_Fk.size(); ++f)
+            unite(parent, rt.m_Nk, rt.m_Fk[f]);
+    }
+
+    m_islands.clear();
+    m_islandOf.resize(m); m_islandPos.resize(m);
+    for (MultiplierIndex mx(0); mx < m; ++mx) {
+        const int root = findRoot(parent, mx);
+        if (root == mx) {
+            m_islandOf[mx] = (int)m_islands.size();
+            m_islands.push_back(); // empty
+        } else 
+            m_islandOf[mx] = m_islandOf[MultiplierIndex(root)];
+        Array_<MultiplierIndex>& island = m_islands[m_islandOf[mx]];
+        m_islandPos[mx] = (int)island.size();
+        island.push_back(mx);
+    }
+    SimTK_DEBUG2("%d multipliers in %d islands.\n", m, (int)m_islands.size());
+}
+
+bool SemiExplicitEulerTimeStepper::allocateIslandSolvers() {
+    while (m_islandSolvers.size() < m_islands.size()) {
+        ImpulseSolver* copy = m_solver->clone();
+        if (!copy) return false;
+        m_islandSolvers.push_back(copy);
+    }
+    return true;
+}
+
+// Fold the island solvers' stats into the main solver's so that those are
+// the stats for all solves.
+void SemiExplicitEulerTimeStepper::collectIslandSolverStats() {
+    for (unsigned i=0; i < m_islandSolvers.size(); ++i) {
+        m_solver->accumulateStats(*m_islandSolvers[i]);
+        m_islandSolvers[i]->clearStats();
+    }
+}
+
+void SemiExplicitEulerTimeStepper::clearIslandSolvers() {
+    for (unsigned i=0; i < m_islandSolvers.size(); ++i)
+        delete m_islandSolvers[i];
+    m_islandSolvers.clear();
+}
+
+//------------------------------------------------------------------------------
+//                                 SLEEPING
+//------------------------------------------------------------------------------
+// Bodies sleep and wake a whole tree at a time; there is a tree for each 
+// child of Ground, containing it and all its descendents. Bodies are numbered
+// so that a parent comes before its children. We also note which trees each
+// unilateral contact touches, not counting Ground.
+void SemiExplicitEulerTimeStepper::initializeSleeping() {
+    const SimbodyMatterSubsystem& matter = m_mbs.getMatterSubsystem();
+    const int nb = matter.getNumBodies();
+
+    m_treeOf.clear(); m_treeOf.resize(nb, -1); // Ground is in no tree
+    m_treeBodies.clear(); m_treeCanSleep.clear();
+    for (MobilizedBodyIndex mbx(1); mbx < nb; ++mbx) {
+        const MobilizedBody& mobod = matter.getMobilizedBody(mbx);
+        int tree = m_treeOf[mobod.getParentMobilizedBody()
+                                 .getMobilizedBodyIndex()];
+        if (tree < 0) {
+            tree = (int)m_treeBodies.size();
+            m_treeBodies.push_back(); // empty
+            m_treeCanSleep.push_back(true);
+        }
+        m_treeOf[mbx] = tree;
+        m_treeBodies[tree].push_back(mbx);
+        // Don't interfere with the user's locks or prescribed motion.
+        if (mobod.isLocked(m_state) || mobod.hasMotion())
+            m_treeCanSleep[tree] = false;
+    }
+    const int nt = (int)m_treeBodies.size();
+    m_treeRestingSince.clear(); m_treeRestingSince.resize(nt, NaN);
+    m_treeSleepGroup.clear(); m_treeSleepGroup.resize(nt, -1);
+
+    m_canSleep = m_useSleeping;
+    const int nc = matter.getNumUnilateralContacts();
+    m_uniContactTrees.clear(); m_uniContactTrees.resize(nc);
+    Array_<MobilizedBodyIndex> bodies;
+    for (UnilateralContactIndex ux(0); ux < nc; ++ux) {
+        bodies.clear();
+        matter.getUnilateralContact(ux).getConstrainedBodies(bodies);
+        if (bodies.empty())
+            m_canSleep = false; // can't tell who it touches
+        Array_<int>& trees = m_uniContactTrees[ux];
+        for (unsigned i=0; i < bodies.size(); ++i) {
+            const int tree = m_treeOf[bodies[i]];
+            if (tree >= 0 && std::find(trees.begin(), trees.end(), tree) 
+                             == trees.end())
+                trees.push_back(tree);
+        }
+    }
+
+    m_sleepBodyForces.clear();
+    m_sleepBodyForces.resize(nb, SpatialVec(Vec3(NaN)));
+    m_sleepMobilityForces.resize(m_state.getNU());
+    m_sleepMobilityForces.setToNaN();
+}
+
+bool SemiExplicitEulerTimeStepper::
+isContactAsleep(UnilateralContactIndex ux) const {
+    if (!m_canSleep) return false;
+    const Array_<int>& trees = m_uniContactTrees[ux];
+    for (unsigned i=0; i < trees.size(); ++i)
+        if (!isTreeAsleep(trees[i])) return false;
+    return !trees.empty();
+}
+
+int SemiExplicitEulerTimeStepper::getNumSleepingBodies() const {
+    int n = 0;
+    for (unsigned t=0; t < m_treeBodies.size(); ++t)
+        if (isTreeAsleep(t)) n += (int)m_treeBodies[t].size();
+    return n;
+}
+
+bool SemiExplicitEulerTimeStepper::isSleeping(MobilizedBodyIndex mbx) const {
+    if (!(0 <= mbx && mbx < (int)m_treeOf.size()) || m_treeOf[mbx] < 0)
+        return false;
+    return isTreeAsleep(m_treeOf[mbx]);
+}
+
+// Lock each body of a group of trees where it is, with zero velocity. The 
+// group is known by its lowest-numbered tree. The group's applied forces are
+// recorded at the start of the next step, once they have been recalculated.
+void SemiExplicitEulerTimeStepper::
+putToSleep(State& s, int group, const Array_<int>& trees) {
+    const SimbodyMatterSubsystem& matter = m_mbs.getMatterSubsystem();
+    for (unsigned i=0; i < trees.size(); ++i) {
+        const int t = trees[i];
+        m_treeSleepGroup[t] = group;
+        m_treeRestingSince[t] = NaN;
+        for (unsigned b=0; b < m_treeBodies[t].size(); ++b) {
+            const MobilizedBodyIndex mbx = m_treeBodies[t][b];
+            matter.getMobilizedBody(mbx).lock(s, Motion::Position);
+            m_sleepBodyForces[mbx] = SpatialVec(Vec3(NaN));
+        }
+    }
+    SimTK_DEBUG2("t=%g: %d trees fell asleep.\n", s.getTime(),
+                 (int)trees.size());
+}
+
+// Unlock all the trees in the given sleeping groups. 
+void SemiExplicitEulerTimeStepper::
+wakeUp(State& s, const Array_<int>& groups) {
+    const SimbodyMatterSubsystem& matter = m_mbs.getMatterSubsystem();
+    for (unsigned t=0; t < m_treeBodies.size(); ++t) {
+        if (!isTreeAsleep(t) || std::find(groups.begin(), groups.end(), 
+                                          m_treeSleepGroup[t]) == groups.end())
+            continue;
+        m_treeSleepGroup[t] = -1;
+        for (unsigned b=0; b < m_treeBodies[t].size(); ++b)
+            matter.getMobilizedBody(m_treeBodies[t][b]).unlock(s);
+    }
+    SimTK_DEBUG2("t=%g: %d sleeping groups woke up.\n", s.getTime(),
+                 (int)groups.size());
+}
+
+// At the start of a step, wake any sleeping group whose applied forces have
+// changed, or that an awake body has come into contact with. Then put to 
+// sleep each group of awake trees that has been resting for the dwell time,
+// where trees are grouped by the unilateral contacts that were proximal on
+// the last step. Any contact between an awake tree and a sleeping one is 
+// distal then, or we would have woken the sleeping one.
+void SemiExplicitEulerTimeStepper::updateSleeping(State& s) {
+    const SimbodyMatterSubsystem& matter = m_mbs.getMatterSubsystem();
+    const int nt = (int)m_treeBodies.size();
+    const Real t0 = s.getTime();
+
+    // This is normally left over from the end of the last step.
+    m_mbs.realize(s, Stage::Dynamics);
+
+    // Note which awake trees are resting now, and since when.
+    for (int t=0; t < nt; ++t) {
+        if (isTreeAsleep(t)) continue;
+        bool resting = m_treeCanSleep[t];
+        for (unsigned b=0; resting && b < m_treeBodies[t].size(); ++b) {
+            const SpatialVec& V = 
+                matter.getMobilizedBody(m_treeBodies[t][b]).getBodyVelocity(s);
+            resting = V[0].norm() <= m_sleepAngularSpeed
+                   && V[1].norm() <= m_sleepLinearSpeed;
+        }
+        if (!resting) m_treeRestingSince[t] = NaN;
+        else if (isNaN(m_treeRestingSince[t])) m_treeRestingSince[t] = t0;
+    }
+
+    // Wake the groups whose applied forces have changed since they fell 
+    // asleep; for those that fell asleep on the last step, record the forces
+    // now.
+    const Vector&              f = m_mbs.getMobilityForces(s, Stage::Dynamics);
+    const Vector_<SpatialVec>& F = m_mbs.getRigidBodyForces(s,Stage::Dynamics);
+    Array_<int> groups;
+    for (int t=0; t < nt; ++t) {
+        if (!isTreeAsleep(t)) continue;
+        for (unsigned b=0; b < m_treeBodies[t].size(); ++b) {
+            const MobilizedBodyIndex mbx = m_treeBodies[t][b];
+            const MobilizedBody& mobod = matter.getMobilizedBody(mbx);
+            const int u0 = mobod.getFirstUIndex(s), nu = mobod.getNumU(s);
+            SpatialVec& Fsleep = m_sleepBodyForces[mbx];
+            if (isNaN(Fsleep[0][0])) {
+                Fsleep = F[mbx];
+                m_sleepMobilityForces(u0, nu) = f(u0, nu);
+            } else if (   (F[mbx]-Fsleep).norm() > m_minSignificantForce
+                       || (f(u0,nu) - m_sleepMobilityForces(u0,nu)).normInf()
+                           > m_minSignificantForce) {
+                groups.push_back(m_treeSleepGroup[t]);
+                break;
+            }
+        }
+    }
+    if (!groups.empty()) {
+        wakeUp(s, groups);
+        m_mbs.realize(s, Stage::Position);
+    }
+
+    // Wake the groups that an awake tree has come into contact with. Those
+    // may in turn be in contact with other sleeping groups.
+    const int nc = matter.getNumUnilateralContacts();
+    do {
+        groups.clear();
+        for (UnilateralContactIndex ux(0); ux < nc; ++ux) {
+            const Array_<int>& trees = m_uniContactTrees[ux];
+            bool anyAwake = false, anyAsleep = false;
+            for (unsigned i=0; i < trees.size(); ++i)
+                if (isTreeAsleep(trees[i])) anyAsleep = true;
+                else anyAwake = true;
+            if (!(anyAwake && anyAsleep) 
+                || !matter.getUnilateralContact(ux).isProximal(s, m_consTol))
+                continue;
+            for (unsigned i=0; i < trees.size(); ++i)
+                if (isTreeAsleep(trees[i]))
+                    groups.push_back(m_treeSleepGroup[trees[i]]);
+        }
+        if (!groups.empty()) {
+            wakeUp(s, groups);
+            m_mbs.realize(s, Stage::Position);
+        }
+    } while (!groups.empty());
+
+    // Group the awake trees through the contacts that were proximal on the 
+    // last step; a group can sleep only if all its trees have been resting
+    // long enough.
+    Array_<int> parent(nt);
+    for (int t=0; t < nt; ++t)
+        parent[t] = t;
+    for (unsigned i=0; i < m_proximalUniContacts.size(); ++i) {
+        const Array_<int>& trees = m_uniContactTrees[m_proximalUniContacts[i]];
+        for (unsigned k=1; k < trees.size(); ++k)
+            unite(parent, trees[0], trees[k]);
+    }
+    Array_<bool> canSleep(nt, true);
+    for (int t=0; t < nt; ++t) {
+        const Real since = m_treeRestingSince[t];
+        if (isTreeAsleep(t) || isNaN(since) || t0-since < m_sleepDwellTime)
+            canSleep[findRoot(parent, t)] = false;
+    }
+    Array_<Array_<int> > sleepers(nt);
+    for (int t=0; t < nt; ++t) {
+        const int root = findRoot(parent, t);
+        if (canSleep[root]) sleepers[root].push_back(t);
+    }
+    for (int root=0; root < nt; ++root)
+        if (!sleepers[root].empty())
+            putToSleep(s, root, sleepers[root]);
+}
+
+//------------------------------------------------------------------------------
+//                            SOLVE IMPULSES
+//------------------------------------------------------------------------------
+// Each island gets its own copy of the parts of the problem that concern it,
+// renumbered to use the island's multiplier numbering. Islands are solved
+// independently, writing only into their own copies, then the results are
+// scattered back into the full-size arrays in island order.
+namespace {
+struct IslandProblem {
+    Matrix                      A;       // one of these is used
+    ImpulseSolver::SparseMatrix sparseA;
+    Vector  D, piExpand, verrStart, verrApplied, pi;
+    Array_<MultiplierIndex>                         participating, expanding;
+    Array_<ImpulseSolver::UniContactRT>             uniContact;
+    Array_<int>                                     whichUniContact;
+    // These are always empty here.
+    Array_<ImpulseSolver::UncondRT>                 unconditional;
+    Array_<ImpulseSolver::UniSpeedRT>               uniSpeed;
+    Array_<ImpulseSolver::BoundedRT>                bounded;
+    Array_<ImpulseSolver::ConstraintLtdFrictionRT>  consLtdFriction;
+    Array_<ImpulseSolver::StateLtdFrictionRT>       stateLtdFriction;
+    bool    converged;
+};
+
+// Adapts ImpulseSolver::solve() or solveBilateral() for runContactLoop().
+// If there is only one solver, it is used for every island.
+class SolveIslands {
+public:
+    SolveIslands(int phase, bool bilateral, bool sparse,
+                 const Array_<ImpulseSolver*>& solvers,
+                 Array_<IslandProblem>& problems)
+    :   phase(phase), bilateral(bilateral), sparse(sparse), solvers(solvers),
+        problems(problems) {}
+
+    void operator()(int k) const {
+        IslandProblem& p = problems[k];
+        p.converged = sparse ? solve(k, p.sparseA) : solve(k, p.A);
+    }
+private:
+    template <class AMatrix>
+    bool solve(int k, const AMatrix& A) const {
+        const ImpulseSolver& solver = 
+            *solvers[solvers.size()==1 ? 0 : k];
+        IslandProblem& p = problems[k];
+        if (bilateral)
+            return solver.solveBilateral(p.participating, A, p.D,
+                                         p.verrStart, p.pi);
+        return solver.solve(phase, p.participating, A, p.D,
+            p.expanding, p.piExpand, p.verrStart, p.verrApplied, p.pi,
+            p.unconditional, p.uniContact, p.uniSpeed, p.bounded,
+            p.consLtdFriction, p.stateLtdFriction);
+    }
+
+    const int                       phase;
+    const bool                      bilateral;
+    const bool                      sparse;
+    const Array_<ImpulseSolver*>&   solvers;
+    Array_<IslandProblem>&          problems;
+};
+
+void gather(const Array_<MultiplierIndex>& island, const Vector& full,
+            Vector& part) {
+    if (full.size() == 0) {part.resize(0); return;}
+    part.resize(island.size());
+    for (unsigned i=0; i < island.size(); ++i)
+        part[i] = full[island[i]];
+}
+
+void scatter(const Array_<MultiplierIndex>& island, const Vector& part,
+             Vector& full) {
+    if (full.size() == 0) return;
+    for (unsigned i=0; i < island.size(); ++i)
+        full[island[i]] = part[i];
+}
+
+// Copy the island's rows and columns of A into the island problem. All the 
+// nonzeros of an island's column lie in the island, in increasing order.
+void extractIsland(const Matrix& A, const Array_<MultiplierIndex>& island,
+                   const Array_<int,MultiplierIndex>&, IslandProblem& p) {
+    const int n = (int)island.size();
+    p.A.resize(n,n);
+    for (int j=0; j < n; ++j)
+        for (int i=0; i < n; ++i)
+            p.A(i,j) = A(island[i],island[j]);
+}
+void extractIsland(const ImpulseSolver::SparseMatrix& A, 
+                   const Array_<MultiplierIndex>& island,
+                   const Array_<int,MultiplierIndex>& islandPos, 
+                   IslandProblem& p) {
+    const int n = (int)island.size();
+    p.sparseA.clear(n);
+    for (int j=0; j < n; ++j) {
+        for (int k=A.getColumnBegin(island[j]); 
+             k < A.getColumnEnd(island[j]); ++k)
+            p.sparseA.appendEntry
+               (islandPos[MultiplierIndex(A.getEntryRow(k))], 
+                A.getEntryValue(k));
+        p.sparseA.finishColumn();
+    }
+}
+}
+
+bool SemiExplicitEulerTimeStepper::
+solveImpulses
+   (int                                             phase,
+    const Array_<MultiplierIndex>&                  participating,
+    const Array_<MultiplierIndex>&                  expanding,
+    Vector&                                         piExpand,
+    Vector&                                         verrStart,
+    Vector&                                         verrApplied,
+    Vector&                                         pi,
+    Array_<ImpulseSolver::UncondRT>&                unconditional,
+    Array_<ImpulseSolver::UniContactRT>&            uniContact,
+    Array_<ImpulseSolver::UniSpeedRT>&              uniSpeed,
+    Array_<ImpulseSolver::BoundedRT>&               bounded,
+    Array_<ImpulseSolver::ConstraintLtdFrictionRT>& consLtdFriction,
+    Array_<ImpulseSolver::StateLtdFrictionRT>&      stateLtdFriction)
+{
+    // Only unilateral contacts know how to be split up so far.
+    if (m_islands.size() < 2 || !unconditional.empty() || !uniSpeed.empty()
+        || !bounded.empty() || !consLtdFriction.empty() 
+        || !stateLtdFriction.empty())
+    {
+        if (m_useSparseMatrix)
+            return m_solver->solve(phase, participating, m_sparseGMInvGt, 
+                m_D, expanding, piExpand, verrStart, verrApplied, pi,
+                unconditional, uniContact, uniSpeed, bounded,
+                consLtdFriction, stateLtdFriction);
+        return m_solver->solve(phase, participating, m_GMInvGt, m_D,
+            expanding, piExpand, verrStart, verrApplied, pi,
+            unconditional, uniContact, uniSpeed, bounded,
+            consLtdFriction, stateLtdFriction);
+    }
+
+    const int m = verrStart.size();
+    const int nIslands = (int)m_islands.size();
+    Array_<IslandProblem> problems(nIslands);
+    for (int k=0; k < nIslands; ++k) {
+        const Array_<MultiplierIndex>& island = m_islands[k];
+        IslandProblem& p = problems[k];
+        if (m_useSparseMatrix)
+            extractIsland(m_sparseGMInvGt, island, m_islandPos, p);
+        else extractIsland(m_GMInvGt, island, m_islandPos, p);
+        gather(island, m_D, p.D);
+        gather(island, piExpand, p.piExpand);
+        gather(island, verrStart, p.verrStart);
+        gather(island, verrApplied, p.verrApplied);
+        if (pi.size() == m) gather(island, pi, p.pi); // initial guess
+    }
+    for (unsigned i=0; i < participating.size(); ++i) {
+        const MultiplierIndex mx = participating[i];
+        problems[m_islandOf[mx]].participating
+            .push_back(MultiplierIndex(m_islandPos[mx]));
+    }
+    for (unsigned i=0; i < expanding.size(); ++i) {
+        const MultiplierIndex mx = expanding[i];
+        problems[m_islandOf[mx]].expanding
+            .push_back(MultiplierIndex(m_islandPos[mx]));
+    }
+    for (unsigned c=0; c < uniContact.size(); ++c) {
+        IslandProblem& p = problems[m_islandOf[uniContact[c].m_Nk]];
+        p.whichUniContact.push_back(c);
+        p.uniContact.push_back(uniContact[c]);
+        ImpulseSolver::UniContactRT& rt = p.uniContact.back();
+        rt.m_Nk = MultiplierIndex(m_islandPos[rt.m_Nk]);
+        for (unsigned f=0; f < rt.m_Fk.size(); ++f)
+            rt.m_Fk[f] = MultiplierIndex(m_islandPos[rt.m_Fk[f]]);
+    }
+
+    // Without copies of the solver we have to go one island at a time.
+    const bool haveCopies = allocateIslandSolvers();
+    const Array_<ImpulseSolver*> onlySolver(1, m_solver);
+    SolveIslands solveIsland(phase, false, m_useSparseMatrix,
+        haveCopies ? m_islandSolvers : onlySolver, problems);
+    runContactLoop(*m_executor, nIslands, 
+                   haveCopies && m >= MinContactsForThreads, solveIsland);
+    if (haveCopies) collectIslandSolverStats();
+
+    bool converged = true;
+    pi.resize(m);
+    for (int k=0; k < nIslands; ++k) {
+        const Array_<MultiplierIndex>& island = m_islands[k];
+        const IslandProblem& p = problems[k];
+        scatter(island, p.piExpand, piExpand);
+        scatter(island, p.verrStart, verrStart);
+        scatter(island, p.verrApplied, verrApplied);
+        scatter(island, p.pi, pi);
+        for (unsigned i=0; i < p.whichUniContact.size(); ++i) {
+            ImpulseSolver::UniContactRT& rt = uniContact[p.whichUniContact[i]];
+            const MultiplierIndex Nk = rt.m_Nk;
+            const Array_<MultiplierIndex> Fk = rt.m_Fk;
+            rt = p.uniContact[i];
+            rt.m_Nk = Nk; rt.m_Fk = Fk;
+        }
+        converged = converged && p.converged;
+    }
+    return converged;
+}
+
+bool SemiExplicitEulerTimeStepper::
+solveBilateralImpulses(const Array_<MultiplierIndex>& participating,
+                       const Vector& rhs, Vector& pi) {
+    if (m_islands.size() < 2) {
+        if (m_useSparseMatrix)
+            return m_solver->solveBilateral(participating, m_sparseGMInvGt,
+                                            m_D, rhs, pi);
+        return m_solver->solveBilateral(participating, m_GMInvGt, m_D, 
+                                        rhs, pi);
+    }
+
+    const int m = rhs.size();
+    const int nIslands = (int)m_islands.size();
+    Array_<IslandProblem> problems(nIslands);
+    for (int k=0; k < nIslands; ++k) {
+        const Array_<MultiplierIndex>& island = m_islands[k];
+        const int n = (int)island.size();
+        IslandProblem& p = problems[k];
+        if (m_useSparseMatrix)
+            extractIsland(m_sparseGMInvGt, island, m_islandPos, p);
+        else extractIsland(m_GMInvGt, island, m_islandPos, p);
+        gather(island, m_D, p.D);
+        gather(island, rhs, p.verrStart);
+        p.pi.resize(n);
+    }
+    for (unsigned i=0; i < participating.size(); ++i) {
+        const MultiplierIndex mx = participating[i];
+        problems[m_islandOf[mx]].participating
+            .push_back(MultiplierIndex(m_islandPos[mx]));
+    }
+
+    const bool haveCopies = allocateIslandSolvers();
+    const Array_<ImpulseSolver*> onlySolver(1, m_solver);
+    SolveIslands solveIsland(2, true, m_useSparseMatrix,
+        haveCopies ? m_islandSolvers : onlySolver, problems);
+    runContactLoop(*m_executor, nIslands, 
+                   haveCopies && m >= MinContactsForThreads, solveIsland);
+    if (haveCopies) collectIslandSolverStats();
+
+    bool converged = true;
+    pi.resize(m);
+    for (int k=0; k < nIslands; ++k) {
+        scatter(m_islands[k], problems[k].pi, pi);
+        converged = converged && problems[k].converged;
     }
     return converged;
 }
@@ -3840,14 +3840,11 @@ static Real calcQErrestWeightedNormU(const SimbodyMatterSubsystemRep& matter,
     const State& s, const Vector& qErrest, const Vector& uWeights) {
     Vector qhatErrest(uWeights.size());
     matter.multiplyByNInv(s, false, qErrest, qhatErrest); // qhatErrest = N+ qErrest
-    qhatErrest.rowScaleInPlace(uWeights);                 // qhatErrest = Wu N+ qErrest
-    return qhatErrest.normRMS();
+    return qhatErrest.weightedNormRMS(uWeights);          // |Wu N+ qErrest|
 }
 static Real calcQErrestWeightedNormQ(const SimbodyMatterSubsystemRep& matter, 
     const State& s, const Vector& qErrest, const Vector& qWeights) {
-    Vector Wq_qErrest(qErrest.size());
-    Wq_qErrest = qErrest.rowScale(qWeights); // Wq*qErrest
-    return Wq_qErrest.normRMS();
+    return qErrest.weightedNormRMS(qWeights); // no temporary needed
 }
 
 void SimbodyMatterSubsystemRep::enforcePositionConstraints
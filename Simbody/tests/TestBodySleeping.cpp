@@ -0,0 +1,183 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that SemiExplicitEulerTimeStepper puts resting bodies to sleep, that
+// sleeping bodies stay put and cost no impulse solves, and that they are woken
+// by an awake body landing on them or by a change in the applied forces.
+
+#include "SimTKsimbody.h"
+
+#include <iostream>
+
+using namespace SimTK;
+using namespace std;
+
+static const Vec3 HalfSize(0.1, 0.05, 0.08);
+static const Real StepSize = 0.001;
+
+// Add a box whose eight corners contact the top face of the given body,
+// which is at the given height in that body's frame. PointPlaneContact only
+// enforces a plane through the plane body's origin, so we shift the corners
+// down by the height instead.
+static MobilizedBody::Free addBox(SimbodyMatterSubsystem& matter,
+                                  MobilizedBody& below, Real height,
+                                  const Vec3& where) {
+    Body::Rigid body(MassProperties(1, Vec3(0),
+        UnitInertia::brick(HalfSize)));
+    MobilizedBody::Free box(matter.updGround(), Transform(where),
+                            body, Transform());
+    for (int i=-1; i<=1; i+=2)
+    for (int j=-1; j<=1; j+=2)
+    for (int k=-1; k<=1; k+=2) {
+        const Vec3 pt = Vec3(i,j,k).elementwiseMultiply(HalfSize)
+                        - Vec3(0,height,0);
+        matter.adoptUnilateralContact(new PointPlaneContact
+           (below, YAxis, 0, box, pt, 0, 0.5, 0.3, 0));
+    }
+    return box;
+}
+
+static void stepTo(SemiExplicitEulerTimeStepper& ts, Real time) {
+    while (ts.getTime() < time - StepSize/2)
+        ts.stepTo(ts.getTime() + StepSize);
+}
+
+// Boxes dropped onto the ground come to rest and fall asleep, after which
+// they don't move and there is nothing left to solve.
+void testRestingBodiesSleep() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::Gravity gravity(forces, matter, -YAxis, 9.8);
+    Array_<MobilizedBody> boxes;
+    for (int b=0; b < 4; ++b)
+        boxes.push_back(addBox(matter, matter.updGround(), 0,
+                               Vec3(0.5*b, HalfSize[1]+0.01*b, 0)));
+    system.realizeTopology();
+
+    SemiExplicitEulerTimeStepper ts(system);
+    SimTK_TEST(!ts.getUseSleeping());
+    ts.setUseSleeping(true);
+    ts.setSleepDwellTime(0.2);
+    SimTK_TEST(ts.getSleepDwellTime() == 0.2);
+    SimTK_TEST_MUST_THROW(ts.setSleepSpeedThresholds(-1, 0.1));
+    ts.initialize(system.getDefaultState());
+    SimTK_TEST(ts.getNumSleepingBodies() == 0);
+
+    stepTo(ts, 1);
+    SimTK_TEST(ts.getNumSleepingBodies() == 4);
+    SimTK_TEST(!ts.isSleeping(MobilizedBodyIndex(0))); // Ground
+    for (unsigned b=0; b < boxes.size(); ++b) {
+        SimTK_TEST(ts.isSleeping(boxes[b].getMobilizedBodyIndex()));
+        SimTK_TEST(boxes[b].isLocked(ts.getState()));
+        SimTK_TEST_EQ_TOL(boxes[b].getBodyOriginLocation(ts.getState())[1],
+                          HalfSize[1], 1e-3);
+    }
+
+    const Vector q = ts.getState().getQ();
+    const long long nSolves = ts.getImpulseSolver().getNumSolves(0);
+    stepTo(ts, 1.5);
+    SimTK_TEST((ts.getState().getQ() - q).normInf() == 0);
+    SimTK_TEST(ts.getImpulseSolver().getNumSolves(0) == nSolves);
+}
+
+// A box resting on the ground falls asleep, then another box lands on it
+// and wakes it up. They both come to rest and sleep together.
+void testWakeOnContact() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::Gravity gravity(forces, matter, -YAxis, 9.8);
+    MobilizedBody::Free lower = addBox(matter, matter.updGround(), 0,
+                                       Vec3(0, HalfSize[1], 0));
+    MobilizedBody::Free upper = addBox(matter, lower, HalfSize[1],
+                                       Vec3(0, 1.5, 0));
+    system.realizeTopology();
+
+    SemiExplicitEulerTimeStepper ts(system);
+    ts.setUseSleeping(true);
+    ts.setSleepDwellTime(0.2);
+    ts.initialize(system.getDefaultState());
+
+    const MobilizedBodyIndex lowerx = lower.getMobilizedBodyIndex(),
+                             upperx = upper.getMobilizedBodyIndex();
+    stepTo(ts, 0.3);
+    SimTK_TEST(ts.isSleeping(lowerx) && !ts.isSleeping(upperx));
+
+    // The upper box lands at about 0.52s.
+    bool lowerWoke = false;
+    while (ts.getTime() < 0.7) {
+        ts.stepTo(ts.getTime() + StepSize);
+        if (!ts.isSleeping(lowerx)) lowerWoke = true;
+    }
+    SimTK_TEST(lowerWoke);
+
+    stepTo(ts, 2);
+    SimTK_TEST(ts.isSleeping(lowerx) && ts.isSleeping(upperx));
+    SimTK_TEST_EQ_TOL(upper.getBodyOriginLocation(ts.getState())[1],
+                      3*HalfSize[1], 2e-3);
+}
+
+// A sleeping box wakes when it is pushed, slides, and goes back to sleep
+// once the push is removed.
+void testWakeOnForce() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::Gravity gravity(forces, matter, -YAxis, 9.8);
+    Force::DiscreteForces push(forces, matter);
+    MobilizedBody::Free box = addBox(matter, matter.updGround(), 0,
+                                     Vec3(0, HalfSize[1], 0));
+    system.realizeTopology();
+
+    SemiExplicitEulerTimeStepper ts(system);
+    ts.setUseSleeping(true);
+    ts.setSleepDwellTime(0.2);
+    ts.initialize(system.getDefaultState());
+    const MobilizedBodyIndex boxx = box.getMobilizedBodyIndex();
+
+    stepTo(ts, 0.3);
+    SimTK_TEST(ts.isSleeping(boxx));
+
+    // Friction can resist only 4.9 N.
+    push.setOneBodyForce(ts.updState(), box, SpatialVec(Vec3(0),
+                                                         Vec3(10,0,0)));
+    ts.stepTo(ts.getTime() + StepSize);
+    SimTK_TEST(!ts.isSleeping(boxx));
+    stepTo(ts, 0.5);
+    SimTK_TEST(!ts.isSleeping(boxx));
+    SimTK_TEST(box.getBodyOriginVelocity(ts.getState())[0] > 0.5);
+
+    push.clearAllBodyForces(ts.updState());
+    stepTo(ts, 1.5);
+    SimTK_TEST(ts.isSleeping(boxx));
+    SimTK_TEST(box.getBodyOriginLocation(ts.getState())[0] > 0.1);
+}
+
+int main() {
+    SimTK_START_TEST("TestBodySleeping");
+        SimTK_SUBTEST(testRestingBodiesSleep);
+        SimTK_SUBTEST(testWakeOnContact);
+        SimTK_SUBTEST(testWakeOnForce);
+    SimTK_END_TEST();
+}
@@ -0,0 +1,188 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that the broad phase algorithms of ContactTrackerSubsystem agree.
+
+#include "SimTKsimbody.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+using namespace SimTK;
+using namespace std;
+
+typedef Array_< pair<ContactSurfaceIndex,ContactSurfaceIndex> > PairList;
+
+// Put a half space on ground and n spheres of assorted sizes on free bodies.
+// The first two spheres of every twenty share a clique so their contact
+// should be excluded.
+static void buildScene(SimbodyMatterSubsystem& matter, int n,
+                       Array_<MobilizedBody::Free>& balls) {
+    const ContactMaterial material(1e6, 0.5, 0.5, 0.5, 0.5);
+    matter.Ground().updBody().addContactSurface(
+        Rotation(-Pi/2, ZAxis),
+        ContactSurface(ContactGeometry::HalfSpace(), material));
+
+    ContactCliqueId clique;
+    for (int i=0; i < n; ++i) {
+        const Real radius = 0.05 + 0.02*(i%7);
+        Body::Rigid body(MassProperties(1, Vec3(0), UnitInertia(1)));
+        ContactSurface surface(ContactGeometry::Sphere(radius), material);
+        if (i % 20 == 0) clique = ContactSurface::createNewContactClique();
+        if (i % 20 < 2) surface.joinClique(clique);
+        body.addContactSurface(Transform(), surface);
+        balls.push_back(MobilizedBody::Free(matter.Ground(), body));
+    }
+}
+
+static PairList getPairs(const ContactTrackerSubsystem& tracker,
+                         const State& state) {
+    const ContactSnapshot& snapshot = tracker.getActiveContacts(state);
+    PairList pairs;
+    for (int i=0; i < snapshot.getNumContacts(); ++i) {
+        ContactSurfaceIndex s1 = snapshot.getContact(i).getSurface1();
+        ContactSurfaceIndex s2 = snapshot.getContact(i).getSurface2();
+        if (s1 > s2) std::swap(s1, s2);
+        pairs.push_back(make_pair(s1, s2));
+    }
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+// Move the same scene around under both broad phases and compare the
+// resulting contacts. Big moves scramble everything; small moves mostly
+// stay within the fattened boxes of the dynamic tree.
+void testBroadPhasesAgree() {
+    const int N = 400;
+
+    MultibodySystem system1;
+    SimbodyMatterSubsystem matter1(system1);
+    ContactTrackerSubsystem tracker1(system1);
+    Array_<MobilizedBody::Free> balls1;
+    buildScene(matter1, N, balls1);
+
+    MultibodySystem system2;
+    SimbodyMatterSubsystem matter2(system2);
+    ContactTrackerSubsystem tracker2(system2);
+    Array_<MobilizedBody::Free> balls2;
+    buildScene(matter2, N, balls2);
+    tracker2.setBroadPhase(ContactTrackerSubsystem::DynamicTree);
+
+    SimTK_TEST(tracker1.getBroadPhase() == ContactTrackerSubsystem::SweepAndPrune);
+    SimTK_TEST(tracker2.getBroadPhase() == ContactTrackerSubsystem::DynamicTree);
+
+    State state1 = system1.realizeTopology();
+    State state2 = system2.realizeTopology();
+
+    Random::Uniform random(-1, 1);
+    random.setSeed(17);
+    Array_<Vec3> where(N);
+    int totalPairs = 0;
+    for (int trial=0; trial < 30; ++trial) {
+        const Real jitter = (trial % 10 == 0) ? 1 : 0.02;
+        for (int i=0; i < N; ++i) {
+            const Vec3 move(random.getValue(), random.getValue(),
+                            random.getValue());
+            where[i] = (trial % 10 == 0) ? move : where[i] + jitter*move;
+            balls1[i].setQToFitTranslation(state1, where[i]);
+        }
+        state2.updQ() = state1.getQ();
+        system1.realize(state1, Stage::Position);
+        system2.realize(state2, Stage::Position);
+
+        const PairList pairs1 = getPairs(tracker1, state1);
+        const PairList pairs2 = getPairs(tracker2, state2);
+        SimTK_TEST(pairs1 == pairs2);
+        totalPairs += pairs1.size();
+    }
+    // Make sure the test is exercising something.
+    SimTK_TEST(totalPairs > 30);
+    cout << "Compared " << totalPairs << " contacts.\n";
+
+    // Switching is a Topology-stage change.
+    tracker1.setBroadPhase(ContactTrackerSubsystem::DynamicTree);
+    SimTK_TEST(!system1.systemTopologyHasBeenRealized());
+    state1 = system1.realizeTopology();
+    state1.updQ() = state2.getQ();
+    system1.realize(state1, Stage::Position);
+    SimTK_TEST(getPairs(tracker1, state1) == getPairs(tracker2, state2));
+}
+
+// The sweep and prune broad phase is updated incrementally from one
+// evaluation to the next. Check it against one built from scratch in a
+// fresh State, in both ContactTrackerSubsystem and GeneralContactSubsystem.
+void testIncrementalMatchesRebuild() {
+    const int N = 300;
+
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    ContactTrackerSubsystem tracker(system);
+    GeneralContactSubsystem general(system);
+    Array_<MobilizedBody::Free> balls;
+    buildScene(matter, N, balls);
+    const ContactSetIndex setIx = general.createContactSet();
+    for (int i=0; i < N; ++i)
+        general.addBody(setIx, balls[i], 
+                        ContactGeometry::Sphere(0.05 + 0.02*(i%7)), 
+                        Transform());
+
+    State state = system.realizeTopology();
+    Random::Uniform random(-1, 1);
+    random.setSeed(99);
+    Array_<Vec3> where(N, Vec3(0));
+    for (int trial=0; trial < 20; ++trial) {
+        // Mostly small moves, with an occasional large one.
+        const Real jitter = (trial % 7 == 0) ? 1 : 0.05;
+        for (int i=0; i < N; ++i) {
+            where[i] += jitter*Vec3(random.getValue(), random.getValue(),
+                                    random.getValue());
+            balls[i].setQToFitTranslation(state, where[i]);
+        }
+        system.realize(state, Stage::Dynamics);
+
+        State fresh = system.realizeTopology(); // empty cache
+        fresh.updQ() = state.getQ();
+        system.realize(fresh, Stage::Dynamics);
+
+        SimTK_TEST(getPairs(tracker, state) == getPairs(tracker, fresh));
+
+        const Array_<Contact>& contacts = general.getContacts(state, setIx);
+        const Array_<Contact>& freshContacts = 
+            general.getContacts(fresh, setIx);
+        SimTK_TEST(contacts.size() == freshContacts.size());
+        for (unsigned i=0; i < contacts.size(); ++i) {
+            SimTK_TEST(contacts[i].getSurface1() 
+                       == freshContacts[i].getSurface1());
+            SimTK_TEST(contacts[i].getSurface2() 
+                       == freshContacts[i].getSurface2());
+        }
+    }
+}
+
+int main() {
+    SimTK_START_TEST("TestContactBroadPhase");
+        SimTK_SUBTEST(testBroadPhasesAgree);
+        SimTK_SUBTEST(testIncrementalMatchesRebuild);
+    SimTK_END_TEST();
+}
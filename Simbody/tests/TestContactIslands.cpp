@@ -0,0 +1,323 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that SemiExplicitEulerTimeStepper splits independent groups of rigid
+// contacts into islands, that solving them separately doesn't change the
+// answer for any one group, and that the answer doesn't depend on the number
+// of threads. Also check that keeping the constraint compliance matrix sparse
+// gives the same answer as the dense matrix, and that PGS's parallel sweeps
+// agree with its serial one.
+
+#include "SimTKsimbody.h"
+
+#include <iostream>
+
+using namespace SimTK;
+using namespace std;
+
+static const Vec3 HalfSize(0.1, 0.05, 0.08);
+
+// A box resting on the ground with a rigid contact at each corner.
+static MobilizedBody addBox(SimbodyMatterSubsystem& matter, 
+                            MobilizedBody& parent, const Transform& X_PF,
+                            const Transform& X_BM, bool pin) {
+    Body::Rigid body(MassProperties(1, Vec3(0), 
+        UnitInertia::brick(HalfSize)));
+    MobilizedBody box = pin 
+        ? (MobilizedBody)MobilizedBody::Pin(parent, X_PF, body, X_BM)
+        : (MobilizedBody)MobilizedBody::Free(parent, X_PF, body, X_BM);
+    for (int i=-1; i<=1; i+=2)
+    for (int j=-1; j<=1; j+=2)
+    for (int k=-1; k<=1; k+=2) {
+        const Vec3 pt = Vec3(i,j,k).elementwiseMultiply(HalfSize);
+        matter.adoptUnilateralContact(new PointPlaneContact
+           (matter.updGround(), YAxis, 0., box, pt, 0, 0.5, 0.3, 0));
+    }
+    return box;
+}
+
+// A row of boxes; if chain is true the last two are hinged together so
+// they form a single island.
+static void buildScene(SimbodyMatterSubsystem& matter, int nBoxes, bool chain,
+                       Array_<MobilizedBody>& boxes) {
+    for (int i=0; i < nBoxes; ++i) {
+        const Transform X_GF(Vec3(0.5*i, HalfSize[1], 0));
+        if (chain && i == nBoxes-1) {
+            boxes.push_back(addBox(matter, boxes.back(), 
+                Transform(Vec3(HalfSize[0], 0, 0)), 
+                Transform(Vec3(-HalfSize[0], 0, 0)), true));
+        } else
+            boxes.push_back(addBox(matter, matter.updGround(), X_GF, 
+                                   Transform(), false));
+    }
+}
+
+// Give the free boxes repeatable little kicks; the first box always gets the
+// same one.
+static void setVelocities(State& state, const Array_<MobilizedBody>& boxes) {
+    Random::Uniform random(-0.2, 0.2);
+    random.setSeed(99);
+    for (unsigned i=0; i < boxes.size(); ++i) {
+        if (!MobilizedBody::Free::isInstanceOf(boxes[i]))
+            continue;
+        boxes[i].setUToFitVelocity(state,
+            SpatialVec(Vec3(random.getValue(), random.getValue(),
+                            random.getValue()),
+                       Vec3(random.getValue(), random.getValue(),
+                            random.getValue())));
+    }
+}
+
+static bool sameBits(const Vector& a, const Vector& b) {
+    if (a.size() != b.size()) return false;
+    for (int i=0; i < a.size(); ++i)
+        if (a[i] != b[i]) return false;
+    return true;
+}
+
+void testIslandsFound() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::Gravity gravity(forces, matter, -YAxis, 9.8);
+    Array_<MobilizedBody> boxes;
+    buildScene(matter, 6, true, boxes);
+    system.realizeTopology();
+
+    SemiExplicitEulerTimeStepper ts(system);
+    SimTK_TEST(ts.getUseIslands());
+    ts.initialize(system.getDefaultState());
+    ts.stepTo(0.001);
+    // The hinged pair makes one island.
+    SimTK_TEST(ts.getNumIslands() == 5);
+
+    ts.setUseIslands(false);
+    ts.stepTo(0.002);
+    SimTK_TEST(ts.getNumIslands() == 0);
+}
+
+void testSameResultForAnyThreadCount() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::Gravity gravity(forces, matter, -YAxis, 9.8);
+    Array_<MobilizedBody> boxes;
+    buildScene(matter, 6, true, boxes);
+    system.realizeTopology();
+    State state = system.getDefaultState();
+    setVelocities(state, boxes);
+
+    const SemiExplicitEulerTimeStepper::ImpulseSolverType solverTypes[] =
+       {SemiExplicitEulerTimeStepper::PLUS, SemiExplicitEulerTimeStepper::PGS};
+    const int threadCounts[] = {1, 2, 8};
+    for (int s=0; s < 2; ++s) {
+        Vector y1;
+        for (int t=0; t < 3; ++t) {
+            SemiExplicitEulerTimeStepper ts(system);
+            ts.setImpulseSolverType(solverTypes[s]);
+            ts.setNumberOfThreads(threadCounts[t]);
+            SimTK_TEST(ts.getNumberOfThreads() == threadCounts[t]);
+            ts.initialize(state);
+            for (int step=1; step <= 20; ++step)
+                ts.stepTo(0.001*step);
+            if (t == 0) y1 = ts.getState().getY();
+            else SimTK_TEST(sameBits(ts.getState().getY(), y1));
+        }
+    }
+}
+
+// A box among others must move just as it would on its own, up to roundoff
+// in the solver's iterations.
+void testIslandMatchesSoloBox() {
+    Vector q[2], u[2];
+    for (int n=0; n < 2; ++n) {
+        MultibodySystem system;
+        SimbodyMatterSubsystem matter(system);
+        GeneralForceSubsystem forces(system);
+        Force::Gravity gravity(forces, matter, -YAxis, 9.8);
+        Array_<MobilizedBody> boxes;
+        buildScene(matter, n==0 ? 1 : 6, false, boxes);
+        system.realizeTopology();
+        State state = system.getDefaultState();
+        setVelocities(state, boxes);
+
+        SemiExplicitEulerTimeStepper ts(system);
+        ts.initialize(state);
+        for (int step=1; step <= 50; ++step)
+            ts.stepTo(0.001*step);
+        q[n] = boxes[0].getQAsVector(ts.getState());
+        u[n] = boxes[0].getUAsVector(ts.getState());
+    }
+    SimTK_TEST_EQ_TOL(q[0], q[1], 1e-10);
+    SimTK_TEST_EQ_TOL(u[0], u[1], 1e-8);
+}
+
+void testSparseMatrix() {
+    // Symmetric, with a zero row and column.
+    Matrix A(4,4, Real(0));
+    A(0,0) = 4; A(1,1) = 3; A(3,3) = 2;
+    A(0,3) = A(3,0) = -1; A(1,3) = A(3,1) = 0.5;
+
+    ImpulseSolver::SparseMatrix S;
+    S.clear(4);
+    for (int j=0; j < 4; ++j) {
+        for (int i=0; i < 4; ++i)
+            if (A(i,j) != 0) S.appendEntry(i, A(i,j));
+        S.finishColumn();
+    }
+    SimTK_TEST(S.nrow() == 4 && S.ncol() == 4);
+    SimTK_TEST(S.getNumEntries() == 7);
+    SimTK_TEST(S.getColumnBegin(2) == S.getColumnEnd(2));
+    for (int i=0; i < 4; ++i)
+        for (int j=0; j < 4; ++j)
+            SimTK_TEST(S(i,j) == A(i,j));
+    SimTK_TEST_EQ(S.toDense(), A);
+
+    const Vector x = Test::randVector(4);
+    Vector Ax;
+    S.multiply(x, Ax);
+    SimTK_TEST_EQ(Ax, A*x);
+
+    // Both solvers should get the same answer from either form of A.
+    const Vector D(4, Real(0));
+    const Vector rhs = Test::randVector(4);
+    Array_<MultiplierIndex> participating;
+    participating.push_back(MultiplierIndex(0));
+    participating.push_back(MultiplierIndex(1));
+    participating.push_back(MultiplierIndex(3));
+    PGSImpulseSolver pgs(0.01);
+    PLUSImpulseSolver plus(0.01);
+    const ImpulseSolver* solvers[] = {&pgs, &plus};
+    for (int k=0; k < 2; ++k) {
+        Vector piDense, piSparse;
+        solvers[k]->solveBilateral(participating, A, D, rhs, piDense);
+        solvers[k]->solveBilateral(participating, S, D, rhs, piSparse);
+        SimTK_TEST_EQ_TOL(piSparse, piDense, 1e-6);
+        SimTK_TEST(piSparse[2] == 0);
+    }
+}
+
+// The sparse compliance matrix must give the same motion as the dense one,
+// with or without islands, up to roundoff.
+void testSparseMatchesDense() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::Gravity gravity(forces, matter, -YAxis, 9.8);
+    Array_<MobilizedBody> boxes;
+    buildScene(matter, 6, true, boxes);
+    system.realizeTopology();
+    State state = system.getDefaultState();
+    setVelocities(state, boxes);
+
+    const SemiExplicitEulerTimeStepper::ImpulseSolverType solverTypes[] =
+       {SemiExplicitEulerTimeStepper::PLUS, SemiExplicitEulerTimeStepper::PGS};
+    for (int s=0; s < 2; ++s)
+    for (int islands=0; islands < 2; ++islands) {
+        Vector y[2];
+        for (int sparse=0; sparse < 2; ++sparse) {
+            SemiExplicitEulerTimeStepper ts(system);
+            SimTK_TEST(ts.getUseSparseMatrix());
+            ts.setImpulseSolverType(solverTypes[s]);
+            ts.setUseIslands(islands==1);
+            ts.setUseSparseMatrix(sparse==1);
+            ts.initialize(state);
+            for (int step=1; step <= 50; ++step)
+                ts.stepTo(0.001*step);
+            y[sparse] = ts.getState().getY();
+        }
+        SimTK_TEST_EQ_TOL(y[1], y[0], 1e-8);
+    }
+}
+
+// Run 20 steps with all the boxes' contacts in one PGS problem, swept as
+// given, and return the final state.
+static Vector simulateSweep(const MultibodySystem& system, const State& state,
+                            PGSImpulseSolver::SweepMode mode, int nThreads) {
+    SemiExplicitEulerTimeStepper ts(system);
+    PGSImpulseSolver* pgs = new PGSImpulseSolver
+       (ts.getDefaultFrictionTransitionVelocityInUse());
+    SimTK_TEST(pgs->getSweepMode() == PGSImpulseSolver::Serial);
+    pgs->setSweepMode(mode);
+    pgs->setNumberOfThreads(nThreads);
+    SimTK_TEST(pgs->getNumberOfThreads() == nThreads);
+    ts.setImpulseSolver(pgs);
+    ts.setUseIslands(false);
+    ts.initialize(state);
+    for (int step=1; step <= 20; ++step)
+        ts.stepTo(0.001*step);
+    SimTK_TEST(pgs->getNumFailures(0) == 0);
+    if (mode != PGSImpulseSolver::Serial) {
+        // Each box's four bottom corners are in contact and no two of them
+        // can share a color.
+        SimTK_TEST(pgs->getNumColors() == 4);
+    }
+    return ts.getState().getY();
+}
+
+// PGS can sweep the contacts one at a time, a color at a time, or all at 
+// once (Jacobi). The parallel sweeps must not depend on the number of 
+// threads. Coloring separate boxes keeps each box's contacts in the same 
+// order so gives the serial answer. Jacobi can find a different one of the
+// many sets of corner forces that work for a sliding box, so we compare it 
+// only for boxes at rest, where the motion is unique.
+void testPGSSweepModes() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::Gravity gravity(forces, matter, -YAxis, 9.8);
+    Array_<MobilizedBody> boxes;
+    buildScene(matter, 40, false, boxes);
+    system.realizeTopology();
+    const State resting = system.getDefaultState();
+    State kicked = resting;
+    setVelocities(kicked, boxes);
+
+    const Vector ySerial = 
+        simulateSweep(system, kicked, PGSImpulseSolver::Serial, 1);
+    const Vector yColored =
+        simulateSweep(system, kicked, PGSImpulseSolver::Colored, 1);
+    SimTK_TEST_EQ_TOL(yColored, ySerial, 1e-10);
+    SimTK_TEST(sameBits(yColored,
+        simulateSweep(system, kicked, PGSImpulseSolver::Colored, 4)));
+    const Vector yJacobi =
+        simulateSweep(system, kicked, PGSImpulseSolver::Jacobi, 1);
+    SimTK_TEST(sameBits(yJacobi,
+        simulateSweep(system, kicked, PGSImpulseSolver::Jacobi, 4)));
+
+    // Both stop within the solver's tolerance of the exact answer.
+    SimTK_TEST_EQ_TOL(
+        simulateSweep(system, resting, PGSImpulseSolver::Jacobi, 4),
+        simulateSweep(system, resting, PGSImpulseSolver::Serial, 1), 1e-5);
+}
+
+int main() {
+    SimTK_START_TEST("TestContactIslands");
+        SimTK_SUBTEST(testIslandsFound);
+        SimTK_SUBTEST(testSameResultForAnyThreadCount);
+        SimTK_SUBTEST(testIslandMatchesSoloBox);
+        SimTK_SUBTEST(testSparseMatrix);
+        SimTK_SUBTEST(testSparseMatchesDense);
+        SimTK_SUBTEST(testPGSSweepModes);
+    SimTK_END_TEST();
+}
@@ -0,0 +1,164 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that warm starting SemiExplicitEulerTimeStepper's impulse solves from
+// the previous step's contact forces takes fewer iterations than starting 
+// from zero, and gets the same answer to within the solver's tolerance.
+
+#include "SimTKsimbody.h"
+
+#include <iostream>
+
+using namespace SimTK;
+using namespace std;
+
+static const Vec3 HalfSize(0.1, 0.05, 0.08);
+
+// A row of boxes resting on the ground, each with a rigid contact at each
+// corner. Odd boxes are given a sideways push so they slide to a stop.
+static void buildScene(SimbodyMatterSubsystem& matter, int nBoxes,
+                       Array_<MobilizedBody>& boxes) {
+    Body::Rigid body(MassProperties(1, Vec3(0), 
+        UnitInertia::brick(HalfSize)));
+    for (int b=0; b < nBoxes; ++b) {
+        MobilizedBody::Free box(matter.updGround(), 
+            Transform(Vec3(0.5*b, HalfSize[1], 0)), body, Transform());
+        for (int i=-1; i<=1; i+=2)
+        for (int j=-1; j<=1; j+=2)
+        for (int k=-1; k<=1; k+=2) {
+            const Vec3 pt = Vec3(i,j,k).elementwiseMultiply(HalfSize);
+            matter.adoptUnilateralContact(new PointPlaneContact
+               (matter.updGround(), YAxis, 0., box, pt, 0, 0.5, 0.3, 0));
+        }
+        boxes.push_back(box);
+    }
+}
+
+static void setVelocities(State& state, const Array_<MobilizedBody>& boxes) {
+    for (unsigned b=1; b < boxes.size(); b += 2)
+        boxes[b].setUToFitLinearVelocity(state, Vec3(0.5, 0, 0.1));
+}
+
+// Run 200 steps and return the final state and the number of iterations 
+// used for the dynamics phase.
+static long long simulate(SemiExplicitEulerTimeStepper::ImpulseSolverType 
+                            solverType, bool warmStart, bool useIslands,
+                          Vector& y) {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::Gravity gravity(forces, matter, -YAxis, 9.8);
+    Array_<MobilizedBody> boxes;
+    buildScene(matter, 4, boxes);
+    system.realizeTopology();
+    State state = system.getDefaultState();
+    setVelocities(state, boxes);
+
+    SemiExplicitEulerTimeStepper ts(system);
+    ts.setImpulseSolverType(solverType);
+    ts.setUseWarmStart(warmStart);
+    SimTK_TEST(ts.getUseWarmStart() == warmStart);
+    ts.setUseIslands(useIslands);
+    ts.initialize(state);
+    SimTK_TEST(ts.getImpulseSolver().getUseInitialGuess() == warmStart);
+    ts.getImpulseSolver().clearStats();
+    const int nSteps = 200;
+    for (int step=1; step <= nSteps; ++step)
+        ts.stepTo(0.001*step);
+    y = ts.getState().getY();
+
+    // Island solvers' stats are included in the main solver's.
+    const ImpulseSolver& solver = ts.getImpulseSolver();
+    SimTK_TEST(solver.getNumSolves(0) >= nSteps);
+    SimTK_TEST(solver.getNumFailures(0) == 0);
+    return solver.getNumIterations(0);
+}
+
+void testWarmStartSavesIterations() {
+    const SemiExplicitEulerTimeStepper::ImpulseSolverType solverTypes[] =
+       {SemiExplicitEulerTimeStepper::PGS, SemiExplicitEulerTimeStepper::PLUS};
+    const char* names[] = {"PGS", "PLUS"};
+    for (int s=0; s < 2; ++s) {
+        for (int islands=0; islands < 2; ++islands) {
+            Vector yCold, yWarm;
+            const long long cold = simulate(solverTypes[s], false, 
+                                            islands!=0, yCold);
+            const long long warm = simulate(solverTypes[s], true,
+                                            islands!=0, yWarm);
+            printf("%s islands=%d: %lld iterations cold, %lld warm\n",
+                   names[s], islands, cold, warm);
+            SimTK_TEST(warm < cold/2);
+            SimTK_TEST_EQ_TOL(yWarm, yCold, 1e-5);
+        }
+    }
+}
+
+// A caller-supplied guess is used only when asked for, and only for the 
+// participating multipliers; either way the answer is the same.
+void testSolverInitialGuess() {
+    Matrix A(3,3, Real(0));
+    A(0,0) = 2; A(1,1) = 3; A(2,2) = 1; A(0,1) = A(1,0) = 0.5;
+    const Vector D(3, Real(0)), rhs(Vec3(1,-2,4));
+    Array_<MultiplierIndex> participating;
+    participating.push_back(MultiplierIndex(0));
+    participating.push_back(MultiplierIndex(1));
+    
+    PGSImpulseSolver pgs(0.01);
+    SimTK_TEST(!pgs.getUseInitialGuess());
+    Vector cold, warm;
+    SimTK_TEST(pgs.solveBilateral(participating, A, D, rhs, cold));
+    SimTK_TEST(cold[2] == 0);
+
+    const Vector verrStart(Vec3(1,-2,4)), piExpand(3, Real(0));
+    Array_<ImpulseSolver::UncondRT> uncond(1);
+    uncond[0].m_mults = participating;
+    Array_<ImpulseSolver::UniContactRT>            uniContact;
+    Array_<ImpulseSolver::UniSpeedRT>              uniSpeed;
+    Array_<ImpulseSolver::BoundedRT>               bounded;
+    Array_<ImpulseSolver::ConstraintLtdFrictionRT> consLtd;
+    Array_<ImpulseSolver::StateLtdFrictionRT>      stateLtd;
+    for (int useGuess=0; useGuess < 2; ++useGuess) {
+        pgs.setUseInitialGuess(useGuess!=0);
+        pgs.clearStats();
+        Vector v = verrStart, noExpand = piExpand, noApplied;
+        Vector pi(Vec3(cold[0], cold[1], 99)); // last entry must be ignored
+        SimTK_TEST(pgs.solve(0, participating, A, D, 
+                             Array_<MultiplierIndex>(), noExpand, v, 
+                             noApplied, pi, uncond, uniContact, uniSpeed,
+                             bounded, consLtd, stateLtd));
+        SimTK_TEST_EQ_TOL(pi, cold, 1e-3);
+        SimTK_TEST(pi[2] == 0);
+        if (useGuess) {
+            SimTK_TEST(pgs.getNumIterations(0) <= 2);
+        } else {
+            SimTK_TEST(pgs.getNumIterations(0) > 2);
+        }
+    }
+}
+
+int main() {
+    SimTK_START_TEST("TestContactWarmStart");
+        SimTK_SUBTEST(testSolverInitialGuess);
+        SimTK_SUBTEST(testWarmStartSavesIterations);
+    SimTK_END_TEST();
+}
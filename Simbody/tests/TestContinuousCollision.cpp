@@ -0,0 +1,124 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that ContactTrackerSubsystem limits the step only for surfaces that
+// could pass through one another, and that ImpactStepLimiter keeps a fast
+// ball from tunneling through a thin plate when the integrator would
+// otherwise step right over it.
+
+#include "SimTKsimbody.h"
+
+#include <iostream>
+
+using namespace SimTK;
+using namespace std;
+
+static const Real Radius = 0.05, HalfThickness = 0.01, Height = 0.6;
+
+// A thin mesh plate on ground and a light ball above it on a free body, 
+// with no gravity. The plate's faces must be small compared to the ball for
+// the elastic foundation model to see the ball.
+static MobilizedBody::Free buildScene(SimbodyMatterSubsystem& matter) {
+    const ContactMaterial material(1e8, 0, 0, 0, 0);
+    matter.Ground().updBody().addContactSurface(Transform(),
+        ContactSurface(ContactGeometry::TriangleMesh
+            (PolygonalMesh::createBrickMesh(Vec3(0.2, HalfThickness, 0.2), 20)),
+         material, 2*HalfThickness));
+    Body::Rigid body(MassProperties(0.01, Vec3(0), UnitInertia(1)));
+    body.addContactSurface(Transform(),
+        ContactSurface(ContactGeometry::Sphere(Radius), material));
+    return MobilizedBody::Free(matter.Ground(), Transform(Vec3(0, Height, 0)),
+                               body, Transform());
+}
+
+void testMaxStepWithoutTunneling() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    ContactTrackerSubsystem tracker(system);
+    MobilizedBody::Free ball = buildScene(matter);
+    State state = system.realizeTopology();
+    const ContactSurfaceIndex plateSurf = tracker.getContactSurfaceIndex
+                                            (matter.Ground(), 0);
+    const ContactSurfaceIndex ballSurf = tracker.getContactSurfaceIndex
+                                            (ball, 0);
+
+    // Heading for the plate at 20; it hits at t=(0.6-0.05-0.01)/20 and may
+    // then go a quarter of its radius further.
+    ball.setUToFitLinearVelocity(state, Vec3(0, -20, 0));
+    system.realize(state, Stage::Velocity);
+    ContactSurfaceIndex surf1, surf2;
+    const Real impact = (Height - Radius - HalfThickness)/20;
+    const Real step = tracker.calcMaxStepWithoutTunneling(state, 0.1,
+                                                          surf1, surf2);
+    SimTK_TEST(impact - 1e-4 <= step && step <= impact + Radius/4/20);
+    SimTK_TEST(min(surf1, surf2) == plateSurf && max(surf1, surf2) == ballSurf);
+
+    // The plate is out of reach in a short step.
+    SimTK_TEST(tracker.calcMaxStepWithoutTunneling(state, 0.01, 
+                                                   surf1, surf2) == 0.01);
+    SimTK_TEST(!surf1.isValid() && !surf2.isValid());
+
+    // Moving away, or too slowly to get through, doesn't limit the step.
+    ball.setUToFitLinearVelocity(state, Vec3(0, 20, 0));
+    system.realize(state, Stage::Velocity);
+    SimTK_TEST(tracker.calcMaxStepWithoutTunneling(state, 0.1,
+                                                   surf1, surf2) == 0.1);
+    ball.setUToFitLinearVelocity(state, Vec3(0, -0.1, 0));
+    system.realize(state, Stage::Velocity);
+    SimTK_TEST(tracker.calcMaxStepWithoutTunneling(state, 0.1,
+                                                   surf1, surf2) == 0.1);
+    SimTK_TEST(!surf1.isValid());
+}
+
+// Fire the ball at the plate and return its height afterwards.
+static Real fireBall(bool limitSteps) {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    ContactTrackerSubsystem tracker(system);
+    CompliantContactSubsystem contact(system, tracker);
+    MobilizedBody::Free ball = buildScene(matter);
+    if (limitSteps)
+        system.addEventHandler(new ImpactStepLimiter(tracker, 0.05));
+    State state = system.realizeTopology();
+    ball.setUToFitLinearVelocity(state, Vec3(0, -20, 0));
+
+    RungeKuttaMersonIntegrator integ(system);
+    integ.setAccuracy(1e-3);
+    integ.setMaximumStepSize(0.05);
+    TimeStepper ts(system, integ);
+    ts.initialize(state);
+    ts.stepTo(0.2);
+    return ball.getBodyOriginLocation(integ.getState())[1];
+}
+
+void testNoTunneling() {
+    SimTK_TEST(fireBall(false) < 0);
+    SimTK_TEST(fireBall(true) > Height);
+}
+
+int main() {
+    SimTK_START_TEST("TestContinuousCollision");
+        SimTK_SUBTEST(testMaxStepWithoutTunneling);
+        SimTK_SUBTEST(testNoTunneling);
+    SimTK_END_TEST();
+}
@@ -135,9 +135,45 @@ void testForces() {
     }
 }
 
+// Two spheres rest on the ground, one of them moving up fast enough that its
+// contact pulls rather than pushes, so it gets no force. That must not keep
+// the other one from getting its force, whichever contact comes first.
+void testSeparatingContact() {
+    const Real radius = 0.5, depth = 0.01, k = 1000;
+    for (int separating = 0; separating < 2; ++separating) {
+        MultibodySystem system;
+        SimbodyMatterSubsystem matter(system);
+        GeneralContactSubsystem contacts(system);
+        GeneralForceSubsystem forces(system);
+        Body::Rigid body(MassProperties(1.0, Vec3(0), Inertia(1)));
+        ContactSetIndex setIndex = contacts.createContactSet();
+        MobilizedBody::Translation sphere[2] = {
+            MobilizedBody::Translation(matter.updGround(), Transform(), body, Transform()),
+            MobilizedBody::Translation(matter.updGround(), Transform(), body, Transform())};
+        for (int i = 0; i < 2; ++i)
+            contacts.addBody(setIndex, sphere[i], ContactGeometry::Sphere(radius), Transform());
+        contacts.addBody(setIndex, matter.updGround(), ContactGeometry::HalfSpace(), Transform(Rotation(-0.5*Pi, ZAxis), Vec3(0))); // y < 0
+        HuntCrossleyForce hc(forces, contacts, setIndex);
+        for (int i = 0; i < 3; ++i)
+            hc.setBodyParameters(ContactSurfaceIndex(i), k, 1.0, 0, 0, 0);
+        State state = system.realizeTopology();
+        for (int i = 0; i < 2; ++i)
+            sphere[i].setQToFitTranslation(state, Vec3(3*i, radius-depth, 0));
+        sphere[separating].setUToFitLinearVelocity(state, Vec3(0, 10, 0));
+        system.realize(state, Stage::Dynamics);
+
+        const Real stiffness = std::pow(k, 2.0/3.0)/2;
+        const Real fh = (4.0/3.0)*stiffness*depth*std::sqrt(radius*stiffness*depth);
+        const Vector_<SpatialVec>& f = system.getRigidBodyForces(state, Stage::Dynamics);
+        assertEqual(f[sphere[separating].getMobilizedBodyIndex()][1], Vec3(0));
+        assertEqual(f[sphere[1-separating].getMobilizedBodyIndex()][1], Vec3(0, fh, 0));
+    }
+}
+
 int main() {
     try {
         testForces();
+        testSeparatingContact();
     }
     catch(const std::exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -0,0 +1,155 @@
+/* -------------------------------------------------------------------------- *
+ *                               Simbody(tm)                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+// Check that contact tracking and compliant contact forces come out exactly
+// the same no matter how many threads are used to calculate them.
+
+#include "SimTKsimbody.h"
+
+#include <iostream>
+
+using namespace SimTK;
+using namespace std;
+
+// A half space on ground with a grid of overlapping spheres sitting in it,
+// plus a row of elastic foundation mesh balls that touch one another and
+// the ground. That gives plenty of point contacts and a few mesh contacts.
+static void buildScene(SimbodyMatterSubsystem& matter,
+                       Array_<MobilizedBody::Free>& bodies) {
+    const ContactMaterial material(1e6, 0.5, 0.8, 0.6, 0.1);
+    matter.Ground().updBody().addContactSurface(
+        Rotation(-Pi/2, ZAxis),
+        ContactSurface(ContactGeometry::HalfSpace(), material));
+
+    const Real r = 0.1;
+    for (int i=0; i < 8; ++i)
+        for (int j=0; j < 8; ++j) {
+            Body::Rigid body(MassProperties(1, Vec3(0), UnitInertia(1)));
+            body.addContactSurface(Transform(),
+                ContactSurface(ContactGeometry::Sphere(r), material));
+            MobilizedBody::Free ball(matter.Ground(),
+                                     Transform(Vec3(0.18*i, 0.09, 0.18*j)),
+                                     body, Transform());
+            bodies.push_back(ball);
+        }
+
+    const Real R = 0.3;
+    const ContactGeometry::TriangleMesh mesh
+        (PolygonalMesh::createSphereMesh(R, 2));
+    for (int i=0; i < 4; ++i) {
+        Body::Rigid body(MassProperties(5, Vec3(0), UnitInertia(1)));
+        body.addContactSurface(Transform(),
+            ContactSurface(mesh, material, 0.1 /*thickness*/));
+        MobilizedBody::Free ball(matter.Ground(),
+                                 Transform(Vec3(0.55*i, 0.28, -1)),
+                                 body, Transform());
+        bodies.push_back(ball);
+    }
+}
+
+// Give all the bodies the same repeatable little kicks.
+static void setVelocities(State& state,
+                          const Array_<MobilizedBody::Free>& bodies) {
+    Random::Uniform random(-0.1, 0.1);
+    random.setSeed(1234);
+    for (unsigned i=0; i < bodies.size(); ++i)
+        bodies[i].setUToFitVelocity(state,
+            SpatialVec(Vec3(random.getValue(), random.getValue(),
+                            random.getValue()),
+                       Vec3(random.getValue(), random.getValue(),
+                            random.getValue())));
+}
+
+static bool sameBits(const Vector& a, const Vector& b) {
+    if (a.size() != b.size()) return false;
+    for (int i=0; i < a.size(); ++i)
+        if (a[i] != b[i]) return false;
+    return true;
+}
+
+void testSameResultForAnyThreadCount() {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::UniformGravity gravity(forces, matter, Vec3(0, -9.8, 0));
+    ContactTrackerSubsystem tracker(system);
+    CompliantContactSubsystem contact(system, tracker);
+    Array_<MobilizedBody::Free> bodies;
+    buildScene(matter, bodies);
+    system.realizeTopology();
+
+    const int threadCounts[] = {1, 2, 3, 8};
+    Vector udot1, y1;
+    Array_<ContactForce> forces1;
+    for (int t=0; t < 4; ++t) {
+        tracker.setNumberOfThreads(threadCounts[t]);
+        contact.setNumberOfThreads(threadCounts[t]);
+        SimTK_TEST(tracker.getNumberOfThreads() == threadCounts[t]);
+        SimTK_TEST(contact.getNumberOfThreads() == threadCounts[t]);
+
+        State state = system.getDefaultState();
+        setVelocities(state, bodies);
+        system.realize(state, Stage::Acceleration);
+
+        Array_<ContactForce> contactForces;
+        for (int i=0; i < contact.getNumContactForces(state); ++i)
+            contactForces.push_back(contact.getContactForce(state, i));
+
+        // Take a few steps so contacts get tracked from one step to the next.
+        RungeKuttaMersonIntegrator integ(system);
+        integ.setAccuracy(1e-2);
+        TimeStepper ts(system, integ);
+        ts.initialize(state);
+        ts.stepTo(0.002);
+
+        if (t == 0) {
+            udot1 = state.getUDot();
+            forces1 = contactForces;
+            y1 = integ.getState().getY();
+            // Make sure the test is exercising something.
+            SimTK_TEST(forces1.size() > 100);
+            cout << forces1.size() << " contact forces.\n";
+            continue;
+        }
+
+        SimTK_TEST(sameBits(state.getUDot(), udot1));
+        SimTK_TEST(contactForces.size() == forces1.size());
+        for (unsigned i=0; i < contactForces.size(); ++i) {
+            const ContactForce& f = contactForces[i];
+            SimTK_TEST(f.getContactPoint() == forces1[i].getContactPoint());
+            SimTK_TEST(f.getForceOnSurface2()
+                       == forces1[i].getForceOnSurface2());
+            SimTK_TEST(f.getPotentialEnergy()
+                       == forces1[i].getPotentialEnergy());
+            SimTK_TEST(f.getPowerDissipation()
+                       == forces1[i].getPowerDissipation());
+        }
+        SimTK_TEST(sameBits(integ.getState().getY(), y1));
+    }
+}
+
+int main() {
+    SimTK_START_TEST("TestParallelContact");
+        SimTK_SUBTEST(testSameResultForAnyThreadCount);
+    SimTK_END_TEST();
+}
@@ -0,0 +1,111 @@
+/* -------------------------------------------------------------------------- *
+ *                    Simbody(tm) - Broad Phase Benchmark                     *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+/* Compare the cost of the ContactTrackerSubsystem broad phase algorithms on
+a heap of "gravel": n small spheres on free bodies packed into a cube at
+constant density, so the cube grows with n. Every sphere overlaps a whole
+slab of others along any one axis, about n^(2/3) of them, so a sweep that
+looked at only one axis would do poorly here. Each configuration is jittered
+slightly between evaluations as it would be from one time step to the next;
+we report the average time to determine the active contacts. An optional
+argument gives the largest n to try (default 20000). */
+
+#include "Simbody.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace SimTK;
+
+static double timeBroadPhase(int n, ContactTrackerSubsystem::BroadPhase method,
+                             int& numContacts) {
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    ContactTrackerSubsystem tracker(system);
+    tracker.setBroadPhase(method);
+
+    const ContactMaterial material(1e6, 0.5, 0.5, 0.5, 0.5);
+    const Real radius = 0.05;
+    Body::Rigid body(MassProperties(1, Vec3(0), UnitInertia(1)));
+    body.addContactSurface(Transform(),
+        ContactSurface(ContactGeometry::Sphere(radius), material));
+    Array_<MobilizedBody::Free> stones;
+    for (int i=0; i < n; ++i)
+        stones.push_back(MobilizedBody::Free(matter.Ground(), body));
+
+    State state = system.realizeTopology();
+
+    const Real side = 3*radius*std::cbrt(Real(n)); // one per (3r)^3 cube
+    Random::Uniform random(0, 1);
+    random.setSeed(n);
+    Array_<Vec3> where(n);
+    for (int i=0; i < n; ++i)
+        where[i] = side*Vec3(random.getValue(), random.getValue(),
+                             random.getValue());
+
+    const int NumEvals = 20;
+    double total = 0;
+    numContacts = 0;
+    for (int eval=0; eval < NumEvals; ++eval) {
+        for (int i=0; i < n; ++i) {
+            where[i] += (radius/20)*Vec3(random.getValue()-0.5,
+                                         random.getValue()-0.5,
+                                         random.getValue()-0.5);
+            stones[i].setQToFitTranslation(state, where[i]);
+        }
+        system.realize(state, Stage::Position);
+        const double start = realTime();
+        numContacts += tracker.getActiveContacts(state).getNumContacts();
+        total += realTime() - start;
+    }
+    numContacts /= NumEvals;
+    return total/NumEvals;
+}
+
+int main(int argc, char** argv) {
+  try {
+    const int maxN = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int sizes[] = {100, 300, 1000, 3000, 10000, 20000};
+
+    std::printf("%8s %10s %14s %14s %8s\n", "surfaces", "contacts",
+                "sweep (ms)", "tree (ms)", "speedup");
+    for (int n : sizes) {
+        if (n > maxN) break;
+        int contactsSweep, contactsTree;
+        const double sweep = timeBroadPhase
+            (n, ContactTrackerSubsystem::SweepAndPrune, contactsSweep);
+        const double tree = timeBroadPhase
+            (n, ContactTrackerSubsystem::DynamicTree, contactsTree);
+        if (contactsSweep != contactsTree)
+            std::printf("*** contact counts differ: %d vs %d\n",
+                        contactsSweep, contactsTree);
+        std::printf("%8d %10d %14.3f %14.3f %8.2f\n", n, contactsTree,
+                    1000*sweep, 1000*tree, sweep/tree);
+    }
+  } catch (const std::exception& e) {
+    std::printf("EXCEPTION THROWN: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
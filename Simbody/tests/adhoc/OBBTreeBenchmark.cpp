@@ -0,0 +1,173 @@
+/* -------------------------------------------------------------------------- *
+ *                     Simbody(tm) - OBB Tree Benchmark                       *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+/* Measure the cost of building and querying the OBB tree of a
+ContactGeometry::TriangleMesh. The meshes are bumpy tori made from an n x n
+grid of quads, so they have 2n^2 triangles and are closed, as contact meshes
+must be. For each size we report the time to construct the mesh (dominated by
+building the tree), the average time for a nearest point query from a point
+near the surface, the average time for a ray cast at the mesh from outside,
+and the time to find the intersecting faces of two overlapping copies of the
+mesh with the mesh-mesh contact tracker. Each mesh is built with the
+default median split serially and in parallel, with the surface area
+heuristic, loaded from a cache file written by an earlier construction, and
+finally with a signed distance field added, whose construction time is
+included in the build time. An optional argument gives the largest number of triangles to
+try (default 2000000). */
+
+#include "Simbody.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace SimTK;
+
+static const Real MajorRadius = 1;
+static const Real MinorRadius = 0.4;
+
+static Vec3 torusPoint(Real u, Real v) {
+    const Real r = MinorRadius*(1 + 0.05*std::sin(7*u)*std::sin(5*v));
+    const Real R = MajorRadius + r*std::cos(v);
+    return Vec3(R*std::cos(u), R*std::sin(u), r*std::sin(v));
+}
+
+static ContactGeometry::TriangleMesh makeTorus
+   (int n, const ContactGeometry::TriangleMesh::OBBTreeOptions& options) {
+    Array_<Vec3> vertices;
+    Array_<int> faces;
+    for (int i=0; i < n; ++i)
+        for (int j=0; j < n; ++j)
+            vertices.push_back(torusPoint(2*Pi*i/n, 2*Pi*j/n));
+    for (int i=0; i < n; ++i)
+        for (int j=0; j < n; ++j) {
+            const int a = i*n + j,           b = ((i+1)%n)*n + j;
+            const int c = ((i+1)%n)*n + (j+1)%n, d = i*n + (j+1)%n;
+            faces.push_back(a); faces.push_back(b); faces.push_back(c);
+            faces.push_back(a); faces.push_back(c); faces.push_back(d);
+        }
+    return ContactGeometry::TriangleMesh(vertices, faces, false, options);
+}
+
+// Time the queries on one mesh and print a line of the table.
+static void timeQueries(const ContactGeometry::TriangleMesh& mesh, int n,
+                        const char* tree, double build) {
+    const int NumQueries = 100000;
+    Random::Uniform random(0, 1);
+    random.setSeed(n);
+    Array_<Vec3> near(NumQueries), from(NumQueries);
+    for (int i=0; i < NumQueries; ++i) {
+        const Real u = 2*Pi*random.getValue(), v = 2*Pi*random.getValue();
+        near[i] = torusPoint(u, v) + 0.05*Vec3(random.getValue()-0.5,
+                                               random.getValue()-0.5,
+                                               random.getValue()-0.5);
+        from[i] = 3*Vec3(std::cos(u), std::sin(u), random.getValue()-0.5);
+    }
+
+    double start = realTime();
+    int numInside = 0;
+    for (int i=0; i < NumQueries; ++i) {
+        bool inside; UnitVec3 normal;
+        mesh.findNearestPoint(near[i], inside, normal);
+        if (inside) ++numInside;
+    }
+    const double nearest = (realTime() - start)/NumQueries;
+
+    start = realTime();
+    int numHits = 0;
+    for (int i=0; i < NumQueries; ++i) {
+        Real distance; UnitVec3 normal;
+        if (mesh.intersectsRay(from[i], UnitVec3(-from[i]), distance, normal))
+            ++numHits;
+    }
+    const double ray = (realTime() - start)/NumQueries;
+
+    // Two copies, one shifted and turned a little so that they overlap
+    // along most of the tube.
+    const ContactTracker::TriangleMeshTriangleMesh tracker;
+    const Transform X_GM2(Rotation(0.3, XAxis), Vec3(0.2, 0, 0));
+    const int NumMeshMesh = 10;
+    const UntrackedContact prior(ContactSurfaceIndex(0),
+                                 ContactSurfaceIndex(1));
+    Contact contact;
+    start = realTime();
+    for (int i=0; i < NumMeshMesh; ++i)
+        tracker.trackContact(prior, Transform(), mesh, X_GM2, mesh,
+                             0, contact);
+    const double meshMesh = (realTime() - start)/NumMeshMesh;
+    int numFaces = 0;
+    if (TriangleMeshContact::isInstance(contact))
+        numFaces = (int)TriangleMeshContact::getAs(contact)
+                            .getSurface1Faces().size();
+
+    std::printf("%9d %-9s %12.1f %14.3f %14.3f %14.2f   "
+                "(%d inside, %d hits, %d faces)\n",
+                2*n*n, tree, 1000*build, 1e6*nearest, 1e6*ray, 1000*meshMesh,
+                numInside, numHits, numFaces);
+}
+
+int main(int argc, char** argv) {
+  try {
+    typedef ContactGeometry::TriangleMesh::OBBTreeOptions OBBTreeOptions;
+    const int maxTriangles = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    const int gridSizes[] = {71, 224, 708}; // 10k, 100k, 1M triangles
+
+    std::printf("%9s %-9s %12s %14s %14s %14s\n", "triangles", "tree", 
+                "build (ms)", "nearest (us)", "ray (us)", "mesh-mesh (ms)");
+    for (int n : gridSizes) {
+        if (2*n*n > maxTriangles) break;
+
+        const OBBTreeOptions serial = OBBTreeOptions().setNumThreads(1);
+        const OBBTreeOptions parallel;
+        const OBBTreeOptions sah = OBBTreeOptions()
+            .setSplitMethod(OBBTreeOptions::SurfaceAreaSplit);
+        const char* names[] = {"serial", "parallel", "SAH"};
+        const OBBTreeOptions* options[] = {&serial, &parallel, &sah};
+        for (int k=0; k < 3; ++k) {
+            const double start = realTime();
+            const ContactGeometry::TriangleMesh mesh = 
+                makeTorus(n, *options[k]);
+            timeQueries(mesh, n, names[k], realTime() - start);
+        }
+
+        // The first construction writes the cache; time the second.
+        const char* cacheFile = "OBBTreeBenchmark.obbtree";
+        std::remove(cacheFile);
+        makeTorus(n, OBBTreeOptions(sah).setCacheFile(cacheFile));
+        const double start = realTime();
+        const ContactGeometry::TriangleMesh mesh =
+            makeTorus(n, OBBTreeOptions(sah).setCacheFile(cacheFile));
+        timeQueries(mesh, n, "SAH cache", realTime() - start);
+
+        const double sdfStart = realTime();
+        ContactGeometry::TriangleMesh sdfMesh = makeTorus(n, sah);
+        sdfMesh.createDistanceField(0.02);
+        timeQueries(sdfMesh, n, "SAH SDF", realTime() - sdfStart);
+        std::remove(cacheFile);
+    }
+  } catch (const std::exception& e) {
+    std::printf("EXCEPTION THROWN: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,193 @@
+/* -------------------------------------------------------------------------- *
+ *                 Simbody(tm) - PGS Sweep Mode Benchmark                     *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+/* Compare PGSImpulseSolver's sweep modes on the impulse problem for a floor
+covered with boxes, each touching the ground with a rigid frictional contact
+at all eight corners, from 1000 to 10000 contacts. The boxes are moving with
+random velocities so that some contacts stick, some slide, and some
+separate. We build the sparse A=G M\ ~G for that directly and call the
+solver, so only the solver is timed. For each convergence tolerance and sweep
+mode we report the iterations needed and the wallclock time per solve; the
+Colored mode is run with one thread and with all of them. An optional
+argument gives the largest number of contacts to try (default 10000). */
+
+#include "Simbody.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace SimTK;
+
+static const Vec3 HalfSize(0.1, 0.05, 0.08);
+static const Real Mu = 0.5, StepSize = 0.001;
+
+// One box's constraint equations, three per corner (normal, then the two
+// friction directions), as rows of its Jacobian in the box's frame, which
+// is aligned with Ground.
+static Matrix calcBoxBlock() {
+    const UnitInertia G = UnitInertia::brick(HalfSize); // mass is 1
+    const Vec3 Iinv(1/G.getMoments()[0], 1/G.getMoments()[1],
+                    1/G.getMoments()[2]);
+    const Vec3 dirs[3] = {Vec3(0,1,0), Vec3(1,0,0), Vec3(0,0,1)};
+    Matrix J(24, 6);
+    int row = 0;
+    for (int i=-1; i<=1; i+=2)
+    for (int j=-1; j<=1; j+=2)
+    for (int k=-1; k<=1; k+=2) {
+        const Vec3 r = Vec3(i,j,k).elementwiseMultiply(HalfSize);
+        for (int d=0; d < 3; ++d, ++row) {
+            const Vec3 w = r % dirs[d];
+            for (int c=0; c < 3; ++c) {
+                J(row,c) = w[c]; J(row,3+c) = dirs[d][c];
+            }
+        }
+    }
+    Matrix JMinv = J;
+    for (int c=0; c < 3; ++c) JMinv(c) *= Iinv[c];
+    return JMinv * ~J;
+}
+
+// Box b's multipliers are 24b..24b+23, so A is block diagonal.
+static void buildProblem(int nBoxes, ImpulseSolver::SparseMatrix& A,
+                         Vector& verr,
+                         Array_<ImpulseSolver::UniContactRT>& contacts) {
+    const Matrix block = calcBoxBlock();
+    const int m = 24*nBoxes;
+    A.clear(m);
+    for (int b=0; b < nBoxes; ++b)
+        for (int j=0; j < 24; ++j) {
+            for (int i=0; i < 24; ++i)
+                if (block(i,j) != 0) A.appendEntry(24*b+i, block(i,j));
+            A.finishColumn();
+        }
+
+    // Constraint velocity error verr=G u for random box velocities u, with
+    // gravity's effect over one step added to the normal velocity.
+    Random::Uniform random(-0.3, 0.3);
+    random.setSeed(nBoxes);
+    verr.resize(m);
+    const Vec3 dirs[3] = {Vec3(0,1,0), Vec3(1,0,0), Vec3(0,0,1)};
+    for (int b=0; b < nBoxes; ++b) {
+        const Vec3 w(random.getValue(), random.getValue(), random.getValue());
+        const Vec3 v(random.getValue(), random.getValue() - 9.8*StepSize,
+                     random.getValue());
+        int row = 24*b;
+        for (int i=-1; i<=1; i+=2)
+        for (int j=-1; j<=1; j+=2)
+        for (int k=-1; k<=1; k+=2) {
+            const Vec3 r = Vec3(i,j,k).elementwiseMultiply(HalfSize);
+            const Vec3 vp = v + w % r; // velocity of the corner
+            for (int d=0; d < 3; ++d, ++row)
+                verr[row] = dot(vp, dirs[d]);
+        }
+    }
+
+    contacts.resize(8*nBoxes);
+    for (int c=0; c < 8*nBoxes; ++c) {
+        ImpulseSolver::UniContactRT& rt = contacts[c];
+        rt.m_Nk = MultiplierIndex(3*c);
+        rt.m_Fk.clear();
+        rt.m_Fk.push_back(MultiplierIndex(3*c+1));
+        rt.m_Fk.push_back(MultiplierIndex(3*c+2));
+        rt.m_type = ImpulseSolver::Participating;
+        rt.m_effMu = Mu;
+    }
+}
+
+struct Result {
+    double iterations, ms;
+    long long failures;
+};
+
+static Result time(const ImpulseSolver::SparseMatrix& A, const Vector& verr,
+                   const Array_<ImpulseSolver::UniContactRT>& contacts,
+                   Real tol, PGSImpulseSolver::SweepMode mode, int nThreads) {
+    PGSImpulseSolver pgs(0.01);
+    pgs.setConvergenceTol(tol);
+    pgs.setMaxIterations(1000);
+    pgs.setSweepMode(mode);
+    pgs.setNumberOfThreads(nThreads);
+
+    const int m = A.nrow();
+    Array_<MultiplierIndex> participating;
+    for (MultiplierIndex mx(0); mx < m; ++mx)
+        participating.push_back(mx);
+    const Vector D(m, Real(0));
+    Array_<ImpulseSolver::UncondRT>                 uncond;
+    Array_<ImpulseSolver::UniSpeedRT>               uniSpeed;
+    Array_<ImpulseSolver::BoundedRT>                bounded;
+    Array_<ImpulseSolver::ConstraintLtdFrictionRT>  consLtd;
+    Array_<ImpulseSolver::StateLtdFrictionRT>       stateLtd;
+
+    const int NumSolves = 5;
+    double total = 0;
+    for (int i=0; i < NumSolves; ++i) {
+        Array_<ImpulseSolver::UniContactRT> uniContact = contacts;
+        Vector piExpand(m, Real(0)), verrStart = verr, verrApplied, pi;
+        const double start = realTime();
+        pgs.solve(0, participating, A, D, Array_<MultiplierIndex>(),
+                  piExpand, verrStart, verrApplied, pi, uncond, uniContact,
+                  uniSpeed, bounded, consLtd, stateLtd);
+        total += realTime() - start;
+    }
+
+    Result result;
+    result.iterations = double(pgs.getNumIterations(0))/NumSolves;
+    result.failures = pgs.getNumFailures(0);
+    result.ms = 1000*total/NumSolves;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const int maxContacts = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int nThreads = ParallelExecutor::getNumProcessors();
+    printf("PGS sweep modes on %d processors: iterations, failed solves, "
+           "and ms per solve.\n", nThreads);
+    printf("%8s %6s %23s %23s %23s %23s\n", "contacts", "tol", "serial",
+           "colored 1 thread", "colored all threads", "Jacobi all threads");
+
+    const int sizes[] = {1000, 2000, 5000, 10000};
+    const Real tols[] = {1e-3, 1e-4, 1e-5, 1e-6};
+    for (int s=0; s < 4 && sizes[s] <= maxContacts; ++s) {
+        ImpulseSolver::SparseMatrix A;
+        Vector verr;
+        Array_<ImpulseSolver::UniContactRT> contacts;
+        buildProblem(sizes[s]/8, A, verr, contacts);
+        for (int t=0; t < 4; ++t) {
+            const Result r[4] = {
+                time(A, verr, contacts, tols[t], PGSImpulseSolver::Serial, 1),
+                time(A, verr, contacts, tols[t], PGSImpulseSolver::Colored,1),
+                time(A, verr, contacts, tols[t], PGSImpulseSolver::Colored,
+                     nThreads),
+                time(A, verr, contacts, tols[t], PGSImpulseSolver::Jacobi,
+                     nThreads)};
+            printf("%8d %6.0e", sizes[s], tols[t]);
+            for (int i=0; i < 4; ++i)
+                printf(" %6.1f %5lld %10.2f", r[i].iterations, r[i].failures,
+                       r[i].ms);
+            printf("\n");
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
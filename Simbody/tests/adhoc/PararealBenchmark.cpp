@@ -0,0 +1,102 @@
+/* -------------------------------------------------------------------------- *
+ *                    Simbody(tm) - Parareal Benchmark                        *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+/* Compare a serial Runge-Kutta-Merson simulation of a damped 20-body pin chain
+with PararealDriver using the same fine integrator, for several numbers of
+time slices. Wall clock time is reported along with the number of Parareal
+iterations and the difference from the serial result. The speedup obtainable
+is at most (number of slices)/(number of iterations), limited by the number
+of processors. */
+
+#include "Simbody.h"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace SimTK;
+
+int main() {
+  try {
+    // A 20-body pendulum with pin joints and a little damping at each joint
+    // so that the motion isn't chaotic (Parareal converges poorly on chaotic
+    // trajectories since the slices are then very sensitive to their initial
+    // conditions). Force elements and mobilized bodies keep references to
+    // these handles so we build the system here rather than in a function.
+    MultibodySystem system;
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    Force::UniformGravity(forces, matter, Vec3(0, -9.8, 0));
+    Body::Rigid body(MassProperties(1, Vec3(0), UnitInertia(.1)));
+
+    MobilizedBody parent = matter.Ground();
+    for (int i = 0; i < 20; ++i) {
+        MobilizedBody::Pin link(parent, Transform(Vec3(0)),
+                                body,   Transform(Vec3(0, .5, 0)));
+        Force::MobilityLinearDamper(forces, link, MobilizerUIndex(0), 2);
+        parent = link;
+    }
+
+    State state = system.realizeTopology();
+    for (int i = 0; i < state.getNQ(); ++i)
+        state.updQ()[i] = 0.01*(i+1);
+
+    const Real tFinal = 20, accuracy = 1e-6;
+
+    RungeKuttaMersonIntegrator serialInteg(system);
+    serialInteg.setAccuracy(accuracy);
+    TimeStepper ts(system, serialInteg);
+    ts.initialize(state);
+    double start = realTime();
+    ts.stepTo(tFinal);
+    const double serialTime = realTime()-start;
+    const State& serial = ts.getState();
+    std::printf("Serial RKMerson acc=%g: %d steps, %.3fs\n", accuracy,
+                serialInteg.getNumStepsTaken(), serialTime);
+    std::printf("%d processors\n", ParallelExecutor::getNumProcessors());
+    std::printf("%8s %6s %10s %10s %10s %9s\n", "slices", "iters",
+                "fine steps", "max |dq|", "wall", "speedup");
+
+    for (int nSlices : {4, 8, 16, 32, 64}) {
+        PararealDriver parareal(system);
+        parareal.setNumTimeSlices(nSlices);
+        parareal.setCoarseIntegrator(PararealDriver::RungeKutta2, 0.02);
+        parareal.setFineIntegrator(PararealDriver::RungeKuttaMerson, accuracy);
+        start = realTime();
+        parareal.simulate(state, tFinal);
+        const double pTime = realTime()-start;
+        const Real dq =
+            (parareal.getState().getQ() - serial.getQ()).normInf();
+        std::printf("%8d %6d %10d %10.3g %9.3fs %8.2fx%s\n", nSlices,
+                    parareal.getNumIterations(), parareal.getNumFineSteps(),
+                    dq, pTime, serialTime/pTime,
+                    parareal.isConverged() ? "" : " (not converged)");
+        if (nSlices == 16)
+            parareal.writeConvergenceReport(std::cout);
+    }
+
+  } catch(const std::exception& e) {
+    std::cout << "EXCEPTION: " << e.what() << std::endl;
+    return 1;
+  }
+    return 0;
+}
@@ -0,0 +1,168 @@
+/* -------------------------------------------------------------------------- *
+ *                 Simbody(tm) - Rattle Integrator Benchmark                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+/* Compare long-horizon energy behavior and cost of RattleIntegrator against
+VerletIntegrator and RungeKuttaMersonIntegrator. The two models are the ones
+from examples/ExampleLongPendulum.cpp (a 10-link chain of ball joints in
+gravity) and examples/DzhanibekovEffect.cpp (a torque-free asymmetric rigid
+body, plus a loop-closing variant of the pendulum so that the constraint
+projections get exercised). No visualization is used. */
+
+#include "Simbody.h"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace SimTK;
+
+namespace {
+
+// Build the ExampleLongPendulum chain. If closeLoop is set, the last body is
+// tied back to ground with a distance constraint.
+void buildLongPendulum(MultibodySystem& system, bool closeLoop) {
+    SimbodyMatterSubsystem matter(system);
+    GeneralForceSubsystem forces(system);
+    // Force elements keep a reference to the matter subsystem so we must
+    // give them the System's copy of the handle rather than our local one.
+    Force::UniformGravity gravity(forces, system.getMatterSubsystem(),
+                                  Vec3(0, -9.8, 0));
+    Body::Rigid pendulumBody(MassProperties(1.0, Vec3(0), Inertia(1)));
+
+    MobilizedBody lastBody = matter.Ground();
+    for (int i = 0; i < 10; ++i) {
+        MobilizedBody::Ball pendulum(lastBody,     Transform(Vec3(0)),
+                                     pendulumBody, Transform(Vec3(0, 1, 0)));
+        lastBody = pendulum;
+    }
+    if (closeLoop)
+        Constraint::Rod(matter.Ground(), Vec3(3,0,0), lastBody, Vec3(0), 4);
+}
+
+// Build the DzhanibekovEffect shaft-and-bar free body.
+void buildDzhanibekov(MultibodySystem& system) {
+    SimbodyMatterSubsystem matter(system);
+    Body::Rigid shaftBody(MassProperties(1, Vec3(0),
+                            UnitInertia::cylinderAlongX(.02, .05)));
+    const Vec3 halfLengths(.02,.04,.3);
+    Body::Rigid barBody(MassProperties(2, Vec3(0),
+                    UnitInertia::brick(halfLengths)));
+    MobilizedBody::Free shaft(matter.Ground(), Transform(),
+                              shaftBody, Transform());
+    MobilizedBody::Weld bar(shaft, Vec3(-.05,0,0),
+                            barBody, Vec3(halfLengths[0],0,0));
+}
+
+struct Result {
+    Real maxDriftEarly, maxDriftLate, cpu;
+    int  nSteps, nRealizations;
+};
+
+Result run(const MultibodySystem& system, const State& init,
+           Integrator& integ, Real tFinal) {
+    integ.setConstraintTolerance(1e-8);
+    TimeStepper ts(system, integ);
+    ts.initialize(init);
+    system.realize(ts.getState(), Stage::Dynamics);
+    const Real E0 = system.calcEnergy(ts.getState());
+    const Real Escale = std::max(std::abs(E0), Real(1));
+
+    Result r; r.maxDriftEarly = r.maxDriftLate = 0;
+    const int NReports = 1000;
+    const double cpuStart = cpuTime();
+    for (int i=1; i <= NReports; ++i) {
+        ts.stepTo(i*tFinal/NReports);
+        system.realize(ts.getState(), Stage::Dynamics);
+        const Real err =
+            std::abs(system.calcEnergy(ts.getState())-E0)/Escale;
+        if (i <= NReports/10)  r.maxDriftEarly = std::max(r.maxDriftEarly,err);
+        if (i > 9*NReports/10) r.maxDriftLate  = std::max(r.maxDriftLate, err);
+    }
+    r.cpu = cpuTime()-cpuStart;
+    r.nSteps = integ.getNumStepsTaken();
+    r.nRealizations = integ.getNumRealizations();
+    return r;
+}
+
+void report(const char* name, const Result& r) {
+    std::printf("  %-26s %10.3g %10.3g %8d %8d %8.3fs\n", name,
+                r.maxDriftEarly, r.maxDriftLate, r.nSteps, r.nRealizations,
+                r.cpu);
+}
+
+void benchmark(const char* title, const MultibodySystem& system,
+               const State& init, Real tFinal, Real h) {
+    std::printf("\n%s: tFinal=%g, fixed h=%g\n", title, tFinal, h);
+    std::printf("  %-26s %10s %10s %8s %8s %9s\n", "integrator",
+                "dE first", "dE last", "steps", "realiz", "cpu");
+
+    { RattleIntegrator integ(system, h);
+      report("Rattle", run(system, init, integ, tFinal)); }
+    { VerletIntegrator integ(system, h);
+      report("Verlet (fixed)", run(system, init, integ, tFinal)); }
+    for (Real acc : {1e-3, 1e-5, 1e-7}) {
+        RungeKuttaMersonIntegrator integ(system);
+        integ.setAccuracy(acc);
+        char name[64]; std::sprintf(name, "RKMerson acc=%g", acc);
+        report(name, run(system, init, integ, tFinal));
+    }
+}
+
+}
+
+int main() {
+  try {
+    {   MultibodySystem system;
+        buildLongPendulum(system, false);
+        State state = system.realizeTopology();
+        Random::Gaussian random; random.setSeed(1234);
+        for (int i = 0; i < state.getNQ(); ++i)
+            state.updQ()[i] = random.getValue();
+        benchmark("ExampleLongPendulum", system, state, 100, 1e-3);
+    }
+
+    {   MultibodySystem system;
+        buildLongPendulum(system, true);
+        State state = system.realizeTopology();
+        Random::Gaussian random; random.setSeed(1234);
+        for (int i = 0; i < state.getNQ(); ++i)
+            state.updQ()[i] = .1*random.getValue();
+        Assembler(system).setErrorTolerance(1e-10).assemble(state);
+        benchmark("ExampleLongPendulum with loop", system, state, 100, 1e-3);
+    }
+
+    {   MultibodySystem system;
+        buildDzhanibekov(system);
+        State state = system.realizeTopology();
+        const SimbodyMatterSubsystem& matter = system.getMatterSubsystem();
+        const MobilizedBody& shaft = matter.getMobilizedBody(MobilizedBodyIndex(1));
+        shaft.setQToFitTranslation(state, Vec3(0,0,.5));
+        shaft.setUToFitAngularVelocity(state, Vec3(10,0,1e-10)); // 10 rad/s
+        benchmark("DzhanibekovEffect", system, state, 1000, 1e-2);
+    }
+
+  } catch(const std::exception& e) {
+    std::cout << "EXCEPTION: " << e.what() << std::endl;
+    return 1;
+  }
+    return 0;
+}
@@ -0,0 +1,165 @@
+/* -------------------------------------------------------------------------- *
+ *                    Simbody(tm) - Rosenbrock Benchmark                      *
+ * -------------------------------------------------------------------------- *
+ * This is part of the SimTK biosimulation toolkit originating from           *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org/home/simbody.  *
+ *                                                                            *
+ * Portions copyright (c) 2016 Stanford University and the Authors.           *
+ * Authors: Michael Sherman                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may    *
+ * not use this file except in compliance with the License. You may obtain a  *
+ * copy of the License at http://www.apache.org/licenses/LICENSE-2.0.         *
+ *                                                                            *
+ * Unless required by applicable law or agreed to in writing, software        *
+ * distributed under the License is distributed on an "AS IS" BASIS,          *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+ * See the License for the specific language governing permissions and        *
+ * limitations under the License.                                             *
+ * -------------------------------------------------------------------------- */
+
+/* Run the scene from examples/ExampleContactPlayground.cpp without the
+Visualizer, once with each of several integrators, and report the number of
+steps, realizations and wall clock time. The scene has stiff compliant
+contact (Hunt-Crossley spheres and half spaces, and elastic foundation
+meshes) which limits the step size of the explicit integrators. */
+
+#include "Simbody.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+using namespace SimTK;
+
+int main(int argc, char** argv) {
+  try {
+    const Real tFinal = argc > 1 ? std::atof(argv[1]) : 2;
+    const Real accuracy = 1e-3;
+
+    // The system is the same as in ExampleContactPlayground. Force elements
+    // and mobilized bodies keep references to these handles so we build the
+    // system here rather than in a function.
+    MultibodySystem         system;
+    SimbodyMatterSubsystem  matter(system);
+    GeneralForceSubsystem   forces(system);
+    Force::Gravity   gravity(forces, matter, UnitVec3(2,-10,0), 1);
+
+    ContactTrackerSubsystem  tracker(system);
+    CompliantContactSubsystem contactForces(system, tracker);
+    contactForces.setTrackDissipatedEnergy(true);
+    contactForces.setTransitionVelocity(1e-3);
+
+    ContactGeometry::TriangleMesh sphere(PolygonalMesh::createSphereMesh(1,4));
+
+    ContactCliqueId clique1 = ContactSurface::createNewContactClique();
+    ContactCliqueId clique2 = ContactSurface::createNewContactClique();
+    ContactCliqueId clique3 = ContactSurface::createNewContactClique();
+
+    const Real fFac = 1, fDis = .5*0.2, fVis = .1*.1, fK = 100*1e6;
+
+    matter.Ground().updBody().addContactSurface(Vec3(.25,0,0),
+        ContactSurface(ContactGeometry::HalfSpace(),
+                       ContactMaterial(fK*.01,fDis*.9,fFac*.8,fFac*.7,fVis*10))
+                       .joinClique(clique3));
+    const Rotation R_xdown(-Pi/2,ZAxis);
+    matter.Ground().updBody().addContactSurface(
+        Transform(R_xdown, Vec3(0,-3,0)),
+        ContactSurface(ContactGeometry::HalfSpace(),
+                       ContactMaterial(fK*.1,fDis*.9,fFac*.8,fFac*.7,fVis*10))
+                       .joinClique(clique1));
+
+    const Real rad = .4;
+    Body::Rigid pendulumBody1(MassProperties(1.0, Vec3(0), Inertia(1)));
+    pendulumBody1.addContactSurface(Transform(),
+        ContactSurface(ContactGeometry::Sphere(rad),
+                       ContactMaterial(fK*.01,fDis*.9,fFac*.8,fFac*.7,fVis*10))
+                       .joinClique(clique2));
+    Body::Rigid pendulumBody2(MassProperties(1.0, Vec3(0), Inertia(1)));
+    pendulumBody2.addContactSurface(Transform(),
+        ContactSurface(ContactGeometry::Sphere(rad),
+                       ContactMaterial(fK*.01,fDis*.9,fFac*.8,fFac*.7,fVis*10))
+                       .joinClique(clique1));
+    MobilizedBody::Pin pendulum(matter.Ground(), Transform(Vec3(0)),
+                                pendulumBody1,    Transform(Vec3(0, 1, 0)));
+    MobilizedBody::Pin pendulum2(pendulum, Transform(Vec3(0)),
+                                 pendulumBody2, Transform(Vec3(0, 1, 0)));
+
+    Body::Rigid pendulumBody3(MassProperties(100.0, Vec3(0), 100*Inertia(1)));
+    ContactGeometry::TriangleMesh geo3(PolygonalMesh::createSphereMesh(rad,2));
+    pendulumBody3.addContactSurface(Transform(),
+        ContactSurface(geo3,
+                       ContactMaterial(fK*.1,fDis*.9,fFac*.8,fFac*.7,fVis*10),
+                       rad/2 /*thickness*/)
+                       .joinClique(clique2));
+    MobilizedBody::Pin pendulum3(matter.Ground(), Transform(Vec3(-2,0,0)),
+                                 pendulumBody3, Transform(Vec3(0, 2, 0)));
+
+    Force::MobilityLinearSpring(forces, pendulum2, MobilizerUIndex(0), 10, 0);
+
+    const Real ballMass = 200;
+    Body::Rigid ballBody(MassProperties(ballMass, Vec3(0),
+                            ballMass*UnitInertia::sphere(1)));
+    ballBody.addContactSurface(Transform(),
+        ContactSurface(sphere,
+                       ContactMaterial(fK*.1,fDis*.9,
+                                       .1*fFac*.8,.1*fFac*.7,fVis*1),
+                       .5 /*thickness*/));
+    MobilizedBody::Free ball(matter.Ground(), Transform(Vec3(-2,0,0)),
+        ballBody, Transform(Vec3(0)));
+
+    system.realizeTopology();
+    State state = system.getDefaultState();
+    ball.setQToFitTransform(state, Transform(Rotation(Pi/2,XAxis),
+                                             Vec3(0,-1.8,0)));
+    pendulum.setOneQ(state, 0, -Pi/12);
+    pendulum3.setOneQ(state, 0, -Pi/4);
+    pendulum.setOneU(state, 0, 5.0);
+    ball.setOneU(state, 2, -20);
+    ball.setOneU(state, 0, .05); // to break symmetry
+
+    std::printf("ContactPlayground scene, %d state variables, %gs, acc=%g\n",
+                state.getNY(), tFinal, accuracy);
+    std::printf("%-22s %8s %8s %10s %8s %9s %9s\n", "integrator", "steps",
+                "fails", "realizes", "jacobians", "wall", "E+Ediss");
+
+    for (int which = 0; which < 4; ++which) {
+        std::unique_ptr<Integrator> integ;
+        switch (which) {
+        case 0: integ.reset(new RungeKuttaMersonIntegrator(system)); break;
+        case 1: integ.reset(new RungeKutta3Integrator(system)); break;
+        case 2: integ.reset(new CPodesIntegrator(system, CPodes::BDF,
+                                                 CPodes::Newton)); break;
+        case 3: integ.reset(new RosenbrockWIntegrator(system)); break;
+        }
+        integ->setAccuracy(accuracy);
+        TimeStepper ts(system, *integ);
+        ts.initialize(state);
+        const double start = realTime();
+        ts.stepTo(tFinal);
+        const double wall = realTime() - start;
+
+        const State& s = ts.getState();
+        system.realize(s, Stage::Dynamics);
+        const RosenbrockWIntegrator* ros = which != 3 ? nullptr
+            : static_cast<const RosenbrockWIntegrator*>(integ.get());
+        std::printf("%-22s %8d %8d %10d %8d %8.3fs %9.4g\n",
+                    integ->getMethodName(), integ->getNumStepsTaken(),
+                    integ->getNumErrorTestFailures()
+                        + integ->getNumConvergenceTestFailures(),
+                    integ->getNumRealizations(),
+                    ros ? ros->getNumJacobianEvaluations() : 0, wall,
+                    system.calcEnergy(s)
+                        + contactForces.getDissipatedEnergy(s));
+    }
+
+  } catch(const std::exception& e) {
+    std::cout << "EXCEPTION: " << e.what() << std::endl;
+    return 1;
+  }
+    return 0;
+}